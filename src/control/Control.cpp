@@ -40,8 +40,10 @@
 #include "undo/InsertUndoAction.h"
 #include "view/TextView.h"
 #include "xojfile/LoadHandler.h"
+#include "xojfile/SaveCache.h"
 
 #include "CrashHandler.h"
+#include "CrashJournal.h"
 #include "FullscreenHandler.h"
 #include "LatexController.h"
 #include "PageBackgroundChangeController.h"
@@ -88,7 +90,7 @@ Control::Control(GApplication* gtkApp, GladeSearchpath* gladeSearchPath): gtkApp
 
     this->scrollHandler = new ScrollHandler(this);
 
-    this->scheduler = new XournalScheduler();
+    this->scheduler = new XournalScheduler(this->settings->getSchedulerThreads());
 
     this->doc = new Document(this);
 
@@ -114,6 +116,13 @@ Control::Control(GApplication* gtkApp, GladeSearchpath* gladeSearchPath): gtkApp
     this->layerController = new LayerController(this);
     this->layerController->registerListener(this);
 
+    this->saveCache = new SaveCache(this);
+    this->saveCache->registerListener(this);
+
+    this->crashJournal = new CrashJournal(this);
+    this->crashJournal->registerListener(this);
+    this->undoRedo->addUndoRedoListener(this->crashJournal);
+
     this->fullscreenHandler = new FullscreenHandler(settings);
 
     this->pluginController = new PluginController(this);
@@ -166,6 +175,10 @@ Control::~Control() {
     this->pageBackgroundChangeController = nullptr;
     delete this->layerController;
     this->layerController = nullptr;
+    delete this->saveCache;
+    this->saveCache = nullptr;
+    delete this->crashJournal;
+    this->crashJournal = nullptr;
     delete this->fullscreenHandler;
     this->fullscreenHandler = nullptr;
 }
@@ -2004,6 +2017,7 @@ auto Control::openFile(fs::path filepath, int scrollToPage, bool forceOpen) -> b
     }
 
     LoadHandler loadHandler;
+    loadHandler.setLazyLoadingEnabled(this->settings->isLazyPageLoading());
     Document* loadedDocument = loadHandler.loadDocument(filepath);
     if ((loadedDocument != nullptr && loadHandler.isAttachedPdfMissing()) ||
         !loadHandler.getMissingPdfFilename().empty()) {
@@ -2888,3 +2902,7 @@ auto Control::getPageBackgroundChangeController() -> PageBackgroundChangeControl
 }
 
 auto Control::getLayerController() -> LayerController* { return this->layerController; }
+
+auto Control::getSaveCache() -> SaveCache* { return this->saveCache; }
+
+auto Control::getCrashJournal() -> CrashJournal* { return this->crashJournal; }
@@ -51,6 +51,8 @@ class PageTypeHandler;
 class PageTypeMenu;
 class BaseExportJob;
 class LayerController;
+class SaveCache;
+class CrashJournal;
 class PluginController;
 
 class Control:
@@ -248,6 +250,8 @@ public:
     PageTypeMenu* getNewPageType();
     PageBackgroundChangeController* getPageBackgroundChangeController();
     LayerController* getLayerController();
+    SaveCache* getSaveCache();
+    CrashJournal* getCrashJournal();
 
 
     bool copy();
@@ -409,6 +413,16 @@ private:
 
     LayerController* layerController;
 
+    /**
+     * The serialized pages of the last autosave
+     */
+    SaveCache* saveCache;
+
+    /**
+     * Journal of the changes since the last autosave
+     */
+    CrashJournal* crashJournal;
+
     /**
      * Manage all Xournal++ plugins
      */
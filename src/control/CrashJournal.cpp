@@ -0,0 +1,446 @@
+#include "CrashJournal.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "control/jobs/AutosaveJob.h"
+#include "control/layer/LayerController.h"
+#include "control/settings/Settings.h"
+#include "model/Document.h"
+#include "model/Layer.h"
+
+#include "Control.h"
+#include "PathUtil.h"
+#include "Util.h"
+#include "i18n.h"
+
+namespace {
+
+/**
+ * Records since the last compaction, after which an autosave is requested to compact the journal
+ */
+constexpr uint64_t MAX_RECORD_SIZE = 32 * 1024 * 1024;
+
+constexpr const char* JOURNAL_EXTENSION = ".journal";
+constexpr const char* LOCK_EXTENSION = ".lock";
+
+auto getJournalFolder() -> fs::path { return Util::getConfigSubfolder("autosave"); }
+
+}  // namespace
+
+CrashJournal::Lock::Lock(fs::path journal): journal(std::move(journal)) {
+    this->lockFile = this->journal;
+    this->lockFile += LOCK_EXTENSION;
+}
+
+CrashJournal::Lock::~Lock() {
+#ifdef _WIN32
+    // The lock file is opened with FILE_FLAG_DELETE_ON_CLOSE
+    CloseHandle(this->handle);
+#else
+    // Deleted while it is still locked, an instance which opened it before checks if it is still linked
+    unlink(this->lockFile.c_str());
+    close(this->fd);
+#endif
+}
+
+auto CrashJournal::Lock::tryLock(const fs::path& journal) -> std::unique_ptr<Lock> {
+    std::unique_ptr<Lock> lock(new Lock(journal));
+
+#ifdef _WIN32
+    // Not shared, opening it fails as long as another instance holds it
+    HANDLE handle = CreateFileW(lock->lockFile.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    lock->handle = handle;
+#else
+    int fd = open(lock->lockFile.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return nullptr;
+    }
+
+    // Locks of the same process on another file descriptor also fail, so the own journal is skipped as well
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    // The file may have been deleted by the instance releasing it after it was opened here
+    struct stat opened {};
+    struct stat current {};
+    if (fstat(fd, &opened) != 0 || stat(lock->lockFile.c_str(), &current) != 0 || opened.st_ino != current.st_ino ||
+        opened.st_dev != current.st_dev) {
+        close(fd);
+        return nullptr;
+    }
+    lock->fd = fd;
+#endif
+
+    return lock;
+}
+
+auto CrashJournal::Lock::getJournal() const -> const fs::path& { return this->journal; }
+
+void CrashJournal::Lock::removeJournal() { fs::remove(this->journal); }
+
+CrashJournal::CrashJournal(Control* control):
+        control(control),
+        // The time is part of the name, the process id of a crashed instance may be reused
+        journal(getJournalFolder() /
+                (std::to_string(Util::getPid()) + "-" + std::to_string(g_get_real_time()) + JOURNAL_EXTENSION)) {}
+
+CrashJournal::~CrashJournal() {
+    if (this->writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(this->journalMutex);
+            this->stopWriter = true;
+        }
+        this->recordQueued.notify_one();
+        this->writer.join();
+    }
+
+    // Exited properly, nothing to recover. The lock is released afterwards.
+    removeFile();
+}
+
+void CrashJournal::start() {
+    if (this->writer.joinable()) {
+        return;
+    }
+
+    fs::create_directories(this->journal.getFile().parent_path());
+    this->lock = Lock::tryLock(this->journal.getFile());
+    if (!this->lock) {
+        g_warning("Could not lock the crash journal \"%s\"", this->journal.getFile().u8string().c_str());
+    }
+
+    this->writer = std::thread([this]() { writeRecords(); });
+}
+
+auto CrashJournal::PageLayout::operator==(const PageLayout& other) const -> bool {
+    return page == other.page && width == other.width && height == other.height && type == other.type &&
+           color == other.color && pdfPage == other.pdfPage;
+}
+
+auto CrashJournal::isEnabled() -> bool { return this->control->getSettings()->isCrashJournalEnabled(); }
+
+auto CrashJournal::currentLayout() -> vector<PageLayout> {
+    Document* doc = this->control->getDocument();
+
+    vector<PageLayout> pages;
+    pages.reserve(doc->getPageCount());
+    for (size_t i = 0; i < doc->getPageCount(); i++) {
+        PageRef p = doc->getPage(i);
+        pages.push_back({p.get(), p->getWidth(), p->getHeight(), p->getBackgroundType(), p->getBackgroundColor(),
+                         p->getPdfPageNr()});
+    }
+    return pages;
+}
+
+void CrashJournal::checkLayout() {
+    vector<PageLayout> pages = currentLayout();
+
+    std::lock_guard<std::mutex> lock(this->journalMutex);
+    if (pages != this->layout) {
+        this->layout = std::move(pages);
+        this->generation++;
+    }
+}
+
+void CrashJournal::reset() {
+    Document* doc = this->control->getDocument();
+    fs::path filepath = doc->getFilepath();
+    vector<PageLayout> pages = currentLayout();
+
+    std::lock_guard<std::mutex> lock(this->journalMutex);
+    removeFile();
+
+    // A document which was not loaded from a Xournal++ file needs an autosave first
+    this->base = Util::hasXournalFileExt(filepath) ? filepath : fs::path{};
+    this->documentPath = filepath;
+    this->layout = std::move(pages);
+    this->generation++;
+    this->baseGeneration = this->generation;
+}
+
+void CrashJournal::removeFile() {
+    this->pending.clear();
+    this->epoch++;
+    this->journal.remove();
+}
+
+auto CrashJournal::getHeader() const -> CrashJournalFile::Header {
+    return {this->base, this->documentPath, this->baseGeneration};
+}
+
+void CrashJournal::requestCompaction() {
+    if (this->compactionRunning) {
+        return;
+    }
+    this->compactionRunning = true;
+
+    auto* job = new AutosaveJob(this->control);
+    this->control->getScheduler()->addJob(job, JOB_PRIORITY_NONE);
+    job->unref();
+}
+
+void CrashJournal::undoRedoChanged() {}
+
+void CrashJournal::undoRedoPageChanged(PageRef page) {
+    if (!isEnabled()) {
+        std::lock_guard<std::mutex> lock(this->journalMutex);
+        removeFile();
+        return;
+    }
+
+    start();
+
+    size_t pageIndex = this->control->getDocument()->indexOf(page);
+    if (pageIndex == npos) {
+        // Page was deleted, this is handled by the layout
+        return;
+    }
+
+    checkLayout();
+
+    // The snapshot is shared with the autosave and the export, and only copied if the page changed since
+    Document* doc = this->control->getDocument();
+    doc->lockShared();
+    page->lockShared();
+    std::shared_ptr<XojPage> snapshot = page->getSnapshot();
+    page->unlockShared();
+    doc->unlockShared();
+
+    {
+        std::lock_guard<std::mutex> lock(this->journalMutex);
+
+        // Only the latest content of a page is needed, a record which was not written yet is replaced
+        auto it = std::find_if(this->pending.begin(), this->pending.end(), [&](const PendingRecord& r) {
+            return r.pageIndex == pageIndex && r.generation == this->generation;
+        });
+        if (it != this->pending.end()) {
+            it->snapshot = std::move(snapshot);
+        } else {
+            this->pending.push_back({this->generation, pageIndex, std::move(snapshot)});
+        }
+    }
+    this->recordQueued.notify_one();
+}
+
+void CrashJournal::writeRecords() {
+    std::unique_lock<std::mutex> lock(this->journalMutex);
+    while (true) {
+        this->recordQueued.wait(lock, [this]() { return this->stopWriter || !this->pending.empty(); });
+        if (this->stopWriter) {
+            return;
+        }
+
+        PendingRecord record = std::move(this->pending.front());
+        this->pending.pop_front();
+        uint64_t recordEpoch = this->epoch;
+
+        // The snapshot is immutable, it is serialized without holding the journal
+        lock.unlock();
+        GString* data = CrashJournalFile::serializePage(record.generation, record.pageIndex, *record.snapshot);
+        record.snapshot.reset();
+        lock.lock();
+
+        if (recordEpoch == this->epoch) {
+            appendPage(data);
+        }
+        g_string_free(data, true);
+    }
+}
+
+void CrashJournal::appendPage(GString* data) {
+    if (!this->journal.isOpen() && !this->journal.open(getHeader())) {
+        return;
+    }
+
+    this->journal.append(data);
+
+    if (this->base.empty() || this->generation != this->baseGeneration ||
+        this->journal.getRecordSize() > MAX_RECORD_SIZE) {
+        requestCompaction();
+    }
+}
+
+void CrashJournal::documentChanged(DocumentChangeType type) {
+    if (type == DOCUMENT_CHANGE_CLEARED || type == DOCUMENT_CHANGE_COMPLETE) {
+        reset();
+    }
+}
+
+void CrashJournal::pageSizeChanged(size_t page) { checkLayout(); }
+
+void CrashJournal::pageChanged(size_t page) { checkLayout(); }
+
+void CrashJournal::pageInserted(size_t page) { checkLayout(); }
+
+void CrashJournal::pageDeleted(size_t page) { checkLayout(); }
+
+auto CrashJournal::mark() -> Mark {
+    Mark mark;
+    mark.documentPath = this->control->getDocument()->getFilepath();
+
+    std::lock_guard<std::mutex> lock(this->journalMutex);
+    mark.offset = this->journal.getSize();
+    mark.generation = this->generation;
+    return mark;
+}
+
+void CrashJournal::compacted(const fs::path& autosaveFile, const Mark& mark) {
+    std::lock_guard<std::mutex> lock(this->journalMutex);
+    this->compactionRunning = false;
+
+    this->base = autosaveFile;
+    this->documentPath = mark.documentPath;
+    this->baseGeneration = mark.generation;
+
+    if (!this->journal.isOpen()) {
+        return;
+    }
+
+    // Keep the records written after the autosave took its snapshot, they may not be contained in the autosave.
+    // If the journal was opened after the mark, its header is not kept.
+    this->journal.rewrite(getHeader(), std::max(mark.offset, this->journal.getHeaderSize()));
+}
+
+void CrashJournal::baseMoved(const fs::path& autosaveFile) {
+    std::lock_guard<std::mutex> lock(this->journalMutex);
+    this->base = autosaveFile;
+
+    if (this->journal.isOpen()) {
+        this->journal.rewrite(getHeader(), this->journal.getHeaderSize());
+    }
+}
+
+void CrashJournal::restored() {
+    fs::path filepath = this->control->getDocument()->getFilepath();
+
+    std::lock_guard<std::mutex> lock(this->journalMutex);
+
+    // The restored changes are not in any file yet
+    this->base.clear();
+    this->documentPath = filepath;
+
+    if (isEnabled()) {
+        requestCompaction();
+    }
+}
+
+void CrashJournal::compactionFailed() {
+    std::lock_guard<std::mutex> lock(this->journalMutex);
+    this->compactionRunning = false;
+}
+
+auto CrashJournal::findJournals() -> vector<std::unique_ptr<Lock>> { return findJournals(getJournalFolder()); }
+
+auto CrashJournal::findJournals(const fs::path& folder) -> vector<std::unique_ptr<Lock>> {
+    vector<std::unique_ptr<Lock>> journals;
+
+    if (!fs::is_directory(folder)) {
+        return journals;
+    }
+
+    // Listed first, stale lock files are deleted while iterating
+    vector<fs::path> files;
+    for (auto const& entry: fs::directory_iterator(folder)) {
+        files.push_back(entry.path());
+    }
+
+    for (const fs::path& p: files) {
+        if (p.extension() == LOCK_EXTENSION) {
+            // Lock file of a crashed instance which never wrote its journal, released (and deleted) immediately
+            fs::path journal = p;
+            journal.replace_extension();
+            if (!fs::exists(journal)) {
+                Lock::tryLock(journal);
+            }
+            continue;
+        }
+        if (p.extension() != JOURNAL_EXTENSION) {
+            continue;
+        }
+
+        // The journals of running instances (including this one) are locked
+        if (auto lock = Lock::tryLock(p)) {
+            journals.push_back(std::move(lock));
+        }
+    }
+
+    return journals;
+}
+
+auto CrashJournal::replay(Control* control, const fs::path& journal, string& error) -> bool {
+    CrashJournalFile::Header header;
+    vector<CrashJournalFile::Record> records;
+    if (!CrashJournalFile::read(journal, header, records, error)) {
+        return false;
+    }
+
+    fs::path base = header.base;
+    if (!base.empty() && !fs::exists(base) && base.extension() == ".tmp") {
+        // The autosave was renamed from its temporary file, but the journal was not updated anymore
+        base.replace_extension();
+    }
+
+    if (base.empty() || !fs::exists(base)) {
+        error = FS(_F("The file \"{1}\" the journal is based on does not exist") % base.u8string());
+        return false;
+    }
+
+    if (!control->openFile(base, -1, true)) {
+        error = FS(_F("Could not open \"{1}\"") % base.u8string());
+        return false;
+    }
+
+    Document* doc = control->getDocument();
+    LayerController* layerController = control->getLayerController();
+    vector<size_t> changedPages;
+
+    for (CrashJournalFile::Record& record: records) {
+        PageRef page = doc->getPage(record.pageIndex);
+        if (record.generation != header.baseGeneration || !page) {
+            // The layout of the document changed, and the autosave which contains it was not written
+            continue;
+        }
+
+        doc->lock();
+        vector<Layer*> oldLayers = *page->getLayers();
+        for (Layer* l: oldLayers) {
+            layerController->removeLayer(page, l);
+            delete l;
+        }
+        for (auto& l: record.layers) {
+            layerController->addLayer(page, l.release());
+        }
+        doc->unlock();
+
+        changedPages.push_back(record.pageIndex);
+    }
+
+    for (size_t page: changedPages) {
+        control->firePageChanged(page);
+    }
+
+    doc->lock();
+    doc->setFilepath(header.documentPath);
+    doc->unlock();
+
+    control->getCrashJournal()->restored();
+
+    return true;
+}
@@ -0,0 +1,277 @@
+/*
+ * Xournal++
+ *
+ * Write-ahead journal of the changed pages, for crash recovery
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model/DocumentListener.h"
+#include "model/PageRef.h"
+#include "model/PageType.h"
+#include "undo/UndoRedoHandler.h"
+
+#include "CrashJournalFile.h"
+
+#include "XournalType.h"
+#include "filesystem.h"
+
+class Control;
+
+/**
+ * @brief Appends the changed pages to a journal file, so the changes since the last autosave are not lost on a crash
+ *
+ * The journal (see CrashJournalFile) starts with a header, which references the base file: the last autosave, or
+ * the file the document was loaded from. For every page changed by an undo action (added, undone or redone) a record
+ * with the layers of the page is appended. Records are complete snapshots of the page, so applying a record twice
+ * does no harm.
+ *
+ * Changes which are not described by the records (inserted, deleted or moved pages, and changed backgrounds) start a
+ * new layout generation, records are only replayed if they were written with the layout of the base file. Such
+ * changes, and a journal which grows too large, request an autosave, which compacts the journal: the autosave
+ * becomes the new base file, and only the records written after the autosave took its snapshot are kept.
+ *
+ * The journal is only locked and written while it is enabled in the settings.
+ */
+class CrashJournal: public UndoRedoListener, public DocumentListener {
+public:
+    explicit CrashJournal(Control* control);
+    ~CrashJournal() override;
+
+private:
+    CrashJournal(const CrashJournal& journal);
+    void operator=(const CrashJournal& journal);
+
+public:
+    /**
+     * @brief Exclusive lock of a journal, held by the instance writing the journal or restoring it
+     *
+     * The lock is a file next to the journal which is locked by the operating system, so the lock is released if
+     * the instance holding it crashes. A journal which can not be locked belongs to a running instance.
+     */
+    class Lock {
+    public:
+        ~Lock();
+
+    private:
+        explicit Lock(fs::path journal);
+        Lock(const Lock& lock);
+        void operator=(const Lock& lock);
+
+    public:
+        /**
+         * Locks the journal without waiting
+         *
+         * @return nullptr if the journal is locked by another instance, or by this instance
+         */
+        static std::unique_ptr<Lock> tryLock(const fs::path& journal);
+
+        const fs::path& getJournal() const;
+
+        /**
+         * Deletes the journal, the lock file is deleted when the lock is released
+         */
+        void removeJournal();
+
+    private:
+        fs::path journal;
+        fs::path lockFile;
+
+#ifdef _WIN32
+        void* handle = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+
+    /**
+     * Position in the journal, taken while the document is locked for an autosave
+     */
+    struct Mark {
+        uint64_t offset = 0;
+        uint64_t generation = 0;
+        fs::path documentPath;
+    };
+
+    /**
+     * Needs to be called while the document is locked, before the document is written by the autosave
+     */
+    Mark mark();
+
+    /**
+     * The autosave was written completely, it is the new base of the journal
+     */
+    void compacted(const fs::path& autosaveFile, const Mark& mark);
+
+    /**
+     * The base file was renamed, e.g. the autosave from its temporary file to its final name
+     */
+    void baseMoved(const fs::path& autosaveFile);
+
+    /**
+     * The autosave failed, the journal keeps the old base
+     */
+    void compactionFailed();
+
+    /**
+     * The document was restored from the journal of another instance, the base file does not contain the restored
+     * changes, so an autosave is requested
+     */
+    void restored();
+
+    /**
+     * Finds and locks the journals left by instances which did not exit properly. Journals of running instances
+     * are skipped.
+     *
+     * @return The locks of the journals, the journals can be restored or deleted as long as they are held
+     */
+    static vector<std::unique_ptr<Lock>> findJournals();
+
+    /**
+     * @param folder The folder containing the journals
+     */
+    static vector<std::unique_ptr<Lock>> findJournals(const fs::path& folder);
+
+    /**
+     * Opens the base file of the journal and applies the records to it
+     *
+     * @return true if the document was restored
+     */
+    static bool replay(Control* control, const fs::path& journal, string& error);
+
+public:
+    // UndoRedoListener
+    void undoRedoChanged() override;
+    void undoRedoPageChanged(PageRef page) override;
+
+    // DocumentListener
+    void documentChanged(DocumentChangeType type) override;
+    void pageSizeChanged(size_t page) override;
+    void pageChanged(size_t page) override;
+    void pageInserted(size_t page) override;
+    void pageDeleted(size_t page) override;
+
+private:
+    /**
+     * What the records do not contain, if this changes the records can not be applied to the base file anymore
+     */
+    struct PageLayout {
+        XojPage* page;
+        double width;
+        double height;
+        PageType type;
+        Color color;
+        size_t pdfPage;
+
+        bool operator==(const PageLayout& other) const;
+    };
+
+    /**
+     * A changed page waiting to be serialized and appended by the writer thread
+     */
+    struct PendingRecord {
+        uint64_t generation;
+        size_t pageIndex;
+        std::shared_ptr<XojPage> snapshot;
+    };
+
+    bool isEnabled();
+
+    /**
+     * Locks the journal and starts the writer thread, if this did not happen yet. Called once the journal is
+     * enabled and a page changes.
+     */
+    void start();
+
+    vector<PageLayout> currentLayout();
+
+    /**
+     * Starts a new layout generation if the layout of the document changed
+     */
+    void checkLayout();
+
+    /**
+     * Starts a new journal for the current document
+     */
+    void reset();
+
+    /**
+     * Closes and deletes the journal file
+     */
+    void removeFile();
+
+    /**
+     * @return The header referencing the current base file
+     */
+    CrashJournalFile::Header getHeader() const;
+
+    void requestCompaction();
+
+    /**
+     * Writer thread, serializes the queued snapshots and appends them to the journal
+     */
+    void writeRecords();
+
+    /**
+     * Appends a serialized page, the journal needs to be locked
+     */
+    void appendPage(GString* data);
+
+private:
+    Control* control;
+
+    /**
+     * Held as long as this instance runs, so other instances do not take the journal for a crashed one
+     */
+    std::unique_ptr<Lock> lock;
+
+    /**
+     * Protects the journal, the records are written by the writer thread, the compaction happens in the autosave job
+     */
+    std::mutex journalMutex;
+
+    /**
+     * The pages are serialized on the writer thread, so undo actions do not wait for the serialization and the disk
+     */
+    std::thread writer;
+    std::condition_variable recordQueued;
+    std::deque<PendingRecord> pending;
+    bool stopWriter = false;
+
+    /**
+     * Incremented when the journal file is removed, a record serialized before is dropped
+     */
+    uint64_t epoch = 0;
+
+    CrashJournalFile journal;
+
+    /**
+     * The base file, empty if there is none yet
+     */
+    fs::path base;
+
+    /**
+     * The path of the document, restored after the replay of an autosave
+     */
+    fs::path documentPath;
+
+    vector<PageLayout> layout;
+    uint64_t generation = 1;
+    uint64_t baseGeneration = 1;
+
+    bool compactionRunning = false;
+};
@@ -0,0 +1,267 @@
+#include "CrashJournalFile.h"
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "model/Image.h"
+#include "model/Layer.h"
+#include "model/Stroke.h"
+#include "model/TexImage.h"
+#include "model/Text.h"
+#include "model/XojPage.h"
+#include "serializing/BinObjectEncoding.h"
+#include "serializing/InputStreamException.h"
+#include "serializing/ObjectInputStream.h"
+#include "serializing/ObjectOutputStream.h"
+
+#include "i18n.h"
+
+namespace {
+
+/**
+ * Reads the next record, the length is stored before each record
+ *
+ * @return false if there is no complete record anymore, e.g. as the last one was cut off by the crash
+ */
+auto readRecord(const string& data, size_t& pos, ObjectInputStream& in) -> bool {
+    uint32_t length = 0;
+    if (data.size() - pos < sizeof(length)) {
+        return false;
+    }
+    memcpy(&length, data.data() + pos, sizeof(length));
+    pos += sizeof(length);
+
+    if (data.size() - pos < length) {
+        return false;
+    }
+    const char* record = data.data() + pos;
+    pos += length;
+
+    return in.read(record, static_cast<int>(length));
+}
+
+auto readElement(ObjectInputStream& in) -> std::unique_ptr<Element> {
+    string name = in.getNextObjectName();
+
+    std::unique_ptr<Element> element;
+    if (name == "Stroke") {
+        element = std::make_unique<Stroke>();
+    } else if (name == "Image") {
+        element = std::make_unique<Image>();
+    } else if (name == "TexImage") {
+        element = std::make_unique<TexImage>();
+    } else if (name == "Text") {
+        element = std::make_unique<Text>();
+    } else {
+        throw InputStreamException(FS(FORMAT_STR("Get unknown object {1}") % name), __FILE__, __LINE__);
+    }
+
+    element->readSerialized(in);
+    return element;
+}
+
+auto readLayers(ObjectInputStream& in) -> vector<std::unique_ptr<Layer>> {
+    vector<std::unique_ptr<Layer>> layers;
+
+    int layerCount = in.readInt();
+    for (int i = 0; i < layerCount; i++) {
+        in.readObject("Layer");
+
+        auto layer = std::make_unique<Layer>();
+        bool hasName = in.readInt();
+        string name = in.readString();
+        if (hasName) {
+            layer->setName(name);
+        }
+
+        int elementCount = in.readInt();
+        for (int e = 0; e < elementCount; e++) {
+            layer->addElement(readElement(in).release());
+        }
+
+        in.endObject();
+        layers.push_back(std::move(layer));
+    }
+
+    return layers;
+}
+
+}  // namespace
+
+CrashJournalFile::CrashJournalFile(fs::path file): file(std::move(file)) {}
+
+CrashJournalFile::~CrashJournalFile() = default;
+
+auto CrashJournalFile::getFile() const -> const fs::path& { return this->file; }
+
+auto CrashJournalFile::isOpen() const -> bool { return this->out.is_open(); }
+
+auto CrashJournalFile::getSize() const -> uint64_t { return this->size; }
+
+auto CrashJournalFile::getHeaderSize() const -> uint64_t { return this->headerSize; }
+
+auto CrashJournalFile::getRecordSize() const -> uint64_t { return this->recordSize; }
+
+auto CrashJournalFile::open(const Header& header) -> bool {
+    fs::create_directories(this->file.parent_path());
+    this->out.open(this->file, std::ios::binary | std::ios::trunc);
+    if (!this->out.is_open()) {
+        g_warning("Could not open the crash journal \"%s\"", this->file.u8string().c_str());
+        return false;
+    }
+
+    this->size = 0;
+    this->recordSize = 0;
+    writeHeader(header);
+    return true;
+}
+
+void CrashJournalFile::remove() {
+    if (this->out.is_open()) {
+        this->out.close();
+        fs::remove(this->file);
+    }
+    this->size = 0;
+    this->headerSize = 0;
+    this->recordSize = 0;
+}
+
+void CrashJournalFile::append(const GString* record) {
+    writeRecord(record->str, record->len);
+    this->recordSize += record->len;
+}
+
+void CrashJournalFile::writeHeader(const Header& header) {
+    ObjectOutputStream stream(new BinObjectEncoding());
+    stream.writeObject("CrashJournal");
+    stream.writeString(header.base.u8string());
+    stream.writeString(header.documentPath.u8string());
+    stream.writeSizeT(header.baseGeneration);
+    stream.endObject();
+
+    GString* data = stream.getStr();
+    writeRecord(data->str, data->len);
+    g_string_free(data, true);
+
+    this->headerSize = this->size;
+}
+
+void CrashJournalFile::writeRecord(const char* data, size_t length) {
+    auto recordLength = static_cast<uint32_t>(length);
+    this->out.write(reinterpret_cast<const char*>(&recordLength), sizeof(recordLength));
+    this->out.write(data, static_cast<std::streamsize>(length));
+
+    // Handed to the operating system before the next change, so the record survives a crash of Xournal++. It is not
+    // synced to the disk, a power loss may still lose the last records.
+    this->out.flush();
+
+    this->size += sizeof(recordLength) + length;
+}
+
+void CrashJournalFile::rewrite(const Header& header, uint64_t keepFrom) {
+    this->out.close();
+
+    string tail;
+    if (keepFrom < this->size) {
+        std::ifstream in(this->file, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(keepFrom));
+        tail.resize(this->size - keepFrom);
+        in.read(&tail[0], static_cast<std::streamsize>(tail.size()));
+        tail.resize(static_cast<size_t>(in.gcount()));
+    }
+
+    // Write the compacted journal next to the old one, so there is always a complete journal
+    fs::path tmp = this->file;
+    tmp += ".tmp";
+    this->out.open(tmp, std::ios::binary | std::ios::trunc);
+    if (!this->out.is_open()) {
+        g_warning("Could not write the crash journal \"%s\"", tmp.u8string().c_str());
+        this->out.open(this->file, std::ios::binary | std::ios::app);
+        return;
+    }
+
+    this->size = 0;
+    writeHeader(header);
+    this->out.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+    this->out.flush();
+    this->size += tail.size();
+    this->recordSize = tail.size();
+    this->out.close();
+
+    fs::rename(tmp, this->file);
+    this->out.open(this->file, std::ios::binary | std::ios::app);
+}
+
+auto CrashJournalFile::serializePage(uint64_t generation, size_t pageIndex, XojPage& page) -> GString* {
+    ObjectOutputStream stream(new BinObjectEncoding());
+    stream.writeObject("JournalPage");
+    stream.writeSizeT(generation);
+    stream.writeSizeT(pageIndex);
+
+    stream.writeInt(static_cast<int>(page.getLayers()->size()));
+    for (Layer* l: *page.getLayers()) {
+        stream.writeObject("Layer");
+        stream.writeInt(l->hasName());
+        stream.writeString(l->hasName() ? l->getName() : "");
+
+        stream.writeInt(static_cast<int>(l->getElements()->size()));
+        for (Element* e: *l->getElements()) {
+            e->serialize(stream);
+        }
+        stream.endObject();
+    }
+    stream.endObject();
+
+    return stream.getStr();
+}
+
+auto CrashJournalFile::read(const fs::path& journal, Header& header, vector<Record>& records, string& error)
+        -> bool {
+    string data;
+    {
+        std::ifstream in(journal, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    size_t pos = 0;
+    try {
+        ObjectInputStream in;
+        if (!readRecord(data, pos, in)) {
+            error = _("The journal is empty or damaged");
+            return false;
+        }
+
+        in.readObject("CrashJournal");
+        header.base = fs::u8path(in.readString());
+        header.documentPath = fs::u8path(in.readString());
+        header.baseGeneration = in.readSizeT();
+        in.endObject();
+    } catch (InputStreamException& e) {
+        error = e.what();
+        return false;
+    }
+
+    while (true) {
+        ObjectInputStream in;
+        if (!readRecord(data, pos, in)) {
+            break;
+        }
+
+        try {
+            Record record;
+            in.readObject("JournalPage");
+            record.generation = in.readSizeT();
+            record.pageIndex = in.readSizeT();
+            record.layers = readLayers(in);
+            in.endObject();
+
+            records.push_back(std::move(record));
+        } catch (InputStreamException& e) {
+            g_warning("Could not read the crash journal: %s", e.what());
+            break;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,137 @@
+/*
+ * Xournal++
+ *
+ * The file format of the crash journal
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+#include "XournalType.h"
+#include "filesystem.h"
+
+class Layer;
+class XojPage;
+
+/**
+ * @brief Reads and writes the crash journal, see CrashJournal
+ *
+ * The journal is a sequence of records, each prefixed with its length. The first record is the header, which
+ * references the base file, the others contain the layers of a page. All records are encoded with
+ * ObjectOutputStream / BinObjectEncoding.
+ *
+ * Not thread safe, the CrashJournal locks it.
+ */
+class CrashJournalFile {
+public:
+    explicit CrashJournalFile(fs::path file);
+    ~CrashJournalFile();
+
+private:
+    CrashJournalFile(const CrashJournalFile& file);
+    void operator=(const CrashJournalFile& file);
+
+public:
+    struct Header {
+        /**
+         * The file the records are applied to, empty if there is none yet
+         */
+        fs::path base;
+
+        /**
+         * The path of the document, restored after the replay of an autosave
+         */
+        fs::path documentPath;
+
+        /**
+         * Only the records of this layout generation can be applied to the base file
+         */
+        uint64_t baseGeneration = 0;
+    };
+
+    /**
+     * The layers of a page, read from the journal
+     */
+    struct Record {
+        uint64_t generation = 0;
+        size_t pageIndex = 0;
+        vector<std::unique_ptr<Layer>> layers;
+    };
+
+    const fs::path& getFile() const;
+    bool isOpen() const;
+
+    /**
+     * Creates the journal and writes the header
+     *
+     * @return false if the file could not be created
+     */
+    bool open(const Header& header);
+
+    /**
+     * Closes and deletes the journal
+     */
+    void remove();
+
+    /**
+     * Appends a record created by serializePage()
+     */
+    void append(const GString* record);
+
+    /**
+     * Replaces the journal by a new header and the records starting at the offset keepFrom, e.g. after an autosave
+     * which contains the records before
+     */
+    void rewrite(const Header& header, uint64_t keepFrom);
+
+    /**
+     * @return Bytes written to the journal, including the header
+     */
+    uint64_t getSize() const;
+
+    /**
+     * @return Bytes of the header at the start of the journal
+     */
+    uint64_t getHeaderSize() const;
+
+    /**
+     * @return Bytes of the records since the journal was opened or rewritten
+     */
+    uint64_t getRecordSize() const;
+
+    /**
+     * Serializes the layers of the page, called without locking the journal
+     */
+    static GString* serializePage(uint64_t generation, size_t pageIndex, XojPage& page);
+
+    /**
+     * Reads the header and all complete records, a record cut off by a crash ends the journal
+     *
+     * @return false if the header could not be read
+     */
+    static bool read(const fs::path& journal, Header& header, vector<Record>& records, string& error);
+
+private:
+    void writeHeader(const Header& header);
+    void writeRecord(const char* data, size_t length);
+
+private:
+    fs::path file;
+    std::ofstream out;
+
+    uint64_t size = 0;
+    uint64_t headerSize = 0;
+    uint64_t recordSize = 0;
+};
@@ -1,131 +1,226 @@
 #include "PdfCache.h"
 
 #include <algorithm>
-#include <cstdio>
+#include <cmath>
 #include <utility>
 
 class PdfCacheEntry {
 public:
     /**
-     *   Cache [img], the result of rendering [popplerPage] with
-     * the given [zoom].
+     *   Cache the result of rendering the page with id [key.pageId]
+     * at the zoom [key.zoom].
      *  A change in the document's zoom causes a change in the
      * quality of the PDF backgrounds (zoomed in => need a higher
      * quality rendering).
      *
-     * @param popplerPage
-     * @param img is the result of rendering popplerPage
-     * @param zoom is the zoom at which the page was rendered.
+     *  The entry is inserted before it is rendered, [rendered] is
+     * nullptr until the rendering finished.
      */
-    PdfCacheEntry(XojPdfPageSPtr popplerPage, cairo_surface_t* img, double zoom) {
-        this->popplerPage = std::move(popplerPage);
-        this->rendered = img;
-        this->zoom = zoom;
-    }
+    explicit PdfCacheEntry(PdfCacheKey key): key(key) {}
 
     ~PdfCacheEntry() {
-        this->popplerPage = nullptr;
-        cairo_surface_destroy(this->rendered);
-        this->rendered = nullptr;
+        if (this->rendered) {
+            cairo_surface_destroy(this->rendered);
+            this->rendered = nullptr;
+        }
     }
 
-    double zoom;
-    XojPdfPageSPtr popplerPage;
-    cairo_surface_t* rendered;
+    PdfCacheKey key;
+    cairo_surface_t* rendered = nullptr;
+    size_t bytes = 0;
 };
 
-PdfCache::PdfCache(int size) {
-    this->size = size;
+PdfCache::PdfCache(size_t maxBytes): maxBytes(maxBytes) {}
+
+PdfCache::~PdfCache() { clearCache(); }
+
+void PdfCache::setRefreshThreshold(double threshold) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->zoomRefreshThreshold = threshold;
+}
 
-    g_mutex_init(&this->renderMutex);
+void PdfCache::setAnyZoomChangeCausesRecache(bool b) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->zoomClearsCache = b;
 }
 
-PdfCache::~PdfCache() {
-    clearCache();
-    this->size = 0;
+void PdfCache::clearCache() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // Entries which are currently rendered are owned by their renderer until they are done
+    this->entries.clear();
+    this->index.clear();
+    this->pageZoomLevels.clear();
+    this->bytes = 0;
 }
 
-void PdfCache::setZoom(double zoom) { this->zoom = zoom; }
+auto PdfCache::quantizeZoom(double zoom) -> double {
+    // Never render with less than 100% quality
+    zoom = std::max(zoom, 1.0);
 
-void PdfCache::setRefreshThreshold(double threshold) { this->zoomRefreshThreshold = threshold; }
+    if (this->zoomClearsCache || this->zoomRefreshThreshold <= 0) {
+        return zoom;
+    }
 
-void PdfCache::setAnyZoomChangeCausesRecache(bool b) { this->zoomClearsCache = b; }
+    // Zoom levels which differ by the threshold, the page is rendered again only if the zoom moves to another level
+    double step = std::log1p(this->zoomRefreshThreshold / 100.0);
+    return std::max(std::exp(std::round(std::log(zoom) / step) * step), 1.0);
+}
 
-void PdfCache::clearCache() {
-    for (PdfCacheEntry* e: this->data) {
-        delete e;
+void PdfCache::touch(const std::shared_ptr<PdfCacheEntry>& entry) {
+    auto it = this->index.find(entry->key);
+    if (it != this->index.end()) {
+        this->entries.splice(this->entries.begin(), this->entries, it->second);
     }
-    this->data.clear();
 }
 
-auto PdfCache::lookup(const XojPdfPageSPtr& popplerPage) -> PdfCacheEntry* {
-    for (PdfCacheEntry* e: this->data) {
-        if (e->popplerPage->getPageId() == popplerPage->getPageId()) {
-            return e;
+void PdfCache::removeEntry(EntryList::iterator it) {
+    const PdfCacheKey& key = (*it)->key;
+
+    auto levels = this->pageZoomLevels.find(key.pageId);
+    if (levels != this->pageZoomLevels.end()) {
+        vector<double>& zooms = levels->second;
+        zooms.erase(std::remove(zooms.begin(), zooms.end(), key.zoom), zooms.end());
+        if (zooms.empty()) {
+            this->pageZoomLevels.erase(levels);
         }
     }
 
-    return nullptr;
+    this->bytes -= (*it)->bytes;
+    this->index.erase(key);
+    this->entries.erase(it);
 }
 
-PdfCacheEntry* PdfCache::cache(XojPdfPageSPtr popplerPage, cairo_surface_t* img, double zoom) {
-    while (this->data.size() > this->size) {
-        delete this->data.back();
-        this->data.pop_back();
-    }
+void PdfCache::evict() {
+    auto it = this->entries.end();
+    while (this->bytes > this->maxBytes && it != this->entries.begin()) {
+        --it;
 
-    auto* ne = new PdfCacheEntry(std::move(popplerPage), img, zoom);
-    this->data.push_front(ne);
+        // Keep the most recently used entry, and the entries which are not rendered yet
+        if (it == this->entries.begin() || (*it)->rendered == nullptr) {
+            continue;
+        }
 
-    return ne;
+        removeEntry(it++);
+    }
 }
 
-void PdfCache::render(cairo_t* cr, const XojPdfPageSPtr& popplerPage, double zoom) {
-    g_mutex_lock(&this->renderMutex);
+auto PdfCache::findLowResolution(int pageId, double zoom) -> std::shared_ptr<PdfCacheEntry> {
+    auto levels = this->pageZoomLevels.find(pageId);
+    if (levels == this->pageZoomLevels.end()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<PdfCacheEntry> best;
+    for (double level: levels->second) {
+        if (level >= zoom) {
+            continue;
+        }
+
+        auto it = this->index.find({pageId, level});
+        if (it == this->index.end() || (*it->second)->rendered == nullptr) {
+            continue;
+        }
 
-    this->setZoom(zoom);
+        if (!best || best->key.zoom < level) {
+            best = *it->second;
+        }
+    }
 
-    PdfCacheEntry* cacheResult = lookup(popplerPage);
-    bool needsRefresh{cacheResult == nullptr};
+    return best;
+}
 
-    if (cacheResult != nullptr) {
-        double averagedZoom = (this->zoom + cacheResult->zoom) / 2.0;
-        double percentZoomChange = std::abs(cacheResult->zoom - this->zoom) * 100.0 / averagedZoom;
+auto PdfCache::getRendered(std::unique_lock<std::mutex>& lock, const XojPdfPageSPtr& popplerPage, double renderZoom)
+        -> std::shared_ptr<PdfCacheEntry> {
+    PdfCacheKey key{popplerPage->getPageId(), renderZoom};
 
-        // If we do have a cached result, is its rendering quality
-        // acceptable for our current zoom?
-        needsRefresh = this->zoom > 1.0 && percentZoomChange > this->zoomRefreshThreshold
+    auto it = this->index.find(key);
+    if (it != this->index.end()) {
+        std::shared_ptr<PdfCacheEntry> entry = *it->second;
+        touch(entry);
 
-                       // Has the user requested that we **always** clear the cache on zoom?
-                       || this->zoomClearsCache && this->zoom != cacheResult->zoom;
+        // Another thread is rendering the page
+        this->renderedCond.wait(lock, [&entry]() { return entry->rendered != nullptr; });
+        return entry;
     }
 
-    if (needsRefresh) {
-        double renderZoom = std::max(zoom, 1.0);
+    auto entry = std::make_shared<PdfCacheEntry>(key);
+    this->entries.push_front(entry);
+    this->index[key] = this->entries.begin();
+    this->pageZoomLevels[key.pageId].push_back(key.zoom);
+
+    lock.unlock();
+
+    auto* img = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, std::lround(popplerPage->getWidth() * renderZoom),
+                                           std::lround(popplerPage->getHeight() * renderZoom));
+    cairo_t* cr2 = cairo_create(img);
 
-        auto* img = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, popplerPage->getWidth() * renderZoom,
-                                               popplerPage->getHeight() * renderZoom);
-        cairo_t* cr2 = cairo_create(img);
+    cairo_scale(cr2, renderZoom, renderZoom);
+    popplerPage->render(cr2, false);
+    cairo_destroy(cr2);
 
-        cairo_scale(cr2, renderZoom, renderZoom);
-        popplerPage->render(cr2, false);
-        cairo_destroy(cr2);
+    lock.lock();
 
-        cacheResult = cache(popplerPage, img, renderZoom);
+    entry->rendered = img;
+    entry->bytes = static_cast<size_t>(cairo_image_surface_get_stride(img)) *
+                   static_cast<size_t>(cairo_image_surface_get_height(img));
+
+    // The cache may have been cleared in the meantime
+    auto current = this->index.find(key);
+    if (current != this->index.end() && *current->second == entry) {
+        this->bytes += entry->bytes;
+        evict();
     }
 
+    this->renderedCond.notify_all();
+
+    return entry;
+}
+
+void PdfCache::paint(cairo_t* cr, cairo_surface_t* img, double renderZoom, double zoom) {
     cairo_matrix_t mOriginal;
     cairo_matrix_t mScaled;
     cairo_get_matrix(cr, &mOriginal);
     cairo_get_matrix(cr, &mScaled);
-    mScaled.xx = this->zoom / cacheResult->zoom;
-    mScaled.yy = this->zoom / cacheResult->zoom;
+    mScaled.xx = zoom / renderZoom;
+    mScaled.yy = zoom / renderZoom;
     mScaled.xy = 0;
     mScaled.yx = 0;
     cairo_set_matrix(cr, &mScaled);
-    cairo_set_source_surface(cr, cacheResult->rendered, 0, 0);
+    cairo_set_source_surface(cr, img, 0, 0);
     cairo_paint(cr);
     cairo_set_matrix(cr, &mOriginal);
+}
+
+auto PdfCache::render(cairo_t* cr, const XojPdfPageSPtr& popplerPage, double zoom, bool allowLowResolution) -> bool {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    double renderZoom = quantizeZoom(zoom);
+    int pageId = popplerPage->getPageId();
+
+    std::shared_ptr<PdfCacheEntry> entry;
+    bool exact = true;
+
+    auto it = this->index.find({pageId, renderZoom});
+    bool cached = it != this->index.end() && (*it->second)->rendered != nullptr;
+
+    if (!cached && allowLowResolution) {
+        entry = findLowResolution(pageId, renderZoom);
+        if (entry) {
+            touch(entry);
+        } else {
+            // Quick to render, the quality is not important
+            entry = getRendered(lock, popplerPage, std::min(LOW_RESOLUTION_ZOOM, renderZoom));
+        }
+        exact = entry->key.zoom == renderZoom;
+    } else {
+        entry = getRendered(lock, popplerPage, renderZoom);
+    }
+
+    // The entry keeps the surface alive even if it is evicted meanwhile
+    lock.unlock();
+
+    paint(cr, entry->rendered, entry->key.zoom, zoom);
 
-    g_mutex_unlock(&this->renderMutex);
+    return exact;
 }
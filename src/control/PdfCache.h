@@ -11,22 +11,59 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <cairo.h>
 
 #include "pdf/base/XojPdfPage.h"
+#include "util/hashcombine.h"
 
 #include "XournalType.h"
-using std::list;
+
+/**
+ * Identifies a rendered PDF page at a (quantized) zoom level
+ */
+struct PdfCacheKey {
+    int pageId;
+    double zoom;
+
+    bool operator==(const PdfCacheKey& other) const { return pageId == other.pageId && zoom == other.zoom; }
+};
+
+namespace std {
+template <>
+class hash<PdfCacheKey> {
+public:
+    size_t operator()(PdfCacheKey const& key) const {
+        size_t seed = 0;
+        boost_c::hash_combine(seed, key.pageId);
+        boost_c::hash_combine(seed, key.zoom);
+        return seed;
+    }
+};
+}  // namespace std
 
 class PdfCacheEntry;
 
+/**
+ * @brief Least recently used cache of rendered PDF pages, bounded by the memory used
+ *
+ * A page can be cached at several zoom levels. The pages are rendered outside of the cache lock, so lookups of cached
+ * pages do not wait for rendering (poppler itself renders one page of a document at a time). Threads requesting a
+ * page which is currently rendered wait for it.
+ */
 class PdfCache {
 public:
-    PdfCache(int size);
+    /**
+     * @param maxBytes The memory budget of the cache
+     */
+    explicit PdfCache(size_t maxBytes);
     virtual ~PdfCache();
 
 private:
@@ -34,7 +71,14 @@ private:
     void operator=(const PdfCache& cache);
 
 public:
-    void render(cairo_t* cr, const XojPdfPageSPtr& popplerPage, double zoom);
+    /**
+     * Paints the page, rendering it if it is not cached at a suitable zoom level
+     *
+     * @param allowLowResolution If the page is not cached at the zoom level, paint a lower resolution version of the
+     * page (rendered quickly if needed) instead of waiting for the page to render
+     * @return false if a lower resolution version of the page was painted
+     */
+    bool render(cairo_t* cr, const XojPdfPageSPtr& popplerPage, double zoom, bool allowLowResolution = false);
     void clearCache();
 
 public:
@@ -54,17 +98,58 @@ public:
     void setRefreshThreshold(double percentDifference);
 
 private:
-    void setZoom(double zoom);
-    PdfCacheEntry* lookup(const XojPdfPageSPtr& popplerPage);
-    PdfCacheEntry* cache(XojPdfPageSPtr popplerPage, cairo_surface_t* img, double zoom);
+    using EntryList = std::list<std::shared_ptr<PdfCacheEntry>>;
+
+    /**
+     * @return The zoom level the page is rendered at for the requested zoom
+     */
+    double quantizeZoom(double zoom);
+
+    /**
+     * Returns the rendered entry, renders it if needed. Called with the lock held, the lock is released while
+     * rendering.
+     */
+    std::shared_ptr<PdfCacheEntry> getRendered(std::unique_lock<std::mutex>& lock, const XojPdfPageSPtr& popplerPage,
+                                               double renderZoom);
+
+    /**
+     * Returns the rendered entry of the page with the highest zoom below the given zoom, or nullptr
+     */
+    std::shared_ptr<PdfCacheEntry> findLowResolution(int pageId, double zoom);
+
+    void touch(const std::shared_ptr<PdfCacheEntry>& entry);
+    void removeEntry(EntryList::iterator it);
+    void evict();
+
+    static void paint(cairo_t* cr, cairo_surface_t* img, double renderZoom, double zoom);
 
 private:
-    GMutex renderMutex{};
+    /**
+     * Zoom of the fallback rendering, if no lower resolution version of the page is cached
+     */
+    static constexpr double LOW_RESOLUTION_ZOOM = 0.5;
+
+    std::mutex mutex;
+
+    /**
+     * Notified if an entry finished rendering
+     */
+    std::condition_variable renderedCond;
+
+    /**
+     * Most recently used entries first
+     */
+    EntryList entries;
+    std::unordered_map<PdfCacheKey, EntryList::iterator> index;
+
+    /**
+     * The zoom levels cached of each page
+     */
+    std::unordered_map<int, vector<double>> pageZoomLevels;
 
-    list<PdfCacheEntry*> data;
-    list<PdfCacheEntry*>::size_type size = 0;
+    size_t bytes = 0;
+    size_t maxBytes;
 
-    double zoom = -1;
-    double zoomRefreshThreshold;
+    double zoomRefreshThreshold = 0;
     bool zoomClearsCache = true;
 };
@@ -19,6 +19,8 @@
 #include "xojfile/LoadHandler.h"
 
 #include "Control.h"
+#include "CrashJournal.h"
+#include "LatencyTracer.h"
 #include "Stacktrace.h"
 #include "StringUtils.h"
 #include "XojMsgBox.h"
@@ -51,6 +53,7 @@ auto migrateSettings() -> MigrateResult;
 
 void checkForErrorlog();
 void checkForEmergencySave(Control* control);
+void checkForCrashJournal(Control* control);
 
 auto exportPdf(const char* input, const char* output, const char* range, ExportBackgroundType exportBackground,
                bool progressiveMode) -> int;
@@ -229,6 +232,41 @@ void checkForEmergencySave(Control* control) {
     gtk_widget_destroy(dialog);
 }
 
+void checkForCrashJournal(Control* control) {
+    for (auto const& journal: CrashJournal::findJournals()) {
+        // The journal stays locked until it is deleted or restored, so other instances do not offer it as well
+        string msg = _("Xournal++ crashed last time. Would you like to restore the changes from the crash journal?");
+
+        GtkWidget* dialog = gtk_message_dialog_new(nullptr, GTK_DIALOG_MODAL, GTK_MESSAGE_QUESTION, GTK_BUTTONS_NONE,
+                                                   "%s", msg.c_str());
+
+        gtk_dialog_add_button(GTK_DIALOG(dialog), _("Delete journal"), 1);
+        gtk_dialog_add_button(GTK_DIALOG(dialog), _("Restore changes"), 2);
+
+        int res = gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+
+        if (res == 1)  // Delete journal
+        {
+            journal->removeJournal();
+        } else if (res == 2)  // Restore changes
+        {
+            string error;
+            if (CrashJournal::replay(control, journal->getJournal(), error)) {
+                // Make sure the document is changed, there is a question to ask for save
+                control->getUndoRedoHandler()->addUndoAction(std::make_unique<EmergencySaveRestore>());
+                control->updateWindowTitle();
+                journal->removeJournal();
+
+                // Only one document can be restored
+                return;
+            }
+
+            XojMsgBox::showErrorToUser(nullptr, FS(_F("Could not restore the crash journal: {1}") % error));
+        }
+    }
+}
+
 /**
  * @brief Export the input file as a bunch of image files (one per page)
  * @param input Path to the input file
@@ -365,6 +403,7 @@ struct XournalMainPrivate {
         g_strfreev(optFilename);
         g_free(pdfFilename);
         g_free(imgFilename);
+        g_free(latencyTraceFilename);
     }
 
     gchar** optFilename{};
@@ -379,6 +418,7 @@ struct XournalMainPrivate {
     gboolean exportNoBackground = false;
     gboolean exportNoRuling = false;
     gboolean progressiveMode = false;
+    gchar* latencyTraceFilename{};
     std::unique_ptr<GladeSearchpath> gladePath;
     std::unique_ptr<Control> control;
     std::unique_ptr<MainWindow> win;
@@ -567,6 +607,7 @@ void on_startup(GApplication* application, XMPtr app_data) {
 
     checkForErrorlog();
     checkForEmergencySave(app_data->control.get());
+    checkForCrashJournal(app_data->control.get());
 
     // There is a timing issue with the layout
     // This fixes it, see #405
@@ -583,6 +624,10 @@ auto on_handle_local_options(GApplication*, GVariantDict*, XMPtr app_data) -> gi
         return 0;
     }
 
+    if (app_data->latencyTraceFilename) {
+        LatencyTracer::getInstance().setEnabled(true);
+    }
+
     if (app_data->pdfFilename && app_data->optFilename && *app_data->optFilename) {
         return exportPdf(*app_data->optFilename, app_data->pdfFilename, app_data->exportRange,
                          app_data->exportNoBackground ? EXPORT_BACKGROUND_NONE :
@@ -605,6 +650,10 @@ void on_shutdown(GApplication*, XMPtr app_data) {
     app_data->win->getXournal()->clearSelection();
     app_data->control->getScheduler()->stop();
     ToolbarColorNames::getInstance().save();
+
+    if (app_data->latencyTraceFilename && !LatencyTracer::getInstance().writeReport(app_data->latencyTraceFilename)) {
+        g_warning("Could not write the latency trace to \"%s\"", app_data->latencyTraceFilename);
+    }
 }
 
 }  // namespace
@@ -626,6 +675,9 @@ auto XournalMain::run(int argc, char** argv) -> int {
                                        "<input>", nullptr},
                           GOptionEntry{"version", 0, 0, G_OPTION_ARG_NONE, &app_data.showVersion,
                                        _("Get version of xournalpp"), nullptr},
+                          GOptionEntry{"trace-latency", 0, 0, G_OPTION_ARG_FILENAME, &app_data.latencyTraceFilename,
+                                       _("Measure the latency of the pen input and write it to FILE on exit"),
+                                       "FILE"},
                           GOptionEntry{nullptr}};  // Must be terminated by a nullptr. See gtk doc
     g_application_add_main_option_entries(G_APPLICATION(app), options.data());
 
@@ -1,8 +1,10 @@
 #include "AutosaveJob.h"
 
 #include "control/Control.h"
+#include "control/CrashJournal.h"
 #include "control/xojfile/SaveHandler.h"
 
+#include "PathUtil.h"
 #include "XojMsgBox.h"
 #include "filesystem.h"
 #include "i18n.h"
@@ -24,10 +26,14 @@ void AutosaveJob::run() {
 
     Document* doc = control->getDocument();
 
-    doc->lock();
-    handler.prepareSave(doc);
+    // Only the changed pages are copied while the document is locked, they are serialized in saveTo().
+    // Pages can be changed while the others are copied, so the journal is marked before: the records of these
+    // changes are kept, even if the change is also part of the autosave.
+    doc->lockShared();
+    CrashJournal::Mark journalMark = control->getCrashJournal()->mark();
+    handler.prepareSave(doc, control->getSaveCache());
     auto filepath = doc->getFilepath();
-    doc->unlock();
+    doc->unlockShared();
 
     if (filepath.empty()) {
         filepath = Util::getAutosaveFilepath();
@@ -37,19 +43,39 @@ void AutosaveJob::run() {
     Util::clearExtensions(filepath);
     filepath += ".autosave.xopp";
 
-    control->renameLastAutosaveFile();
-
     g_message("%s", FS(_F("Autosaving to {1}") % filepath.string()).c_str());
 
-    handler.saveTo(filepath);
+    // The previous autosave, which may be the base of the crash journal, is only replaced once the new one was
+    // written completely
+    fs::path tmpfile = filepath;
+    tmpfile += ".tmp";
+
+    // Autosaves are only read after a crash, they can be compressed faster
+    handler.setCompressionLevel(control->getSettings()->getAutosaveCompressionLevel());
+    handler.saveTo(tmpfile, filepath, nullptr);
 
     this->error = handler.getErrorMessage();
     if (!this->error.empty()) {
+        fs::remove(tmpfile);
+        control->getCrashJournal()->compactionFailed();
         callAfterRun();
-    } else {
-        // control->deleteLastAutosaveFile(filepath);
-        control->setLastAutosaveFile(filepath);
+        return;
+    }
+
+    control->getCrashJournal()->compacted(tmpfile, journalMark);
+    control->renameLastAutosaveFile();
+
+    try {
+        Util::safeRenameFile(tmpfile, filepath);
+    } catch (fs::filesystem_error const& e) {
+        // The journal still refers to the temporary file
+        this->error = e.what();
+        callAfterRun();
+        return;
     }
+
+    control->getCrashJournal()->baseMoved(filepath);
+    control->setLastAutosaveFile(filepath);
 }
 
 auto AutosaveJob::getType() -> JobType { return JOB_TYPE_AUTOSAVE; }
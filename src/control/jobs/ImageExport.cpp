@@ -7,8 +7,13 @@
 
 #include "control/jobs/ProgressListener.h"
 #include "model/Document.h"
+#include "model/Layer.h"
+#include "model/Stroke.h"
+#include "model/TexImage.h"
+#include "view/DocumentView.h"
 #include "view/PdfView.h"
 
+#include "ParallelUtil.h"
 #include "Util.h"
 #include "i18n.h"
 
@@ -46,51 +51,47 @@ auto ImageExport::getLastErrorMsg() const -> string { return lastError; }
  * @param height the height of the page being exported
  * @param id the id of the page being exported
  * @param zoomRatio the zoom ratio for PNG exports with fixed DPI
+ *          The value is updated if the export has fixed page width or height (in pixels). In this case, the zoomRatio
+ * (and the DPI) is page-dependent as soon as the document has pages of different sizes.
  *
- * @return the zoom ratio of the current page if the export type is PNG, 0.0 otherwise
- *          The return value may differ from that of the parameter zoomRatio if the export has fixed page width or
- * height (in pixels). In this case, the zoomRatio (and the DPI) is page-dependent as soon as the document has pages of
- * different sizes.
+ * @return The surface
  */
-auto ImageExport::createSurface(double width, double height, int id, double zoomRatio) -> double {
+auto ImageExport::createSurface(double width, double height, int id, double& zoomRatio) const -> cairo_surface_t* {
+    cairo_surface_t* surface = nullptr;
     switch (this->format) {
         case EXPORT_GRAPHICS_PNG:
             switch (this->qualityParameter.getQualityCriterion()) {
                 case EXPORT_QUALITY_WIDTH:
                     zoomRatio = ((double)this->qualityParameter.getValue()) / width;
-                    this->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, this->qualityParameter.getValue(),
-                                                               (int)std::round(height * zoomRatio));
+                    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, this->qualityParameter.getValue(),
+                                                         (int)std::round(height * zoomRatio));
                     break;
                 case EXPORT_QUALITY_HEIGHT:
                     zoomRatio = ((double)this->qualityParameter.getValue()) / height;
-                    this->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)std::round(width * zoomRatio),
-                                                               this->qualityParameter.getValue());
+                    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)std::round(width * zoomRatio),
+                                                         this->qualityParameter.getValue());
                     break;
                 case EXPORT_QUALITY_DPI:  // Use the zoomRatio given as argument
-                    this->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)std::round(width * zoomRatio),
-                                                               (int)std::round(height * zoomRatio));
+                    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int)std::round(width * zoomRatio),
+                                                         (int)std::round(height * zoomRatio));
                     break;
             }
-            this->cr = cairo_create(this->surface);
-            cairo_scale(this->cr, zoomRatio, zoomRatio);
-            return zoomRatio;
+            break;
         case EXPORT_GRAPHICS_SVG:
-            this->surface = cairo_svg_surface_create(getFilenameWithNumber(id).u8string().c_str(), width, height);
-            cairo_svg_surface_restrict_to_version(this->surface, CAIRO_SVG_VERSION_1_2);
-            this->cr = cairo_create(this->surface);
+            surface = cairo_svg_surface_create(getFilenameWithNumber(id).u8string().c_str(), width, height);
+            cairo_svg_surface_restrict_to_version(surface, CAIRO_SVG_VERSION_1_2);
+            zoomRatio = 1.0;
             break;
         default:
             g_error("Unsupported graphics format: %i", this->format);
     }
-    return 0.0;
+    return surface;
 }
 
 /**
  * Free / store the surface
  */
-auto ImageExport::freeSurface(int id) -> bool {
-    cairo_destroy(this->cr);
-
+auto ImageExport::freeSurface(cairo_surface_t* surface, int id) const -> bool {
     cairo_status_t status = CAIRO_STATUS_SUCCESS;
     if (format == EXPORT_GRAPHICS_PNG) {
         auto filepath = getFilenameWithNumber(id);
@@ -124,45 +125,67 @@ auto ImageExport::getFilenameWithNumber(int no) const -> fs::path {
 
 /**
  * @brief Export a single PNG/SVG page
- * @param pageId The index of the page being exported
+ * Called from several threads at the same time, each page is written to its own file
+ *
+ * @param page The snapshot of the page being exported
  * @param id The number of the page being exported
  * @param zoomRatio The zoom ratio for PNG exports with fixed DPI
- * @param format The format of the exported image
- * @param view A DocumentView for drawing the page
+ *
+ * @return The error message, empty on success
  */
-void ImageExport::exportImagePage(int pageId, int id, double zoomRatio, ExportGraphicsFormat format,
-                                  DocumentView& view) {
-    doc->lock();
-    PageRef page = doc->getPage(pageId);
-    doc->unlock();
+auto ImageExport::exportImagePage(const PageRef& page, int id, double zoomRatio) const -> string {
+    cairo_surface_t* surface = createSurface(page->getWidth(), page->getHeight(), id, zoomRatio);
 
-    zoomRatio = createSurface(page->getWidth(), page->getHeight(), id, zoomRatio);
-
-    cairo_status_t state = cairo_surface_status(this->surface);
+    cairo_status_t state = cairo_surface_status(surface);
     if (state != CAIRO_STATUS_SUCCESS) {
-        this->lastError = _("Error save image #1");
-        return;
+        cairo_surface_destroy(surface);
+        return _("Error save image #1");
     }
 
+    cairo_t* cr = cairo_create(surface);
+    cairo_scale(cr, zoomRatio, zoomRatio);
+
     if (page->getBackgroundType().isPdfPage() && (exportBackground >= EXPORT_BACKGROUND_UNRULED)) {
         int pgNo = page->getPdfPageNr();
+        doc->lockShared();
         XojPdfPageSPtr popplerPage = doc->getPdfPage(pgNo);
+        doc->unlockShared();
 
         PdfView::drawPage(nullptr, popplerPage, cr, zoomRatio, page->getWidth(), page->getHeight());
     }
 
-    view.drawPage(page, this->cr, true, exportBackground == EXPORT_BACKGROUND_NONE,
-                  exportBackground == EXPORT_BACKGROUND_NONE, exportBackground <= EXPORT_BACKGROUND_UNRULED);
+    // Each thread needs its own view, the view keeps the drawing state
+    DocumentView view;
+    view.drawPage(page, cr, true, exportBackground == EXPORT_BACKGROUND_NONE, exportBackground == EXPORT_BACKGROUND_NONE,
+                  exportBackground <= EXPORT_BACKGROUND_UNRULED);
+
+    cairo_destroy(cr);
+
+    // The snapshot is kept until the export is finished, but its strokes and formulas are not drawn again
+    if (page->isContentLoaded()) {
+        for (Layer* layer: *page->getLayers()) {
+            for (Element* e: *layer->getElements()) {
+                if (e->getType() == ELEMENT_STROKE) {
+                    dynamic_cast<Stroke*>(e)->resetRenderCache();
+                } else if (e->getType() == ELEMENT_TEXIMAGE) {
+                    dynamic_cast<TexImage*>(e)->releaseRaster();
+                }
+            }
+        }
+    }
 
-    if (!freeSurface(id)) {
+    if (!freeSurface(surface, id)) {
         // could not create this file...
-        this->lastError = _("Error save image #2");
-        return;
+        return _("Error save image #2");
     }
+
+    return "";
 }
 
 /**
  * @brief Create one Graphics file per page
+ * The pages are rendered concurrently, one thread per CPU core
+ *
  * @param stateListener A listener to track the export progress
  */
 void ImageExport::exportGraphics(ProgressListener* stateListener) {
@@ -173,19 +196,26 @@ void ImageExport::exportGraphics(ProgressListener* stateListener) {
     bool onePage =
             ((this->exportRange.size() == 1) && (this->exportRange[0]->getFirst() == this->exportRange[0]->getLast()));
 
-    char selectedPages[count];
-    int selectedCount = 0;
-    for (int i = 0; i < count; i++) {
-        selectedPages[i] = 0;
-    }
+    vector<bool> selectedPages(count, false);
     for (PageRangeEntry* e: this->exportRange) {
         for (int x = e->getFirst(); x <= e->getLast(); x++) {
-            selectedPages[x] = 1;
-            selectedCount++;
+            if (x >= 0 && x < count) {
+                selectedPages[x] = true;
+            }
         }
     }
 
-    stateListener->setMaximumState(selectedCount);
+    // Snapshots of the pages and the number appended to their filename, the pages are drawn without lock
+    vector<std::pair<PageRef, int>> pages;
+    doc->lockShared();
+    for (int i = 0; i < count; i++) {
+        if (selectedPages[i]) {
+            pages.emplace_back(doc->getPageSnapshot(i), onePage ? -1 : i + 1);
+        }
+    }
+    doc->unlockShared();
+
+    stateListener->setMaximumState(static_cast<int>(pages.size()));
 
     /*
      * Compute the zoomRatio only once if using DPI as a PNG quality criterion
@@ -195,21 +225,16 @@ void ImageExport::exportGraphics(ProgressListener* stateListener) {
         zoomRatio = ((double)this->qualityParameter.getValue()) / Util::DPI_NORMALIZATION_FACTOR;
     }
 
-    DocumentView view;
-    int current = 0;
-
-    for (int i = 0; i < count; i++) {
-        int id = i + 1;
-        if (onePage) {
-            id = -1;
-        }
-
-        if (selectedPages[i]) {
-            stateListener->setCurrentState(current++);
-
-            exportImagePage(i, id, zoomRatio, format, view);
-        }
-    }
+    unsigned int threads = Util::getParallelThreadCount();
+    Util::orderedParallelFor(
+            pages.size(), threads, threads,
+            [&](size_t i) { return exportImagePage(pages[i].first, pages[i].second, zoomRatio); },
+            [&](size_t i, const string& error) {
+                if (!error.empty()) {
+                    this->lastError = error;
+                }
+                stateListener->setCurrentState(static_cast<int>(i + 1));
+            });
 }
 
 RasterImageQualityParameter::RasterImageQualityParameter() = default;
@@ -217,6 +242,6 @@ RasterImageQualityParameter::RasterImageQualityParameter(ExportQualityCriterion
         qualityCriterion(criterion), value(value) {}
 RasterImageQualityParameter::~RasterImageQualityParameter() = default;
 
-auto RasterImageQualityParameter::getQualityCriterion() -> ExportQualityCriterion { return qualityCriterion; }
+auto RasterImageQualityParameter::getQualityCriterion() const -> ExportQualityCriterion { return qualityCriterion; }
 
-auto RasterImageQualityParameter::getValue() -> int { return value; }
+auto RasterImageQualityParameter::getValue() const -> int { return value; }
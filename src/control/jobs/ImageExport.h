@@ -16,7 +16,7 @@
 
 #include <gtk/gtk.h>
 
-#include "view/DocumentView.h"
+#include "model/PageRef.h"
 
 #include "BaseExportJob.h"
 #include "PageRange.h"
@@ -47,13 +47,13 @@ public:
      * @brief Get the quality criterion of this parameter
      * @return The quality criterion
      */
-    ExportQualityCriterion getQualityCriterion();
+    ExportQualityCriterion getQualityCriterion() const;
 
     /**
      * @brief Get the target value of this parameter
      * @return The target value
      */
-    int getValue();
+    int getValue() const;
 
 private:
     /**
@@ -105,17 +105,16 @@ private:
      * @param height the height of the page being exported
      * @param id the id of the page being exported
      * @param zoomRatio the zoom ratio for PNG exports with fixed DPI
+     *          The value is updated if the export has fixed page width or height (in pixels)
      *
-     * @return the zoom ratio of the current page if the export type is PNG, 0.0 otherwise
-     *          The return value may differ from that of the parameter zoomRatio
-     *          if the export has fixed page width or height (in pixels)
+     * @return The surface
      */
-    double createSurface(double width, double height, int id, double zoomRatio);
+    cairo_surface_t* createSurface(double width, double height, int id, double& zoomRatio) const;
 
     /**
      * Free / store the surface
      */
-    bool freeSurface(int id);
+    bool freeSurface(cairo_surface_t* surface, int id) const;
 
     /**
      * @brief Get a filename with a (page) number appended
@@ -128,13 +127,15 @@ private:
 
     /**
      * @brief Export a single PNG/SVG page
-     * @param pageId The index of the page being exported
+     * Called from several threads at the same time, each page is written to its own file
+     *
+     * @param page The snapshot of the page being exported
      * @param id The number of the page being exported
      * @param zoomRatio The zoom ratio for PNG exports with fixed DPI
-     * @param format The format of the exported image
-     * @param view A DocumentView for drawing the page
+     *
+     * @return The error message, empty on success
      */
-    void exportImagePage(int pageId, int id, double zoomRatio, ExportGraphicsFormat format, DocumentView& view);
+    string exportImagePage(const PageRef& page, int id, double zoomRatio) const;
 
 public:
     /**
@@ -167,16 +168,6 @@ public:
      */
     RasterImageQualityParameter qualityParameter = RasterImageQualityParameter();
 
-    /**
-     * Export surface
-     */
-    cairo_surface_t* surface = nullptr;
-
-    /**
-     * Cairo context
-     */
-    cairo_t* cr = nullptr;
-
     /**
      * The last error message to show to the user
      */
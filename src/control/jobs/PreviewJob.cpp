@@ -68,7 +68,8 @@ void PreviewJob::drawPage() {
     PreviewRenderType type = this->sidebarPreview->getRenderType();
     int layer;
 
-    doc->lock();
+    doc->lockShared();
+    page->lockShared();
 
     // getLayer is not defined for page preview
     if (type != RENDER_TYPE_PAGE_PREVIEW) {
@@ -131,7 +132,8 @@ void PreviewJob::drawPage() {
     }
 
     cairo_destroy(cr2);
-    doc->unlock();
+    page->unlockShared();
+    doc->unlockShared();
 }
 
 void PreviewJob::clipToPage() {
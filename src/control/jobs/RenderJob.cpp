@@ -1,10 +1,9 @@
 #include "RenderJob.h"
 
-#include <cmath>
-
 #include "control/Control.h"
 #include "control/ToolHandler.h"
 #include "gui/PageView.h"
+#include "gui/TileCache.h"
 #include "gui/XournalView.h"
 #include "model/Document.h"
 #include "view/DocumentView.h"
@@ -17,124 +16,96 @@ RenderJob::RenderJob(XojPageView* view): view(view) {}
 
 auto RenderJob::getSource() -> void* { return this->view; }
 
-void RenderJob::rerenderRectangle(Rectangle<double> const& rect) {
-    double zoom = view->xournal->getZoom();
+auto RenderJob::renderTile(const TileKey& key, bool allowLowResolution) -> bool {
     Document* doc = view->xournal->getDocument();
-    doc->lock();
-    double pageWidth = view->page->getWidth();
-    double pageHeight = view->page->getHeight();
-    doc->unlock();
+    PageRef page = view->page;
+    doc->lockShared();
+    double pageWidth = page->getWidth();
+    double pageHeight = page->getHeight();
+    doc->unlockShared();
+
+    int width = 0;
+    int height = 0;
+    TileCache::tileSize(key, pageWidth, pageHeight, width, height);
+    if (width <= 0 || height <= 0) {
+        return true;
+    }
 
-    auto x = int(std::lround(rect.x * zoom));
-    auto y = int(std::lround(rect.y * zoom));
-    auto width = int(std::lround(rect.width * zoom));
-    auto height = int(std::lround(rect.height * zoom));
+    Rectangle<double> area = TileCache::tileArea(key);
 
-    cairo_surface_t* rectBuffer = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
-    cairo_t* crRect = cairo_create(rectBuffer);
-    cairo_translate(crRect, -x, -y);
-    cairo_scale(crRect, zoom, zoom);
+    cairo_surface_t* tile = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cairo_t* crTile = cairo_create(tile);
+    cairo_translate(crTile, -key.col * TileCache::TILE_SIZE, -key.row * TileCache::TILE_SIZE);
+    cairo_scale(crTile, key.zoom, key.zoom);
 
     DocumentView v;
     Control* control = view->getXournal()->getControl();
     v.setMarkAudioStroke(control->getToolHandler()->getToolType() == TOOL_PLAY_OBJECT);
-    v.limitArea(rect.x, rect.y, rect.width, rect.height);
+    v.limitArea(area.x, area.y, area.width, area.height);
+    v.setAllowIncompleteImages(allowLowResolution);
 
-    bool backgroundVisible = view->page->isLayerVisible(0);
-    if (backgroundVisible && view->page->getBackgroundType().isPdfPage()) {
-        int pgNo = view->page->getPdfPageNr();
+    bool exact = true;
+    bool backgroundVisible = page->isLayerVisible(0);
+    if (backgroundVisible && page->getBackgroundType().isPdfPage()) {
+        int pgNo = page->getPdfPageNr();
         XojPdfPageSPtr popplerPage = doc->getPdfPage(pgNo);
         PdfCache* cache = view->xournal->getCache();
-        PdfView::drawPage(cache, popplerPage, crRect, zoom, pageWidth, pageHeight);
+        exact = PdfView::drawPage(cache, popplerPage, crTile, key.zoom, pageWidth, pageHeight, false,
+                                  allowLowResolution);
     }
 
-    doc->lock();
-    v.drawPage(view->page, crRect, false);
-    doc->unlock();
-
-    cairo_destroy(crRect);
+    // Only this page is locked, other pages can be changed while rendering
+    doc->lockShared();
+    page->lockShared();
+    v.drawPage(page, crTile, false);
+    page->unlockShared();
+    doc->unlockShared();
 
-    g_mutex_lock(&view->drawingMutex);
+    exact = exact && !v.hasIncompleteImages();
 
-    cairo_t* crPageBuffer = cairo_create(view->crBuffer);
+    cairo_destroy(crTile);
 
-    cairo_set_operator(crPageBuffer, CAIRO_OPERATOR_SOURCE);
-    cairo_set_source_surface(crPageBuffer, rectBuffer, x, y);
-    cairo_rectangle(crPageBuffer, x, y, width, height);
-    cairo_fill(crPageBuffer);
+    view->xournal->getTileCache()->insert(key, tile);
 
-    cairo_destroy(crPageBuffer);
-
-    cairo_surface_destroy(rectBuffer);
-
-    g_mutex_unlock(&view->drawingMutex);
+    return exact;
 }
 
 void RenderJob::run() {
-    double zoom = this->view->xournal->getZoom();
+    double zoom = this->view->xournal->getZoom() * this->view->xournal->getDpiScaleFactor();
 
     g_mutex_lock(&this->view->repaintRectMutex);
 
-    bool rerenderComplete = this->view->rerenderComplete;
-    auto rerenderRects = std::move(this->view->rerenderRects);
-
-    this->view->rerenderComplete = false;
+    vector<TileKey> tiles(this->view->pendingTiles.begin(), this->view->pendingTiles.end());
+    this->view->renderingTiles.insert(this->view->pendingTiles.begin(), this->view->pendingTiles.end());
+    this->view->pendingTiles.clear();
 
     g_mutex_unlock(&this->view->repaintRectMutex);
 
-    int dpiScaleFactor = this->view->xournal->getDpiScaleFactor();
-
-    if (rerenderComplete || dpiScaleFactor > 1) {
-        Document* doc = this->view->xournal->getDocument();
-
-        int dispWidth = this->view->getDisplayWidth();
-        int dispHeight = this->view->getDisplayHeight();
-
-        dispWidth *= dpiScaleFactor;
-        dispHeight *= dpiScaleFactor;
-        zoom *= dpiScaleFactor;
-
-        cairo_surface_t* crBuffer = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, dispWidth, dispHeight);
-        cairo_t* cr2 = cairo_create(crBuffer);
-        cairo_scale(cr2, zoom, zoom);
-
-        XojPdfPageSPtr popplerPage;
-
-        doc->lock();
-
-        if (this->view->page->getBackgroundType().isPdfPage()) {
-            int pgNo = this->view->page->getPdfPageNr();
-            popplerPage = doc->getPdfPage(pgNo);
+    // Show the tiles with a low resolution PDF background and images first, if they are not ready at this zoom yet
+    vector<TileKey> lowResolutionTiles;
+    for (TileKey const& key: tiles) {
+        // The zoom changed since the tile was requested, the tiles of the new zoom are requested by the next paint
+        if (key.zoom != zoom) {
+            continue;
         }
-
-        Control* control = view->getXournal()->getControl();
-        DocumentView localView;
-        localView.setMarkAudioStroke(control->getToolHandler()->getToolType() == TOOL_PLAY_OBJECT);
-        int width = this->view->page->getWidth();
-        int height = this->view->page->getHeight();
-
-        bool backgroundVisible = this->view->page->isLayerVisible(0);
-        if (backgroundVisible) {
-            PdfView::drawPage(this->view->xournal->getCache(), popplerPage, cr2, zoom, width, height);
+        if (!renderTile(key, true)) {
+            lowResolutionTiles.push_back(key);
         }
-        localView.drawPage(this->view->page, cr2, false);
-
-        cairo_destroy(cr2);
+    }
 
-        g_mutex_lock(&this->view->drawingMutex);
+    if (!lowResolutionTiles.empty()) {
+        repaintWidget(this->view->getXournal()->getWidget());
 
-        if (this->view->crBuffer) {
-            cairo_surface_destroy(this->view->crBuffer);
+        for (TileKey const& key: lowResolutionTiles) {
+            renderTile(key, false);
         }
-        this->view->crBuffer = crBuffer;
+    }
 
-        g_mutex_unlock(&this->view->drawingMutex);
-        doc->unlock();
-    } else {
-        for (Rectangle<double> const& rect: rerenderRects) {
-            rerenderRectangle(rect);
-        }
+    g_mutex_lock(&this->view->repaintRectMutex);
+    for (TileKey const& key: tiles) {
+        this->view->renderingTiles.erase(key);
     }
+    g_mutex_unlock(&this->view->repaintRectMutex);
 
     // Schedule a repaint of the widget
     repaintWidget(this->view->getXournal()->getWidget());
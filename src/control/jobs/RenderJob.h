@@ -1,7 +1,7 @@
 /*
  * Xournal++
  *
- * A job which redraws a page or a page region
+ * A job which renders the requested tiles of a page
  *
  * @author Xournal++ Team
  * https://github.com/xournalpp/xournalpp
@@ -21,6 +21,7 @@
 #include "XournalType.h"
 
 class XojPageView;
+struct TileKey;
 
 class RenderJob: public Job {
 public:
@@ -42,7 +43,14 @@ private:
      */
     static void repaintWidget(GtkWidget* widget);
 
-    void rerenderRectangle(Rectangle<double> const& rect);
+    /**
+     * Renders the tile and adds it to the tile cache
+     *
+     * @param allowLowResolution Use a low resolution PDF background if the PDF page is not rendered at this zoom yet,
+     * and images which are not decoded at this zoom yet
+     * @return false if a low resolution PDF background or image was used
+     */
+    bool renderTile(const TileKey& key, bool allowLowResolution);
 
 private:
     XojPageView* view;
@@ -37,11 +37,18 @@ void SaveJob::updatePreview(Control* control) {
 
     Document* doc = control->getDocument();
 
-    doc->lock();
+    // The preview is drawn from a snapshot, the page can be changed meanwhile
+    doc->lockShared();
+    PageRef page = doc->getPageSnapshot(0);
+    XojPdfPageSPtr popplerPage;
+    if (page && page->getBackgroundType().isPdfPage()) {
+        popplerPage = doc->getPdfPage(page->getPdfPageNr());
+    }
+    doc->unlockShared();
 
-    if (doc->getPageCount() > 0) {
-        PageRef page = doc->getPage(0);
+    cairo_surface_t* crBuffer = nullptr;
 
+    if (page) {
         double width = page->getWidth();
         double height = page->getHeight();
 
@@ -55,29 +62,28 @@ void SaveJob::updatePreview(Control* control) {
         width *= zoom;
         height *= zoom;
 
-        cairo_surface_t* crBuffer = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+        crBuffer = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
 
         cairo_t* cr = cairo_create(crBuffer);
         cairo_scale(cr, zoom, zoom);
 
-        if (page->getBackgroundType().isPdfPage()) {
-            int pgNo = page->getPdfPageNr();
-            XojPdfPageSPtr popplerPage = doc->getPdfPage(pgNo);
-            if (popplerPage) {
-                popplerPage->render(cr, false);
-            }
+        if (popplerPage) {
+            popplerPage->render(cr, false);
         }
 
         DocumentView view;
         view.drawPage(page, cr, true);
+
         cairo_destroy(cr);
-        doc->setPreview(crBuffer);
-        cairo_surface_destroy(crBuffer);
-    } else {
-        doc->setPreview(nullptr);
     }
 
+    doc->lock();
+    doc->setPreview(crBuffer);
     doc->unlock();
+
+    if (crBuffer) {
+        cairo_surface_destroy(crBuffer);
+    }
 }
 
 auto SaveJob::save() -> bool {
@@ -85,10 +91,11 @@ auto SaveJob::save() -> bool {
     Document* doc = this->control->getDocument();
     SaveHandler h;
 
-    doc->lock();
+    // Only snapshots of the pages are taken here, the layers are serialized in saveTo() without lock
+    doc->lockShared();
     h.prepareSave(doc);
     fs::path const filepath = doc->getFilepath();
-    doc->unlock();
+    doc->unlockShared();
 
     auto const target = fs::path{filepath}.replace_extension(".xopp");
 
@@ -104,8 +111,9 @@ auto SaveJob::save() -> bool {
         doc->setCreateBackupOnSave(false);
     }
 
-    doc->lock();
     h.saveTo(target, this->control);
+
+    doc->lock();
     doc->setFilepath(target);
     doc->unlock();
 
@@ -1,7 +1,8 @@
 #include "Scheduler.h"
 
-#include <cassert>
+#include <algorithm>
 #include <cinttypes>
+#include <thread>
 
 #include <config-debug.h>
 
@@ -11,29 +12,38 @@
 #define SDEBUG(msg, ...)
 #endif
 
-Scheduler::Scheduler() {
+Scheduler::Scheduler(unsigned int threadCount) {
     this->name = "Scheduler";
 
-    // Queue
-    this->jobQueue[JOB_PRIORITY_URGENT] = &this->queueUrgent;
-    this->jobQueue[JOB_PRIORITY_HIGH] = &this->queueHigh;
-    this->jobQueue[JOB_PRIORITY_LOW] = &this->queueLow;
-    this->jobQueue[JOB_PRIORITY_NONE] = &this->queueNone;
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    for (unsigned int i = 0; i < threadCount; i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->scheduler = this;
+        worker->index = i;
+        this->workers.push_back(std::move(worker));
+    }
 }
 
 Scheduler::~Scheduler() {
     SDEBUG("Destroy scheduler");
 
+    stop();
+
     if (this->jobRenderThreadTimerId) {
         g_source_remove(this->jobRenderThreadTimerId);
         this->jobRenderThreadTimerId = 0;
     }
 
-    stop();
-
-    Job* job = nullptr;
-    while ((job = getNextJobUnlocked()) != nullptr) {
-        job->unref();
+    for (auto& worker: this->workers) {
+        for (std::deque<Job*>& queue: worker->queues) {
+            for (Job* job: queue) {
+                job->unref();
+            }
+            queue.clear();
+        }
     }
 
     if (this->blockRenderZoomTime) {
@@ -43,63 +53,96 @@ Scheduler::~Scheduler() {
 
 void Scheduler::start() {
     SDEBUG("Starting scheduler");
-    g_return_if_fail(this->thread == nullptr);
+    g_return_if_fail(this->workers.front()->thread == nullptr);
 
-    this->thread = g_thread_new(name.c_str(), reinterpret_cast<GThreadFunc>(jobThreadCallback), this);
+    for (auto& worker: this->workers) {
+        std::string threadName = this->name + " " + std::to_string(worker->index);
+        worker->thread =
+                g_thread_new(threadName.c_str(), reinterpret_cast<GThreadFunc>(jobThreadCallback), worker.get());
+    }
 }
 
 void Scheduler::stop() {
     SDEBUG("Stopping scheduler");
 
-    if (!this->threadRunning) {
-        return;
+    {
+        std::lock_guard lock{this->jobQueueMutex};
+        if (!this->threadRunning) {
+            return;
+        }
+        this->threadRunning = false;
     }
-    this->threadRunning = false;
     this->jobQueueCond.notify_all();
 
-    if (this->thread) {
-        g_thread_join(this->thread);
+    for (auto& worker: this->workers) {
+        if (worker->thread) {
+            g_thread_join(worker->thread);
+            worker->thread = nullptr;
+        }
     }
 }
 
+auto Scheduler::getThreadCount() const -> size_t { return this->workers.size(); }
+
 void Scheduler::addJob(Job* job, JobPriority priority) {
     SDEBUG("Adding job...");
 
     {
         std::lock_guard lock{this->jobQueueMutex};
 
+        // Keep the jobs of a source on one worker, they can't run concurrently anyway
+        size_t index = 0;
+        if (void* source = job->getSource()) {
+            index = std::hash<void*>()(source) % this->workers.size();
+        } else {
+            index = this->nextWorker++ % this->workers.size();
+        }
+
         job->ref();
-        this->jobQueue[priority]->push_back(job);
+        this->workers[index]->queues[priority].push_back(job);
     }
 
     SDEBUG("add job: %" PRId64 "; type: %" PRId64, (uint64_t)job, (uint64_t)job->getType());
-    this->jobQueueCond.notify_all();
+    this->jobQueueCond.notify_one();
 }
 
-auto Scheduler::getNextJobUnlocked(bool onlyNotRender, bool* hasRenderJobs) -> Job* {
-    Job* job = nullptr;
+auto Scheduler::isExclusive(Job* job) -> bool {
+    JobType type = job->getType();
+    return type != JOB_TYPE_RENDER && type != JOB_TYPE_PREVIEW;
+}
 
-    for (int i = JOB_PRIORITY_URGENT; i < JOB_N_PRIORITIES; i++) {
-        std::deque<Job*>& queue = *this->jobQueue[i];
+auto Scheduler::canRunUnlocked(Job* job, bool renderBlocked, bool* hasBlockedRenderJobs) -> bool {
+    if (renderBlocked && job->getType() == JOB_TYPE_RENDER) {
+        *hasBlockedRenderJobs = true;
+        return false;
+    }
 
-        if (onlyNotRender) {
-            for (auto it = queue.begin(); it != queue.end(); ++it) {
-                job = *it;
+    void* source = job->getSource();
+    bool exclusive = isExclusive(job);
 
-                if (job->getType() != JOB_TYPE_RENDER) {
-                    queue.erase(it);
-                    return job;
-                }
+    for (auto& worker: this->workers) {
+        if (worker->runningId == 0) {
+            continue;
+        }
+        if (source != nullptr && worker->runningSource == source) {
+            return false;
+        }
+        if (exclusive && worker->runningExclusive) {
+            return false;
+        }
+    }
 
-                if (hasRenderJobs != nullptr) {
-                    *hasRenderJobs = true;
-                }
-            }
-        } else if (!queue.empty()) {
-            job = queue.front();
-            queue.pop_front();
-            assert(job != nullptr);
+    return true;
+}
+
+auto Scheduler::takeJobFromQueue(std::deque<Job*>& queue, bool fromBack, bool renderBlocked,
+                                 bool* hasBlockedRenderJobs) -> Job* {
+    for (size_t i = 0; i < queue.size(); i++) {
+        size_t index = fromBack ? queue.size() - 1 - i : i;
+        Job* job = queue[index];
 
+        if (canRunUnlocked(job, renderBlocked, hasBlockedRenderJobs)) {
+            queue.erase(queue.begin() + static_cast<std::ptrdiff_t>(index));
             return job;
         }
     }
@@ -107,15 +150,78 @@ auto Scheduler::getNextJobUnlocked(bool onlyNotRender, bool* hasRenderJobs) -> J
     return nullptr;
 }
 
-/**
- * Locks the complete scheduler
- */
-void Scheduler::lock() { this->schedulerMutex.lock(); }
+auto Scheduler::takeJobUnlocked(Worker& worker, bool renderBlocked, bool* hasBlockedRenderJobs) -> Job* {
+    if (this->locked) {
+        return nullptr;
+    }
 
-/**
- * Unlocks the complete scheduler
- */
-void Scheduler::unlock() { this->schedulerMutex.unlock(); }
+    size_t count = this->workers.size();
+
+    // A job of a higher priority is always preferred, even if it has to be stolen from another worker
+    for (int priority = JOB_PRIORITY_URGENT; priority < JOB_N_PRIORITIES; priority++) {
+        // The own jobs in the order they were added
+        Job* job = takeJobFromQueue(worker.queues[priority], false, renderBlocked, hasBlockedRenderJobs);
+        if (job != nullptr) {
+            return job;
+        }
+
+        // Steal the most recently added jobs of the other workers
+        for (size_t i = 1; i < count; i++) {
+            Worker& victim = *this->workers[(worker.index + i) % count];
+            job = takeJobFromQueue(victim.queues[priority], true, renderBlocked, hasBlockedRenderJobs);
+            if (job != nullptr) {
+                SDEBUG("worker %zu stole job from worker %zu", worker.index, victim.index);
+                return job;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void Scheduler::awaitRunningJobs() {
+    std::unique_lock lock{this->jobQueueMutex};
+
+    vector<uint64_t> running;
+    for (auto& worker: this->workers) {
+        if (worker->runningId != 0) {
+            running.push_back(worker->runningId);
+        }
+    }
+
+    // Jobs started later are not waited for
+    this->jobFinishedCond.wait(lock, [&]() {
+        for (auto& worker: this->workers) {
+            if (std::find(running.begin(), running.end(), worker->runningId) != running.end()) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+void Scheduler::lock() {
+    std::unique_lock lock{this->jobQueueMutex};
+    this->locked = true;
+
+    this->jobFinishedCond.wait(lock, [&]() {
+        for (auto& worker: this->workers) {
+            if (worker->runningId != 0) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+void Scheduler::unlock() {
+    {
+        std::lock_guard lock{this->jobQueueMutex};
+        this->locked = false;
+    }
+
+    this->jobQueueCond.notify_all();
+}
 
 #define ZOOM_WAIT_US_TIMEOUT 300000  // 0.3s
 
@@ -143,6 +249,13 @@ void Scheduler::unblockRerenderZoom() {
         }
     }
 
+    wakeWorkers();
+}
+
+void Scheduler::wakeWorkers() {
+    // Take the queue lock, else a worker between checking the blocking and waiting could miss the notification
+    { std::lock_guard lock{this->jobQueueMutex}; }
+
     this->jobQueueCond.notify_all();
 }
 
@@ -168,83 +281,90 @@ auto g_time_val_diff(GTimeVal* t1, GTimeVal* t2) -> glong {
  * we need to wakeup it later
  */
 auto Scheduler::jobRenderThreadTimer(Scheduler* scheduler) -> bool {
-    scheduler->jobRenderThreadTimerId = 0;
-
     {
         std::lock_guard lock{scheduler->blockRenderMutex};
+        scheduler->jobRenderThreadTimerId = 0;
         g_free(scheduler->blockRenderZoomTime);
         scheduler->blockRenderZoomTime = nullptr;
     }
 
-    scheduler->jobQueueCond.notify_all();
+    scheduler->wakeWorkers();
 
     return false;
 }
 
-auto Scheduler::jobThreadCallback(Scheduler* scheduler) -> gpointer {
-    while (scheduler->threadRunning) {
-        // lock the whole scheduler
-        std::unique_lock schedulerLock{scheduler->schedulerMutex};
-        SDEBUG("Job Thread: Blocked scheduler.");
+auto Scheduler::isRenderBlocked(glong& diff) -> bool {
+    std::lock_guard lock{this->blockRenderMutex};
 
-        bool onlyNonRenderJobs = false;
-        glong diff = 1000;
-        if (scheduler->blockRenderZoomTime) {
-            std::lock_guard lock{scheduler->blockRenderMutex};
-            SDEBUG("Zoom re-render blocking.");
-
-            GTimeVal time;
-            g_get_current_time(&time);
-
-            diff = g_time_val_diff(scheduler->blockRenderZoomTime, &time);
-            if (diff <= 0) {
-                g_free(scheduler->blockRenderZoomTime);
-                scheduler->blockRenderZoomTime = nullptr;
-                SDEBUG("Ended zoom re-render blocking.");
-            } else {
-                onlyNonRenderJobs = true;
-                SDEBUG("Rendering blocked: Only running non-rendering jobs.");
-            }
-        }
+    if (this->blockRenderZoomTime == nullptr) {
+        return false;
+    }
 
-        Job* job;
+    SDEBUG("Zoom re-render blocking.");
 
-        {
-            std::unique_lock jobLock{scheduler->jobQueueMutex};
-            SDEBUG("Job Thread: Locked job queue.");
+    GTimeVal time;
+    g_get_current_time(&time);
 
-            bool hasOnlyRenderJobs = false;
-            job = scheduler->getNextJobUnlocked(onlyNonRenderJobs, &hasOnlyRenderJobs);
-            if (job != nullptr) {
-                hasOnlyRenderJobs = false;
-            }
+    diff = g_time_val_diff(this->blockRenderZoomTime, &time);
+    if (diff <= 0) {
+        g_free(this->blockRenderZoomTime);
+        this->blockRenderZoomTime = nullptr;
+        SDEBUG("Ended zoom re-render blocking.");
+        return false;
+    }
+
+    SDEBUG("Rendering blocked: Only running non-rendering jobs.");
+    return true;
+}
 
-            SDEBUG("get job: %" PRId64, (uint64_t)job);
+auto Scheduler::jobThreadCallback(Worker* worker) -> gpointer {
+    Scheduler* scheduler = worker->scheduler;
 
-            if (job == nullptr) {
-                // unlock the whole scheduler
-                schedulerLock.unlock();
+    std::unique_lock jobLock{scheduler->jobQueueMutex};
 
-                if (hasOnlyRenderJobs) {
-                    if (scheduler->jobRenderThreadTimerId) {
-                        g_source_remove(scheduler->jobRenderThreadTimerId);
-                    }
-                    scheduler->jobRenderThreadTimerId = g_timeout_add(
-                            static_cast<guint>(diff), reinterpret_cast<GSourceFunc>(jobRenderThreadTimer), scheduler);
-                }
+    while (scheduler->threadRunning) {
+        glong diff = 1000;
+        bool renderBlocked = scheduler->isRenderBlocked(diff);
+
+        bool hasBlockedRenderJobs = false;
+        Job* job = scheduler->takeJobUnlocked(*worker, renderBlocked, &hasBlockedRenderJobs);
+
+        SDEBUG("get job: %" PRId64, (uint64_t)job);
 
-                scheduler->jobQueueCond.wait(jobLock);
-                continue;
+        if (job == nullptr) {
+            if (hasBlockedRenderJobs) {
+                std::lock_guard lock{scheduler->blockRenderMutex};
+                if (scheduler->jobRenderThreadTimerId) {
+                    g_source_remove(scheduler->jobRenderThreadTimerId);
+                }
+                scheduler->jobRenderThreadTimerId = g_timeout_add(
+                        static_cast<guint>(diff), reinterpret_cast<GSourceFunc>(jobRenderThreadTimer), scheduler);
             }
+
+            scheduler->jobQueueCond.wait(jobLock);
+            continue;
         }
 
+        worker->runningId = ++scheduler->lastJobId;
+        worker->runningSource = job->getSource();
+        worker->runningExclusive = isExclusive(job);
+
+        jobLock.unlock();
+
         // Run the job.
-        {
-            std::lock_guard lock{scheduler->jobRunningMutex};
-            SDEBUG("do job: %" PRId64, (uint64_t)job);
-            job->execute();
-            job->unref();
-        }
+        SDEBUG("do job: %" PRId64, (uint64_t)job);
+        job->execute();
+        job->unref();
+
+        jobLock.lock();
+
+        worker->runningId = 0;
+        worker->runningSource = nullptr;
+        worker->runningExclusive = false;
+
+        // Jobs of the same source, or exclusive jobs, may run now
+        scheduler->jobQueueCond.notify_all();
+        scheduler->jobFinishedCond.notify_all();
 
         SDEBUG("next");
     }
@@ -15,9 +15,12 @@
 
 #include <array>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "Job.h"
 #include "XournalType.h"
@@ -64,7 +67,10 @@ enum JobPriority {
 
 class Scheduler {
 public:
-    Scheduler();
+    /**
+     * @param threadCount The number of worker threads, 0 to use one thread per CPU core
+     */
+    explicit Scheduler(unsigned int threadCount = 0);
     virtual ~Scheduler();
 
 public:
@@ -82,7 +88,7 @@ public:
     void stop();
 
     /**
-     * Locks the complete scheduler
+     * Locks the complete scheduler: waits until all running jobs are done, no new jobs are started until unlock()
      */
     void lock();
 
@@ -101,44 +107,102 @@ public:
      */
     void unblockRerenderZoom();
 
+    /**
+     * @return The number of worker threads
+     */
+    size_t getThreadCount() const;
+
+protected:
+    /**
+     * A worker thread with its own job queues. Jobs of the same source are queued to the same worker, idle workers
+     * steal jobs from the queues of the others.
+     */
+    struct Worker {
+        Scheduler* scheduler = nullptr;
+        size_t index = 0;
+
+        GThread* thread = nullptr;
+
+        /**
+         * Jobs of each priority. New jobs are added to the back of each queue.
+         */
+        std::array<std::deque<Job*>, JOB_N_PRIORITIES> queues{};
+
+        /**
+         * The job currently executed, 0 if the worker is idle
+         */
+        uint64_t runningId = 0;
+        void* runningSource = nullptr;
+        bool runningExclusive = false;
+    };
+
+    /**
+     * Blocks until all currently running Job%s have been executed
+     */
+    void awaitRunningJobs();
+
 private:
-    static gpointer jobThreadCallback(Scheduler* scheduler);
-    Job* getNextJobUnlocked(bool onlyNotRender = false, bool* hasRenderJobs = nullptr);
+    static gpointer jobThreadCallback(Worker* worker);
+
+    /**
+     * Removes the next job the worker is allowed to run from the queues, called with jobQueueMutex locked
+     *
+     * @param renderBlocked Skip render jobs
+     * @param[out] hasBlockedRenderJobs Set to true if a render job was skipped
+     */
+    Job* takeJobUnlocked(Worker& worker, bool renderBlocked, bool* hasBlockedRenderJobs);
+    Job* takeJobFromQueue(std::deque<Job*>& queue, bool fromBack, bool renderBlocked, bool* hasBlockedRenderJobs);
+    bool canRunUnlocked(Job* job, bool renderBlocked, bool* hasBlockedRenderJobs);
+
+    /**
+     * @return true if render jobs are blocked, diff is set to the remaining time in ms
+     */
+    bool isRenderBlocked(glong& diff);
+
+    /**
+     * Wakes up the workers after the blocked rendering ends
+     */
+    void wakeWorkers();
 
     static bool jobRenderThreadTimer(Scheduler* scheduler);
 
+    /**
+     * Blocking and autosave jobs may modify the document or write files, they never run concurrently
+     */
+    static bool isExclusive(Job* job);
+
 protected:
     bool threadRunning = true;
 
-    int jobRenderThreadTimerId = 0;
+    /**
+     * No new jobs are started while the scheduler is locked
+     */
+    bool locked = false;
 
-    GThread* thread = nullptr;
+    int jobRenderThreadTimerId = 0;
 
-    std::condition_variable jobQueueCond{};
+    /**
+     * Protects the queues and the running state of all workers
+     */
     std::mutex jobQueueMutex{};
-    std::mutex schedulerMutex{};
+    std::condition_variable jobQueueCond{};
 
     /**
-     * This is need to be sure there is no job running if we delete a page.
-     * If a job is, we may access deleted memory.
+     * Notified if a worker finished a job
      */
-    std::mutex jobRunningMutex{};
+    std::condition_variable jobFinishedCond{};
+
+    std::vector<std::unique_ptr<Worker>> workers;
 
     /**
-     * Jobs of each priority. New jobs
-     * are added to the back of each queue.
+     * Worker for the next job without a source
      */
-    std::deque<Job*> queueUrgent{};
-    std::deque<Job*> queueHigh{};
-    std::deque<Job*> queueLow{};
-    std::deque<Job*> queueNone{};
+    size_t nextWorker = 0;
 
     /**
-     * Map (JobPriority) -> queue of that priority.
-     * For example,
-     *   jobQueue[JOB_PRIORITY_URGENT] is &queueUrgent.
+     * Id of the last started job
      */
-    std::array<std::deque<Job*>*, JOB_N_PRIORITIES> jobQueue{};
+    uint64_t lastJobId = 0;
 
     GTimeVal* blockRenderZoomTime = nullptr;
     std::mutex blockRenderMutex{};
@@ -3,7 +3,9 @@
 #include "PreviewJob.h"
 #include "RenderJob.h"
 
-XournalScheduler::XournalScheduler() { this->name = "XournalScheduler"; }
+XournalScheduler::XournalScheduler(unsigned int threadCount): Scheduler(threadCount) {
+    this->name = "XournalScheduler";
+}
 
 XournalScheduler::~XournalScheduler() = default;
 
@@ -19,50 +21,54 @@ void XournalScheduler::removePage(XojPageView* view) { removeSource(view, JOB_TY
 void XournalScheduler::removeAllJobs() {
     std::lock_guard lock{this->jobQueueMutex};
 
-    for (int priority = JOB_PRIORITY_URGENT; priority < JOB_N_PRIORITIES; priority++) {
-        std::deque<Job*>& queue = *this->jobQueue[priority];
-        auto it = queue.begin();
+    for (auto& worker: this->workers) {
+        for (std::deque<Job*>& queue: worker->queues) {
+            auto it = queue.begin();
 
-        while (it != queue.end()) {
-            Job* job = *it;
+            while (it != queue.end()) {
+                Job* job = *it;
 
-            // Only remove PREVIEW and RENDER jobs; we aren't
-            // responsible for other types of jobs.
-            JobType type = job->getType();
-            if (type == JOB_TYPE_PREVIEW || type == JOB_TYPE_RENDER) {
-                job->deleteJob();
+                // Only remove PREVIEW and RENDER jobs; we aren't
+                // responsible for other types of jobs.
+                JobType type = job->getType();
+                if (type == JOB_TYPE_PREVIEW || type == JOB_TYPE_RENDER) {
+                    job->deleteJob();
 
-                it = queue.erase(it);
+                    it = queue.erase(it);
 
-                job->unref();
-                job = nullptr;
-            } else {
-                ++it;
+                    job->unref();
+                    job = nullptr;
+                } else {
+                    ++it;
+                }
             }
         }
     }
 }
 
-void XournalScheduler::finishTask() { std::lock_guard lock{this->jobRunningMutex}; }
+void XournalScheduler::finishTask() { awaitRunningJobs(); }
 
 void XournalScheduler::removeSource(void* source, JobType type, JobPriority priority, bool awaitFinishTask) {
     {
         std::lock_guard lock{this->jobQueueMutex};
-        std::deque<Job*>& queue = *this->jobQueue[priority];
 
-        auto it = queue.begin();
+        for (auto& worker: this->workers) {
+            std::deque<Job*>& queue = worker->queues[priority];
 
-        while (it != queue.end()) {
-            Job* job = *it;
+            auto it = queue.begin();
 
-            if (job->getType() == type && job->getSource() == source) {
-                it = queue.erase(it);
+            while (it != queue.end()) {
+                Job* job = *it;
+
+                if (job->getType() == type && job->getSource() == source) {
+                    it = queue.erase(it);
 
-                job->deleteJob();
-                job->unref();
-                job = nullptr;
-            } else {
-                ++it;
+                    job->deleteJob();
+                    job->unref();
+                    job = nullptr;
+                } else {
+                    ++it;
+                }
             }
         }
     }
@@ -78,10 +84,12 @@ auto XournalScheduler::existsSource(void* source, JobType type, JobPriority prio
     bool exists = false;
     std::lock_guard lock{this->jobQueueMutex};
 
-    for (Job* job: *this->jobQueue[priority]) {
-        if (job->getType() == type && job->getSource() == source) {
-            exists = true;
-            break;
+    for (auto& worker: this->workers) {
+        for (Job* job: worker->queues[priority]) {
+            if (job->getType() == type && job->getSource() == source) {
+                exists = true;
+                break;
+            }
         }
     }
 
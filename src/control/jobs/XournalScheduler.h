@@ -24,7 +24,10 @@
 
 class XournalScheduler: public Scheduler {
 public:
-    XournalScheduler();
+    /**
+     * @param threadCount The number of worker threads, 0 to use one thread per CPU core
+     */
+    explicit XournalScheduler(unsigned int threadCount = 0);
     virtual ~XournalScheduler();
 
 public:
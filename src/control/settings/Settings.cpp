@@ -1,5 +1,6 @@
 #include "Settings.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "model/FormatDefinitions.h"
@@ -88,6 +89,9 @@ void Settings::loadDefault() {
     // Set this for autosave frequency in minutes.
     this->autosaveTimeout = 3;
     this->autosaveEnabled = true;
+    this->crashJournalEnabled = false;
+    this->autosaveCompressionLevel = 1;
+    this->lazyPageLoading = false;
 
     this->addHorizontalSpace = false;
     this->addHorizontalSpaceAmount = 150;
@@ -137,7 +141,10 @@ void Settings::loadDefault() {
     this->touchZoomStartThreshold = 0.0;
 
     this->pageRerenderThreshold = 5.0;
-    this->pdfPageCacheSize = 10;
+    this->pdfPageCacheMemory = 128;
+    this->imageCacheMemory = 256;
+    this->pageTileCacheSize = 256;
+    this->schedulerThreads = 0U;
     this->preloadPagesBefore = 3U;
     this->preloadPagesAfter = 5U;
     this->eagerPageCleanup = true;
@@ -184,6 +191,7 @@ void Settings::loadDefault() {
     this->stabilizerPreprocessor = StrokeStabilizer::Preprocessor::NONE;
     this->stabilizerBuffersize = 20;
     this->stabilizerSigma = 0.5;
+    this->stabilizerPredictionTime = 0;
     this->stabilizerDeadzoneRadius = 1.3;
     this->stabilizerCuspDetection = true;
     this->stabilizerDrag = 0.4;
@@ -401,8 +409,15 @@ void Settings::parseItem(xmlDocPtr doc, xmlNodePtr cur) {
         this->audioFolder = reinterpret_cast<const char*>(value);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("autosaveEnabled")) == 0) {
         this->autosaveEnabled = xmlStrcmp(value, reinterpret_cast<const xmlChar*>("true")) == 0;
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("crashJournalEnabled")) == 0) {
+        this->crashJournalEnabled = xmlStrcmp(value, reinterpret_cast<const xmlChar*>("true")) == 0;
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("autosaveTimeout")) == 0) {
         this->autosaveTimeout = g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("autosaveCompressionLevel")) == 0) {
+        this->autosaveCompressionLevel =
+                std::clamp<int>(g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10), 1, 9);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("lazyPageLoading")) == 0) {
+        this->lazyPageLoading = xmlStrcmp(value, reinterpret_cast<const xmlChar*>("true")) == 0;
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("fullscreenHideElements")) == 0) {
         this->fullscreenHideElements = reinterpret_cast<const char*>(value);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("presentationHideElements")) == 0) {
@@ -411,8 +426,14 @@ void Settings::parseItem(xmlDocPtr doc, xmlNodePtr cur) {
         this->touchZoomStartThreshold = g_ascii_strtod(reinterpret_cast<const char*>(value), nullptr);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pageRerenderThreshold")) == 0) {
         this->pageRerenderThreshold = g_ascii_strtod(reinterpret_cast<const char*>(value), nullptr);
-    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pdfPageCacheSize")) == 0) {
-        this->pdfPageCacheSize = g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pdfPageCacheMemory")) == 0) {
+        this->pdfPageCacheMemory = g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("imageCacheMemory")) == 0) {
+        this->imageCacheMemory = g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pageTileCacheSize")) == 0) {
+        this->pageTileCacheSize = g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("schedulerThreads")) == 0) {
+        this->schedulerThreads = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("preloadPagesBefore")) == 0) {
         this->preloadPagesBefore = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("preloadPagesAfter")) == 0) {
@@ -518,6 +539,8 @@ void Settings::parseItem(xmlDocPtr doc, xmlNodePtr cur) {
         this->stabilizerBuffersize = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("stabilizerSigma")) == 0) {
         this->stabilizerSigma = tempg_ascii_strtod(reinterpret_cast<const char*>(value), nullptr);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("stabilizerPredictionTime")) == 0) {
+        this->stabilizerPredictionTime = tempg_ascii_strtod(reinterpret_cast<const char*>(value), nullptr);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("stabilizerDeadzoneRadius")) == 0) {
         this->stabilizerDeadzoneRadius = tempg_ascii_strtod(reinterpret_cast<const char*>(value), nullptr);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("stabilizerDrag")) == 0) {
@@ -854,6 +877,12 @@ void Settings::save() {
 
     SAVE_BOOL_PROP(autosaveEnabled);
     SAVE_INT_PROP(autosaveTimeout);
+    SAVE_BOOL_PROP(crashJournalEnabled);
+    ATTACH_COMMENT("Appends the changes since the last autosave to a journal, to restore them after a crash");
+    SAVE_INT_PROP(autosaveCompressionLevel);
+    ATTACH_COMMENT("The compression level of the autosave files, 1 (fastest) to 9 (smallest)");
+    SAVE_BOOL_PROP(lazyPageLoading);
+    ATTACH_COMMENT("Parses the content of a page when it is shown the first time, opens huge documents faster");
 
     SAVE_BOOL_PROP(addHorizontalSpace);
     SAVE_INT_PROP(addHorizontalSpaceAmount);
@@ -880,8 +909,14 @@ void Settings::save() {
     SAVE_DOUBLE_PROP(touchZoomStartThreshold);
     SAVE_DOUBLE_PROP(pageRerenderThreshold);
 
-    SAVE_INT_PROP(pdfPageCacheSize);
-    ATTACH_COMMENT("The count of rendered PDF pages which will be cached.");
+    SAVE_INT_PROP(pdfPageCacheMemory);
+    ATTACH_COMMENT("The memory in MiB used to cache the rendered PDF pages.");
+    SAVE_INT_PROP(imageCacheMemory);
+    ATTACH_COMMENT("The memory in MiB used to cache the decoded images.");
+    SAVE_INT_PROP(pageTileCacheSize);
+    ATTACH_COMMENT("The memory in MiB used to cache the rendered tiles of the pages.");
+    SAVE_UINT_PROP(schedulerThreads);
+    ATTACH_COMMENT("The number of background threads, 0 for one per CPU core. Applied on restart.");
     SAVE_UINT_PROP(preloadPagesBefore);
     SAVE_UINT_PROP(preloadPagesAfter);
     SAVE_BOOL_PROP(eagerPageCleanup);
@@ -925,6 +960,8 @@ void Settings::save() {
     saveProperty("stabilizerPreprocessor", static_cast<int>(stabilizerPreprocessor), root);
     SAVE_UINT_PROP(stabilizerBuffersize);
     SAVE_DOUBLE_PROP(stabilizerSigma);
+    SAVE_DOUBLE_PROP(stabilizerPredictionTime);
+    ATTACH_COMMENT("Time in ms the motion of the pen is extrapolated for display, 0 to disable");
     SAVE_DOUBLE_PROP(stabilizerDeadzoneRadius);
     SAVE_DOUBLE_PROP(stabilizerDrag);
     SAVE_DOUBLE_PROP(stabilizerMass);
@@ -1094,6 +1131,43 @@ void Settings::setAutosaveEnabled(bool autosave) {
     save();
 }
 
+auto Settings::isCrashJournalEnabled() const -> bool { return this->crashJournalEnabled; }
+
+void Settings::setCrashJournalEnabled(bool enabled) {
+    if (this->crashJournalEnabled == enabled) {
+        return;
+    }
+
+    this->crashJournalEnabled = enabled;
+
+    save();
+}
+
+auto Settings::getAutosaveCompressionLevel() const -> int { return this->autosaveCompressionLevel; }
+
+void Settings::setAutosaveCompressionLevel(int level) {
+    level = std::clamp(level, 1, 9);
+    if (this->autosaveCompressionLevel == level) {
+        return;
+    }
+
+    this->autosaveCompressionLevel = level;
+
+    save();
+}
+
+auto Settings::isLazyPageLoading() const -> bool { return this->lazyPageLoading; }
+
+void Settings::setLazyPageLoading(bool lazy) {
+    if (this->lazyPageLoading == lazy) {
+        return;
+    }
+
+    this->lazyPageLoading = lazy;
+
+    save();
+}
+
 auto Settings::getAddVerticalSpace() const -> bool { return this->addVerticalSpace; }
 
 void Settings::setAddVerticalSpace(bool space) { this->addVerticalSpace = space; }
@@ -1658,13 +1732,43 @@ void Settings::setPDFPageRerenderThreshold(double threshold) {
     save();
 }
 
-auto Settings::getPdfPageCacheSize() const -> int { return this->pdfPageCacheSize; }
+auto Settings::getPdfPageCacheMemory() const -> int { return this->pdfPageCacheMemory; }
+
+void Settings::setPdfPageCacheMemory(int size) {
+    if (this->pdfPageCacheMemory == size) {
+        return;
+    }
+    this->pdfPageCacheMemory = size;
+    save();
+}
+
+auto Settings::getImageCacheMemory() const -> int { return this->imageCacheMemory; }
 
-void Settings::setPdfPageCacheSize(int size) {
-    if (this->pdfPageCacheSize == size) {
+void Settings::setImageCacheMemory(int size) {
+    if (this->imageCacheMemory == size) {
         return;
     }
-    this->pdfPageCacheSize = size;
+    this->imageCacheMemory = size;
+    save();
+}
+
+auto Settings::getPageTileCacheSize() const -> int { return this->pageTileCacheSize; }
+
+void Settings::setPageTileCacheSize(int size) {
+    if (this->pageTileCacheSize == size) {
+        return;
+    }
+    this->pageTileCacheSize = size;
+    save();
+}
+
+auto Settings::getSchedulerThreads() const -> unsigned int { return this->schedulerThreads; }
+
+void Settings::setSchedulerThreads(unsigned int n) {
+    if (this->schedulerThreads == n) {
+        return;
+    }
+    this->schedulerThreads = n;
     save();
 }
 
@@ -2089,6 +2193,7 @@ auto Settings::getStabilizerDeadzoneRadius() const -> double { return stabilizer
 auto Settings::getStabilizerDrag() const -> double { return stabilizerDrag; }
 auto Settings::getStabilizerMass() const -> double { return stabilizerMass; }
 auto Settings::getStabilizerSigma() const -> double { return stabilizerSigma; }
+auto Settings::getStabilizerPredictionTime() const -> double { return stabilizerPredictionTime; }
 auto Settings::getStabilizerAveragingMethod() const -> StrokeStabilizer::AveragingMethod {
     return stabilizerAveragingMethod;
 }
@@ -2143,6 +2248,13 @@ void Settings::setStabilizerSigma(double sigma) {
     stabilizerSigma = sigma;
     save();
 }
+void Settings::setStabilizerPredictionTime(double predictionTime) {
+    if (stabilizerPredictionTime == predictionTime) {
+        return;
+    }
+    stabilizerPredictionTime = predictionTime;
+    save();
+}
 void Settings::setStabilizerAveragingMethod(StrokeStabilizer::AveragingMethod averagingMethod) {
     const StrokeStabilizer::AveragingMethod method =
             StrokeStabilizer::isValid(averagingMethod) ? averagingMethod : StrokeStabilizer::AveragingMethod::NONE;
@@ -240,6 +240,12 @@ public:
     void setAutosaveTimeout(int autosave);
     bool isAutosaveEnabled() const;
     void setAutosaveEnabled(bool autosave);
+    bool isCrashJournalEnabled() const;
+    void setCrashJournalEnabled(bool enabled);
+    int getAutosaveCompressionLevel() const;
+    void setAutosaveCompressionLevel(int level);
+    bool isLazyPageLoading() const;
+    void setLazyPageLoading(bool lazy);
 
     bool getAddVerticalSpace() const;
     void setAddVerticalSpace(bool space);
@@ -325,8 +331,17 @@ public:
     double getTouchZoomStartThreshold() const;
     void setTouchZoomStartThreshold(double threshold);
 
-    int getPdfPageCacheSize() const;
-    [[maybe_unused]] void setPdfPageCacheSize(int size);
+    int getPdfPageCacheMemory() const;
+    [[maybe_unused]] void setPdfPageCacheMemory(int size);
+
+    int getImageCacheMemory() const;
+    [[maybe_unused]] void setImageCacheMemory(int size);
+
+    int getPageTileCacheSize() const;
+    [[maybe_unused]] void setPageTileCacheSize(int size);
+
+    unsigned int getSchedulerThreads() const;
+    [[maybe_unused]] void setSchedulerThreads(unsigned int n);
 
     unsigned int getPreloadPagesBefore() const;
     void setPreloadPagesBefore(unsigned int n);
@@ -489,6 +504,7 @@ public:
     double getStabilizerDrag() const;
     double getStabilizerMass() const;
     double getStabilizerSigma() const;
+    double getStabilizerPredictionTime() const;
     StrokeStabilizer::AveragingMethod getStabilizerAveragingMethod() const;
     StrokeStabilizer::Preprocessor getStabilizerPreprocessor() const;
 
@@ -499,6 +515,7 @@ public:
     void setStabilizerDrag(double drag);
     void setStabilizerMass(double mass);
     void setStabilizerSigma(double sigma);
+    void setStabilizerPredictionTime(double predictionTime);
     void setStabilizerAveragingMethod(StrokeStabilizer::AveragingMethod averagingMethod);
     void setStabilizerPreprocessor(StrokeStabilizer::Preprocessor preprocessor);
 
@@ -744,6 +761,21 @@ private:
      */
     bool autosaveEnabled{};
 
+    /**
+     * Journal the changes between the autosaves for crash recovery
+     */
+    bool crashJournalEnabled{};
+
+    /**
+     * The zlib compression level of the autosave files, 1 (fastest) to 9 (smallest)
+     */
+    int autosaveCompressionLevel{};
+
+    /**
+     * Only parse the content of a page when it is shown the first time, opens huge documents faster
+     */
+    bool lazyPageLoading{};
+
     /**
      * Allow scroll outside the page display area (horizontal)
      */
@@ -801,9 +833,24 @@ private:
     string presentationHideElements;
 
     /**
-     *  The count of pages which will be cached
+     *  The memory in MiB used for the cached PDF pages
      */
-    int pdfPageCacheSize{};
+    int pdfPageCacheMemory{};
+
+    /**
+     *  The memory in MiB used for the decoded images
+     */
+    int imageCacheMemory{};
+
+    /**
+     *  The memory in MiB used for the rendered tiles of the pages
+     */
+    int pageTileCacheSize{};
+
+    /**
+     *  The number of worker threads of the scheduler, 0 for one per CPU core
+     */
+    unsigned int schedulerThreads{};
 
     /**
      *  Percentage by which the page's zoom must change
@@ -982,6 +1029,11 @@ private:
     double stabilizerDrag{};
     double stabilizerMass{};
     double stabilizerSigma{};
+
+    /**
+     * Time in ms the motion of the pen is extrapolated, only for display. 0 disables the prediction.
+     */
+    double stabilizerPredictionTime{};
     StrokeStabilizer::AveragingMethod stabilizerAveragingMethod{};
     StrokeStabilizer::Preprocessor stabilizerPreprocessor{};
 };
@@ -1,6 +1,7 @@
 #include "CircleRecognizer.h"
 
 #include <cmath>
+#include <vector>
 
 #include "model/Stroke.h"
 #include "util/LoopUtil.h"
@@ -45,11 +46,11 @@ auto CircleRecognizer::scoreCircle(Stroke* s, Inertia& inertia) -> double {
     double x0 = inertia.centerX();
     double y0 = inertia.centerY();
 
-    auto const& pv = s->getPointVector();
-    for (auto pt_1st = begin(pv), pt_2nd = std::next(pt_1st), p_end_i = end(pv); pt_1st != p_end_i && pt_2nd != p_end_i;
-         ++pt_2nd, ++pt_1st) {
-        double dm = hypot(pt_2nd->x - pt_1st->x, pt_2nd->y - pt_1st->y);
-        double deltar = hypot(pt_1st->x - x0, pt_1st->y - y0) - r0;
+    const double* px = s->getPointData().getX();
+    const double* py = s->getPointData().getY();
+    for (size_t i = 0; i + 1 < s->getPointData().size(); i++) {
+        double dm = hypot(px[i + 1] - px[i], py[i + 1] - py[i]);
+        double deltar = hypot(px[i] - x0, py[i] - y0) - r0;
         sum += dm * fabs(deltar);
     }
 
@@ -58,7 +59,8 @@ auto CircleRecognizer::scoreCircle(Stroke* s, Inertia& inertia) -> double {
 
 auto CircleRecognizer::recognize(Stroke* stroke) -> Stroke* {
     Inertia s;
-    s.calc(stroke->getPoints(), 0, stroke->getPointCount());
+    std::vector<Point> points = stroke->getPointVector();
+    s.calc(points.data(), 0, stroke->getPointCount());
     RDEBUG("Mass=%.0f, Center=(%.1f,%.1f), I=(%.0f,%.0f, %.0f), Rad=%.2f, Det=%.4f", s.getMass(), s.centerX(),
            s.centerY(), s.xx(), s.yy(), s.xy(), s.rad(), s.det());
 
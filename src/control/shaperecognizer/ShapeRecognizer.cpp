@@ -1,6 +1,7 @@
 #include "ShapeRecognizer.h"
 
 #include <cmath>
+#include <vector>
 
 #include <config-debug.h>
 
@@ -250,10 +251,13 @@ auto ShapeRecognizer::recognizePatterns(Stroke* stroke) -> ShapeRecognizerResult
     Inertia ss[4];
     int brk[5] = {0};
 
+    // The recognizer works on an array of points
+    std::vector<Point> points = stroke->getPointVector();
+
     // first see if it's a polygon
-    int n = findPolygonal(stroke->getPoints(), 0, stroke->getPointCount() - 1, MAX_POLYGON_SIDES, brk, ss);
+    int n = findPolygonal(points.data(), 0, stroke->getPointCount() - 1, MAX_POLYGON_SIDES, brk, ss);
     if (n > 0) {
-        optimizePolygonal(stroke->getPoints(), n, brk, ss);
+        optimizePolygonal(points.data(), n, brk, ss);
 #ifdef DEBUG_RECOGNIZER
         g_message("--");
         g_message("ShapeReco:: Polygon, %d edges:", n);
@@ -281,7 +285,7 @@ auto ShapeRecognizer::recognizePatterns(Stroke* stroke) -> ShapeRecognizerResult
         for (int i = 0; i < n; i++) {
             rs[i].startpt = brk[i];
             rs[i].endpt = brk[i + 1];
-            rs[i].calcSegmentGeometry(stroke->getPoints(), brk[i], brk[i + 1], ss + i);
+            rs[i].calcSegmentGeometry(points.data(), brk[i], brk[i + 1], ss + i);
         }
 
         Stroke* tmp = nullptr;
@@ -166,11 +166,15 @@ void BaseStrokeHandler::onButtonReleaseEvent(const PositionInputData& pos) {
 
     Layer* layer = page->getSelectedLayer();
 
-    UndoRedoHandler* undo = control->getUndoRedoHandler();
+    Document* doc = control->getDocument();
+    doc->lockShared();
+    page->lock();
+    layer->addElement(stroke);
+    page->unlock();
+    doc->unlockShared();
 
+    UndoRedoHandler* undo = control->getUndoRedoHandler();
     undo->addUndoAction(std::make_unique<InsertUndoAction>(page, layer, stroke));
-
-    layer->addElement(stroke);
     page->fireElementChanged(stroke);
 
     stroke = nullptr;
@@ -48,15 +48,27 @@ void EraseHandler::erase(double x, double y) {
 
     auto* range = new Range(x, y);
 
+    // Only this page is locked, the other pages can be rendered and saved while erasing
+    this->doc->lockShared();
+    this->page->lock();
+
     Layer* l = page->getSelectedLayer();
 
-    vector<Element*> tmp(*l->getElements());
-    for (Element* e: tmp) {
+    Rectangle<double> eraserArea(x - halfEraserSize, y - halfEraserSize, halfEraserSize * 2, halfEraserSize * 2);
+    for (Element* e: l->getElementsInArea(eraserArea)) {
         if (e->getType() == ELEMENT_STROKE && e->intersectsArea(&eraserRect)) {
             eraseStroke(l, dynamic_cast<Stroke*>(e), x, y, range);
         }
     }
 
+    this->page->unlock();
+    this->doc->unlockShared();
+
+    // Added after the page is changed, the listeners take the new revision of the page
+    if (this->pendingUndoAction) {
+        this->undo->addUndoAction(std::move(this->pendingUndoAction));
+    }
+
     this->view->rerenderRange(*range);
     delete range;
 }
@@ -68,9 +80,7 @@ void EraseHandler::eraseStroke(Layer* l, Stroke* s, double x, double y, Range* r
 
     // delete complete element
     if (this->handler->getEraserType() == ERASER_TYPE_DELETE_STROKE) {
-        this->doc->lock();
         int pos = l->removeElement(s, false);
-        this->doc->unlock();
 
         if (pos == -1) {
             return;
@@ -84,7 +94,7 @@ void EraseHandler::eraseStroke(Layer* l, Stroke* s, double x, double y, Range* r
             auto eraseDel = std::make_unique<DeleteUndoAction>(this->page, true);
             // Todo check dangerous: this->eraseDeleteUndoAction could be a dangling reference
             this->eraseDeleteUndoAction = eraseDel.get();
-            this->undo->addUndoAction(std::move(eraseDel));
+            this->pendingUndoAction = std::move(eraseDel);
         }
 
         this->eraseDeleteUndoAction->addElement(l, s, pos);
@@ -99,15 +109,13 @@ void EraseHandler::eraseStroke(Layer* l, Stroke* s, double x, double y, Range* r
             auto eraseUndo = std::make_unique<EraseUndoAction>(this->page);
             // Todo check dangerous: this->eraseDeleteUndoAction could be a dangling reference
             this->eraseUndoAction = eraseUndo.get();
-            this->undo->addUndoAction(std::move(eraseUndo));
+            this->pendingUndoAction = std::move(eraseUndo);
         }
 
         EraseableStroke* eraseable = nullptr;
         if (s->getEraseable() == nullptr) {
-            doc->lock();
             eraseable = new EraseableStroke(s);
             s->setEraseable(eraseable);
-            doc->unlock();
             this->eraseUndoAction->addOriginal(l, s, pos);
         } else {
             eraseable = s->getEraseable();
@@ -119,9 +127,19 @@ void EraseHandler::eraseStroke(Layer* l, Stroke* s, double x, double y, Range* r
 
 void EraseHandler::finalize() {
     if (this->eraseUndoAction) {
+        this->doc->lockShared();
+        this->page->lock();
         this->eraseUndoAction->finalize();
+        this->page->unlock();
+        this->doc->unlockShared();
+
         this->eraseUndoAction = nullptr;
     } else if (this->eraseDeleteUndoAction) {
         this->eraseDeleteUndoAction = nullptr;
+    } else {
+        return;
     }
+
+    // The page was changed after the undo action was added
+    this->undo->fireUpdateUndoRedoButtons({this->page});
 }
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "model/PageRef.h"
+#include "undo/UndoAction.h"
 
 #include "XournalType.h"
 
@@ -50,5 +51,10 @@ private:
     DeleteUndoAction* eraseDeleteUndoAction;
     EraseUndoAction* eraseUndoAction;
 
+    /**
+     * The undo action created while the page is locked, it is added after the page is unlocked
+     */
+    UndoActionPtr pendingUndoAction;
+
     double halfEraserSize;
 };
@@ -73,7 +73,12 @@ auto ImageHandler::insertImage(GFile* file, double x, double y) -> bool {
     img->setWidth(width * zoom);
     img->setHeight(height * zoom);
 
+    Document* doc = control->getDocument();
+    doc->lockShared();
+    page->lock();
     page->getSelectedLayer()->addElement(img);
+    page->unlock();
+    doc->unlockShared();
 
     control->getUndoRedoHandler()->addUndoAction(
             std::make_unique<InsertUndoAction>(page, page->getSelectedLayer(), img));
@@ -44,7 +44,8 @@ auto RectSelection::finalize(PageRef page) -> bool {
     this->page = page;
 
     Layer* l = page->getSelectedLayer();
-    for (Element* e: *l->getElements()) {
+    Rectangle<double> box(this->x1, this->y1, this->x2 - this->x1, this->y2 - this->y1);
+    for (Element* e: l->getElementsInArea(box)) {
         if (e->isInSelection(this)) {
             this->selectedElements.push_back(e);
         }
@@ -295,7 +296,8 @@ auto RegionSelect::finalize(PageRef page) -> bool {
     }
 
     Layer* l = page->getSelectedLayer();
-    for (Element* e: *l->getElements()) {
+    Rectangle<double> box(this->x1Box, this->y1Box, this->x2Box - this->x1Box, this->y2Box - this->y1Box);
+    for (Element* e: l->getElementsInArea(box)) {
         if (e->isInSelection(this)) {
             this->selectedElements.push_back(e);
         }
@@ -309,11 +309,16 @@ void SplineHandler::finalizeSpline() {
 
     Layer* layer = page->getSelectedLayer();
 
+    Document* doc = control->getDocument();
+    doc->lockShared();
+    page->lock();
+    layer->addElement(stroke);
+    page->unlock();
+    doc->unlockShared();
+
     UndoRedoHandler* undo = control->getUndoRedoHandler();
     undo->addUndoAction(std::make_unique<InsertUndoAction>(page, layer, stroke));
 
-    layer->addElement(stroke);
-
     Rectangle<double> rect = this->computeRepaintRectangle();
     this->redrawable->rerenderRect(rect.x, rect.y, rect.width, rect.height);
 
@@ -1,5 +1,6 @@
 #include "StrokeHandler.h"
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
@@ -14,6 +15,7 @@
 #include "undo/InsertUndoAction.h"
 #include "undo/RecognizerUndoAction.h"
 
+#include "LatencyTracer.h"
 #include "StrokeStabilizer.h"
 #include "config-features.h"
 
@@ -23,7 +25,9 @@ guint32 StrokeHandler::lastStrokeTime;  // persist for next stroke
 StrokeHandler::StrokeHandler(XournalView* xournal, XojPageView* redrawable, const PageRef& page):
         InputHandler(xournal, redrawable, page),
         snappingHandler(xournal->getControl()->getSettings()),
-        stabilizer(StrokeStabilizer::get(xournal->getControl()->getSettings())) {}
+        stabilizer(StrokeStabilizer::get(xournal->getControl()->getSettings())) {
+    stabilizer->setPredictionTime(xournal->getControl()->getSettings()->getStabilizerPredictionTime());
+}
 
 StrokeHandler::~StrokeHandler() {
     destroySurface();
@@ -32,7 +36,7 @@ StrokeHandler::~StrokeHandler() {
 }
 
 void StrokeHandler::draw(cairo_t* cr) {
-    if (!stroke) {
+    if (!stroke || !surfMask) {
         return;
     }
 
@@ -44,7 +48,87 @@ void StrokeHandler::draw(cairo_t* cr) {
         cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
     }
 
-    cairo_mask_surface(cr, surfMask, 0, 0);
+    cairo_mask_surface(cr, surfMask, this->maskX, this->maskY);
+
+    drawPrediction(cr);
+}
+
+void StrokeHandler::drawPrediction(cairo_t* cr) {
+    if (this->prediction.empty() || stroke->getPointCount() == 0) {
+        return;
+    }
+
+    // The color and operator are already set for the mask
+    Point last = stroke->getPoint(stroke->getPointCount() - 1);
+    double width = stroke->hasPressure() && stroke->getPointCount() > 1 ?
+                           stroke->getPoint(stroke->getPointCount() - 2).z :
+                           stroke->getWidth();
+
+    cairo_save(cr);
+    cairo_scale(cr, this->maskScale, this->maskScale);
+    cairo_set_line_width(cr, width);
+    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+    cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+
+    cairo_move_to(cr, last.x, last.y);
+    for (const Point& offset: this->prediction) {
+        cairo_line_to(cr, last.x + offset.x, last.y + offset.y);
+    }
+    cairo_stroke(cr);
+    cairo_restore(cr);
+}
+
+void StrokeHandler::setPrediction(std::vector<Point> offsets) {
+    if (!stroke) {
+        return;
+    }
+
+    // Only solid pen strokes, the prediction is drawn on top of the mask
+    if (stroke->getToolType() != STROKE_TOOL_PEN || stroke->getFill() != -1 || stroke->getLineStyle().hasDashes()) {
+        offsets.clear();
+    }
+
+    if (offsets.empty() && this->prediction.empty()) {
+        return;
+    }
+
+    // Repaint the old and the new prediction
+    Range oldBounds(0, 0);
+    bool hadPrediction = getPredictionBounds(oldBounds);
+
+    this->prediction = std::move(offsets);
+
+    Range bounds(0, 0);
+    if (getPredictionBounds(bounds)) {
+        if (hadPrediction) {
+            bounds.addPoint(oldBounds.getX(), oldBounds.getY());
+            bounds.addPoint(oldBounds.getX2(), oldBounds.getY2());
+        }
+    } else if (hadPrediction) {
+        bounds = oldBounds;
+    } else {
+        return;
+    }
+
+    this->redrawable->repaintRect(bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight());
+}
+
+auto StrokeHandler::getPredictionBounds(Range& bounds) const -> bool {
+    if (this->prediction.empty() || stroke == nullptr || stroke->getPointCount() == 0) {
+        return false;
+    }
+
+    Point last = stroke->getPoint(stroke->getPointCount() - 1);
+    bounds = Range(last.x, last.y);
+    for (const Point& offset: this->prediction) {
+        bounds.addPoint(last.x + offset.x, last.y + offset.y);
+    }
+
+    // Widest possible line, as the width of the stroke may change until the repaint
+    double w = stroke->getWidth();
+    bounds.addPoint(bounds.getX() - w, bounds.getY() - w);
+    bounds.addPoint(bounds.getX2() + w, bounds.getY2() + w);
+    return true;
 }
 
 
@@ -65,6 +149,7 @@ auto StrokeHandler::onMotionNotifyEvent(const PositionInputData& pos) -> bool {
     }
 
     stabilizer->processEvent(pos);
+    stabilizer->predictMotion(pos);
     return true;
 }
 
@@ -119,23 +204,31 @@ void StrokeHandler::paintTo(const Point& point) {
 void StrokeHandler::drawSegmentTo(const Point& point) {
 
     stroke->addPoint(this->hasPressure ? point : Point(point.x, point.y));
+    LatencyTracer::getInstance().pointAdded();
+
+    const double w = stroke->getWidth();
+    const double x = stroke->getX() - w;
+    const double y = stroke->getY() - w;
+    const double width = stroke->getElementWidth() + 2 * w;
+    const double height = stroke->getElementHeight() + 2 * w;
+
+    growMask(x, y, width, height);
 
-    if ((stroke->getFill() != -1 || stroke->getLineStyle().hasDashes()) &&
-        !(stroke->getFill() != -1 && stroke->getToolType() == STROKE_TOOL_HIGHLIGHTER)) {
-        // Clear surface
+    if (stroke->getFill() != -1 && stroke->getToolType() != STROKE_TOOL_HIGHLIGHTER) {
+        // The filled area changes with every point, clear the mask and draw the whole stroke
 
-        // for debugging purposes
-        // cairo_set_source_rgba(crMask, 1, 0, 0, 1);
-        cairo_set_source_rgba(crMask, 0, 0, 0, 0);
-        cairo_rectangle(crMask, 0, 0, cairo_image_surface_get_width(surfMask),
-                        cairo_image_surface_get_height(surfMask));
-        cairo_fill(crMask);
+        cairo_save(crMask);
+        cairo_set_operator(crMask, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(crMask);
+        cairo_restore(crMask);
 
         view.drawStroke(crMask, stroke, 0, 1, true, true);
-    } else {
-        if (auto const pointCount = stroke->getPointCount(); pointCount > 1) {
-            Point prevPoint(stroke->getPoint(pointCount - 2));
+    } else if (auto const pointCount = stroke->getPointCount(); pointCount > 1) {
+        Point prevPoint(stroke->getPoint(pointCount - 2));
 
+        if (stroke->getLineStyle().hasDashes()) {
+            drawDashedSegment(prevPoint, point);
+        } else {
             Stroke lastSegment;
 
             lastSegment.addPoint(prevPoint);
@@ -149,13 +242,84 @@ void StrokeHandler::drawSegmentTo(const Point& point) {
         }
     }
 
-    const double w = stroke->getWidth();
+    this->redrawable->repaintRect(x, y, width, height);
+    LatencyTracer::getInstance().repaintQueued();
+}
+
+void StrokeHandler::drawDashedSegment(const Point& from, const Point& to) {
+    const double* dashes = nullptr;
+    int dashCount = 0;
+    stroke->getLineStyle().getDashes(dashes, dashCount);
+
+    // The pressure of the first point is the width of the segment
+    double width = from.z != Point::NO_PRESSURE ? from.z : stroke->getWidth();
 
-    this->redrawable->repaintRect(stroke->getX() - w, stroke->getY() - w, stroke->getElementWidth() + 2 * w,
-                                  stroke->getElementHeight() + 2 * w);
+    cairo_set_operator(crMask, CAIRO_OPERATOR_OVER);
+    cairo_set_source_rgba(crMask, 1, 1, 1, 1);
+    cairo_set_line_width(crMask, width);
+    cairo_set_line_cap(crMask, CAIRO_LINE_CAP_ROUND);
+    cairo_set_line_join(crMask, CAIRO_LINE_JOIN_ROUND);
+    cairo_set_dash(crMask, dashes, dashCount, this->dashOffset);
+
+    cairo_move_to(crMask, from.x, from.y);
+    cairo_line_to(crMask, to.x, to.y);
+    cairo_stroke(crMask);
+
+    this->dashOffset += from.lineLengthTo(to);
+}
+
+void StrokeHandler::growMask(double x, double y, double width, double height) {
+    int x1 = std::max(0, static_cast<int>(std::floor(x * this->maskScale)));
+    int y1 = std::max(0, static_cast<int>(std::floor(y * this->maskScale)));
+    int x2 = std::min(this->pageWidth, static_cast<int>(std::ceil((x + width) * this->maskScale)));
+    int y2 = std::min(this->pageHeight, static_cast<int>(std::ceil((y + height) * this->maskScale)));
+
+    if (surfMask && x1 >= this->maskX && y1 >= this->maskY && x2 <= this->maskX + this->maskWidth &&
+        y2 <= this->maskY + this->maskHeight) {
+        return;
+    }
+
+    // Grow by a margin, proportional to the current size, so the mask is only replaced a few times per stroke
+    int marginX = MASK_MARGIN;
+    int marginY = MASK_MARGIN;
+    if (surfMask) {
+        x1 = std::min(x1, this->maskX);
+        y1 = std::min(y1, this->maskY);
+        x2 = std::max(x2, this->maskX + this->maskWidth);
+        y2 = std::max(y2, this->maskY + this->maskHeight);
+        marginX = std::max(marginX, this->maskWidth / 2);
+        marginY = std::max(marginY, this->maskHeight / 2);
+    }
+    x1 = std::max(0, x1 - marginX);
+    y1 = std::max(0, y1 - marginY);
+    x2 = std::min(this->pageWidth, x2 + marginX);
+    y2 = std::min(this->pageHeight, y2 + marginY);
+
+    // Image surfaces are initialized transparent
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_A8, std::max(1, x2 - x1), std::max(1, y2 - y1));
+
+    if (surfMask) {
+        cairo_t* cr = cairo_create(surface);
+        cairo_set_source_surface(cr, surfMask, this->maskX - x1, this->maskY - y1);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+    }
+
+    destroySurface();
+
+    surfMask = surface;
+    this->maskX = x1;
+    this->maskY = y1;
+    this->maskWidth = x2 - x1;
+    this->maskHeight = y2 - y1;
+
+    crMask = cairo_create(surfMask);
+    cairo_translate(crMask, -x1, -y1);
+    cairo_scale(crMask, this->maskScale, this->maskScale);
 }
 
 void StrokeHandler::onMotionCancelEvent() {
+    setPrediction({});
     delete stroke;
     stroke = nullptr;
 }
@@ -165,6 +329,9 @@ void StrokeHandler::onButtonReleaseEvent(const PositionInputData& pos) {
         return;
     }
 
+    // The real points are there now
+    setPrediction({});
+
     /**
      * The stabilizer may have added a gap between the end of the stroke and the input device
      * Fill this gap.
@@ -213,8 +380,8 @@ void StrokeHandler::onButtonReleaseEvent(const PositionInputData& pos) {
     // Backward compatibility and also easier to handle for me;-)
     // I cannot draw a line with one point, to draw a visible line I need two points,
     // twice the same Point is also OK
-    if (auto const& pv = stroke->getPointVector(); pv.size() == 1) {
-        stroke->addPoint(pv.front());
+    if (stroke->getPointCount() == 1) {
+        stroke->addPoint(stroke->getPoint(0));
         // Todo: check if the following is the reason for a bug, that single points have no pressure:
         // No pressure sensitivity,
         stroke->clearPressure();
@@ -228,8 +395,6 @@ void StrokeHandler::onButtonReleaseEvent(const PositionInputData& pos) {
 
     UndoRedoHandler* undo = control->getUndoRedoHandler();
 
-    undo->addUndoAction(std::make_unique<InsertUndoAction>(page, layer, stroke));
-
     ToolHandler* h = control->getToolHandler();
 
     if (h->getDrawingType() == DRAWING_TYPE_STROKE_RECOGNIZER) {
@@ -240,6 +405,7 @@ void StrokeHandler::onButtonReleaseEvent(const PositionInputData& pos) {
         ShapeRecognizerResult* result = reco->recognizePatterns(stroke);
 
         if (result) {
+            undo->addUndoAction(std::make_unique<InsertUndoAction>(page, layer, stroke));
             strokeRecognizerDetected(result, layer);
 
             // Full repaint is done anyway
@@ -255,10 +421,19 @@ void StrokeHandler::onButtonReleaseEvent(const PositionInputData& pos) {
         // If the stroke has fill values, it needs to be re-rendered
         // else the fill will not be visible.
 
+        growMask(stroke->getX(), stroke->getY(), stroke->getElementWidth(), stroke->getElementHeight());
         view.drawStroke(crMask, stroke, 0, 1, true, true);
     }
 
+    Document* doc = control->getDocument();
+    doc->lockShared();
+    page->lock();
     layer->addElement(stroke);
+    page->unlock();
+    doc->unlockShared();
+
+    // Added after the page is changed, the listeners take the new revision of the page
+    undo->addUndoAction(std::make_unique<InsertUndoAction>(page, layer, stroke));
     page->fireElementChanged(stroke);
 
     // Manually force the rendering of the stroke, if no motion event occurred between, that would rerender the page.
@@ -297,8 +472,9 @@ void StrokeHandler::strokeRecognizerDetected(ShapeRecognizerResult* result, Laye
     auto recognizerUndo = std::make_unique<RecognizerUndoAction>(page, layer, stroke, snappedStroke);
     auto& locRecUndo = *recognizerUndo;
 
-    UndoRedoHandler* undo = xournal->getControl()->getUndoRedoHandler();
-    undo->addUndoAction(std::move(recognizerUndo));
+    Document* doc = xournal->getControl()->getDocument();
+    doc->lockShared();
+    page->lock();
     layer->addElement(snappedStroke);
 
     Range range(snappedStroke->getX(), snappedStroke->getY());
@@ -317,6 +493,12 @@ void StrokeHandler::strokeRecognizerDetected(ShapeRecognizerResult* result, Laye
         range.addPoint(s->getX() + s->getElementWidth(), s->getY() + s->getElementHeight());
     }
 
+    page->unlock();
+    doc->unlockShared();
+
+    UndoRedoHandler* undo = xournal->getControl()->getUndoRedoHandler();
+    undo->addUndoAction(std::move(recognizerUndo));
+
     page->fireRangeChanged(range);
 
     // delete the result object, this is not needed anymore, the stroke are not deleted with this
@@ -331,21 +513,11 @@ void StrokeHandler::onButtonPressEvent(const PositionInputData& pos) {
 
     int dpiScaleFactor = xournal->getDpiScaleFactor();
 
-    double width = page->getWidth() * zoom * dpiScaleFactor;
-    double height = page->getHeight() * zoom * dpiScaleFactor;
-
-    surfMask = cairo_image_surface_create(CAIRO_FORMAT_A8, width, height);
-
-    crMask = cairo_create(surfMask);
-
-    // for debugging purposes
-    // cairo_set_source_rgba(crMask, 0, 0, 0, 1);
-    cairo_set_source_rgba(crMask, 0, 0, 0, 0);
-    cairo_rectangle(crMask, 0, 0, width, height);
-
-    cairo_fill(crMask);
-
-    cairo_scale(crMask, zoom * dpiScaleFactor, zoom * dpiScaleFactor);
+    // The mask is created with the first segment, only around the stroke
+    this->maskScale = zoom * dpiScaleFactor;
+    this->pageWidth = static_cast<int>(page->getWidth() * this->maskScale);
+    this->pageHeight = static_cast<int>(page->getHeight() * this->maskScale);
+    this->dashOffset = 0;
 
     if (!stroke) {
         this->buttonDownPoint.x = pos.x / zoom;
@@ -11,9 +11,12 @@
 
 #pragma once
 
+#include <vector>
+
 #include "view/DocumentView.h"
 
 #include "InputHandler.h"
+#include "Range.h"
 #include "SnapToGridInputHandler.h"
 
 class ShapeRecognizer;
@@ -31,6 +34,9 @@ class Active;
  * drawn opaquely on the initially transparent masking
  * surface. The surface is used to mask the stroke
  * when drawing it to the XojPageView
+ *
+ * The mask only covers the bounding box of the stroke (plus a margin),
+ * it is replaced by a larger one when the stroke grows out of it.
  */
 class StrokeHandler: public InputHandler {
 public:
@@ -58,6 +64,12 @@ public:
      */
     void paintTo(const Point& point);
 
+    /**
+     * @brief Display the predicted motion of the pen after the end of the stroke, until the next call
+     * @param offsets The predicted points, relative to the last point of the stroke. Empty to remove the prediction.
+     */
+    void setPrediction(std::vector<Point> offsets);
+
 protected:
     /**
      * @brief Unconditionally add a segment to the stroke.
@@ -66,6 +78,26 @@ protected:
      */
     void drawSegmentTo(const Point& point);
 
+    /**
+     * Draws a segment of a dashed stroke, the dash pattern continues from the previous segment
+     */
+    void drawDashedSegment(const Point& from, const Point& to);
+
+    /**
+     * Makes sure the mask covers the rectangle (in page coordinates), a larger mask is created if needed
+     */
+    void growMask(double x, double y, double width, double height);
+
+    /**
+     * Draws the predicted motion, cr is in device pixels like the mask
+     */
+    void drawPrediction(cairo_t* cr);
+
+    /**
+     * @return The area covered by the prediction, in page coordinates, or false if there is none
+     */
+    bool getPredictionBounds(Range& bounds) const;
+
     void strokeRecognizerDetected(ShapeRecognizerResult* result, Layer* layer);
     void destroySurface();
 
@@ -84,6 +116,31 @@ private:
      */
     cairo_t* crMask = nullptr;
 
+    /**
+     * Position and size of the mask on the page, in device pixels
+     */
+    int maskX = 0;
+    int maskY = 0;
+    int maskWidth = 0;
+    int maskHeight = 0;
+
+    /**
+     * Device pixels per page unit (zoom and DPI scale), and the size of the page in device pixels
+     */
+    double maskScale = 1;
+    int pageWidth = 0;
+    int pageHeight = 0;
+
+    /**
+     * Length of the stroke drawn so far, the dash offset of the next segment
+     */
+    double dashOffset = 0;
+
+    /**
+     * The predicted motion relative to the last point of the stroke, see StrokeStabilizer::MotionPredictor
+     */
+    std::vector<Point> prediction;
+
     DocumentView view;
 
     ShapeRecognizer* reco = nullptr;
@@ -103,4 +160,9 @@ private:
     friend class StrokeStabilizer::Active;
 
     static constexpr double MAX_WIDTH_VARIATION = 0.3;
+
+    /**
+     * Minimum margin around the stroke when the mask is created or grown, in device pixels
+     */
+    static constexpr int MASK_MARGIN = 256;
 };
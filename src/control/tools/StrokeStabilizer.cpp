@@ -1,5 +1,6 @@
 #include "StrokeStabilizer.h"
 
+#include <algorithm>
 #include <numeric>
 
 #include "control/settings/Settings.h"
@@ -64,6 +65,92 @@ auto StrokeStabilizer::get(Settings* settings) -> std::unique_ptr<StrokeStabiliz
     return std::make_unique<StrokeStabilizer::Base>();
 }
 
+/**
+ * StrokeStabilizer::MotionPredictor
+ */
+void StrokeStabilizer::MotionPredictor::reset() { events.clear(); }
+
+void StrokeStabilizer::MotionPredictor::addEvent(const Event& ev, guint32 timestamp) {
+    events.emplace_back(ev, timestamp);
+    while (timestamp - events.front().second > WINDOW) {
+        events.pop_front();
+    }
+}
+
+auto StrokeStabilizer::MotionPredictor::predict() const -> std::vector<MathVect> {
+    std::vector<MathVect> offsets;
+    if (events.size() < 3) {
+        return offsets;
+    }
+
+    /**
+     * Least squares fit of x(t) and y(t) with a line, the slopes are the velocity.
+     * The timestamps are relative to the last event, they only have a resolution of 1 ms.
+     */
+    const guint32 lastTimestamp = events.back().second;
+    const Event& last = events.back().first;
+    double sumT = 0;
+    double sumTT = 0;
+    double sumX = 0;
+    double sumY = 0;
+    double sumTX = 0;
+    double sumTY = 0;
+    for (auto& [ev, timestamp]: events) {
+        double t = -static_cast<double>(lastTimestamp - timestamp);
+        double x = ev.x - last.x;
+        double y = ev.y - last.y;
+        sumT += t;
+        sumTT += t * t;
+        sumX += x;
+        sumY += y;
+        sumTX += t * x;
+        sumTY += t * y;
+    }
+
+    const auto n = static_cast<double>(events.size());
+    const double denominator = n * sumTT - sumT * sumT;
+    if (denominator <= 0) {
+        // All events within the same millisecond
+        return offsets;
+    }
+
+    MathVect velocity{(n * sumTX - sumT * sumX) / denominator, (n * sumTY - sumT * sumY) / denominator};
+    if (velocity.norm() < MIN_SPEED) {
+        return offsets;
+    }
+
+    for (double t = STEP; t < predictionTime + STEP; t += STEP) {
+        double time = std::min(t, predictionTime);
+        offsets.push_back({velocity.dx * time, velocity.dy * time});
+    }
+    return offsets;
+}
+
+/**
+ * StrokeStabilizer::Base
+ */
+void StrokeStabilizer::Base::setPredictionTime(double predictionTime) {
+    if (predictionTime > 0) {
+        predictor = std::make_unique<MotionPredictor>(predictionTime);
+    } else {
+        predictor.reset();
+    }
+}
+
+void StrokeStabilizer::Base::predictMotion(const PositionInputData& pos) {
+    if (!predictor) {
+        return;
+    }
+
+    predictor->addEvent(Event(pos), pos.timestamp);
+
+    std::vector<Point> offsets;
+    for (const MathVect& offset: predictor->predict()) {
+        offsets.emplace_back(offset.dx / zoom, offset.dy / zoom);
+    }
+    strokeHandler->setPrediction(std::move(offsets));
+}
+
 /**
  * StrokeStabilizer::Active
  */
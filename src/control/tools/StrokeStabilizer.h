@@ -14,6 +14,8 @@
 #include <cmath>
 #include <deque>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include "control/tools/StrokeHandler.h"
 
@@ -49,6 +51,52 @@ struct Event {
     double pressure{};
 };
 
+/**
+ * @brief Extrapolates the motion of the pen for a few milliseconds, to display the ink ahead of the input
+ *
+ * The velocity is a least squares fit of the events received in the last WINDOW milliseconds. The predicted motion is
+ * only displayed by the StrokeHandler, it is replaced when the next event arrives and never added to the stroke.
+ */
+class MotionPredictor {
+public:
+    /**
+     * @param predictionTime How far the motion is extrapolated, in milliseconds
+     */
+    explicit MotionPredictor(double predictionTime): predictionTime(predictionTime) {}
+
+    void reset();
+    void addEvent(const Event& ev, guint32 timestamp);
+
+    /**
+     * @return The predicted offsets from the last event, one every STEP milliseconds up to the prediction time. Empty
+     * if the pen does not move or there are not enough recent events.
+     */
+    std::vector<MathVect> predict() const;
+
+private:
+    /**
+     * @brief Time span of the events used for the velocity, in milliseconds
+     */
+    static constexpr guint32 WINDOW = 40;
+
+    /**
+     * @brief Time between two predicted points, in milliseconds
+     */
+    static constexpr double STEP = 4;
+
+    /**
+     * @brief Minimum speed for a prediction, in pixels per millisecond. Slower motion would only show the jitter.
+     */
+    static constexpr double MIN_SPEED = 0.05;
+
+    const double predictionTime;
+
+    /**
+     * @brief The recent events with their timestamps, the most recent at the back
+     */
+    std::deque<std::pair<Event, guint32>> events;
+};
+
 /**
  * @brief Base stabilizer class. Also used as default (no stabilization).
  */
@@ -67,8 +115,26 @@ public:
         strokeHandler = sH;
         zoom = zoomValue;
         recordFirstEvent(pos);
+        if (predictor) {
+            predictor->reset();
+            predictor->addEvent(Event(pos), pos.timestamp);
+        }
     }
 
+    /**
+     * @brief Enable the motion prediction
+     * @param predictionTime How far the motion is extrapolated in milliseconds, 0 disables the prediction
+     */
+    void setPredictionTime(double predictionTime);
+
+    /**
+     * @brief Display the predicted motion of the pen after the event, called after processEvent
+     * @param pos The MotionNotify event information
+     *
+     * Does nothing if the prediction is disabled
+     */
+    void predictMotion(const PositionInputData& pos);
+
     /**
      * @brief Compute stabilized coordinates for the event and paints the obtained point
      * @param pos The MotionNotify event information
@@ -104,6 +170,11 @@ protected:
      * @brief The zoom value to be applied on all painted points
      */
     double zoom;
+
+    /**
+     * @brief The motion predictor, nullptr if the prediction is disabled
+     */
+    std::unique_ptr<MotionPredictor> predictor;
 };
 
 /**
@@ -13,22 +13,22 @@ VerticalToolHandler::VerticalToolHandler(Redrawable* view, const PageRef& page,
     double ySnapped = snappingHandler.snapVertically(y, false);
     this->startY = ySnapped;
     this->endY = ySnapped;
-    for (Element* e: *this->layer->getElements()) {
-        if (e->getY() >= y) {
-            this->elements.push_back(e);
-        }
-    }
 
-    for (Element* e: this->elements) {
-        this->layer->removeElement(e, false);
+    // Found with the index of the layer, and removed in one pass, the page may contain thousands of elements
+    this->elements = this->layer->getElementsBelow(y);
+    this->layer->removeElements(this->elements, false);
 
+    for (Element* e: this->elements) {
         this->jumpY = std::max(this->jumpY, e->getY() + e->getElementHeight());
     }
 
+    // The buffer only needs to cover the moved elements, not the rest of the page
+    double bufferHeight = std::max(0.0, std::min(this->jumpY, this->page->getHeight()) - y);
+
     this->jumpY = this->page->getHeight() - this->jumpY;
 
-    this->crBuffer = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, this->page->getWidth() * zoom,
-                                                (this->page->getHeight() - y) * zoom);
+    this->crBuffer = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, std::ceil(this->page->getWidth() * zoom),
+                                                std::ceil(bufferHeight * zoom));
 
     cairo_t* cr = cairo_create(this->crBuffer);
     cairo_scale(cr, zoom, zoom);
@@ -101,9 +101,8 @@ auto VerticalToolHandler::finalize() -> std::unique_ptr<MoveUndoAction> {
 
     for (Element* e: this->elements) {
         e->move(0, dY);
-
-        this->layer->addElement(e);
     }
+    this->layer->addElements(this->elements);
 
     view->rerenderPage();
 
@@ -0,0 +1,163 @@
+#include "XmlWriter.h"
+
+#include "Util.h"
+
+XmlWriter::XmlWriter(OutputStream* out): out(out) {}
+
+XmlWriter::~XmlWriter() = default;
+
+void XmlWriter::closeStartTag(bool content) {
+    if (this->startTagOpen) {
+        this->out->write(content ? ">" : ">\n");
+        this->startTagOpen = false;
+    }
+}
+
+void XmlWriter::startElement(const char* tag) {
+    closeStartTag(false);
+
+    this->out->write("<");
+    this->out->write(tag);
+    this->tags.emplace_back(tag);
+    this->startTagOpen = true;
+}
+
+void XmlWriter::endElement() {
+    if (this->tags.empty()) {
+        g_warning("XmlWriter::endElement(); no element is open");
+        return;
+    }
+
+    if (this->startTagOpen) {
+        this->out->write("/>\n");
+        this->startTagOpen = false;
+    } else {
+        this->out->write("</");
+        this->out->write(this->tags.back());
+        this->out->write(">\n");
+    }
+    this->tags.pop_back();
+}
+
+void XmlWriter::writeEscaped(const string& text, bool attribute) {
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        const char* replacement = nullptr;
+        switch (text[i]) {
+            case '&':
+                replacement = "&amp;";
+                break;
+            case '<':
+                replacement = "&lt;";
+                break;
+            case '>':
+                replacement = "&gt;";
+                break;
+            case '"':
+                replacement = attribute ? "&quot;" : nullptr;
+                break;
+            case '\n':
+                replacement = attribute ? "&#13;" : nullptr;
+                break;
+            default:
+                break;
+        }
+
+        if (replacement) {
+            this->out->write(text.data() + start, static_cast<int>(i - start));
+            this->out->write(replacement);
+            start = i + 1;
+        }
+    }
+    this->out->write(text.data() + start, static_cast<int>(text.size() - start));
+}
+
+void XmlWriter::writeAttribute(const char* name, const string& value) {
+    this->out->write(" ");
+    this->out->write(name);
+    this->out->write("=\"");
+    writeEscaped(value, true);
+    this->out->write("\"");
+}
+
+void XmlWriter::writeAttribute(const char* name, const char* value) {
+    writeAttribute(name, string(value == nullptr ? "" : value));
+}
+
+void XmlWriter::writeAttribute(const char* name, double value) {
+    char str[G_ASCII_DTOSTR_BUF_SIZE];
+    Util::formatDouble(str, value);
+    writeAttribute(name, str);
+}
+
+void XmlWriter::writeAttribute(const char* name, int value) { writeAttribute(name, std::to_string(value)); }
+
+void XmlWriter::writeAttribute(const char* name, size_t value) { writeAttribute(name, std::to_string(value)); }
+
+void XmlWriter::writeAttribute(const char* name, const vector<double>& values) {
+    string value;
+    value.reserve(values.size() * 12);
+
+    char str[G_ASCII_DTOSTR_BUF_SIZE];
+    for (double v: values) {
+        if (!value.empty()) {
+            value += ' ';
+        }
+        value.append(str, Util::formatDouble(str, v));
+    }
+
+    writeAttribute(name, value);
+}
+
+void XmlWriter::writeText(const string& text) {
+    closeStartTag(true);
+    writeEscaped(text, false);
+}
+
+void XmlWriter::writePoints(const StrokePoints& points) {
+    closeStartTag(true);
+
+    const double* x = points.getX();
+    const double* y = points.getY();
+    for (size_t i = 0; i < points.size(); i++) {
+        if (i > 0) {
+            this->out->write(" ");
+        }
+
+        Util::writeCoordinateString(this->out, x[i], y[i]);
+    }
+}
+
+void XmlWriter::writeBase64(const string& data) {
+    closeStartTag(true);
+
+    gchar* base64Str = g_base64_encode(reinterpret_cast<const guchar*>(data.c_str()), data.length());
+    this->out->write(base64Str);
+    g_free(base64Str);
+}
+
+auto XmlWriter::pngWriteFunction(XmlWriter* writer, const unsigned char* data, unsigned int length)
+        -> cairo_status_t {
+    string encoded((length / 3 + 1) * 4 + 4, '\0');
+    gsize len = g_base64_encode_step(data, length, false, &encoded[0], &writer->base64State, &writer->base64Save);
+    writer->out->write(encoded.data(), static_cast<int>(len));
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+void XmlWriter::writeImage(cairo_surface_t* img) {
+    closeStartTag(true);
+
+    if (img == nullptr) {
+        g_error("XmlWriter::writeImage(); img == nullptr");
+        return;
+    }
+
+    this->base64State = 0;
+    this->base64Save = 0;
+    cairo_surface_write_to_png_stream(img, reinterpret_cast<cairo_write_func_t>(&pngWriteFunction), this);
+
+    char end[8];
+    gsize len = g_base64_encode_close(false, end, &this->base64State, &this->base64Save);
+    this->out->write(end, static_cast<int>(len));
+}
@@ -0,0 +1,105 @@
+/*
+ * Xournal++
+ *
+ * Streaming XML writer
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cairo.h>
+#include <glib.h>
+
+#include "model/StrokePoints.h"
+
+#include "OutputStream.h"
+#include "XournalType.h"
+
+/**
+ * @brief Writes XML directly to an OutputStream, without building a tree of the document
+ *
+ * The start tag of an element stays open for attributes until a child or content is written. Elements without
+ * children and content are written as empty element tag.
+ */
+class XmlWriter {
+public:
+    explicit XmlWriter(OutputStream* out);
+    virtual ~XmlWriter();
+
+private:
+    XmlWriter(const XmlWriter& writer);
+    void operator=(const XmlWriter& writer);
+
+public:
+    void startElement(const char* tag);
+    void endElement();
+
+    void writeAttribute(const char* name, const char* value);
+    void writeAttribute(const char* name, const string& value);
+    void writeAttribute(const char* name, double value);
+    void writeAttribute(const char* name, int value);
+    void writeAttribute(const char* name, size_t value);
+
+    /**
+     * Writes the values space separated
+     */
+    void writeAttribute(const char* name, const vector<double>& values);
+
+    /**
+     * Writes escaped text as content of the current element
+     */
+    void writeText(const string& text);
+
+    /**
+     * Writes the coordinates of the points as content of the current element
+     */
+    void writePoints(const StrokePoints& points);
+
+    /**
+     * Writes the data base64 encoded as content of the current element
+     */
+    void writeBase64(const string& data);
+
+    /**
+     * Writes the image as base64 encoded PNG as content of the current element
+     */
+    void writeImage(cairo_surface_t* img);
+
+private:
+    /**
+     * Closes the start tag of the current element, if it is still open
+     *
+     * @param content True if content follows, false if a child element follows
+     */
+    void closeStartTag(bool content);
+
+    void writeEscaped(const string& text, bool attribute);
+
+    static cairo_status_t pngWriteFunction(XmlWriter* writer, const unsigned char* data, unsigned int length);
+
+private:
+    OutputStream* out;
+
+    /**
+     * The open elements
+     */
+    vector<string> tags;
+
+    /**
+     * If the start tag of the current element is still open
+     */
+    bool startTagOpen = false;
+
+    /**
+     * State of the base64 encoder
+     */
+    gint base64State = 0;
+    gint base64Save = 0;
+};
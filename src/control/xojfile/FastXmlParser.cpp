@@ -0,0 +1,300 @@
+#include "FastXmlParser.h"
+
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+inline auto isWhitespace(char c) -> bool { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+
+inline auto isNameChar(char c) -> bool {
+    return !isWhitespace(c) && c != '>' && c != '/' && c != '=' && c != '<' && c != '"' && c != '\'' && c != '&';
+}
+
+}  // namespace
+
+FastXmlParser::FastXmlParser(const GMarkupParser* parser, gpointer userdata): parser(parser), userdata(userdata) {}
+
+FastXmlParser::~FastXmlParser() = default;
+
+void FastXmlParser::skipWhitespace() {
+    while (this->pos < this->end && isWhitespace(*this->pos)) {
+        this->pos++;
+    }
+}
+
+auto FastXmlParser::parseName() -> const char* {
+    const char* name = this->pos;
+    while (this->pos < this->end && isNameChar(*this->pos)) {
+        this->pos++;
+    }
+    return name;
+}
+
+auto FastXmlParser::appendDecoded(const char* text, const char* end) -> bool {
+    while (text < end) {
+        const auto* amp = static_cast<const char*>(memchr(text, '&', static_cast<size_t>(end - text)));
+        if (amp == nullptr) {
+            this->scratch.append(text, end);
+            return true;
+        }
+        this->scratch.append(text, amp);
+
+        const auto* semicolon = static_cast<const char*>(memchr(amp, ';', static_cast<size_t>(end - amp)));
+        if (semicolon == nullptr) {
+            return false;
+        }
+
+        std::string_view entity(amp + 1, static_cast<size_t>(semicolon - amp - 1));
+        if (entity == "amp") {
+            this->scratch.push_back('&');
+        } else if (entity == "lt") {
+            this->scratch.push_back('<');
+        } else if (entity == "gt") {
+            this->scratch.push_back('>');
+        } else if (entity == "quot") {
+            this->scratch.push_back('"');
+        } else if (entity == "apos") {
+            this->scratch.push_back('\'');
+        } else if (entity.size() > 1 && entity.size() < 10 && entity[0] == '#') {
+            bool hex = entity[1] == 'x';
+            string number(entity.substr(hex ? 2 : 1));
+            if (number.empty()) {
+                return false;
+            }
+
+            char* numberEnd = nullptr;
+            guint64 c = g_ascii_strtoull(number.c_str(), &numberEnd, hex ? 16 : 10);
+            if (*numberEnd != 0 || !g_unichar_validate(static_cast<gunichar>(c)) || c == 0) {
+                return false;
+            }
+
+            char utf8[6];
+            gint len = g_unichar_to_utf8(static_cast<gunichar>(c), utf8);
+            this->scratch.append(utf8, static_cast<size_t>(len));
+        } else {
+            return false;
+        }
+
+        text = semicolon + 1;
+    }
+
+    return true;
+}
+
+auto FastXmlParser::parseStartElement(GError** error) -> Result {
+    const char* name = parseName();
+    auto nameLength = static_cast<size_t>(this->pos - name);
+    if (nameLength == 0) {
+        return UNSUPPORTED;
+    }
+
+    this->scratch.clear();
+    this->scratch.append(name, nameLength);
+    this->scratch.push_back('\0');
+    this->attributeOffsets.clear();
+
+    bool selfClosing = false;
+    while (true) {
+        char* attributeStart = this->pos;
+        skipWhitespace();
+        if (this->pos >= this->end) {
+            return UNSUPPORTED;
+        }
+
+        if (*this->pos == '>') {
+            this->pos++;
+            break;
+        }
+        if (*this->pos == '/') {
+            if (this->pos + 1 >= this->end || this->pos[1] != '>') {
+                return UNSUPPORTED;
+            }
+            this->pos += 2;
+            selfClosing = true;
+            break;
+        }
+
+        // Attributes need to be separated by whitespace
+        if (attributeStart == this->pos) {
+            return UNSUPPORTED;
+        }
+
+        const char* attribute = parseName();
+        if (attribute == this->pos) {
+            return UNSUPPORTED;
+        }
+        this->attributeOffsets.push_back(this->scratch.size());
+        this->scratch.append(attribute, static_cast<size_t>(this->pos - attribute));
+        this->scratch.push_back('\0');
+
+        skipWhitespace();
+        if (this->pos >= this->end || *this->pos != '=') {
+            return UNSUPPORTED;
+        }
+        this->pos++;
+        skipWhitespace();
+        if (this->pos >= this->end || (*this->pos != '"' && *this->pos != '\'')) {
+            return UNSUPPORTED;
+        }
+
+        char quote = *this->pos++;
+        auto* valueEnd = static_cast<char*>(memchr(this->pos, quote, static_cast<size_t>(this->end - this->pos)));
+        if (valueEnd == nullptr || memchr(this->pos, '<', static_cast<size_t>(valueEnd - this->pos)) != nullptr) {
+            return UNSUPPORTED;
+        }
+
+        this->attributeOffsets.push_back(this->scratch.size());
+        if (!appendDecoded(this->pos, valueEnd)) {
+            return UNSUPPORTED;
+        }
+        this->scratch.push_back('\0');
+
+        this->pos = valueEnd + 1;
+    }
+
+    // The scratch buffer does not change anymore, so the pointers stay valid
+    this->attributeNames.clear();
+    this->attributeValues.clear();
+    for (size_t i = 0; i < this->attributeOffsets.size(); i += 2) {
+        this->attributeNames.push_back(this->scratch.data() + this->attributeOffsets[i]);
+        this->attributeValues.push_back(this->scratch.data() + this->attributeOffsets[i + 1]);
+    }
+    this->attributeNames.push_back(nullptr);
+    this->attributeValues.push_back(nullptr);
+
+    this->parser->start_element(nullptr, this->scratch.data(), this->attributeNames.data(),
+                                this->attributeValues.data(), this->userdata, error);
+    if (*error) {
+        return PARSED;
+    }
+
+    if (selfClosing) {
+        this->parser->end_element(nullptr, this->scratch.data(), this->userdata, error);
+    } else {
+        this->openElements.emplace_back(name, nameLength);
+    }
+
+    return PARSED;
+}
+
+auto FastXmlParser::parseEndElement(GError** error) -> Result {
+    const char* name = parseName();
+    auto nameLength = static_cast<size_t>(this->pos - name);
+
+    skipWhitespace();
+    if (this->pos >= this->end || *this->pos != '>' || this->openElements.empty()) {
+        return UNSUPPORTED;
+    }
+    this->pos++;
+
+    auto& open = this->openElements.back();
+    if (open.second != nameLength || memcmp(open.first, name, nameLength) != 0) {
+        return UNSUPPORTED;
+    }
+    this->openElements.pop_back();
+
+    this->scratch.assign(name, nameLength);
+    this->parser->end_element(nullptr, this->scratch.c_str(), this->userdata, error);
+
+    return PARSED;
+}
+
+auto FastXmlParser::parseText(GError** error) -> Result {
+    char* text = this->pos;
+    auto* textEnd = static_cast<char*>(memchr(text, '<', static_cast<size_t>(this->end - text)));
+    if (textEnd == nullptr) {
+        textEnd = this->end;
+    }
+    this->pos = textEnd;
+
+    if (this->openElements.empty()) {
+        // Only whitespace is allowed outside of the root element
+        for (const char* c = text; c < textEnd; c++) {
+            if (!isWhitespace(*c)) {
+                return UNSUPPORTED;
+            }
+        }
+        return PARSED;
+    }
+
+    if (textEnd == this->end) {
+        // The document is cut off
+        return UNSUPPORTED;
+    }
+
+    if (memchr(text, '&', static_cast<size_t>(textEnd - text)) != nullptr) {
+        this->scratch.clear();
+        if (!appendDecoded(text, textEnd)) {
+            return UNSUPPORTED;
+        }
+        this->parser->text(nullptr, this->scratch.c_str(), this->scratch.size(), this->userdata, error);
+        return PARSED;
+    }
+
+    // Pass the text without copying it, null terminated as GMarkup does
+    char next = *textEnd;
+    *textEnd = '\0';
+    this->parser->text(nullptr, text, static_cast<gsize>(textEnd - text), this->userdata, error);
+    *textEnd = next;
+
+    return PARSED;
+}
+
+auto FastXmlParser::parse(char* data, size_t length, GError** error) -> Result {
+    this->pos = data;
+    this->end = data + length;
+    this->openElements.clear();
+
+    bool rootParsed = false;
+
+    while (this->pos < this->end) {
+        Result result = PARSED;
+
+        if (*this->pos != '<') {
+            result = parseText(error);
+        } else if (this->pos + 1 >= this->end) {
+            return UNSUPPORTED;
+        } else if (this->pos[1] == '?') {
+            // XML declaration or processing instruction, not needed
+            size_t close = std::string_view(this->pos, static_cast<size_t>(this->end - this->pos)).find("?>", 2);
+            if (close == std::string_view::npos) {
+                return UNSUPPORTED;
+            }
+            this->pos += close + 2;
+        } else if (this->pos[1] == '!') {
+            std::string_view rest(this->pos, static_cast<size_t>(this->end - this->pos));
+            if (rest.compare(0, 4, "<!--") != 0) {
+                // DOCTYPE, CDATA etc.
+                return UNSUPPORTED;
+            }
+            size_t close = rest.find("-->", 4);
+            if (close == std::string_view::npos) {
+                return UNSUPPORTED;
+            }
+            this->pos += close + 3;
+        } else if (this->pos[1] == '/') {
+            this->pos += 2;
+            result = parseEndElement(error);
+        } else {
+            if (rootParsed && this->openElements.empty()) {
+                // Only one root element is allowed
+                return UNSUPPORTED;
+            }
+            rootParsed = true;
+
+            this->pos++;
+            result = parseStartElement(error);
+        }
+
+        if (result == UNSUPPORTED || *error) {
+            return result;
+        }
+    }
+
+    if (!rootParsed || !this->openElements.empty()) {
+        return UNSUPPORTED;
+    }
+
+    return PARSED;
+}
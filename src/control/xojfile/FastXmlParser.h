@@ -0,0 +1,95 @@
+/*
+ * Xournal++
+ *
+ * Fast XML parser for the subset of XML written to .xoj / .xopp files
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+#include "XournalType.h"
+
+/**
+ * @brief Parses a complete document in memory and calls the callbacks of a GMarkupParser
+ *
+ * Supports elements, attributes, text, comments, processing instructions and the predefined and numeric character
+ * references. The callbacks get the same arguments as from GMarkup (the context is nullptr), but the text is not
+ * copied if it contains no references, and the text of an element is always passed in a single call.
+ *
+ * Documents using anything else (DTDs, CDATA sections, ...) or which are not well-formed are rejected without an
+ * error message, they have to be parsed by GMarkup, which reports the errors.
+ */
+class FastXmlParser {
+public:
+    enum Result {
+        /**
+         * The document was parsed, or a callback failed with an error
+         */
+        PARSED,
+
+        /**
+         * The document can not be parsed by this parser, parse it with GMarkup
+         */
+        UNSUPPORTED
+    };
+
+    FastXmlParser(const GMarkupParser* parser, gpointer userdata);
+    virtual ~FastXmlParser();
+
+private:
+    FastXmlParser(const FastXmlParser& parser);
+    void operator=(const FastXmlParser& parser);
+
+public:
+    /**
+     * Parses the document. The data is not changed, but it needs to be writable as the text passed to the
+     * callbacks is temporarily null terminated.
+     *
+     * @param data The UTF-8 validated document
+     */
+    Result parse(char* data, size_t length, GError** error);
+
+private:
+    Result parseStartElement(GError** error);
+    Result parseEndElement(GError** error);
+    Result parseText(GError** error);
+
+    /**
+     * Appends the text to the scratch buffer, and decodes character references
+     *
+     * @return false if the text contains an unknown reference
+     */
+    bool appendDecoded(const char* text, const char* end);
+
+    const char* parseName();
+    void skipWhitespace();
+
+private:
+    const GMarkupParser* parser;
+    gpointer userdata;
+
+    char* pos = nullptr;
+    char* end = nullptr;
+
+    /**
+     * Names of the open elements, they point into the document
+     */
+    vector<std::pair<const char*, size_t>> openElements;
+
+    /**
+     * Decoded names and values, null terminated
+     */
+    string scratch;
+    vector<size_t> attributeOffsets;
+    vector<const gchar*> attributeNames;
+    vector<const gchar*> attributeValues;
+};
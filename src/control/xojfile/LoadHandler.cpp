@@ -1,6 +1,11 @@
 #include "LoadHandler.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
 #include <utility>
 
 #include <config.h>
@@ -12,8 +17,12 @@
 #include "model/StrokeStyle.h"
 #include "model/XojPage.h"
 
+#include "FastXmlParser.h"
+#include "FloatParser.h"
 #include "GzUtil.h"
 #include "LoadHandlerHelper.h"
+#include "Util.h"
+#include "XojMsgBox.h"
 #include "i18n.h"
 
 #define error2(var, ...)                                                                \
@@ -26,6 +35,166 @@
         error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_INVALID_CONTENT, __VA_ARGS__); \
     }
 
+/**
+ * The state of the loaded file which is needed to parse the layers of a page later, shared by all pages
+ */
+struct LazyPageSource {
+    LazyPageSource() = default;
+    LazyPageSource(const LazyPageSource&) = delete;
+    LazyPageSource& operator=(const LazyPageSource&) = delete;
+
+    ~LazyPageSource() {
+        if (this->zipFp) {
+            zip_close(this->zipFp);
+        }
+    }
+
+    fs::path filepath;
+    int fileVersion = 0;
+    bool isGzFile = false;
+    bool fastParserEnabled = true;
+
+    /**
+     * The temporary files of the audio attachments
+     */
+    std::map<string, string> audioFiles;
+
+    /**
+     * The opened .xopp file for the attachments of the layers, libzip does not allow concurrent access
+     */
+    zip_t* zipFp = nullptr;
+    std::mutex zipMutex;
+};
+
+/**
+ * Parses the layers of a page when they are accessed the first time
+ */
+class LazyPageLoader: public LazyPageContent {
+public:
+    LazyPageLoader(std::shared_ptr<LazyPageSource> source, std::shared_ptr<const string> layers):
+            source(std::move(source)), layers(std::move(layers)) {}
+
+    bool load(XojPage& page) override {
+        std::unique_lock<std::mutex> zipLock(this->source->zipMutex, std::defer_lock);
+        if (!this->source->isGzFile) {
+            zipLock.lock();
+        }
+
+        LoadHandler handler;
+        handler.resetParser();
+        handler.filepath = this->source->filepath;
+        handler.xournalFilepath = this->source->filepath;
+        handler.fileVersion = this->source->fileVersion;
+        handler.isGzFile = this->source->isGzFile;
+        handler.zipFp = this->source->zipFp;
+        for (auto& file: this->source->audioFiles) {
+            g_hash_table_insert(handler.audioFiles, const_cast<char*>(file.first.c_str()),
+                                const_cast<char*>(file.second.c_str()));
+        }
+
+        // The page is owned by the document, not by the handler
+        handler.page = PageRef(&page, [](XojPage*) {});
+        handler.pos = PARSER_POS_IN_PAGE;
+
+        const GMarkupParser parser = {LoadHandler::parserStartElement, LoadHandler::parserEndElement,
+                                      LoadHandler::parserText, nullptr, nullptr};
+
+        // The fast parser works in place, the layers are kept unchanged for saving
+        string xml = "<page>";
+        xml += *this->layers;
+        xml += "</page>";
+
+        bool parsed = false;
+        if (this->source->fastParserEnabled) {
+            FastXmlParser fastParser(&parser, &handler);
+            parsed = fastParser.parse(&xml[0], xml.size(), &handler.error) == FastXmlParser::PARSED;
+        }
+        if (!parsed) {
+            // Discard the layers parsed so far, GMarkup parses them again
+            for (Layer* layer: *page.getLayers()) {
+                delete layer;
+            }
+            page.getLayers()->clear();
+            handler.page = PageRef(&page, [](XojPage*) {});
+            handler.pos = PARSER_POS_IN_PAGE;
+            if (handler.error) {
+                g_error_free(handler.error);
+                handler.error = nullptr;
+            }
+
+            xml = "<page>";
+            xml += *this->layers;
+            xml += "</page>";
+
+            GMarkupParseContext* context =
+                    g_markup_parse_context_new(&parser, static_cast<GMarkupParseFlags>(0), &handler, nullptr);
+            if (g_markup_parse_context_parse(context, xml.data(), static_cast<gssize>(xml.size()), &handler.error) &&
+                handler.error == nullptr) {
+                g_markup_parse_context_end_parse(context, &handler.error);
+            }
+            g_markup_parse_context_free(context);
+        }
+
+        handler.page = nullptr;
+        handler.zipFp = nullptr;
+
+        if (handler.error) {
+            string msg = FS(_F("Could not load the layers of a page of \"{1}\": {2}") %
+                            this->source->filepath.u8string() % handler.error->message);
+            if (getLayersXml()) {
+                msg += "\n";
+                msg += _("The page is saved as it was read, unless it is changed.");
+            }
+            g_warning("%s", msg.c_str());
+            g_error_free(handler.error);
+
+            Util::execInUiThread([msg]() { XojMsgBox::showErrorToUser(nullptr, msg); });
+            return false;
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<const string> getLayersXml() const override {
+        // Other versions and the attachments of zipped files would need to be converted
+        if (!this->source->isGzFile || this->source->fileVersion != FILE_FORMAT_VERSION) {
+            return nullptr;
+        }
+        return this->layers;
+    }
+
+    std::unique_ptr<LazyPageContent> clone() const override {
+        return std::make_unique<LazyPageLoader>(this->source, this->layers);
+    }
+
+private:
+    std::shared_ptr<LazyPageSource> source;
+
+    /**
+     * The layers of the page as they are in the file, shared by the copies of the page
+     */
+    std::shared_ptr<const string> layers;
+};
+
+namespace {
+
+/**
+ * @return The position of the next start tag with the name, or string::npos
+ */
+auto findStartTag(std::string_view content, std::string_view name, size_t from) -> size_t {
+    while ((from = content.find(name, from)) != std::string_view::npos) {
+        size_t end = from + name.size();
+        if (from > 0 && content[from - 1] == '<' && end < content.size() &&
+            (g_ascii_isspace(content[end]) || content[end] == '>' || content[end] == '/')) {
+            return from - 1;
+        }
+        from = end;
+    }
+    return std::string_view::npos;
+}
+
+}  // namespace
+
 LoadHandler::LoadHandler():
         attachedPdfMissing(false),
         removePdfBackgroundFlag(false),
@@ -166,71 +335,138 @@ auto LoadHandler::closeFile() -> bool {
     }
 
     zip_fclose(this->zipContentFile);
+    if (this->zipFp == nullptr) {
+        // Still needed by the lazily loaded pages
+        return true;
+    }
     int zipError = zip_close(this->zipFp);
     return zipError == 0;
 }
 
-auto LoadHandler::readContentFile(char* buffer, zip_uint64_t len) -> zip_int64_t {
-    if (this->isGzFile) {
-        if (gzeof(this->gzFp)) {
-            return -1;
+auto LoadHandler::readContentFile(string& content) -> bool {
+    constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    if (!this->isGzFile) {
+        if (this->zipContentFile == nullptr) {
+            return false;
+        }
+
+        // Avoid reallocating huge documents while reading
+        zip_stat_t contentStat;
+        if (zip_stat(this->zipFp, "content.xml", 0, &contentStat) == 0 && (contentStat.valid & ZIP_STAT_SIZE)) {
+            content.reserve(contentStat.size + CHUNK_SIZE);
         }
-        return gzread(this->gzFp, buffer, static_cast<unsigned int>(len));
     }
 
-    zip_int64_t lengthRead = zip_fread(this->zipContentFile, buffer, len);
-    if (lengthRead > 0) {
-        return lengthRead;
+    size_t length = 0;
+    while (true) {
+        content.resize(length + CHUNK_SIZE);
+
+        zip_int64_t read = 0;
+        if (this->isGzFile) {
+            read = gzread(this->gzFp, &content[length], static_cast<unsigned int>(CHUNK_SIZE));
+        } else {
+            read = zip_fread(this->zipContentFile, &content[length], CHUNK_SIZE);
+        }
+
+        if (read < 0) {
+            return false;
+        }
+        if (read == 0) {
+            break;
+        }
+        length += static_cast<size_t>(read);
     }
 
-    return -1;
+    content.resize(length);
+    return true;
 }
 
-auto LoadHandler::parseXml() -> bool {
-    const GMarkupParser parser = {LoadHandler::parserStartElement, LoadHandler::parserEndElement,
-                                  LoadHandler::parserText, nullptr, nullptr};
+void LoadHandler::resetParser() {
     this->error = nullptr;
-    gboolean valid = true;
-
     this->pos = PARSER_POS_NOT_STARTED;
     this->creator = "Unknown";
     this->fileVersion = 1;
+    this->endRootTag = "xournal";
 
-    GMarkupParseContext* context =
-            g_markup_parse_context_new(&parser, static_cast<GMarkupParseFlags>(0), this, nullptr);
+    this->pages.clear();
+    this->page = nullptr;
+    this->layer = nullptr;
+    this->stroke = nullptr;
+    this->text = nullptr;
+    this->image = nullptr;
+    this->teximage = nullptr;
+    this->pressureBuffer.clear();
+    this->loadedTimeStamp = 0;
+    this->loadedFilename = "";
 
-    zip_int64_t len = 0;
-    do {
-        char buffer[1024];
-        len = readContentFile(buffer, sizeof(buffer));
-        if (len > 0) {
-            valid = g_markup_parse_context_parse(context, buffer, len, &error);
-        }
+    this->pdfFilenameParsed = false;
+    this->attachedPdfMissing = false;
+    this->pdfMissing = "";
+}
 
-        if (error) {
-            g_warning("LoadHandler::parseXml: %s\n", error->message);
-            valid = false;
-            break;
-        }
-    } while (len >= 0 && valid && !error);
+auto LoadHandler::parseXml() -> bool {
+    // The whole content is parsed at once, that's much faster than feeding the parser with small chunks
+    string content;
+    if (!readContentFile(content)) {
+        this->lastError = FS(_F("Could not read file: \"{1}\"") % this->filepath.u8string());
+        return false;
+    }
 
-    if (valid) {
-        valid = g_markup_parse_context_end_parse(context, &error);
-    } else {
-        if (error != nullptr && error->message != nullptr) {
-            this->lastError = FS(_F("XML Parser error: {1}") % error->message);
-            g_error_free(error);
+    vector<string> pageLayers;
+    bool valid = false;
+    bool lazy = false;
+    if (this->lazyLoadingEnabled) {
+        string skeleton = splitPageLayers(content, pageLayers);
+        valid = parseContent(skeleton);
+        lazy = valid && this->pos == PASER_POS_FINISHED && this->pages.size() == pageLayers.size();
+
+        if (lazy) {
+            content = string();
         } else {
-            this->lastError = _("Unknown parser error");
+            // Parse the whole document again, so the errors are reported as usual
+            this->lastError = "";
+            pageLayers.clear();
+            this->doc.clearDocument();
         }
-        g_warning("LoadHandler::parseXml: %s\n", this->lastError.c_str());
     }
 
-    g_markup_parse_context_free(context);
+    if (!lazy) {
+        valid = parseContent(content);
+    }
 
     // Add all parsed pages to the document
     this->doc.addPages(pages.begin(), pages.end());
 
+    if (lazy && std::any_of(pageLayers.begin(), pageLayers.end(), [](const string& xml) { return !xml.empty(); })) {
+        auto source = std::make_shared<LazyPageSource>();
+        source->filepath = this->filepath;
+        source->fileVersion = this->fileVersion;
+        source->isGzFile = this->isGzFile;
+        source->fastParserEnabled = this->fastParserEnabled;
+
+        GHashTableIter iter;
+        gpointer key = nullptr;
+        gpointer value = nullptr;
+        g_hash_table_iter_init(&iter, this->audioFiles);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            source->audioFiles[static_cast<char*>(key)] = static_cast<char*>(value);
+        }
+
+        if (!this->isGzFile) {
+            // The archive is closed with the last lazily loaded page
+            source->zipFp = this->zipFp;
+            this->zipFp = nullptr;
+        }
+
+        for (size_t i = 0; i < pages.size(); i++) {
+            if (!pageLayers[i].empty()) {
+                auto layers = std::make_shared<const string>(std::move(pageLayers[i]));
+                pages[i]->setLazyContent(std::make_unique<LazyPageLoader>(source, std::move(layers)));
+            }
+        }
+    }
+
     if (this->pos != PASER_POS_FINISHED && this->lastError.empty()) {
         lastError = _("Document is not complete (maybe the end is cut off?)");
         return false;
@@ -245,6 +481,90 @@ auto LoadHandler::parseXml() -> bool {
     return valid;
 }
 
+auto LoadHandler::parseContent(string& content) -> bool {
+    const GMarkupParser parser = {LoadHandler::parserStartElement, LoadHandler::parserEndElement,
+                                  LoadHandler::parserText, nullptr, nullptr};
+
+    resetParser();
+    gboolean valid = true;
+
+    this->fastParserUsed = false;
+    if (this->fastParserEnabled && g_utf8_validate(content.data(), static_cast<gssize>(content.size()), nullptr)) {
+        FastXmlParser fastParser(&parser, this);
+        if (fastParser.parse(&content[0], content.size(), &error) == FastXmlParser::PARSED) {
+            this->fastParserUsed = true;
+            valid = error == nullptr;
+        } else {
+            // Not supported by the fast parser, GMarkup parses the document again (and reports the errors)
+            resetParser();
+            this->doc.clearDocument();
+        }
+    }
+
+    GMarkupParseContext* context = nullptr;
+    if (!this->fastParserUsed) {
+        context = g_markup_parse_context_new(&parser, static_cast<GMarkupParseFlags>(0), this, nullptr);
+        valid = g_markup_parse_context_parse(context, content.data(), static_cast<gssize>(content.size()), &error);
+        if (error) {
+            valid = false;
+        }
+    }
+
+    if (valid) {
+        if (context) {
+            valid = g_markup_parse_context_end_parse(context, &error);
+        }
+    } else {
+        if (error != nullptr && error->message != nullptr) {
+            this->lastError = FS(_F("XML Parser error: {1}") % error->message);
+            g_error_free(error);
+        } else {
+            this->lastError = _("Unknown parser error");
+        }
+        g_warning("LoadHandler::parseXml: %s\n", this->lastError.c_str());
+    }
+
+    if (context) {
+        g_markup_parse_context_free(context);
+    }
+
+    return valid;
+}
+
+auto LoadHandler::splitPageLayers(const string& content, vector<string>& pageLayers) -> string {
+    constexpr std::string_view PAGE_END = "</page>";
+
+    std::string_view view(content);
+    string skeleton;
+    size_t copied = 0;
+    size_t pageStart = 0;
+
+    while ((pageStart = findStartTag(view, "page", pageStart)) != std::string_view::npos) {
+        size_t pageEnd = view.find(PAGE_END, pageStart);
+        if (pageEnd == std::string_view::npos) {
+            break;
+        }
+
+        std::string_view page = view.substr(pageStart, pageEnd - pageStart);
+        size_t layerStart = findStartTag(page, "layer", 0);
+        if (layerStart != std::string_view::npos &&
+            findStartTag(page, "background", layerStart) == std::string_view::npos) {
+            skeleton.append(view.substr(copied, pageStart + layerStart - copied));
+
+            pageLayers.emplace_back(page.substr(layerStart));
+
+            copied = pageEnd;
+        } else {
+            pageLayers.emplace_back();
+        }
+
+        pageStart = pageEnd + PAGE_END.size();
+    }
+
+    skeleton.append(view.substr(copied));
+    return skeleton;
+}
+
 void LoadHandler::parseStart() {
     if (strcmp(elementName, "xournal") == 0) {
         endRootTag = "xournal";
@@ -503,9 +823,11 @@ void LoadHandler::parseStroke() {
     this->layer->addElement(this->stroke);
 
     const char* width = LoadHandlerHelper::getAttrib("width", false, this);
+    const char* widthEnd = width + strlen(width);
 
-    char* endPtr = nullptr;
-    stroke->setWidth(g_ascii_strtod(width, &endPtr));
+    double strokeWidth = 0;
+    const char* endPtr = Util::parseDouble(width, widthEnd, strokeWidth);
+    stroke->setWidth(strokeWidth);
     if (endPtr == width) {
         error("%s", FC(_F("Error reading width of a stroke: {1}") % width));
         return;
@@ -515,17 +837,9 @@ void LoadHandler::parseStroke() {
     const char* pressure = LoadHandlerHelper::getAttrib("pressures", true, this);
     if (pressure == nullptr) {
         // Xournal / Xournal++ uses the width field
-        pressure = endPtr;
-    }
-
-    while (*pressure != 0) {
-        char* tmpptr = nullptr;
-        double val = g_ascii_strtod(pressure, &tmpptr);
-        if (tmpptr == pressure) {
-            break;
-        }
-        pressure = tmpptr;
-        this->pressureBuffer.push_back(val);
+        Util::parseDoubles(endPtr, widthEnd, this->pressureBuffer);
+    } else {
+        Util::parseDoubles(pressure, pressure + strlen(pressure), this->pressureBuffer);
     }
 
     Color color{0U};
@@ -871,30 +1185,19 @@ void LoadHandler::parserText(GMarkupParseContext* context, const gchar* text, gs
 
     auto* handler = static_cast<LoadHandler*>(userdata);
     if (handler->pos == PARSER_POS_IN_STROKE) {
-        const char* ptr = text;
-        int n = 0;
+        vector<double>& coordinates = handler->coordinateBuffer;
+        coordinates.clear();
+        Util::parseDoubles(text, text + textLen, coordinates);
 
-        bool xRead = false;
-        double x = 0;
-
-        while (textLen > 0) {
-            double tmp = g_ascii_strtod(text, const_cast<char**>(&ptr));
-            if (ptr == text) {
-                break;
-            }
-            textLen -= (ptr - text);
-            text = ptr;
-            n++;
+        int n = static_cast<int>(coordinates.size());
 
-            if (!xRead) {
-                xRead = true;
-                x = tmp;
-            } else {
-                xRead = false;
-                handler->stroke->addPoint(Point(x, tmp));
-            }
+        // Reserve exactly, so the point arrays never need to grow or to be shrunk
+        StrokePoints points;
+        points.reserve(coordinates.size() / 2);
+        for (size_t i = 0; i + 1 < coordinates.size(); i += 2) {
+            points.add(Point(coordinates[i], coordinates[i + 1]));
         }
-        handler->stroke->freeUnusedPointItems();
+        handler->stroke->setPoints(std::move(points));
 
         if (n < 4 || (n & 1)) {
             error2(*error, "%s", FC(_F("Wrong count of points ({1})") % n));
@@ -1048,3 +1351,9 @@ auto LoadHandler::getTempFileForPath(fs::path const& filename) -> fs::path {
 }
 
 auto LoadHandler::getFileVersion() const -> int { return this->fileVersion; }
+
+void LoadHandler::setFastParserEnabled(bool enabled) { this->fastParserEnabled = enabled; }
+
+auto LoadHandler::isFastParserUsed() const -> bool { return this->fastParserUsed; }
+
+void LoadHandler::setLazyLoadingEnabled(bool enabled) { this->lazyLoadingEnabled = enabled; }
@@ -58,6 +58,20 @@ public:
     /** @return The version of the loaded file */
     int getFileVersion() const;
 
+    /**
+     * Use the fast parser for documents it supports (enabled by default), else all documents are parsed by GMarkup
+     */
+    void setFastParserEnabled(bool enabled);
+
+    /** @return true if the last document was parsed by the fast parser */
+    bool isFastParserUsed() const;
+
+    /**
+     * Only parse the backgrounds of the pages while loading (disabled by default), the layers of a page are parsed
+     * when the page is accessed the first time. Errors within the layers are only reported as warning then.
+     */
+    void setLazyLoadingEnabled(bool enabled);
+
 private:
     void parseStart();
     void parseContents();
@@ -74,11 +88,37 @@ private:
     void initAttributes();
 
     string readLine();
-    zip_int64_t readContentFile(char* buffer, zip_uint64_t len);
+
+    /**
+     * Reads the whole decompressed content file
+     */
+    bool readContentFile(string& content);
     bool closeFile();
     bool openFile(fs::path const& filepath);
     bool parseXml();
 
+    /**
+     * Parses the whole XML content, by the fast parser if possible
+     *
+     * @return false on errors, lastError is set then
+     */
+    bool parseContent(string& content);
+
+    /**
+     * Moves the layers of each page out of the content, for lazy loading.
+     * The layers of a page are only moved if nothing but layers follows the first layer.
+     *
+     * @param pageLayers Filled with the layers of each page, or an empty string if the layers of the page were
+     *                   not moved
+     * @return The content without the moved layers
+     */
+    static string splitPageLayers(const string& content, vector<string>& pageLayers);
+
+    /**
+     * Resets the state of the parser, and discards everything parsed so far
+     */
+    void resetParser();
+
     static void parserText(GMarkupParseContext* context, const gchar* text, gsize textLen, gpointer userdata,
                            GError** error);
     static void parserEndElement(GMarkupParseContext* context, const gchar* elementName, gpointer userdata,
@@ -116,6 +156,11 @@ private:
 
     bool pdfFilenameParsed;
 
+    bool fastParserEnabled = true;
+    bool fastParserUsed = false;
+
+    bool lazyLoadingEnabled = false;
+
     ParserPosition pos;
 
     string creator;
@@ -129,6 +174,11 @@ private:
 
     vector<double> pressureBuffer;
 
+    /**
+     * The coordinates of the stroke which is parsed, reused for all strokes
+     */
+    vector<double> coordinateBuffer;
+
     std::vector<PageRef> pages;
     PageRef page;
     Layer* layer;
@@ -153,6 +203,8 @@ private:
     DocumentHandler dHanlder;
     Document doc;
 
+    friend class LazyPageLoader;
+
     friend Color LoadHandlerHelper::parseBackgroundColor(LoadHandler* loadHandler);
     friend bool LoadHandlerHelper::parseColor(const char* text, Color& color, LoadHandler* loadHandler);
 
@@ -0,0 +1,48 @@
+#include "SaveCache.h"
+
+#include <utility>
+
+#include "control/Control.h"
+#include "model/Document.h"
+
+SaveCache::SaveCache(Control* control): control(control) {}
+
+SaveCache::~SaveCache() = default;
+
+auto SaveCache::get(uint64_t revision) -> std::shared_ptr<const string> {
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+
+    auto it = this->layers.find(revision);
+    if (it == this->layers.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void SaveCache::replace(std::unordered_map<uint64_t, std::shared_ptr<const string>> layers) {
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+    this->layers = std::move(layers);
+}
+
+void SaveCache::clear() {
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+    this->layers.clear();
+}
+
+void SaveCache::documentChanged(DocumentChangeType type) {
+    if (type == DOCUMENT_CHANGE_CLEARED || type == DOCUMENT_CHANGE_COMPLETE) {
+        // The pages were replaced, the cached layers will not be used anymore
+        clear();
+    }
+}
+
+void SaveCache::pageSizeChanged(size_t page) { markPageChanged(page); }
+
+void SaveCache::pageChanged(size_t page) { markPageChanged(page); }
+
+void SaveCache::markPageChanged(size_t page) {
+    PageRef p = this->control->getDocument()->getPage(page);
+    if (p) {
+        p->markChanged();
+    }
+}
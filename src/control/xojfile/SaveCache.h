@@ -0,0 +1,69 @@
+/*
+ * Xournal++
+ *
+ * Serialized pages of the last autosave
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "model/DocumentListener.h"
+
+#include "XournalType.h"
+
+class Control;
+
+/**
+ * @brief Keeps the serialized layers of the pages of the last autosave, by page revision
+ *
+ * The revision of a page changes with every undo action on the page, every change of the elements of its layers
+ * and with the page change events of the document, so on autosave only the pages changed since the last autosave
+ * need to be serialized again.
+ */
+class SaveCache: public DocumentListener {
+public:
+    explicit SaveCache(Control* control);
+    ~SaveCache() override;
+
+private:
+    SaveCache(const SaveCache& cache);
+    void operator=(const SaveCache& cache);
+
+public:
+    /**
+     * @return The serialized layers of the page revision, or nullptr if they are not cached
+     */
+    std::shared_ptr<const string> get(uint64_t revision);
+
+    /**
+     * Replaces the content of the cache with the layers written by the last save, so the cache does not keep
+     * revisions of pages which changed or were deleted since
+     */
+    void replace(std::unordered_map<uint64_t, std::shared_ptr<const string>> layers);
+
+    void clear();
+
+public:
+    void documentChanged(DocumentChangeType type) override;
+    void pageSizeChanged(size_t page) override;
+    void pageChanged(size_t page) override;
+
+private:
+    void markPageChanged(size_t page);
+
+private:
+    Control* control;
+
+    std::mutex cacheMutex;
+    std::unordered_map<uint64_t, std::shared_ptr<const string>> layers;
+};
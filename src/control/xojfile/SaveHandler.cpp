@@ -1,16 +1,14 @@
 #include "SaveHandler.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <unordered_map>
+#include <utility>
 
 #include <config.h>
 
 #include "control/jobs/ProgressListener.h"
 #include "control/pagetype/PageTypeHandler.h"
-#include "control/xml/XmlImageNode.h"
-#include "control/xml/XmlNode.h"
-#include "control/xml/XmlPointNode.h"
-#include "control/xml/XmlTexNode.h"
-#include "control/xml/XmlTextNode.h"
 #include "model/BackgroundImage.h"
 #include "model/Document.h"
 #include "model/Image.h"
@@ -21,67 +19,64 @@
 #include "model/Text.h"
 
 #include "PathUtil.h"
+#include "SaveCache.h"
 #include "i18n.h"
 
+/**
+ * Size of the chunks in which the XML is written to the output, to report the progress
+ */
+constexpr size_t WRITE_CHUNK_SIZE = 1024 * 1024;
+
 SaveHandler::SaveHandler() {
-    this->root = nullptr;
     this->firstPdfPageVisited = false;
     this->attachBgId = 1;
-    this->backgroundImages = nullptr;
 }
 
-SaveHandler::~SaveHandler() {
-    delete this->root;
+SaveHandler::~SaveHandler() = default;
 
-    for (GList* l = this->backgroundImages; l != nullptr; l = l->next) {
-        delete static_cast<BackgroundImage*>(l->data);
-    }
-    g_list_free(this->backgroundImages);
-    this->backgroundImages = nullptr;
-}
+void SaveHandler::prepareSave(Document* doc, SaveCache* cache) {
+    // cleanup old data
+    this->content.clear();
+    this->pages.clear();
+    this->cache = cache;
 
-void SaveHandler::prepareSave(Document* doc) {
-    if (this->root) {
-        // cleanup old data
-        delete this->root;
-        this->root = nullptr;
-
-        for (GList* l = this->backgroundImages; l != nullptr; l = l->next) {
-            delete static_cast<BackgroundImage*>(l->data);
-        }
-        g_list_free(this->backgroundImages);
-        this->backgroundImages = nullptr;
-    }
+    this->backgrounds.clear();
 
     this->firstPdfPageVisited = false;
     this->attachBgId = 1;
 
-    this->root = new XmlNode("xournal");
+    // The XML is locale-safe, doubles are always written using Locale 'C' format
+    this->content.write("<?xml version=\"1.0\" standalone=\"no\"?>\n");
+
+    XmlWriter writer(&this->content);
+    writer.startElement("xournal");
 
-    writeHeader();
+    writeHeader(writer);
 
     cairo_surface_t* preview = doc->getPreview();
     if (preview) {
-        auto* image = new XmlImageNode("preview");
-        image->setImage(preview);
-        this->root->addChild(image);
+        writer.startElement("preview");
+        writer.writeImage(preview);
+        writer.endElement();
     }
 
     for (size_t i = 0; i < doc->getPageCount(); i++) {
         PageRef p = doc->getPage(i);
-        p->getBackgroundImage().clearSaveState();
+        p->lockShared();
+        visitPage(writer, p, doc, i);
+        p->unlockShared();
     }
 
-    for (size_t i = 0; i < doc->getPageCount(); i++) {
-        PageRef p = doc->getPage(i);
-        visitPage(this->root, p, doc, i);
-    }
+    writer.endElement();
 }
 
-void SaveHandler::writeHeader() {
-    this->root->setAttrib("creator", PROJECT_STRING);
-    this->root->setAttrib("fileversion", FILE_FORMAT_VERSION);
-    this->root->addChild(new XmlTextNode("title", std::string{"Xournal++ document - see "} + PROJECT_URL));
+void SaveHandler::writeHeader(XmlWriter& writer) {
+    writer.writeAttribute("creator", PROJECT_STRING);
+    writer.writeAttribute("fileversion", FILE_FORMAT_VERSION);
+
+    writer.startElement("title");
+    writer.writeText(std::string{"Xournal++ document - see "} + PROJECT_URL);
+    writer.endElement();
 }
 
 auto SaveHandler::getColorStr(Color c, unsigned char alpha) -> string {
@@ -91,129 +86,130 @@ auto SaveHandler::getColorStr(Color c, unsigned char alpha) -> string {
     return color;
 }
 
-void SaveHandler::writeTimestamp(AudioElement* audioElement, XmlAudioNode* xmlAudioNode) {
-    /** set stroke timestamp value to the XmlPointNode */
-    xmlAudioNode->setAttrib("ts", audioElement->getTimestamp());
-    xmlAudioNode->setAttrib("fn", audioElement->getAudioFilename());
+void SaveHandler::writeTimestamp(XmlWriter& writer, AudioElement* audioElement) {
+    writer.writeAttribute("ts", audioElement->getTimestamp());
+    writer.writeAttribute("fn", audioElement->getAudioFilename());
 }
 
-void SaveHandler::visitStroke(XmlPointNode* stroke, Stroke* s) {
+void SaveHandler::visitStroke(XmlWriter& writer, Stroke* s) {
     StrokeTool t = s->getToolType();
 
     unsigned char alpha = 0xff;
 
     if (t == STROKE_TOOL_PEN) {
-        stroke->setAttrib("tool", "pen");
-        writeTimestamp(s, stroke);
+        writer.writeAttribute("tool", "pen");
+        writeTimestamp(writer, s);
     } else if (t == STROKE_TOOL_ERASER) {
-        stroke->setAttrib("tool", "eraser");
+        writer.writeAttribute("tool", "eraser");
     } else if (t == STROKE_TOOL_HIGHLIGHTER) {
-        stroke->setAttrib("tool", "highlighter");
+        writer.writeAttribute("tool", "highlighter");
         alpha = 0x7f;
     } else {
         g_warning("Unknown stroke tool type: %i", t);
-        stroke->setAttrib("tool", "pen");
+        writer.writeAttribute("tool", "pen");
     }
 
-    stroke->setAttrib("color", getColorStr(s->getColor(), alpha).c_str());
+    writer.writeAttribute("color", getColorStr(s->getColor(), alpha));
 
-    int pointCount = s->getPointCount();
-
-    for (int i = 0; i < pointCount; i++) {
-        Point p = s->getPoint(i);
-        stroke->addPoint(&p);
-    }
+    const StrokePoints& points = s->getPointData();
 
     if (s->hasPressure()) {
-        auto* values = new double[pointCount + 1];
-        values[0] = s->getWidth();
-        for (int i = 0; i < pointCount; i++) {
-            values[i + 1] = s->getPoint(i).z;
-        }
-
-        stroke->setAttrib("width", values, pointCount);
+        // The pressure of the last point is not stored, there is one width per segment
+        const double* pressure = points.getPressure();
+        std::vector<double> values;
+        values.reserve(points.size());
+        values.push_back(s->getWidth());
+        values.insert(values.end(), pressure, pressure + points.size() - 1);
+
+        writer.writeAttribute("width", values);
     } else {
-        stroke->setAttrib("width", s->getWidth());
+        writer.writeAttribute("width", s->getWidth());
     }
 
-    visitStrokeExtended(stroke, s);
+    visitStrokeExtended(writer, s);
+
+    writer.writePoints(points);
 }
 
 /**
  * Export the fill attributes
  */
-void SaveHandler::visitStrokeExtended(XmlPointNode* stroke, Stroke* s) {
+void SaveHandler::visitStrokeExtended(XmlWriter& writer, Stroke* s) {
     if (s->getFill() != -1) {
-        stroke->setAttrib("fill", s->getFill());
+        writer.writeAttribute("fill", s->getFill());
     }
 
     if (s->getLineStyle().hasDashes()) {
-        stroke->setAttrib("style", StrokeStyle::formatStyle(s->getLineStyle()));
+        writer.writeAttribute("style", StrokeStyle::formatStyle(s->getLineStyle()));
     }
 }
 
-void SaveHandler::visitLayer(XmlNode* page, Layer* l) {
-    auto* layer = new XmlNode("layer");
-    page->addChild(layer);
+void SaveHandler::visitLayer(XmlWriter& writer, Layer* l) {
+    writer.startElement("layer");
     if (l->hasName()) {
-        layer->setAttrib("name", l->getName().c_str());
+        writer.writeAttribute("name", l->getName());
     }
 
     for (Element* e: *l->getElements()) {
         if (e->getType() == ELEMENT_STROKE) {
             auto* s = dynamic_cast<Stroke*>(e);
-            auto* stroke = new XmlPointNode("stroke");
-            layer->addChild(stroke);
-            visitStroke(stroke, s);
+            writer.startElement("stroke");
+            visitStroke(writer, s);
+            writer.endElement();
         } else if (e->getType() == ELEMENT_TEXT) {
             Text* t = dynamic_cast<Text*>(e);
-            auto* text = new XmlTextNode("text", t->getText());
-            layer->addChild(text);
+            writer.startElement("text");
 
             XojFont& f = t->getFont();
 
-            text->setAttrib("font", f.getName().c_str());
-            text->setAttrib("size", f.getSize());
-            text->setAttrib("x", t->getX());
-            text->setAttrib("y", t->getY());
-            text->setAttrib("color", getColorStr(t->getColor()).c_str());
+            writer.writeAttribute("font", f.getName());
+            writer.writeAttribute("size", f.getSize());
+            writer.writeAttribute("x", t->getX());
+            writer.writeAttribute("y", t->getY());
+            writer.writeAttribute("color", getColorStr(t->getColor()));
+
+            writeTimestamp(writer, t);
 
-            writeTimestamp(t, text);
+            writer.writeText(t->getText());
+            writer.endElement();
         } else if (e->getType() == ELEMENT_IMAGE) {
             auto* i = dynamic_cast<Image*>(e);
-            auto* image = new XmlImageNode("image");
-            layer->addChild(image);
+            writer.startElement("image");
 
-            image->setImage(i->getImage());
+            writer.writeAttribute("left", i->getX());
+            writer.writeAttribute("top", i->getY());
+            writer.writeAttribute("right", i->getX() + i->getElementWidth());
+            writer.writeAttribute("bottom", i->getY() + i->getElementHeight());
 
-            image->setAttrib("left", i->getX());
-            image->setAttrib("top", i->getY());
-            image->setAttrib("right", i->getX() + i->getElementWidth());
-            image->setAttrib("bottom", i->getY() + i->getElementHeight());
+            // Written as loaded, without decoding and encoding the image again
+            writer.writeBase64(*i->getPngData());
+            writer.endElement();
         } else if (e->getType() == ELEMENT_TEXIMAGE) {
             auto* i = dynamic_cast<TexImage*>(e);
-            auto* image = new XmlTexNode("teximage", std::string(i->getBinaryData()));
-            layer->addChild(image);
-
-            image->setAttrib("text", i->getText().c_str());
-            image->setAttrib("left", i->getX());
-            image->setAttrib("top", i->getY());
-            image->setAttrib("right", i->getX() + i->getElementWidth());
-            image->setAttrib("bottom", i->getY() + i->getElementHeight());
+            writer.startElement("teximage");
+
+            writer.writeAttribute("text", i->getText());
+            writer.writeAttribute("left", i->getX());
+            writer.writeAttribute("top", i->getY());
+            writer.writeAttribute("right", i->getX() + i->getElementWidth());
+            writer.writeAttribute("bottom", i->getY() + i->getElementHeight());
+
+            writer.writeBase64(i->getBinaryData());
+            writer.endElement();
         }
     }
+
+    writer.endElement();
 }
 
-void SaveHandler::visitPage(XmlNode* root, PageRef p, Document* doc, int id) {
-    auto* page = new XmlNode("page");
-    root->addChild(page);
-    page->setAttrib("width", p->getWidth());
-    page->setAttrib("height", p->getHeight());
+void SaveHandler::visitPage(XmlWriter& writer, PageRef p, Document* doc, int id) {
+    writer.startElement("page");
+    writer.writeAttribute("width", p->getWidth());
+    writer.writeAttribute("height", p->getHeight());
 
-    auto* background = new XmlNode("background");
-    page->addChild(background);
+    writer.startElement("background");
 
-    writeBackgroundName(background, p);
+    writeBackgroundName(writer, p);
 
     if (p->getBackgroundType().isPdfPage()) {
         /**
@@ -221,16 +217,16 @@ void SaveHandler::visitPage(XmlNode* root, PageRef p, Document* doc, int id) {
          * DO NOT CHANGE THE ORDER OF THE ATTRIBUTES!
          */
 
-        background->setAttrib("type", "pdf");
+        writer.writeAttribute("type", "pdf");
         if (!firstPdfPageVisited) {
             firstPdfPageVisited = true;
 
             if (doc->isAttachPdf()) {
-                background->setAttrib("domain", "attach");
+                writer.writeAttribute("domain", "attach");
                 auto filepath = doc->getFilepath();
                 Util::clearExtensions(filepath);
                 filepath += ".xopp.bg.pdf";
-                background->setAttrib("filename", "bg.pdf");
+                writer.writeAttribute("filename", "bg.pdf");
 
                 GError* error = nullptr;
                 doc->getPdfDocument().save(filepath, &error);
@@ -245,73 +241,103 @@ void SaveHandler::visitPage(XmlNode* root, PageRef p, Document* doc, int id) {
                     g_error_free(error);
                 }
             } else {
-                background->setAttrib("domain", "absolute");
-                background->setAttrib("filename", doc->getPdfFilepath().string());
+                writer.writeAttribute("domain", "absolute");
+                writer.writeAttribute("filename", doc->getPdfFilepath().string());
             }
         }
-        background->setAttrib("pageno", p->getPdfPageNr() + 1);
+        writer.writeAttribute("pageno", p->getPdfPageNr() + 1);
     } else if (p->getBackgroundType().isImagePage()) {
-        background->setAttrib("type", "pixmap");
-
-        int cloneId = p->getBackgroundImage().getCloneId();
-        if (cloneId != -1) {
-            background->setAttrib("domain", "clone");
-            char* filename = g_strdup_printf("%i", cloneId);
-            background->setAttrib("filename", filename);
-            g_free(filename);
-        } else if (p->getBackgroundImage().isAttached() && p->getBackgroundImage().getPixbuf()) {
-            char* filename = g_strdup_printf("bg_%d.png", this->attachBgId++);
-            background->setAttrib("domain", "attach");
-            background->setAttrib("filename", filename);
-            p->getBackgroundImage().setFilepath(filename);
-
-            auto* img = new BackgroundImage();
-            *img = p->getBackgroundImage();
-            this->backgroundImages = g_list_append(this->backgroundImages, img);
-
-            g_free(filename);
-            p->getBackgroundImage().setCloneId(id);
+        writer.writeAttribute("type", "pixmap");
+
+        BackgroundImage& image = p->getBackgroundImage();
+        auto saved = std::find_if(this->backgrounds.begin(), this->backgrounds.end(),
+                                  [&](SavedBackground& b) { return b.image == image; });
+        if (saved != this->backgrounds.end()) {
+            writer.writeAttribute("domain", "clone");
+            writer.writeAttribute("filename", std::to_string(saved->pageId));
+        } else if (image.isAttached() && image.getPixbuf()) {
+            string filename = "bg_" + std::to_string(this->attachBgId++) + ".png";
+            writer.writeAttribute("domain", "attach");
+            writer.writeAttribute("filename", filename);
+            this->backgrounds.push_back({image, id, filename});
         } else {
-            background->setAttrib("domain", "absolute");
-            background->setAttrib("filename", p->getBackgroundImage().getFilepath().string());
-            p->getBackgroundImage().setCloneId(id);
+            writer.writeAttribute("domain", "absolute");
+            writer.writeAttribute("filename", image.getFilepath().string());
+            this->backgrounds.push_back({image, id, ""});
         }
     } else {
-        writeSolidBackground(background, p);
+        writeSolidBackground(writer, p);
+    }
+
+    writer.endElement();
+
+    // The layers are independent of the other pages, so they can be reused if the page did not change
+    PageLayers layers;
+    layers.prefix = this->content.takeString();
+    layers.revision = p->getRevision();
+    if (this->cache) {
+        layers.xml = this->cache->get(layers.revision);
     }
+    if (!layers.xml) {
+        // Pages which were never loaded, or could not be parsed completely, are written as they were read
+        layers.xml = p->getUnparsedLayersXml();
+    }
+    if (!layers.xml) {
+        // Copying is much faster than serializing, the snapshot is serialized in saveTo() without the lock
+        layers.copy = p->getSnapshot();
+    }
+    this->pages.push_back(std::move(layers));
+
+    writer.endElement();
+}
 
+void SaveHandler::visitLayers(XmlWriter& writer, PageRef p) {
     // no layer, but we need to write one layer, else the old Xournal cannot read the file
     if (p->getLayers()->empty()) {
-        auto* layer = new XmlNode("layer");
-        page->addChild(layer);
+        writer.startElement("layer");
+        writer.endElement();
     }
 
     for (Layer* l: *p->getLayers()) {
-        visitLayer(page, l);
+        visitLayer(writer, l);
     }
 }
 
-void SaveHandler::writeSolidBackground(XmlNode* background, PageRef p) {
-    background->setAttrib("type", "solid");
-    background->setAttrib("color", getColorStr(p->getBackgroundColor()));
+auto SaveHandler::serializeLayers(PageRef p) -> std::shared_ptr<const string> {
+    StringOutputStream out;
+    XmlWriter writer(&out);
+    visitLayers(writer, p);
+
+    return std::make_shared<const string>(out.takeString());
+}
+
+void SaveHandler::writeSolidBackground(XmlWriter& writer, PageRef p) {
+    writer.writeAttribute("type", "solid");
+    writer.writeAttribute("color", getColorStr(p->getBackgroundColor()));
 
-    background->setAttrib("style", PageTypeHandler::getStringForPageTypeFormat(p->getBackgroundType().format));
+    writer.writeAttribute("style", PageTypeHandler::getStringForPageTypeFormat(p->getBackgroundType().format));
 
     // Not compatible with Xournal, so the background needs
     // to be changed to a basic one!
     if (!p->getBackgroundType().config.empty()) {
-        background->setAttrib("config", p->getBackgroundType().config);
+        writer.writeAttribute("config", p->getBackgroundType().config);
     }
 }
 
-void SaveHandler::writeBackgroundName(XmlNode* background, PageRef p) {
+void SaveHandler::writeBackgroundName(XmlWriter& writer, PageRef p) {
     if (p->backgroundHasName()) {
-        background->setAttrib("name", p->getBackgroundName());
+        writer.writeAttribute("name", p->getBackgroundName());
     }
 }
 
+void SaveHandler::setCompressionLevel(int level) { this->compressionLevel = level; }
+
 void SaveHandler::saveTo(const fs::path& filepath, ProgressListener* listener) {
-    GzOutputStream out(filepath);
+    saveTo(filepath, filepath, listener);
+}
+
+void SaveHandler::saveTo(const fs::path& target, const fs::path& filepath, ProgressListener* listener) {
+    ParallelGzOutputStream out(target, this->compressionLevel);
 
     if (!out.getLastError().empty()) {
         this->errorMessage = out.getLastError();
@@ -328,16 +354,52 @@ void SaveHandler::saveTo(const fs::path& filepath, ProgressListener* listener) {
 }
 
 void SaveHandler::saveTo(OutputStream* out, const fs::path& filepath, ProgressListener* listener) {
-    // XMLNode should be locale-safe ( store doubles using Locale 'C' format
+    const string& xml = this->content.getString();
+    size_t chunks = (xml.size() + WRITE_CHUNK_SIZE - 1) / WRITE_CHUNK_SIZE;
 
-    out->write("<?xml version=\"1.0\" standalone=\"no\"?>\n");
-    root->writeOut(out, listener);
+    if (listener) {
+        listener->setMaximumState(static_cast<int>(this->pages.size() + chunks));
+    }
+
+    int state = 0;
+    for (PageLayers& layers: this->pages) {
+        out->write(layers.prefix);
 
-    for (GList* l = this->backgroundImages; l != nullptr; l = l->next) {
-        auto* img = static_cast<BackgroundImage*>(l->data);
+        if (!layers.xml) {
+            layers.xml = serializeLayers(layers.copy);
+            layers.copy = nullptr;
+        }
+        out->write(*layers.xml);
+
+        if (listener) {
+            listener->setCurrentState(++state);
+        }
+    }
+
+    for (size_t i = 0; i < chunks; i++) {
+        size_t offset = i * WRITE_CHUNK_SIZE;
+        out->write(xml.data() + offset, static_cast<int>(std::min(WRITE_CHUNK_SIZE, xml.size() - offset)));
+
+        if (listener) {
+            listener->setCurrentState(++state);
+        }
+    }
+
+    if (this->cache) {
+        std::unordered_map<uint64_t, std::shared_ptr<const string>> cached;
+        for (PageLayers& layers: this->pages) {
+            cached.emplace(layers.revision, layers.xml);
+        }
+        this->cache->replace(std::move(cached));
+    }
+
+    for (SavedBackground& background: this->backgrounds) {
+        if (background.filename.empty()) {
+            continue;
+        }
 
-        auto tmpfn = (fs::path(filepath) += ".") += img->getFilepath();
-        if (!gdk_pixbuf_save(img->getPixbuf(), tmpfn.u8string().c_str(), "png", nullptr, nullptr)) {
+        auto tmpfn = (fs::path(filepath) += ".") += background.filename;
+        if (!gdk_pixbuf_save(background.image.getPixbuf(), tmpfn.u8string().c_str(), "png", nullptr, nullptr)) {
             if (!this->errorMessage.empty()) {
                 this->errorMessage += "\n";
             }
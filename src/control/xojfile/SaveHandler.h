@@ -11,10 +11,13 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
-#include "control/xml/XmlAudioNode.h"
+#include "control/xml/XmlWriter.h"
+#include "model/BackgroundImage.h"
 #include "model/Document.h"
 #include "model/PageRef.h"
 #include "model/Stroke.h"
@@ -22,9 +25,9 @@
 #include "OutputStream.h"
 #include "XournalType.h"
 
-class XmlNode;
-class XmlPointNode;
+class AudioElement;
 class ProgressListener;
+class SaveCache;
 
 class SaveHandler {
 public:
@@ -32,34 +35,112 @@ public:
     virtual ~SaveHandler();
 
 public:
-    void prepareSave(Document* doc);
+    /**
+     * Writes the document to an in-memory buffer, the document needs to be locked (shared) only while this is called.
+     * The layers are not serialized here, only a snapshot of each page is taken, they are serialized by saveTo().
+     *
+     * @param cache If set, the layers of pages which did not change since the last save with this cache are
+     * taken from the cache.
+     */
+    void prepareSave(Document* doc, SaveCache* cache = nullptr);
+
+    /**
+     * @param level The zlib compression level of the file written by saveTo(), 0 to 9
+     */
+    void setCompressionLevel(int level);
+
+    /**
+     * Writes the file, compressed on several threads
+     */
     void saveTo(const fs::path& filepath, ProgressListener* listener = nullptr);
+
+    /**
+     * Writes the file to target, e.g. a temporary file which is renamed to filepath afterwards.
+     * The attached background images are named after filepath.
+     */
+    void saveTo(const fs::path& target, const fs::path& filepath, ProgressListener* listener);
     void saveTo(OutputStream* out, const fs::path& filepath, ProgressListener* listener = nullptr);
     string getErrorMessage();
 
 protected:
     static string getColorStr(Color c, unsigned char alpha = 0xff);
 
-    virtual void visitPage(XmlNode* root, PageRef p, Document* doc, int id);
-    virtual void visitLayer(XmlNode* page, Layer* l);
-    virtual void visitStroke(XmlPointNode* stroke, Stroke* s);
+    virtual void visitPage(XmlWriter& writer, PageRef p, Document* doc, int id);
+    void visitLayers(XmlWriter& writer, PageRef p);
+    virtual void visitLayer(XmlWriter& writer, Layer* l);
+    virtual void visitStroke(XmlWriter& writer, Stroke* s);
 
     /**
      * Export the fill attributes
      */
-    virtual void visitStrokeExtended(XmlPointNode* stroke, Stroke* s);
+    virtual void visitStrokeExtended(XmlWriter& writer, Stroke* s);
 
-    virtual void writeHeader();
-    virtual void writeSolidBackground(XmlNode* background, PageRef p);
-    virtual void writeTimestamp(AudioElement* audioElement, XmlAudioNode* xmlAudioNode);
-    virtual void writeBackgroundName(XmlNode* background, PageRef p);
+    virtual void writeHeader(XmlWriter& writer);
+    virtual void writeSolidBackground(XmlWriter& writer, PageRef p);
+    virtual void writeTimestamp(XmlWriter& writer, AudioElement* audioElement);
+    virtual void writeBackgroundName(XmlWriter& writer, PageRef p);
+
+private:
+    /**
+     * Writes the layers of the page into a string
+     */
+    std::shared_ptr<const string> serializeLayers(PageRef p);
 
 protected:
-    XmlNode* root;
+    /**
+     * The layers of a page, written in saveTo()
+     */
+    struct PageLayers {
+        /**
+         * The XML before the layers
+         */
+        string prefix;
+
+        uint64_t revision = 0;
+
+        /**
+         * The serialized layers, or nullptr if they are not serialized yet
+         */
+        std::shared_ptr<const string> xml;
+
+        /**
+         * A snapshot of the page, as long as the layers are not serialized
+         */
+        PageRef copy;
+    };
+
+    /**
+     * The XML of the document, written by prepareSave. The pages are stored separately,
+     * and content is the XML after the last page.
+     */
+    StringOutputStream content;
+    vector<PageLayers> pages;
+    SaveCache* cache = nullptr;
+
+    int compressionLevel = Z_DEFAULT_COMPRESSION;
+
     bool firstPdfPageVisited;
     int attachBgId;
 
     string errorMessage;
 
-    GList* backgroundImages;
+    /**
+     * A background image written by this save. Kept here and not in the image, which is shared with the document
+     * and may be read by other threads while saving.
+     */
+    struct SavedBackground {
+        BackgroundImage image;
+
+        /**
+         * The page the image is written with, the other pages with the same image reference it as clone
+         */
+        int pageId;
+
+        /**
+         * The name of the attached file, empty if the image is not attached
+         */
+        string filename;
+    };
+
+    vector<SavedBackground> backgrounds;
 };
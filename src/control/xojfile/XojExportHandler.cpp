@@ -4,11 +4,6 @@
 
 #include "control/jobs/ProgressListener.h"
 #include "control/pagetype/PageTypeHandler.h"
-#include "control/xml/XmlImageNode.h"
-#include "control/xml/XmlNode.h"
-#include "control/xml/XmlPointNode.h"
-#include "control/xml/XmlTexNode.h"
-#include "control/xml/XmlTextNode.h"
 #include "model/BackgroundImage.h"
 #include "model/Document.h"
 #include "model/Image.h"
@@ -26,22 +21,24 @@ XojExportHandler::~XojExportHandler() = default;
 /**
  * Export the fill attributes
  */
-void XojExportHandler::visitStrokeExtended(XmlPointNode* stroke, Stroke* s) {
+void XojExportHandler::visitStrokeExtended(XmlWriter& writer, Stroke* s) {
     // Fill is not exported in .xoj
     // Line style is also not supported
 }
 
-void XojExportHandler::writeHeader() {
-    this->root->setAttrib("creator", PROJECT_STRING);
+void XojExportHandler::writeHeader(XmlWriter& writer) {
+    writer.writeAttribute("creator", PROJECT_STRING);
     // Keep this version on 2, as this is anyway not read by Xournal
-    this->root->setAttrib("fileversion", "2");
-    this->root->addChild(
-            new XmlTextNode("title", std::string{"Xournal document (Compatibility) - see "} + PROJECT_URL));
+    writer.writeAttribute("fileversion", "2");
+
+    writer.startElement("title");
+    writer.writeText(std::string{"Xournal document (Compatibility) - see "} + PROJECT_URL);
+    writer.endElement();
 }
 
-void XojExportHandler::writeSolidBackground(XmlNode* background, PageRef p) {
-    background->setAttrib("type", "solid");
-    background->setAttrib("color", getColorStr(p->getBackgroundColor()));
+void XojExportHandler::writeSolidBackground(XmlWriter& writer, PageRef p) {
+    writer.writeAttribute("type", "solid");
+    writer.writeAttribute("color", getColorStr(p->getBackgroundColor()));
 
     PageTypeFormat bgFormat = p->getBackgroundType().format;
     string format;
@@ -52,13 +49,13 @@ void XojExportHandler::writeSolidBackground(XmlNode* background, PageRef p) {
         format = "plain";
     }
 
-    background->setAttrib("style", format);
+    writer.writeAttribute("style", format);
 }
 
-void XojExportHandler::writeTimestamp(AudioElement* audioElement, XmlAudioNode* xmlAudioNode) {
+void XojExportHandler::writeTimestamp(XmlWriter& writer, AudioElement* audioElement) {
     // Do nothing since timestamp are not supported by Xournal
 }
 
-void XojExportHandler::writeBackgroundName(XmlNode* background, PageRef p) {
+void XojExportHandler::writeBackgroundName(XmlWriter& writer, PageRef p) {
     // Do nothing since background name is not supported by Xournal
 }
@@ -27,11 +27,11 @@ protected:
     /**
      * Export the fill attributes
      */
-    void visitStrokeExtended(XmlPointNode* stroke, Stroke* s) override;
-    void writeHeader() override;
-    void writeSolidBackground(XmlNode* background, PageRef p) override;
-    void writeTimestamp(AudioElement* audioElement, XmlAudioNode* xmlAudioNode) override;
-    void writeBackgroundName(XmlNode* background, PageRef p) override;
+    void visitStrokeExtended(XmlWriter& writer, Stroke* s) override;
+    void writeHeader(XmlWriter& writer) override;
+    void writeSolidBackground(XmlWriter& writer, PageRef p) override;
+    void writeTimestamp(XmlWriter& writer, AudioElement* audioElement) override;
+    void writeBackgroundName(XmlWriter& writer, PageRef p) override;
 
 private:
 };
@@ -33,6 +33,7 @@
 #include "undo/InsertUndoAction.h"
 #include "undo/TextBoxUndoAction.h"
 #include "util/XojMsgBox.h"
+#include "view/ImageCache.h"
 #include "view/TextView.h"
 #include "widgets/XournalWidget.h"
 
@@ -90,7 +91,7 @@ void XojPageView::setIsVisible(bool visible) {
 }
 
 auto XojPageView::getLastVisibleTime() -> int {
-    if (this->crBuffer == nullptr) {
+    if (this->xournal->getTileCache()->getBytes(this) == 0) {
         return -1;
     }
 
@@ -98,12 +99,37 @@ auto XojPageView::getLastVisibleTime() -> int {
 }
 
 void XojPageView::deleteViewBuffer() {
-    g_mutex_lock(&this->drawingMutex);
-    if (this->crBuffer) {
-        cairo_surface_destroy(this->crBuffer);
-        this->crBuffer = nullptr;
+    g_mutex_lock(&this->repaintRectMutex);
+    this->pendingTiles.clear();
+    g_mutex_unlock(&this->repaintRectMutex);
+
+    this->xournal->getTileCache()->remove(this);
+}
+
+void XojPageView::releaseImages() {
+    Document* doc = this->xournal->getDocument();
+    doc->lockShared();
+    this->page->lockShared();
+
+    // The layers of pages which are not loaded yet contain no decoded images
+    if (this->page->isContentLoaded()) {
+        for (Layer* layer: *this->page->getLayers()) {
+            for (Element* e: *layer->getElements()) {
+                if (e->getType() == ELEMENT_STROKE) {
+                    dynamic_cast<Stroke*>(e)->resetRenderCache();
+                } else if (e->getType() == ELEMENT_IMAGE) {
+                    ImageCache::getInstance().release(dynamic_cast<Image*>(e)->getPngData());
+                } else if (e->getType() == ELEMENT_TEXIMAGE) {
+                    dynamic_cast<TexImage*>(e)->releaseRaster();
+                }
+            }
+        }
     }
-    g_mutex_unlock(&this->drawingMutex);
+
+    // The levels of the background image are shared with other pages, they are evicted by the ImageCache
+
+    this->page->unlockShared();
+    doc->unlockShared();
 }
 
 auto XojPageView::containsPoint(int x, int y, bool local) const -> bool {
@@ -205,7 +231,8 @@ void XojPageView::startText(double x, double y) {
         // Is there already a textfield?
         Text* text = nullptr;
 
-        for (Element* e: *this->page->getSelectedLayer()->getElements()) {
+        Rectangle<double> matchArea(x - 10, y - 10, 20, 20);
+        for (Element* e: this->page->getSelectedLayer()->getElementsInArea(matchArea)) {
             if (e->getType() == ELEMENT_TEXT) {
                 GdkRectangle matchRect = {gint(x - 10), gint(y - 10), 20, 20};
                 if (e->intersectsArea(&matchRect)) {
@@ -525,10 +552,7 @@ auto XojPageView::onButtonReleaseEvent(const PositionInputData& pos) -> bool {
 
     if (this->inEraser) {
         this->inEraser = false;
-        Document* doc = this->xournal->getControl()->getDocument();
-        doc->lock();
         this->eraser->finalize();
-        doc->unlock();
     }
 
     if (this->verticalSpace) {
@@ -608,9 +632,27 @@ auto XojPageView::onKeyReleaseEvent(GdkEventKey* event) -> bool {
     return false;
 }
 
-void XojPageView::rerenderPage() {
-    this->rerenderComplete = true;
-    this->xournal->getControl()->getScheduler()->addRerenderPage(this);
+void XojPageView::rerenderPage() { invalidateTiles(nullptr); }
+
+void XojPageView::preloadPage() {
+    double zoom = xournal->getZoom() * xournal->getDpiScaleFactor();
+    if (zoom != this->tileZoom) {
+        setTileZoom(zoom);
+    }
+
+    int col1 = 0, row1 = 0, col2 = 0, row2 = 0;
+    Rectangle<double> area(0, 0, getWidth(), getHeight());
+    if (!TileCache::tileRange(area, zoom, getWidth(), getHeight(), col1, row1, col2, row2)) {
+        return;
+    }
+
+    vector<TileKey> tiles;
+    for (int row = row1; row <= row2; row++) {
+        for (int col = col1; col <= col2; col++) {
+            tiles.push_back({this, zoom, col, row});
+        }
+    }
+    requestTiles(tiles, false);
 }
 
 void XojPageView::repaintPage() { xournal->getRepaintHandler()->repaintPage(this); }
@@ -622,38 +664,41 @@ void XojPageView::repaintArea(double x1, double y1, double x2, double y2) {
 }
 
 void XojPageView::rerenderRect(double x, double y, double width, double height) {
-    int rx = std::lround(std::max(x - 10, 0.0));
-    int ry = std::lround(std::max(y - 10, 0.0));
-    int rwidth = std::lround(width + 20);
-    int rheight = std::lround(height + 20);
-
-    addRerenderRect(rx, ry, rwidth, rheight);
+    auto rect = Rectangle<double>{x - 10, y - 10, width + 20, height + 20};
+    invalidateTiles(&rect);
 }
 
-void XojPageView::addRerenderRect(double x, double y, double width, double height) {
-    if (this->rerenderComplete) {
-        return;
-    }
+void XojPageView::invalidateTiles(const Rectangle<double>* area) {
+    // Tiles which are not cached are rendered as soon as they are painted
+    requestTiles(this->xournal->getTileCache()->invalidate(this, this->tileZoom, area), true);
+}
 
-    auto rect = Rectangle<double>{x, y, width, height};
+void XojPageView::requestTiles(const vector<TileKey>& tiles, bool invalidated) {
+    bool added = false;
 
     g_mutex_lock(&this->repaintRectMutex);
-
-    for (auto&& r: this->rerenderRects) {
-        // its faster to redraw only one rect than repaint twice the same area
-        // so loop through the rectangles to be redrawn, if new rectangle
-        // intersects any of them, replace it by the union with the new one
-        if (r.intersects(rect)) {
-            r.unite(rect);
-            g_mutex_unlock(&this->repaintRectMutex);
-            return;
+    for (const TileKey& key: tiles) {
+        if (!invalidated && this->renderingTiles.count(key)) {
+            continue;
         }
+        added |= this->pendingTiles.insert(key).second;
     }
-
-    this->rerenderRects.push_back(rect);
     g_mutex_unlock(&this->repaintRectMutex);
 
-    this->xournal->getControl()->getScheduler()->addRerenderPage(this);
+    if (added) {
+        this->xournal->getControl()->getScheduler()->addRerenderPage(this);
+    }
+}
+
+void XojPageView::setTileZoom(double zoom) {
+    TileCache* cache = this->xournal->getTileCache();
+
+    if (this->fallbackZoom != zoom) {
+        cache->removeZoomLevel(this, this->fallbackZoom);
+    }
+
+    this->fallbackZoom = this->tileZoom;
+    this->tileZoom = zoom;
 }
 
 void XojPageView::setSelected(bool selected) {
@@ -718,64 +763,119 @@ void XojPageView::drawLoadingPage(cairo_t* cr) {
     cairo_move_to(cr, (page->getWidth() - ex.width) / 2 - ex.x_bearing,
                   (page->getHeight() - ex.height) / 2 - ex.y_bearing);
     cairo_show_text(cr, txtLoading.c_str());
+}
 
-    rerenderPage();
+void XojPageView::paintFallbackTile(cairo_t* cr, const TileKey& key, int width, int height) {
+    int x = key.col * TileCache::TILE_SIZE;
+    int y = key.row * TileCache::TILE_SIZE;
+
+    cairo_save(cr);
+    cairo_rectangle(cr, x, y, width, height);
+    cairo_clip(cr);
+
+    cairo_set_source_rgb(cr, 1, 1, 1);
+    cairo_paint(cr);
+
+    int col1 = 0, row1 = 0, col2 = 0, row2 = 0;
+    if (this->fallbackZoom > 0 && TileCache::tileRange(TileCache::tileArea(key), this->fallbackZoom, getWidth(),
+                                                       getHeight(), col1, row1, col2, row2)) {
+        TileCache* cache = this->xournal->getTileCache();
+        double scale = key.zoom / this->fallbackZoom;
+        cairo_scale(cr, scale, scale);
+
+        for (int row = row1; row <= row2; row++) {
+            for (int col = col1; col <= col2; col++) {
+                cairo_surface_t* tile = cache->lookup({this, this->fallbackZoom, col, row});
+                if (tile == nullptr) {
+                    continue;
+                }
+
+                // Scale current image to fit the zoom level
+                cairo_set_source_surface(cr, tile, col * TileCache::TILE_SIZE, row * TileCache::TILE_SIZE);
+                cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_FAST);
+                cairo_paint(cr);
+                cairo_surface_destroy(tile);
+            }
+        }
+    }
+
+    cairo_restore(cr);
 }
 
 /**
  * Does the painting, called in synchronized block
  */
 void XojPageView::paintPageSync(cairo_t* cr, GdkRectangle* rect) {
-    if (this->crBuffer == nullptr) {
-        drawLoadingPage(cr);
-        return;
+    TileCache* cache = this->xournal->getTileCache();
+    double zoom = xournal->getZoom();
+    int dpiScaleFactor = xournal->getDpiScaleFactor();
+    double tileZoom = zoom * dpiScaleFactor;
+
+    if (tileZoom != this->tileZoom) {
+        setTileZoom(tileZoom);
     }
 
-    double zoom = xournal->getZoom();
-    int dispWidth = getDisplayWidth();
+    // Nothing rendered yet, show the loading page until the first tiles are ready
+    bool loading = cache->getBytes(this) == 0;
+    if (loading) {
+        cairo_save(cr);
+        drawLoadingPage(cr);
+        cairo_restore(cr);
+    }
 
-    cairo_save(cr);
+    Rectangle<double> area = rect ? Rectangle<double>(rect->x / zoom, rect->y / zoom, rect->width / zoom,
+                                                      rect->height / zoom) :
+                                    Rectangle<double>(0, 0, getWidth(), getHeight());
 
-    double width = cairo_image_surface_get_width(this->crBuffer);
+    vector<TileKey> missing;
+    int col1 = 0, row1 = 0, col2 = 0, row2 = 0;
+    if (TileCache::tileRange(area, tileZoom, getWidth(), getHeight(), col1, row1, col2, row2)) {
+        cairo_save(cr);
 
-    bool rerender = true;
-    if (width / xournal->getDpiScaleFactor() == dispWidth) {
-        rerender = false;
-    }
+        // The tiles are in device pixels
+        cairo_scale(cr, 1.0 / dpiScaleFactor, 1.0 / dpiScaleFactor);
 
-    if (width != dispWidth) {
-        double scale = (static_cast<double>(dispWidth)) / (width);
+        for (int row = row1; row <= row2; row++) {
+            for (int col = col1; col <= col2; col++) {
+                TileKey key{this, tileZoom, col, row};
+                int width = 0, height = 0;
+                TileCache::tileSize(key, getWidth(), getHeight(), width, height);
 
-        // Scale current image to fit the zoom level
-        cairo_scale(cr, scale, scale);
-        cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_FAST);
+                bool dirty = false;
+                cairo_surface_t* tile = cache->lookup(key, &dirty);
+                if (tile == nullptr || dirty) {
+                    missing.push_back(key);
+                }
 
-        cairo_set_source_surface(cr, this->crBuffer, 0, 0);
+                if (tile == nullptr) {
+                    if (!loading) {
+                        paintFallbackTile(cr, key, width, height);
+                    }
+                    continue;
+                }
 
-        if (rerender) {
-            rerenderPage();
+                cairo_set_source_surface(cr, tile, col * TileCache::TILE_SIZE, row * TileCache::TILE_SIZE);
+                cairo_rectangle(cr, col * TileCache::TILE_SIZE, row * TileCache::TILE_SIZE, width, height);
+                cairo_fill(cr);
+                cairo_surface_destroy(tile);
+            }
         }
 
-        rect = nullptr;
-    } else {
-        cairo_set_source_surface(cr, this->crBuffer, 0, 0);
+        cairo_restore(cr);
     }
 
-    if (rect) {
-        cairo_rectangle(cr, rect->x, rect->y, rect->width, rect->height);
-        cairo_fill(cr);
+    requestTiles(missing, false);
 
 #ifdef DEBUG_SHOW_PAINT_BOUNDS
+    if (rect) {
+        cairo_save(cr);
         cairo_set_source_rgb(cr, 1.0, 0.5, 1.0);
         cairo_set_line_width(cr, 1. / zoom);
         cairo_rectangle(cr, rect->x, rect->y, rect->width, rect->height);
         cairo_stroke(cr);
-#endif
-    } else {
-        cairo_paint(cr);
+        cairo_restore(cr);
     }
-
-    cairo_restore(cr);
+#endif
 
     // don't paint this with scale, because it needs a 1:1 zoom
     if (this->verticalSpace) {
@@ -821,10 +921,8 @@ auto XojPageView::paintPage(cairo_t* cr, GdkRectangle* rect) -> bool {
 auto XojPageView::isSelected() const -> bool { return selected; }
 
 auto XojPageView::getBufferPixels() -> int {
-    if (crBuffer) {
-        return cairo_image_surface_get_width(crBuffer) * cairo_image_surface_get_height(crBuffer);
-    }
-    return 0;
+    // The tiles are stored as ARGB32
+    return static_cast<int>(this->xournal->getTileCache()->getBytes(this) / 4);
 }
 
 auto XojPageView::getSelectionColor() -> GdkRGBA { return Util::rgb_to_GdkRGBA(settings->getSelectionColor()); }
@@ -913,13 +1011,30 @@ void XojPageView::pageChanged() { rerenderPage(); }
 
 void XojPageView::elementChanged(Element* elem) {
     if (this->inputHandler && elem == this->inputHandler->getStroke()) {
-        g_mutex_lock(&this->drawingMutex);
-
-        cairo_t* cr = cairo_create(this->crBuffer);
+        TileCache* cache = this->xournal->getTileCache();
 
-        this->inputHandler->draw(cr);
+        g_mutex_lock(&this->drawingMutex);
 
-        cairo_destroy(cr);
+        // Draw the stroke into the cached tiles it covers, until they are rendered again
+        int col1 = 0, row1 = 0, col2 = 0, row2 = 0;
+        if (TileCache::tileRange(elem->boundingRect(), this->tileZoom, getWidth(), getHeight(), col1, row1, col2,
+                                 row2)) {
+            for (int row = row1; row <= row2; row++) {
+                for (int col = col1; col <= col2; col++) {
+                    cairo_surface_t* tile = cache->lookup({this, this->tileZoom, col, row});
+                    if (tile == nullptr) {
+                        continue;
+                    }
+
+                    cairo_t* cr = cairo_create(tile);
+                    cairo_translate(cr, -col * TileCache::TILE_SIZE, -row * TileCache::TILE_SIZE);
+                    this->inputHandler->draw(cr);
+                    cairo_destroy(cr);
+
+                    cairo_surface_destroy(tile);
+                }
+            }
+        }
 
         g_mutex_unlock(&this->drawingMutex);
     } else {
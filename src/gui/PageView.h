@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <unordered_set>
+
 #include "gui/inputdevices/PositionInputData.h"
 #include "model/PageListener.h"
 #include "model/PageRef.h"
@@ -20,6 +22,7 @@
 #include "Layout.h"
 #include "Range.h"
 #include "Redrawable.h"
+#include "TileCache.h"
 
 class EditSelection;
 class EraseHandler;
@@ -43,6 +46,11 @@ public:
     virtual void rerenderPage();
     virtual void rerenderRect(double x, double y, double width, double height);
 
+    /**
+     * Renders all tiles of the page at the current zoom level, even if the page is not visible
+     */
+    void preloadPage();
+
     virtual void repaintPage();
     virtual void repaintArea(double x1, double y1, double x2, double y2);
 
@@ -69,6 +77,11 @@ public:
 
     void deleteViewBuffer();
 
+    /**
+     * Drops the decoded images, rendered formulas and stroke geometry of the page, if the page is not shown anymore
+     */
+    void releaseImages();
+
     /**
      * Returns whether this PageView contains the
      * given point on the display
@@ -90,7 +103,7 @@ public:
 
     /**
      * 0 if currently visible
-     * -1 if no image is saved (never visible or cleanup)
+     * -1 if no tile is cached (never visible or cleanup)
      * else the time in Seconds
      */
     int getLastVisibleTime();
@@ -174,7 +187,29 @@ private:
 
     void startText(double x, double y);
 
-    void addRerenderRect(double x, double y, double width, double height);
+    /**
+     * Invalidates the cached tiles intersecting the area and schedules them for rendering
+     *
+     * @param area The area in page coordinates, or nullptr for the whole page
+     */
+    void invalidateTiles(const Rectangle<double>* area);
+
+    /**
+     * Schedules the tiles for rendering
+     *
+     * @param invalidated The content of the tiles changed, render them again even if they are being rendered
+     */
+    void requestTiles(const vector<TileKey>& tiles, bool invalidated);
+
+    /**
+     * Keeps the tiles of the previous zoom level to be shown scaled until the tiles of the new one are rendered
+     */
+    void setTileZoom(double zoom);
+
+    /**
+     * Paints the tile from the tiles of the previous zoom level, called if it is not rendered yet
+     */
+    void paintFallbackTile(cairo_t* cr, const TileKey& key, int width, int height);
 
     void drawLoadingPage(cairo_t* cr);
 
@@ -208,7 +243,15 @@ private:
 
     bool selected = false;
 
-    cairo_surface_t* crBuffer = nullptr;
+    /**
+     * The zoom level of the tiles which are rendered, including the DPI scale factor
+     */
+    double tileZoom = 0;
+
+    /**
+     * The previous zoom level, its tiles are shown until the tiles of tileZoom are rendered
+     */
+    double fallbackZoom = 0;
 
     bool inEraser = false;
 
@@ -228,8 +271,16 @@ private:
     int lastVisibleTime = -1;
 
     GMutex repaintRectMutex{};
-    vector<Rectangle<double>> rerenderRects;
-    bool rerenderComplete = false;
+
+    /**
+     * Tiles waiting for a RenderJob
+     */
+    std::unordered_set<TileKey> pendingTiles;
+
+    /**
+     * Tiles currently rendered by a RenderJob
+     */
+    std::unordered_set<TileKey> renderingTiles;
 
     GMutex drawingMutex{};
 
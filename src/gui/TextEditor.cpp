@@ -1,5 +1,6 @@
 #include "TextEditor.h"
 
+#include <algorithm>
 #include <memory>
 
 #include <gtk/gtkimmulticontext.h>
@@ -135,7 +136,9 @@ auto TextEditor::setColor(Color color) -> UndoAction* {
 
 void TextEditor::setFont(XojFont font) {
     this->text->setFont(font);
-    TextView::updatePangoFont(this->layout, this->text);
+    if (this->layout) {
+        TextView::updatePangoFont(this->layout, this->text);
+    }
     this->repaintEditor();
 }
 
@@ -207,6 +210,7 @@ void TextEditor::iMPreeditChangedCallback(GtkIMContext* context, TextEditor* te)
         te->preeditString = "";
     }
     te->preeditCursor = cursor_pos;
+    te->layoutValid = false;
     te->repaintEditor();
     te->contentsChanged();
 
@@ -907,7 +911,14 @@ auto TextEditor::blinkCallback(TextEditor* te) -> gint {
     return false;
 }
 
-void TextEditor::repaintEditor() { this->gui->repaintPage(); }
+void TextEditor::repaintEditor() {
+    // The text may have become smaller than it was painted the last time
+    double x = this->text->getX();
+    double y = this->text->getY();
+    double width = std::max(this->text->getElementWidth(), this->paintedWidth);
+    double height = std::max(this->text->getElementHeight(), this->paintedHeight);
+    this->gui->repaintArea(x, y, x + width, y + height);
+}
 
 /**
  * Calculate the UTF-8 Char offset into a byte offset.
@@ -971,8 +982,10 @@ void TextEditor::paint(cairo_t* cr, GdkRectangle* repaintRect, double zoom) {
         this->layout = TextView::initPango(cr, this->text);
     }
 
+    string txt = this->text->getText();
+    int attributeStart = -1;
+    int attributeEnd = -1;
     if (!this->preeditString.empty()) {
-        string text = this->text->getText();
         int offset = gtk_text_iter_get_offset(&cursorIter);
         int pos = gtk_text_iter_get_line_index(&cursorIter);
 
@@ -980,49 +993,42 @@ void TextEditor::paint(cairo_t* cr, GdkRectangle* repaintRect, double zoom) {
             pos += gtk_text_iter_get_bytes_in_line(&cursorIter);
         }
         gtk_text_iter_set_offset(&cursorIter, offset);
-        string txt = text.substr(0, pos) + preeditString + text.substr(pos);
+        txt = txt.substr(0, pos) + preeditString + txt.substr(pos);
 
-        PangoAttrList* attrlist = pango_attr_list_new();
-        PangoAttrList* preedit_attrlist = this->preeditAttrList;
-        pango_attr_list_splice(attrlist, preedit_attrlist, pos, preeditString.length());
-        pango_layout_set_attributes(this->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-        attrlist = nullptr;
-        pango_layout_set_text(this->layout, txt.c_str(), txt.length());
+        attributeStart = pos;
+        attributeEnd = pos + preeditString.length();
     } else {
-        string txt = this->text->getText();
-        pango_layout_set_text(this->layout, txt.c_str(), txt.length());
-
         GtkTextIter start;
         GtkTextIter end;
-        bool hasSelection = gtk_text_buffer_get_selection_bounds(this->buffer, &start, &end);
+        if (gtk_text_buffer_get_selection_bounds(this->buffer, &start, &end)) {
+            attributeStart = getByteOffset(gtk_text_iter_get_offset(&start));
+            attributeEnd = getByteOffset(gtk_text_iter_get_offset(&end));
+        }
+    }
 
-        if (hasSelection) {
+    // Setting the text or the attributes reshapes the layout, e.g. the cursor blinking does not change them
+    if (!this->layoutValid || txt != this->layoutText || attributeStart != this->layoutAttributeStart ||
+        attributeEnd != this->layoutAttributeEnd) {
+        PangoAttrList* attrlist = pango_attr_list_new();
+        if (!this->preeditString.empty()) {
+            pango_attr_list_splice(attrlist, this->preeditAttrList, attributeStart, preeditString.length());
+        } else if (attributeStart != -1) {
             auto selectionColorU16 = Util::GdkRGBA_to_ColorU16(selectionColor);
             PangoAttribute* attrib =
                     pango_attr_background_new(selectionColorU16.red, selectionColorU16.green, selectionColorU16.blue);
-            PangoAttrList* attrlist = pango_layout_get_attributes(this->layout);
-
-            attrib->start_index = getByteOffset(gtk_text_iter_get_offset(&start));
-            attrib->end_index = getByteOffset(gtk_text_iter_get_offset(&end));
-
-            const bool isNewAttrlist = attrlist == nullptr;
-            if (isNewAttrlist) {
-                attrlist = pango_attr_list_new();
-                pango_layout_set_attributes(this->layout, attrlist);
-            }
+            attrib->start_index = attributeStart;
+            attrib->end_index = attributeEnd;
             pango_attr_list_insert(attrlist, attrib);
-            if (isNewAttrlist) {
-                pango_attr_list_unref(attrlist);
-                attrlist = nullptr;
-            }
-        } else {
-            // remove all attributes
-            PangoAttrList* attrlist = pango_attr_list_new();
-            pango_layout_set_attributes(this->layout, attrlist);
-            pango_attr_list_unref(attrlist);
-            attrlist = nullptr;
         }
+        pango_layout_set_attributes(this->layout, attrlist);
+        pango_attr_list_unref(attrlist);
+
+        pango_layout_set_text(this->layout, txt.c_str(), txt.length());
+
+        this->layoutText = std::move(txt);
+        this->layoutAttributeStart = attributeStart;
+        this->layoutAttributeEnd = attributeEnd;
+        this->layoutValid = true;
     }
 
     pango_cairo_show_layout(cr, this->layout);
@@ -1072,6 +1078,8 @@ void TextEditor::paint(cairo_t* cr, GdkRectangle* repaintRect, double zoom) {
 
     this->text->setWidth(width);
     this->text->setHeight(height);
+    this->paintedWidth = width;
+    this->paintedHeight = height;
 
     if (this->markPosQueue) {
         this->markPosQueue = false;
@@ -96,6 +96,20 @@ private:
     PangoLayout* layout = nullptr;
     Text* text = nullptr;
 
+    /**
+     * The text and the range of the selection or preedit attributes the layout was last shaped with
+     */
+    string layoutText;
+    int layoutAttributeStart = -1;
+    int layoutAttributeEnd = -1;
+    bool layoutValid = false;
+
+    /**
+     * The size of the text when it was painted the last time, including the preedit string
+     */
+    double paintedWidth = 0;
+    double paintedHeight = 0;
+
     PangoAttrList* preeditAttrList = nullptr;
     int preeditCursor;
     string preeditString;
@@ -0,0 +1,160 @@
+#include "TileCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+TileCache::TileCache(size_t maxBytes): maxBytes(maxBytes) {}
+
+TileCache::~TileCache() {
+    for (Tile& tile: this->tiles) {
+        cairo_surface_destroy(tile.surface);
+    }
+}
+
+auto TileCache::lookup(const TileKey& key, bool* dirty) -> cairo_surface_t* {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->index.find(key);
+    if (it == this->index.end()) {
+        return nullptr;
+    }
+
+    // Move to the front, most recently used
+    this->tiles.splice(this->tiles.begin(), this->tiles, it->second);
+
+    if (dirty) {
+        *dirty = it->second->dirty;
+    }
+    return cairo_surface_reference(it->second->surface);
+}
+
+void TileCache::insert(const TileKey& key, cairo_surface_t* surface) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->index.find(key);
+    if (it != this->index.end()) {
+        removeTile(it->second);
+    }
+
+    size_t size = static_cast<size_t>(cairo_image_surface_get_stride(surface)) *
+                  static_cast<size_t>(cairo_image_surface_get_height(surface));
+
+    this->tiles.push_front({key, surface, size, false});
+    this->index[key] = this->tiles.begin();
+    this->bytes += size;
+    this->viewBytes[key.view] += size;
+
+    evictLocked();
+}
+
+void TileCache::removeTile(TileList::iterator it) {
+    this->bytes -= it->bytes;
+
+    auto viewIt = this->viewBytes.find(it->key.view);
+    viewIt->second -= it->bytes;
+    if (viewIt->second == 0) {
+        this->viewBytes.erase(viewIt);
+    }
+
+    cairo_surface_destroy(it->surface);
+    this->index.erase(it->key);
+    this->tiles.erase(it);
+}
+
+auto TileCache::invalidate(const XojPageView* view, double zoom, const Rectangle<double>* area) -> vector<TileKey> {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    vector<TileKey> invalidated;
+    for (auto it = this->tiles.begin(); it != this->tiles.end();) {
+        auto current = it++;
+        if (current->key.view != view) {
+            continue;
+        }
+        if (area && !tileArea(current->key).intersects(*area)) {
+            continue;
+        }
+
+        if (current->key.zoom != zoom) {
+            removeTile(current);
+            continue;
+        }
+
+        current->dirty = true;
+        invalidated.push_back(current->key);
+    }
+
+    return invalidated;
+}
+
+void TileCache::remove(const XojPageView* view) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    for (auto it = this->tiles.begin(); it != this->tiles.end();) {
+        auto current = it++;
+        if (current->key.view == view) {
+            removeTile(current);
+        }
+    }
+}
+
+void TileCache::removeZoomLevel(const XojPageView* view, double zoom) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    for (auto it = this->tiles.begin(); it != this->tiles.end();) {
+        auto current = it++;
+        if (current->key.view == view && current->key.zoom == zoom) {
+            removeTile(current);
+        }
+    }
+}
+
+auto TileCache::getBytes(const XojPageView* view) -> size_t {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->viewBytes.find(view);
+    return it == this->viewBytes.end() ? 0 : it->second;
+}
+
+void TileCache::evict() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    evictLocked();
+}
+
+void TileCache::evictLocked() {
+    // Always keep the most recently used tile, else a single huge tile could never be shown
+    while (this->bytes > this->maxBytes && this->tiles.size() > 1) {
+        removeTile(std::prev(this->tiles.end()));
+    }
+}
+
+void TileCache::setMaxBytes(size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->maxBytes = maxBytes;
+    evictLocked();
+}
+
+auto TileCache::tileRange(const Rectangle<double>& area, double zoom, double pageWidth, double pageHeight, int& col1,
+                          int& row1, int& col2, int& row2) -> bool {
+    int lastCol = static_cast<int>(std::ceil(pageWidth * zoom / TILE_SIZE)) - 1;
+    int lastRow = static_cast<int>(std::ceil(pageHeight * zoom / TILE_SIZE)) - 1;
+
+    col1 = std::max(0, static_cast<int>(std::floor(area.x * zoom / TILE_SIZE)));
+    row1 = std::max(0, static_cast<int>(std::floor(area.y * zoom / TILE_SIZE)));
+    col2 = std::min(lastCol, static_cast<int>(std::ceil((area.x + area.width) * zoom / TILE_SIZE)) - 1);
+    row2 = std::min(lastRow, static_cast<int>(std::ceil((area.y + area.height) * zoom / TILE_SIZE)) - 1);
+
+    return col1 <= col2 && row1 <= row2;
+}
+
+auto TileCache::tileArea(const TileKey& key) -> Rectangle<double> {
+    double size = TILE_SIZE / key.zoom;
+    return Rectangle<double>(key.col * size, key.row * size, size, size);
+}
+
+void TileCache::tileSize(const TileKey& key, double pageWidth, double pageHeight, int& width, int& height) {
+    int pageWidthPx = static_cast<int>(std::ceil(pageWidth * key.zoom));
+    int pageHeightPx = static_cast<int>(std::ceil(pageHeight * key.zoom));
+
+    width = std::clamp(pageWidthPx - key.col * TILE_SIZE, 0, TILE_SIZE);
+    height = std::clamp(pageHeightPx - key.row * TILE_SIZE, 0, TILE_SIZE);
+}
@@ -0,0 +1,183 @@
+/*
+ * Xournal++
+ *
+ * Cache for the rendered tiles of the page views
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <gtk/gtk.h>
+
+#include "util/hashcombine.h"
+
+#include "Rectangle.h"
+#include "XournalType.h"
+
+class XojPageView;
+
+/**
+ * @brief Identifies a rendered tile of a page view at a zoom level
+ */
+struct TileKey {
+    const XojPageView* view;
+
+    /**
+     * Device pixels per page unit, i.e. the zoom including the DPI scale factor
+     */
+    double zoom;
+
+    int col;
+    int row;
+
+    bool operator==(const TileKey& other) const {
+        return view == other.view && zoom == other.zoom && col == other.col && row == other.row;
+    }
+};
+
+namespace std {
+template <>
+class hash<TileKey> {
+public:
+    size_t operator()(TileKey const& key) const {
+        size_t seed = 0;
+        boost_c::hash_combine(seed, key.view);
+        boost_c::hash_combine(seed, key.zoom);
+        boost_c::hash_combine(seed, key.col);
+        boost_c::hash_combine(seed, key.row);
+        return seed;
+    }
+};
+}  // namespace std
+
+/**
+ * @brief Least recently used cache of the rendered page tiles of all page views
+ *
+ * Pages are split in square tiles of TILE_SIZE device pixels per zoom level. Tiles are only rendered if they are
+ * visible, invalidated tiles are kept (marked as dirty) and shown until they are rendered again. The total size of
+ * the cached tiles is bounded by a memory budget.
+ *
+ * All methods are thread safe.
+ */
+class TileCache {
+public:
+    /**
+     * @param maxBytes The memory budget of the cache
+     */
+    explicit TileCache(size_t maxBytes);
+    ~TileCache();
+
+    TileCache(const TileCache&) = delete;
+    TileCache& operator=(const TileCache&) = delete;
+
+public:
+    /**
+     * Returns a new reference to the surface of the tile, or nullptr if the tile is not cached
+     *
+     * @param dirty Set to true if the tile has been invalidated since it was rendered
+     */
+    cairo_surface_t* lookup(const TileKey& key, bool* dirty = nullptr);
+
+    /**
+     * Adds or replaces a tile, the cache takes the reference to the surface
+     */
+    void insert(const TileKey& key, cairo_surface_t* surface);
+
+    /**
+     * Marks the tiles at the zoom level intersecting the area as dirty, tiles at other zoom levels are removed
+     *
+     * @param area The area in page coordinates, or nullptr for the whole page
+     * @return The invalidated tiles at the zoom level
+     */
+    vector<TileKey> invalidate(const XojPageView* view, double zoom, const Rectangle<double>* area);
+
+    /**
+     * Removes all tiles of the view
+     */
+    void remove(const XojPageView* view);
+
+    /**
+     * Removes the tiles of the view at the zoom level
+     */
+    void removeZoomLevel(const XojPageView* view, double zoom);
+
+    /**
+     * @return The number of bytes used by the tiles of the view
+     */
+    size_t getBytes(const XojPageView* view);
+
+    /**
+     * Evicts least recently used tiles until the cache fits in its memory budget
+     */
+    void evict();
+
+    void setMaxBytes(size_t maxBytes);
+
+    /**
+     * Returns the tile grid covering the area
+     *
+     * @param area The area in page coordinates
+     * @param zoom Device pixels per page unit
+     * @param pageWidth Width of the page, in page coordinates
+     * @param pageHeight Height of the page, in page coordinates
+     * @param[out] col1, row1, col2, row2 The range of tiles (inclusive)
+     * @return false if the area does not cover any tile
+     */
+    static bool tileRange(const Rectangle<double>& area, double zoom, double pageWidth, double pageHeight, int& col1,
+                          int& row1, int& col2, int& row2);
+
+    /**
+     * @return The area of the tile, in page coordinates
+     */
+    static Rectangle<double> tileArea(const TileKey& key);
+
+    /**
+     * Returns the size of the tile in device pixels, tiles at the right and bottom edge are cut at the page border
+     */
+    static void tileSize(const TileKey& key, double pageWidth, double pageHeight, int& width, int& height);
+
+public:
+    /**
+     * Edge length of a tile, in device pixels
+     */
+    static constexpr int TILE_SIZE = 256;
+
+private:
+    struct Tile {
+        TileKey key;
+        cairo_surface_t* surface;
+        size_t bytes;
+        bool dirty;
+    };
+
+    using TileList = std::list<Tile>;
+
+    void removeTile(TileList::iterator it);
+    void evictLocked();
+
+private:
+    std::mutex mutex;
+
+    /**
+     * Most recently used tiles first
+     */
+    TileList tiles;
+    std::unordered_map<TileKey, TileList::iterator> index;
+
+    /**
+     * The bytes used by the tiles of each view
+     */
+    std::unordered_map<const XojPageView*, size_t> viewBytes;
+
+    size_t bytes = 0;
+    size_t maxBytes;
+};
@@ -14,6 +14,7 @@
 #include "model/Document.h"
 #include "model/Stroke.h"
 #include "undo/DeleteUndoAction.h"
+#include "view/ImageCache.h"
 #include "widgets/XournalWidget.h"
 
 #include "Layout.h"
@@ -21,6 +22,7 @@
 #include "Rectangle.h"
 #include "RepaintHandler.h"
 #include "Shadow.h"
+#include "TileCache.h"
 #include "Util.h"
 #include "XournalppCursor.h"
 #include "filesystem.h"
@@ -35,7 +37,10 @@ std::pair<size_t, size_t> XournalView::preloadPageBounds(size_t page, size_t max
 
 XournalView::XournalView(GtkWidget* parent, Control* control, ScrollHandling* scrollHandling):
         scrollHandling(scrollHandling), control(control) {
-    this->cache = new PdfCache(control->getSettings()->getPdfPageCacheSize());
+    this->cache = new PdfCache(static_cast<size_t>(control->getSettings()->getPdfPageCacheMemory()) * 1024 * 1024);
+    this->tileCache = new TileCache(static_cast<size_t>(control->getSettings()->getPageTileCacheSize()) * 1024 * 1024);
+    ImageCache::getInstance().setMaxBytes(static_cast<size_t>(control->getSettings()->getImageCacheMemory()) * 1024 *
+                                          1024);
 
     registerListener(control);
 
@@ -72,6 +77,8 @@ XournalView::~XournalView() {
 
     delete this->cache;
     this->cache = nullptr;
+    delete this->tileCache;
+    this->tileCache = nullptr;
     delete this->repaintHandler;
     this->repaintHandler = nullptr;
 
@@ -107,8 +114,12 @@ auto XournalView::cleanupBufferCache() -> void {
         const bool isPreload = pagesLower <= pageNum && pageNum <= pagesUpper;
         if (!isPreload && page->getLastVisibleTime() > 0 && page->getBufferPixels() > 0) {
             page->deleteViewBuffer();
+            page->releaseImages();
         }
     }
+
+    // Tiles of the visible and preloaded pages are only dropped if the memory budget is exceeded
+    this->tileCache->evict();
 }
 
 auto XournalView::getCurrentPage() const -> size_t { return currentPage; }
@@ -358,7 +369,7 @@ void XournalView::pageSelected(size_t page) {
     g_assert(pagesLower <= pagesUpper);
     for (size_t i = pagesLower; i < pagesUpper; i++) {
         if (this->viewPages[i]->getBufferPixels() == 0) {
-            this->viewPages[i]->rerenderPage();
+            this->viewPages[i]->preloadPage();
         }
     }
 }
@@ -545,6 +556,8 @@ void XournalView::resetShapeRecognizer() {
 
 auto XournalView::getCache() -> PdfCache* { return this->cache; }
 
+auto XournalView::getTileCache() -> TileCache* { return this->tileCache; }
+
 void XournalView::pageInserted(size_t page) {
     Document* doc = control->getDocument();
     doc->lock();
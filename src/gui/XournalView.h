@@ -29,6 +29,7 @@ class PdfCache;
 class RepaintHandler;
 class ScrollHandling;
 class TextEditor;
+class TileCache;
 class HandRecognition;
 
 class XournalView: public DocumentListener, public ZoomListener {
@@ -95,6 +96,7 @@ public:
     int getDpiScaleFactor();
     Document* getDocument();
     PdfCache* getCache();
+    TileCache* getTileCache();
     RepaintHandler* getRepaintHandler();
     GtkWidget* getWidget();
     XournalppCursor* getCursor();
@@ -168,6 +170,11 @@ private:
 
     PdfCache* cache = nullptr;
 
+    /**
+     * The rendered tiles of all pages
+     */
+    TileCache* tileCache = nullptr;
+
     /**
      * Handler for rerendering pages / repainting pages
      */
@@ -22,9 +22,12 @@ RenameLayerDialog::RenameLayerDialog(GladeSearchpath* gladeSearchPath, UndoRedoH
 void RenameLayerDialog::renameSuccessful(GtkButton* bttn, RenameLayerDialog* rld) {
     std::string newName = gtk_entry_get_text(GTK_ENTRY(rld->get("layerNameEntry")));
 
-    rld->undo->addUndoAction(std::make_unique<LayerRenameUndoAction>(rld->l, newName, rld->lc->getCurrentLayerName()));
-
+    std::string oldName = rld->lc->getCurrentLayerName();
     rld->lc->setCurrentLayerName(newName);
+
+    // Added after the change, so the page is marked as changed with the new name
+    rld->undo->addUndoAction(
+            std::make_unique<LayerRenameUndoAction>(rld->lc->getCurrentPage(), rld->l, newName, oldName));
     gtk_window_close(GTK_WINDOW(rld->window));
 }
 
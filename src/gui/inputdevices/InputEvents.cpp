@@ -4,6 +4,8 @@
 
 #include "InputEvents.h"
 
+#include "LatencyTracer.h"
+
 auto InputEvents::translateEventType(GdkEventType type) -> InputEventType {
     switch (type) {
         case GDK_MOTION_NOTIFY:
@@ -107,6 +109,10 @@ auto InputEvents::translateEvent(GdkEvent* sourceEvent, Settings* settings) -> I
     // Copy the timestamp
     targetEvent.timestamp = gdk_event_get_time(sourceEvent);
 
+    if (targetEvent.type == MOTION_EVENT || targetEvent.type == BUTTON_PRESS_EVENT) {
+        LatencyTracer::getInstance().eventReceived();
+    }
+
     // Copy the pressure data
     gdk_event_get_axis(sourceEvent, GDK_AXIS_PRESSURE, &targetEvent.pressure);
 
@@ -11,7 +11,7 @@ SidebarPreviewBase::SidebarPreviewBase(Control* control, GladeGui* gui, SidebarT
         AbstractSidebarPage(control, toolbar) {
     this->layoutmanager = new SidebarLayout();
 
-    this->cache = new PdfCache(control->getSettings()->getPdfPageCacheSize());
+    this->cache = new PdfCache(static_cast<size_t>(control->getSettings()->getPdfPageCacheMemory()) * 1024 * 1024);
 
     this->iconViewPreview = gtk_layout_new(nullptr, nullptr);
     g_object_ref(this->iconViewPreview);
@@ -15,6 +15,7 @@
 #include "gui/inputdevices/InputContext.h"
 #include "gui/scroll/ScrollHandling.h"
 
+#include "LatencyTracer.h"
 #include "Rectangle.h"
 #include "Util.h"
 
@@ -300,6 +301,8 @@ static auto gtk_xournal_draw(GtkWidget* widget, cairo_t* cr) -> gboolean {
         xournal->selection->paint(cr, zoom);
     }
 
+    LatencyTracer::getInstance().frameDrawn();
+
     return true;
 }
 
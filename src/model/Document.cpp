@@ -15,7 +15,7 @@
 #include "filesystem.h"
 #include "i18n.h"
 
-Document::Document(DocumentHandler* handler): handler(handler) { g_mutex_init(&this->documentLock); }
+Document::Document(DocumentHandler* handler): handler(handler) {}
 
 Document::~Document() {
     clearDocument(true);
@@ -49,26 +49,30 @@ auto Document::freeTreeContentEntry(GtkTreeModel* treeModel, GtkTreePath* path,
 }
 
 void Document::lock() {
-    g_mutex_lock(&this->documentLock);
+    this->documentLock.lock();
 
     //	if(tryLock()) {
     //		fprintf(stderr, "Locked by\n");
     //		Stacktrace::printStracktrace();
     //		fprintf(stderr, "\n\n\n\n");
     //	} else {
-    //		g_mutex_lock(&this->documentLock);
+    //		this->documentLock.lock();
     //	}
 }
 
 void Document::unlock() {
-    g_mutex_unlock(&this->documentLock);
+    this->documentLock.unlock();
 
     //	fprintf(stderr, "Unlocked by\n");
     //	Stacktrace::printStracktrace();
     //	fprintf(stderr, "\n\n\n\n");
 }
 
-auto Document::tryLock() -> bool { return g_mutex_trylock(&this->documentLock); }
+auto Document::tryLock() -> bool { return this->documentLock.try_lock(); }
+
+void Document::lockShared() { this->documentLock.lock_shared(); }
+
+void Document::unlockShared() { this->documentLock.unlock_shared(); }
 
 void Document::clearDocument(bool destroy) {
     if (this->preview) {
@@ -387,6 +391,18 @@ auto Document::getPage(size_t page) -> PageRef {
     return this->pages[page];
 }
 
+auto Document::getPageSnapshot(size_t page) -> PageRef {
+    PageRef p = getPage(page);
+    if (!p) {
+        return nullptr;
+    }
+
+    p->lockShared();
+    PageRef snapshot = p->getSnapshot();
+    p->unlockShared();
+    return snapshot;
+}
+
 auto Document::getPdfPage(size_t page) -> XojPdfPageSPtr { return this->pdfDocument.getPage(page); }
 
 auto Document::getPdfDocument() -> XojPdfDocument& { return this->pdfDocument; }
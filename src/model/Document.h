@@ -5,6 +5,11 @@
  *
  * All methods are unlocked, you need to lock the document before you change something and unlock after.
  *
+ * The document lock is a reader/writer lock: changes of the structure of the document (inserting, deleting or moving
+ * pages, changing backgrounds) need the exclusive lock. Reading the document, and changing the content of a single
+ * page, only need the shared lock, together with the lock of the page (see XojPage::lock()).
+ * The document is always locked before a page, never lock the document while holding a page lock.
+ *
  * @author Xournal++ Team
  * https://github.com/xournalpp/xournalpp
  *
@@ -14,6 +19,7 @@
 #pragma once
 
 #include <memory>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -49,6 +55,13 @@ public:
     template <class InputIter>
     void addPages(InputIter first, InputIter last);
     PageRef getPage(size_t page);
+
+    /**
+     * @return An immutable copy of the page, which can be read without lock (see XojPage::getSnapshot()),
+     * or nullptr if there is no such page. The document needs to be locked (shared).
+     */
+    PageRef getPageSnapshot(size_t page);
+
     void deletePage(size_t pNr);
 
     static void setPageSize(PageRef p, double width, double height);
@@ -86,10 +99,19 @@ public:
     cairo_surface_t* getPreview();
     void setPreview(cairo_surface_t* preview);
 
+    /**
+     * Exclusive lock, needed to change the structure of the document, or to change pages without locking them
+     */
     void lock();
     void unlock();
     bool tryLock();
 
+    /**
+     * Shared lock, needed to read the document, or to change a page which is locked with XojPage::lock()
+     */
+    void lockShared();
+    void unlockShared();
+
 private:
     void buildContentsModel();
     void freeTreeContentModel();
@@ -155,7 +177,7 @@ private:
     /**
      * The lock of the document
      */
-    GMutex documentLock{};
+    std::shared_mutex documentLock;
 };
 
 template <class InputIter>
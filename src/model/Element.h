@@ -22,6 +22,8 @@
 #include "Rectangle.h"
 #include "XournalType.h"
 
+class SpatialIndex;
+
 enum ElementType { ELEMENT_STROKE = 1, ELEMENT_IMAGE, ELEMENT_TEXIMAGE, ELEMENT_TEXT };
 
 class ShapeContainer {
@@ -35,6 +37,12 @@ class Element: public Serializeable {
 protected:
     Element(ElementType type);
 
+    /**
+     * Copies do not belong to the Layer of the original element
+     */
+    Element(const Element& other);
+    Element& operator=(const Element& other);
+
 public:
     ~Element() override;
 
@@ -80,6 +88,11 @@ protected:
     void serializeElement(ObjectOutputStream& out) const;
     void readSerializedElement(ObjectInputStream& in);
 
+    /**
+     * Has to be called whenever the bounding box of the element changes, so the Layer index can be updated
+     */
+    void boundsChanged() const;
+
 protected:
     // If the size has been calculated
     mutable bool sizeCalculated = false;
@@ -104,4 +117,11 @@ private:
      * The color in RGB format
      */
     Color color{0U};
+
+    /**
+     * The index of the Layer this element is on, if any
+     */
+    SpatialIndex* spatialIndex = nullptr;
+
+    friend class SpatialIndex;
 };
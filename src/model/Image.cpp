@@ -7,14 +7,9 @@
 
 #include "pixbuf-utils.h"
 
-Image::Image(): Element(ELEMENT_IMAGE) {}
+Image::Image(): Element(ELEMENT_IMAGE), data(std::make_shared<const string>()) {}
 
-Image::~Image() {
-    if (this->image) {
-        cairo_surface_destroy(this->image);
-        this->image = nullptr;
-    }
-}
+Image::~Image() = default;
 
 auto Image::clone() -> Element* {
     auto* img = new Image();
@@ -26,10 +21,8 @@ auto Image::clone() -> Element* {
     img->height = this->height;
     img->data = this->data;
 
-    img->image = cairo_surface_reference(this->image);
     img->snappedBounds = this->snappedBounds;
     img->sizeCalculated = this->sizeCalculated;
-    img->read = this->read;
 
     return img;
 }
@@ -37,53 +30,34 @@ auto Image::clone() -> Element* {
 void Image::setWidth(double width) {
     this->width = width;
     this->calcSize();
+    boundsChanged();
 }
 
 void Image::setHeight(double height) {
     this->height = height;
     this->calcSize();
+    boundsChanged();
 }
 
-auto Image::cairoReadFunction(Image* image, unsigned char* data, unsigned int length) -> cairo_status_t {
-    for (unsigned int i = 0; i < length; i++, image->read++) {
-        if (image->read >= image->data.length()) {
-            return CAIRO_STATUS_READ_ERROR;
-        }
-
-        data[i] = image->data[image->read];
-    }
-
+auto Image::cairoWriteFunction(string* data, const unsigned char* buffer, unsigned int length) -> cairo_status_t {
+    data->append(reinterpret_cast<const char*>(buffer), length);
     return CAIRO_STATUS_SUCCESS;
 }
 
-void Image::setImage(string data) {
-    if (this->image) {
-        cairo_surface_destroy(this->image);
-        this->image = nullptr;
-    }
-    this->data = std::move(data);
-}
+void Image::setImage(string data) { this->data = std::make_shared<const string>(std::move(data)); }
 
 void Image::setImage(GdkPixbuf* img) { setImage(f_pixbuf_to_cairo_surface(img)); }
 
 void Image::setImage(cairo_surface_t* image) {
-    if (this->image) {
-        cairo_surface_destroy(this->image);
-        this->image = nullptr;
-    }
+    // Only the encoded image is kept, it is decoded again by the ImageCache at the needed resolution
+    string png;
+    cairo_surface_write_to_png_stream(image, reinterpret_cast<cairo_write_func_t>(&cairoWriteFunction), &png);
+    cairo_surface_destroy(image);
 
-    this->image = image;
+    setImage(std::move(png));
 }
 
-auto Image::getImage() -> cairo_surface_t* {
-    if (this->image == nullptr && this->data.length()) {
-        this->read = 0;
-        this->image = cairo_image_surface_create_from_png_stream(
-                reinterpret_cast<cairo_read_func_t>(&cairoReadFunction), this);
-    }
-
-    return this->image;
-}
+auto Image::getPngData() const -> const std::shared_ptr<const string>& { return this->data; }
 
 void Image::scale(double x0, double y0, double fx, double fy, double rotation,
                   bool) {  // line width scaling option is not used
@@ -97,6 +71,7 @@ void Image::scale(double x0, double y0, double fx, double fy, double rotation,
     this->width *= fx;
     this->height *= fy;
     this->calcSize();
+    boundsChanged();
 }
 
 void Image::rotate(double x0, double y0, double th) {}
@@ -109,7 +84,7 @@ void Image::serialize(ObjectOutputStream& out) {
     out.writeDouble(this->width);
     out.writeDouble(this->height);
 
-    out.writeImage(this->image);
+    out.writeData(this->data->data(), static_cast<int>(this->data->size()), 1);
 
     out.endObject();
 }
@@ -122,12 +97,11 @@ void Image::readSerialized(ObjectInputStream& in) {
     this->width = in.readDouble();
     this->height = in.readDouble();
 
-    if (this->image) {
-        cairo_surface_destroy(this->image);
-        this->image = nullptr;
-    }
-
-    this->image = in.readImage();
+    void* png = nullptr;
+    int length = 0;
+    in.readData(&png, &length);
+    setImage(length > 0 ? string(static_cast<const char*>(png), static_cast<size_t>(length)) : string());
+    g_free(png);
 
     in.endObject();
     this->calcSize();
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -26,10 +27,22 @@ public:
     void setWidth(double width);
     void setHeight(double height);
 
+    /**
+     * @param data The image encoded as PNG
+     */
     void setImage(string data);
+
+    /**
+     * Encodes the image as PNG, takes the ownership of the surface
+     */
     void setImage(cairo_surface_t* image);
     void setImage(GdkPixbuf* img);
-    cairo_surface_t* getImage();
+
+    /**
+     * @return The image encoded as PNG, shared with the clones of this image. The decoded image is cached by the
+     * ImageCache.
+     */
+    const std::shared_ptr<const string>& getPngData() const;
 
     virtual void scale(double x0, double y0, double fx, double fy, double rotation, bool restoreLineWidth);
     virtual void rotate(double x0, double y0, double th);
@@ -47,12 +60,8 @@ public:
 private:
     void calcSize() const override;
 
-    static cairo_status_t cairoReadFunction(Image* image, unsigned char* data, unsigned int length);
+    static cairo_status_t cairoWriteFunction(string* data, const unsigned char* buffer, unsigned int length);
 
 private:
-    cairo_surface_t* image = nullptr;
-
-    string data;
-
-    string::size_type read = false;
+    std::shared_ptr<const string> data;
 };
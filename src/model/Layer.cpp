@@ -1,10 +1,15 @@
 #include "Layer.h"
 
+#include <unordered_set>
+
 #include "Stacktrace.h"
+#include "XojPage.h"
 
 Layer::Layer() = default;
 
 Layer::~Layer() {
+    this->index.clear();
+
     for (Element* e: this->elements) {
         delete e;
     }
@@ -32,14 +37,21 @@ void Layer::addElement(Element* e) {
         return;
     }
 
-    for (Element* elem2: this->elements) {
-        if (e == elem2) {
-            g_warning("Layer::addElement: Element is already on this layer!");
-            return;
-        }
+    if (this->index.contains(e)) {
+        g_warning("Layer::addElement: Element is already on this layer!");
+        return;
     }
 
     this->elements.push_back(e);
+    this->index.insert(e);
+    markChanged();
+}
+
+void Layer::addElements(const vector<Element*>& elements) {
+    this->elements.reserve(this->elements.size() + elements.size());
+    for (Element* e: elements) {
+        addElement(e);
+    }
 }
 
 void Layer::insertElement(Element* e, ElementIndex pos) {
@@ -49,12 +61,10 @@ void Layer::insertElement(Element* e, ElementIndex pos) {
         return;
     }
 
-    for (Element* elem2: this->elements) {
-        if (e == elem2) {
-            g_warning("Layer::insertElement() try to add an element twice!");
-            Stacktrace::printStracktrace();
-            return;
-        }
+    if (this->index.contains(e)) {
+        g_warning("Layer::insertElement() try to add an element twice!");
+        Stacktrace::printStracktrace();
+        return;
     }
 
     // prevent crash, even if this never should happen,
@@ -66,9 +76,13 @@ void Layer::insertElement(Element* e, ElementIndex pos) {
     // If the element should be inserted at the top
     if (pos >= static_cast<int>(this->elements.size())) {
         this->elements.push_back(e);
+        this->index.insert(e);
     } else {
         this->elements.insert(this->elements.begin() + pos, e);
+        this->index.insert(e);
+        this->index.invalidateOrder();
     }
+    markChanged();
 }
 
 auto Layer::indexOf(Element* e) -> ElementIndex {
@@ -85,6 +99,8 @@ auto Layer::removeElement(Element* e, bool free) -> ElementIndex {
     for (unsigned int i = 0; i < this->elements.size(); i++) {
         if (e == this->elements[i]) {
             this->elements.erase(this->elements.begin() + i);
+            this->index.remove(e);
+            markChanged();
 
             if (free) {
                 delete e;
@@ -98,6 +114,40 @@ auto Layer::removeElement(Element* e, bool free) -> ElementIndex {
     return InvalidElementIndex;
 }
 
+void Layer::removeElements(const vector<Element*>& elements, bool free) {
+    if (elements.empty()) {
+        return;
+    }
+
+    std::unordered_set<Element*> toRemove(elements.begin(), elements.end());
+
+    // Compacts the remaining elements, their relative order is unchanged, so the order of the index stays valid
+    size_t kept = 0;
+    size_t removed = 0;
+    for (Element* e: this->elements) {
+        if (toRemove.count(e) == 0) {
+            this->elements[kept++] = e;
+            continue;
+        }
+
+        this->index.remove(e);
+        if (free) {
+            delete e;
+        }
+        removed++;
+    }
+    this->elements.resize(kept);
+
+    if (removed > 0) {
+        markChanged();
+    }
+
+    if (removed != toRemove.size()) {
+        g_warning("Could not remove all elements from layer, some are not on the layer!");
+        Stacktrace::printStracktrace();
+    }
+}
+
 auto Layer::isAnnotated() -> bool { return !this->elements.empty(); }
 
 /**
@@ -112,9 +162,26 @@ void Layer::setVisible(bool visible) { this->visible = visible; }
 
 auto Layer::getElements() -> vector<Element*>* { return &this->elements; }
 
+auto Layer::getElementsInArea(const Rectangle<double>& area) -> vector<Element*> {
+    return this->index.query(area, this->elements);
+}
+
+auto Layer::getElementsBelow(double y) -> vector<Element*> { return this->index.queryBelow(y, this->elements); }
+
 
 auto Layer::hasName() const -> bool { return name.has_value(); }
 
 auto Layer::getName() const -> string { return name.value_or(""); }
 
-void Layer::setName(const string& newName) { this->name = newName; }
+void Layer::setName(const string& newName) {
+    this->name = newName;
+    markChanged();
+}
+
+void Layer::setPage(XojPage* page) { this->page = page; }
+
+void Layer::markChanged() {
+    if (this->page) {
+        this->page->markChanged();
+    }
+}
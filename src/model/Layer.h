@@ -15,11 +15,15 @@
 #include <vector>
 
 #include "Element.h"
+#include "Rectangle.h"
+#include "SpatialIndex.h"
 #include "XournalType.h"
 
 template <class T>
 using optional = std::optional<T>;
 
+class XojPage;
+
 class Layer {
 public:
     Layer();
@@ -36,6 +40,13 @@ public:
      */
     void addElement(Element* e);
 
+    /**
+     * Appends all Element%s to this Layer, in the given order
+     *
+     * @note Element%s already contained in the Layer are skipped
+     */
+    void addElements(const vector<Element*>& elements);
+
     /**
      * Inserts an Element in the specified position of the Layer%s internal list
      *
@@ -53,11 +64,32 @@ public:
      */
     ElementIndex removeElement(Element* e, bool free);
 
+    /**
+     * Removes all given Element%s from the Layer in a single pass over the internal list, and optionally deletes them
+     *
+     * Prefer this over calling removeElement() for each Element, which is quadratic in the size of the Layer
+     */
+    void removeElements(const vector<Element*>& elements, bool free);
+
     /**
      * Returns an iterator over the Element%s contained in this Layer
      */
     vector<Element*>* getElements();
 
+    /**
+     * Returns the Element%s whose bounding box intersects (or touches) the given area, in drawing order
+     *
+     * Uses the spatial index of the Layer, prefer this over iterating getElements() for area lookups
+     */
+    vector<Element*> getElementsInArea(const Rectangle<double>& area);
+
+    /**
+     * Returns the Element%s whose bounding box starts at or below the given y coordinate, in drawing order
+     *
+     * Uses the spatial index of the Layer, which keeps the Element%s sorted by their top edge
+     */
+    vector<Element*> getElementsBelow(double y);
+
     /**
      * Returns whether or not the Layer is empty
      */
@@ -94,10 +126,28 @@ public:
      */
     void setName(const string& newName);
 
+    /**
+     * Sets the page the Layer belongs to, or nullptr. Set by the page.
+     *
+     * Every change of the Element%s of the Layer assigns a new revision to the page (see XojPage::getRevision()),
+     * e.g. elements taken out of the layer by a selection and put back when it is finalized.
+     */
+    void setPage(XojPage* page);
+
+private:
+    void markChanged();
+
 private:
     vector<Element*> elements;
 
+    /**
+     * Index over the bounding boxes of the elements
+     */
+    SpatialIndex index;
+
     bool visible = true;
 
     optional<string> name;
+
+    XojPage* page = nullptr;
 };
@@ -0,0 +1,265 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Element.h"
+
+SpatialIndex::SpatialIndex() = default;
+
+SpatialIndex::~SpatialIndex() = default;
+
+auto SpatialIndex::cellIndex(double coordinate) -> int32_t {
+    // Keep broken coordinates in a sane range, the cell keys would overflow otherwise
+    constexpr double LIMIT = 1e6;
+
+    double cell = std::floor(coordinate / CELL_SIZE);
+    if (std::isnan(cell)) {
+        return 0;
+    }
+    return static_cast<int32_t>(std::clamp(cell, -LIMIT, LIMIT));
+}
+
+auto SpatialIndex::cellKey(int32_t cx, int32_t cy) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32U) | static_cast<uint32_t>(cy);
+}
+
+void SpatialIndex::addToCells(Entry* entry) {
+    entry->bounds = entry->element->boundingRect();
+    entry->cx1 = cellIndex(entry->bounds.x);
+    entry->cy1 = cellIndex(entry->bounds.y);
+    entry->cx2 = cellIndex(entry->bounds.x + entry->bounds.width);
+    entry->cy2 = cellIndex(entry->bounds.y + entry->bounds.height);
+
+    int64_t cellCount = (int64_t(entry->cx2) - entry->cx1 + 1) * (int64_t(entry->cy2) - entry->cy1 + 1);
+    entry->large = cellCount > MAX_CELLS_PER_ELEMENT;
+
+    if (entry->large) {
+        this->largeElements.push_back(entry);
+        return;
+    }
+
+    for (int32_t cx = entry->cx1; cx <= entry->cx2; cx++) {
+        for (int32_t cy = entry->cy1; cy <= entry->cy2; cy++) {
+            this->cells[cellKey(cx, cy)].push_back(entry);
+        }
+    }
+}
+
+void SpatialIndex::removeFromCells(Entry* entry) {
+    auto removeFrom = [entry](vector<Entry*>& list) {
+        auto it = std::find(list.begin(), list.end(), entry);
+        if (it != list.end()) {
+            *it = list.back();
+            list.pop_back();
+        }
+    };
+
+    if (entry->large) {
+        removeFrom(this->largeElements);
+        return;
+    }
+
+    for (int32_t cx = entry->cx1; cx <= entry->cx2; cx++) {
+        for (int32_t cy = entry->cy1; cy <= entry->cy2; cy++) {
+            auto cell = this->cells.find(cellKey(cx, cy));
+            if (cell == this->cells.end()) {
+                continue;
+            }
+
+            removeFrom(cell->second);
+            if (cell->second.empty()) {
+                this->cells.erase(cell);
+            }
+        }
+    }
+}
+
+void SpatialIndex::insert(Element* e) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto [it, inserted] = this->entries.try_emplace(e);
+    if (!inserted) {
+        return;
+    }
+
+    Entry* entry = &it->second;
+    entry->element = e;
+    entry->order = this->nextOrder++;
+    addToCells(entry);
+    this->sortedByTopValid = false;
+
+    e->spatialIndex = this;
+}
+
+void SpatialIndex::remove(Element* e) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->entries.find(e);
+    if (it == this->entries.end()) {
+        return;
+    }
+
+    removeFromCells(&it->second);
+    this->entries.erase(it);
+    this->sortedByTopValid = false;
+
+    e->spatialIndex = nullptr;
+}
+
+void SpatialIndex::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    for (auto& [e, entry]: this->entries) {
+        e->spatialIndex = nullptr;
+    }
+
+    this->entries.clear();
+    this->cells.clear();
+    this->largeElements.clear();
+    this->staleElements.clear();
+    this->sortedByTop.clear();
+    this->sortedByTopValid = false;
+    this->nextOrder = 0;
+    this->orderValid = true;
+}
+
+auto SpatialIndex::contains(Element* e) -> bool {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->entries.find(e) != this->entries.end();
+}
+
+void SpatialIndex::invalidate(Element* e) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->entries.find(e);
+    if (it == this->entries.end() || it->second.stale) {
+        return;
+    }
+
+    it->second.stale = true;
+    this->staleElements.push_back(e);
+}
+
+void SpatialIndex::invalidateOrder() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->orderValid = false;
+}
+
+void SpatialIndex::refresh(const vector<Element*>& elements) {
+    for (Element* e: this->staleElements) {
+        auto it = this->entries.find(e);
+
+        // The element may have been removed (and its memory reused) in the meantime
+        if (it == this->entries.end() || !it->second.stale) {
+            continue;
+        }
+
+        removeFromCells(&it->second);
+        it->second.stale = false;
+        addToCells(&it->second);
+        this->sortedByTopValid = false;
+    }
+    this->staleElements.clear();
+
+    if (!this->orderValid) {
+        size_t order = 0;
+        for (Element* e: elements) {
+            auto it = this->entries.find(e);
+            if (it != this->entries.end()) {
+                it->second.order = order;
+            }
+            order++;
+        }
+        this->nextOrder = order;
+        this->orderValid = true;
+    }
+}
+
+auto SpatialIndex::query(const Rectangle<double>& area, const vector<Element*>& elements) -> vector<Element*> {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    refresh(elements);
+
+    double x2 = area.x + area.width;
+    double y2 = area.y + area.height;
+
+    vector<Entry*> candidates;
+    auto addCandidate = [&](Entry* entry) {
+        const Rectangle<double>& b = entry->bounds;
+        if (b.x <= x2 && area.x <= b.x + b.width && b.y <= y2 && area.y <= b.y + b.height) {
+            candidates.push_back(entry);
+        }
+    };
+
+    int32_t cx1 = cellIndex(area.x);
+    int32_t cy1 = cellIndex(area.y);
+    int32_t cx2 = cellIndex(x2);
+    int32_t cy2 = cellIndex(y2);
+
+    auto cellCount = static_cast<size_t>((int64_t(cx2) - cx1 + 1) * (int64_t(cy2) - cy1 + 1));
+    if (cellCount > this->cells.size()) {
+        // Cheaper to test all elements than to look up mostly empty cells
+        for (auto& [e, entry]: this->entries) {
+            addCandidate(&entry);
+        }
+    } else {
+        for (Entry* entry: this->largeElements) {
+            addCandidate(entry);
+        }
+        for (int32_t cx = cx1; cx <= cx2; cx++) {
+            for (int32_t cy = cy1; cy <= cy2; cy++) {
+                auto cell = this->cells.find(cellKey(cx, cy));
+                if (cell == this->cells.end()) {
+                    continue;
+                }
+                for (Entry* entry: cell->second) {
+                    addCandidate(entry);
+                }
+            }
+        }
+
+        // Elements spanning multiple cells were found more than once
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](Entry* a, Entry* b) { return a->order < b->order; });
+
+    vector<Element*> result;
+    result.reserve(candidates.size());
+    for (Entry* entry: candidates) {
+        result.push_back(entry->element);
+    }
+    return result;
+}
+
+auto SpatialIndex::queryBelow(double y, const vector<Element*>& elements) -> vector<Element*> {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    refresh(elements);
+
+    if (!this->sortedByTopValid) {
+        this->sortedByTop.clear();
+        this->sortedByTop.reserve(this->entries.size());
+        for (auto& [e, entry]: this->entries) {
+            this->sortedByTop.push_back(&entry);
+        }
+        std::sort(this->sortedByTop.begin(), this->sortedByTop.end(),
+                  [](Entry* a, Entry* b) { return a->bounds.y < b->bounds.y; });
+        this->sortedByTopValid = true;
+    }
+
+    auto first = std::lower_bound(this->sortedByTop.begin(), this->sortedByTop.end(), y,
+                                  [](Entry* entry, double y) { return entry->bounds.y < y; });
+
+    vector<Entry*> candidates(first, this->sortedByTop.end());
+    std::sort(candidates.begin(), candidates.end(), [](Entry* a, Entry* b) { return a->order < b->order; });
+
+    vector<Element*> result;
+    result.reserve(candidates.size());
+    for (Entry* entry: candidates) {
+        result.push_back(entry->element);
+    }
+    return result;
+}
@@ -0,0 +1,148 @@
+/*
+ * Xournal++
+ *
+ * A uniform grid over the bounding boxes of the elements of a layer
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Rectangle.h"
+#include "XournalType.h"
+
+class Element;
+
+/**
+ * @brief Spatial lookup structure used by Layer to answer rectangle queries without scanning all elements
+ *
+ * Every element is stored in all grid cells its bounding box overlaps. Elements covering a large number of cells
+ * (e.g. a full page image) are kept in a separate list and tested on every query.
+ *
+ * Additionally the elements are sorted by the top edge of their bounding box, for the queries of everything below
+ * a line (vertical space tool). This order is rebuilt lazily by the next such query after any change.
+ *
+ * Elements report changes of their bounding box with Element::boundsChanged(), they are then reindexed lazily
+ * by the next query. All methods are thread safe.
+ */
+class SpatialIndex {
+public:
+    SpatialIndex();
+    ~SpatialIndex();
+
+    SpatialIndex(const SpatialIndex&) = delete;
+    SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+public:
+    /**
+     * Adds an element on top of the drawing order and registers the index on the element
+     */
+    void insert(Element* e);
+
+    /**
+     * Removes an element from the index and unregisters the index from the element
+     */
+    void remove(Element* e);
+
+    /**
+     * Removes all elements from the index
+     */
+    void clear();
+
+    /**
+     * @return true if the element is contained in the index
+     */
+    bool contains(Element* e);
+
+    /**
+     * Marks the bounding box of the element as outdated, it is reindexed by the next query
+     */
+    void invalidate(Element* e);
+
+    /**
+     * Has to be called if an element was not inserted on top, the drawing order is then recomputed by the next query
+     */
+    void invalidateOrder();
+
+    /**
+     * Returns all elements whose bounding box intersects (or touches) the given area
+     *
+     * @param area The area to search, in page coordinates
+     * @param elements The elements of the layer in drawing order, used to renumber the elements if the order was
+     * invalidated
+     * @return The elements in drawing order
+     */
+    vector<Element*> query(const Rectangle<double>& area, const vector<Element*>& elements);
+
+    /**
+     * Returns all elements whose bounding box starts at or below the given line
+     *
+     * @param y The line, in page coordinates
+     * @param elements The elements of the layer in drawing order, see query()
+     * @return The elements in drawing order
+     */
+    vector<Element*> queryBelow(double y, const vector<Element*>& elements);
+
+private:
+    struct Entry {
+        Element* element = nullptr;
+
+        Rectangle<double> bounds;
+
+        // Range of grid cells covered, inclusive
+        int32_t cx1 = 0;
+        int32_t cy1 = 0;
+        int32_t cx2 = 0;
+        int32_t cy2 = 0;
+
+        bool large = false;
+        bool stale = false;
+
+        size_t order = 0;
+    };
+
+    void addToCells(Entry* entry);
+    void removeFromCells(Entry* entry);
+    void refresh(const vector<Element*>& elements);
+
+    static int32_t cellIndex(double coordinate);
+    static uint64_t cellKey(int32_t cx, int32_t cy);
+
+private:
+    /**
+     * Size of a grid cell in page coordinates
+     */
+    static constexpr double CELL_SIZE = 64.0;
+
+    /**
+     * Elements covering more cells are stored in largeElements
+     */
+    static constexpr int64_t MAX_CELLS_PER_ELEMENT = 64;
+
+    std::mutex mutex;
+
+    /**
+     * The nodes of an unordered_map are stable, so the cells can point to the entries directly
+     */
+    std::unordered_map<Element*, Entry> entries;
+    std::unordered_map<uint64_t, vector<Entry*>> cells;
+    vector<Entry*> largeElements;
+    vector<Element*> staleElements;
+
+    /**
+     * All entries sorted by the top of their bounds, only valid if sortedByTopValid
+     */
+    vector<Entry*> sortedByTop;
+    bool sortedByTopValid = false;
+
+    size_t nextOrder = 0;
+    bool orderValid = true;
+};
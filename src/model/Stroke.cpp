@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <numeric>
+#include <utility>
 
 #include "serializing/ObjectInputStream.h"
 #include "serializing/ObjectOutputStream.h"
@@ -52,7 +53,8 @@ void Stroke::serialize(ObjectOutputStream& out) {
 
     out.writeInt(fill);
 
-    out.writeData(this->points.data(), this->points.size(), sizeof(Point));
+    std::vector<Point> pointVector = this->points.toVector();
+    out.writeData(pointVector.data(), pointVector.size(), sizeof(Point));
 
     this->lineStyle.serialize(out);
 
@@ -73,9 +75,10 @@ void Stroke::readSerialized(ObjectInputStream& in) {
     Point* p{};
     int count{};
     in.readData(reinterpret_cast<void**>(&p), &count);
-    this->points = std::vector<Point>{p, p + count};
+    this->points = StrokePoints(std::vector<Point>{p, p + count});
     g_free(p);
     this->lineStyle.readSerialized(in);
+    this->revision++;
 
     in.endObject();
 }
@@ -98,18 +101,22 @@ auto Stroke::getFill() const -> int { return fill; }
  */
 void Stroke::setFill(int fill) { this->fill = fill; }
 
-void Stroke::setWidth(double width) { this->width = width; }
+void Stroke::setWidth(double width) {
+    this->width = width;
+    this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
+}
 
 auto Stroke::getWidth() const -> double { return this->width; }
 
 auto Stroke::rescaleWithMirror() -> bool { return true; }
 
 auto Stroke::isInSelection(ShapeContainer* container) -> bool {
-    for (auto&& p: this->points) {
-        double px = p.x;
-        double py = p.y;
-
-        if (!container->contains(px, py)) {
+    const double* px = this->points.getX();
+    const double* py = this->points.getY();
+    for (size_t i = 0; i < this->points.size(); i++) {
+        if (!container->contains(px[i], py[i])) {
             return false;
         }
     }
@@ -119,10 +126,13 @@ auto Stroke::isInSelection(ShapeContainer* container) -> bool {
 
 void Stroke::setFirstPoint(double x, double y) {
     if (!this->points.empty()) {
-        Point& p = this->points.front();
+        Point p = this->points.get(0);
         p.x = x;
         p.y = y;
+        this->points.set(0, p);
         this->sizeCalculated = false;
+        boundsChanged();
+        this->revision++;
     }
 }
 
@@ -130,35 +140,58 @@ void Stroke::setLastPoint(double x, double y) { setLastPoint({x, y}); }
 
 void Stroke::setLastPoint(const Point& p) {
     if (!this->points.empty()) {
-        this->points.back() = p;
+        this->points.set(this->points.size() - 1, p);
         this->sizeCalculated = false;
+        boundsChanged();
+        this->revision++;
     }
 }
 
 void Stroke::addPoint(const Point& p) {
-    this->points.emplace_back(p);
+    this->points.add(p);
+    this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
+}
+
+void Stroke::setPoints(const std::vector<Point>& points) { setPoints(StrokePoints(points)); }
+
+void Stroke::setPoints(StrokePoints points) {
+    this->points = std::move(points);
     this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
 }
 
 auto Stroke::getPointCount() const -> int { return this->points.size(); }
 
-auto Stroke::getPointVector() const -> std::vector<Point> const& { return points; }
+auto Stroke::getPointVector() const -> std::vector<Point> { return this->points.toVector(); }
+
+auto Stroke::getPointData() const -> StrokePoints const& { return this->points; }
 
-void Stroke::deletePointsFrom(int index) { points.resize(std::min(size_t(index), points.size())); }
+void Stroke::deletePointsFrom(int index) {
+    this->points.truncate(static_cast<size_t>(index));
+    this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
+}
 
-void Stroke::deletePoint(int index) { this->points.erase(std::next(begin(this->points), index)); }
+void Stroke::deletePoint(int index) {
+    this->points.erase(static_cast<size_t>(index));
+    this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
+}
 
 auto Stroke::getPoint(int index) const -> Point {
     if (index < 0 || index >= this->points.size()) {
         g_warning("Stroke::getPoint(%i) out of bounds!", index);
         return Point(0, 0, Point::NO_PRESSURE);
     }
-    return points.at(index);
+    return this->points.get(static_cast<size_t>(index));
 }
 
-auto Stroke::getPoints() const -> const Point* { return this->points.data(); }
-
-void Stroke::freeUnusedPointItems() { this->points = {begin(this->points), end(this->points)}; }
+void Stroke::freeUnusedPointItems() { this->points.shrinkToFit(); }
 
 void Stroke::setToolType(StrokeTool type) { this->toolType = type; }
 
@@ -169,12 +202,11 @@ void Stroke::setLineStyle(const LineStyle& style) { this->lineStyle = style; }
 auto Stroke::getLineStyle() const -> const LineStyle& { return this->lineStyle; }
 
 void Stroke::move(double dx, double dy) {
-    for (auto&& point: points) {
-        point.x += dx;
-        point.y += dy;
-    }
+    this->points.translate(dx, dy);
 
     this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
 }
 
 void Stroke::rotate(double x0, double y0, double th) {
@@ -184,11 +216,11 @@ void Stroke::rotate(double x0, double y0, double th) {
     cairo_matrix_rotate(&rotMatrix, th);
     cairo_matrix_translate(&rotMatrix, -x0, -y0);
 
-    for (auto&& p: points) {
-        cairo_matrix_transform_point(&rotMatrix, &p.x, &p.y);
-    }
+    this->points.transform(rotMatrix);
     // Width and Height will likely be changed after this operation
     calcSize();
+    boundsChanged();
+    this->revision++;
 }
 
 void Stroke::scale(double x0, double y0, double fx, double fy, double rotation, bool restoreLineWidth) {
@@ -201,56 +233,54 @@ void Stroke::scale(double x0, double y0, double fx, double fy, double rotation,
     cairo_matrix_rotate(&scaleMatrix, -rotation);
     cairo_matrix_translate(&scaleMatrix, -x0, -y0);
 
-    for (auto&& p: points) {
-        cairo_matrix_transform_point(&scaleMatrix, &p.x, &p.y);
-
-        if (p.z != Point::NO_PRESSURE) {
-            p.z *= fz;
-        }
-    }
+    this->points.transform(scaleMatrix);
+    this->points.scalePressure(fz);
     this->width *= fz;
 
     this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
 }
 
-auto Stroke::hasPressure() const -> bool {
-    if (!this->points.empty()) {
-        return this->points[0].z != Point::NO_PRESSURE;
-    }
-    return false;
-}
+auto Stroke::hasPressure() const -> bool { return this->points.hasPressure(); }
 
 auto Stroke::getAvgPressure() const -> double {
-    return std::accumulate(begin(this->points), end(this->points), 0.0,
-                           [](double l, Point const& p) { return l + p.z; }) /
-           this->points.size();
+    const double* pressure = this->points.getPressure();
+    if (pressure == nullptr) {
+        return Point::NO_PRESSURE;
+    }
+    return std::accumulate(pressure, pressure + this->points.size(), 0.0) / this->points.size();
 }
 
 void Stroke::scalePressure(double factor) {
     if (!hasPressure()) {
         return;
     }
-    for (auto&& p: this->points) {
-        p.z *= factor;
-    }
+    this->points.scalePressure(factor);
+    this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
 }
 
 void Stroke::clearPressure() {
-    for (auto&& p: points) {
-        p.z = Point::NO_PRESSURE;
-    }
+    this->points.clearPressure();
+    this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
 }
 
 void Stroke::setLastPressure(double pressure) {
     if (!this->points.empty()) {
-        this->points.back().z = pressure;
+        this->points.setPressure(this->points.size() - 1, pressure);
+        this->revision++;
     }
 }
 
 void Stroke::setSecondToLastPressure(double pressure) {
-    auto const pointCount = this->getPointCount();
+    auto const pointCount = this->points.size();
     if (pointCount >= 2) {
-        this->points[pointCount - 2].z = pressure;
+        this->points.setPressure(pointCount - 2, pressure);
+        this->revision++;
     }
 }
 
@@ -263,8 +293,11 @@ void Stroke::setPressure(const vector<double>& pressure) {
 
     auto max_size = std::min(pressure.size(), this->points.size() - 1);
     for (size_t i = 0U; i != max_size; ++i) {
-        this->points[i].z = pressure[i];
+        this->points.setPressure(i, pressure[i]);
     }
+    this->sizeCalculated = false;
+    boundsChanged();
+    this->revision++;
 }
 
 /**
@@ -287,32 +320,27 @@ auto Stroke::intersects(double x, double y, double halfEraserSize, double* gap)
     double y1 = y - halfEraserSize;
     double y2 = y + halfEraserSize;
 
-    double lastX = points[0].x;
-    double lastY = points[0].y;
-    for (auto&& point: points) {
-        double px = point.x;
-        double py = point.y;
-
-        if (px >= x1 && py >= y1 && px <= x2 && py <= y2) {
-            if (gap) {
-                *gap = 0;
-            }
-            return true;
-        }
+    // The segments only need to be checked up to the first point within the eraser box
+    size_t firstInRect = this->points.findFirstInRect(x1, y1, x2, y2);
 
-        double len = hypot(px - lastX, py - lastY);
+    const double* px = this->points.getX();
+    const double* py = this->points.getY();
+    double lastX = px[0];
+    double lastY = py[0];
+    for (size_t i = 0; i < firstInRect; i++) {
+        double len = hypot(px[i] - lastX, py[i] - lastY);
         if (len >= halfEraserSize) {
             /**
              * The distance of the center of the eraser box to the line passing through (lastx, lasty) and (px, py)
              */
-            double p = std::abs((x - lastX) * (lastY - py) + (y - lastY) * (px - lastX)) / len;
+            double p = std::abs((x - lastX) * (lastY - py[i]) + (y - lastY) * (px[i] - lastX)) / len;
 
             // If the distance p of the center of the eraser box to the (full) line is in the range,
             // we check whether the eraser box is not too far from the line segment through the two points.
 
             if (p <= halfEraserSize) {
-                double centerX = (lastX + px) / 2;
-                double centerY = (lastY + py) / 2;
+                double centerX = (lastX + px[i]) / 2;
+                double centerY = (lastY + py[i]) / 2;
                 double distance = hypot(x - centerX, y - centerY);
 
                 // For the above check we imagine a circle whose center is the mid point of the two points of the stroke
@@ -333,8 +361,15 @@ auto Stroke::intersects(double x, double y, double halfEraserSize, double* gap)
             }
         }
 
-        lastX = px;
-        lastY = py;
+        lastX = px[i];
+        lastY = py[i];
+    }
+
+    if (firstInRect < this->points.size()) {
+        if (gap) {
+            *gap = 0;
+        }
+        return true;
     }
 
     return false;
@@ -347,66 +382,45 @@ auto Stroke::intersects(double x, double y, double halfEraserSize, double* gap)
  * Also used for Selected Bounding box.
  */
 void Stroke::calcSize() const {
-    if (this->points.empty()) {
-        Element::x = 0;
-        Element::y = 0;
+    // The snapped bounds do not include the width of the stroke
+    Rectangle<double> snapped;
+    Rectangle<double> bounds = this->points.getBounds(this->width / 2.0, snapped);
 
-        // The size of the rectangle, not the size of the pen!
-        Element::width = 0;
-        Element::height = 0;
+    Element::x = bounds.x;
+    Element::y = bounds.y;
 
-        // used for snapping
-        Element::snappedBounds = Rectangle<double>{};
-    }
+    // The size of the rectangle, not the size of the pen!
+    Element::width = bounds.width;
+    Element::height = bounds.height;
 
-    double minX = DBL_MAX;
-    double maxX = DBL_MIN;
-    double minY = DBL_MAX;
-    double maxY = DBL_MIN;
-
-    double minSnapX = DBL_MAX;
-    double maxSnapX = DBL_MIN;
-    double minSnapY = DBL_MAX;
-    double maxSnapY = DBL_MIN;
-
-    bool hasPressure = points[0].z != Point::NO_PRESSURE;
-    double halfThick = this->width / 2.0;  //  accommodate for pen width
+    // used for snapping
+    Element::snappedBounds = snapped;
+}
 
-    for (auto&& p: points) {
-        if (hasPressure) {
-            halfThick = p.z / 2.0;
-        }
+auto Stroke::getEraseable() -> EraseableStroke* { return this->eraseable; }
 
-        minX = std::min(minX, p.x - halfThick);
-        minY = std::min(minY, p.y - halfThick);
+void Stroke::setEraseable(EraseableStroke* eraseable) { this->eraseable = eraseable; }
 
-        maxX = std::max(maxX, p.x + halfThick);
-        maxY = std::max(maxY, p.y + halfThick);
+auto Stroke::getRevision() const -> uint64_t { return this->revision; }
 
-        minSnapX = std::min(minSnapX, p.x);
-        minSnapY = std::min(minSnapY, p.y);
+auto Stroke::getRenderCache() const -> std::shared_ptr<StrokeRenderCache> { return std::atomic_load(&this->renderCache); }
 
-        maxSnapX = std::max(maxSnapX, p.x);
-        maxSnapY = std::max(maxSnapY, p.y);
+auto Stroke::replaceRenderCache(std::shared_ptr<StrokeRenderCache> expected,
+                                std::shared_ptr<StrokeRenderCache> cache) const -> std::shared_ptr<StrokeRenderCache> {
+    // Another rendering thread may have been faster, then its cache is used
+    if (std::atomic_compare_exchange_strong(&this->renderCache, &expected, cache)) {
+        return cache;
     }
-
-    Element::x = minX;
-    Element::y = minY;
-    Element::width = maxX - minX;
-    Element::height = maxY - minY;
-
-    Element::snappedBounds = Rectangle<double>(minSnapX, minSnapY, maxSnapX - minSnapX, maxSnapY - minSnapY);
+    return expected;
 }
 
-auto Stroke::getEraseable() -> EraseableStroke* { return this->eraseable; }
-
-void Stroke::setEraseable(EraseableStroke* eraseable) { this->eraseable = eraseable; }
+void Stroke::resetRenderCache() { std::atomic_store(&this->renderCache, std::shared_ptr<StrokeRenderCache>()); }
 
 void Stroke::debugPrint() {
     g_message("%s", FC(FORMAT_STR("Stroke {1} / hasPressure() = {2}") % (uint64_t)this % this->hasPressure()));
 
-    for (auto&& p: points) {
-        g_message("%lf / %lf", p.x, p.y);
+    for (size_t i = 0; i < this->points.size(); i++) {
+        g_message("%lf / %lf", this->points.getX()[i], this->points.getY()[i]);
     }
 
     g_message("\n");
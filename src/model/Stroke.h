@@ -11,14 +11,19 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
+
 #include "AudioElement.h"
 #include "Element.h"
 #include "LineStyle.h"
 #include "Point.h"
+#include "StrokePoints.h"
 
 enum StrokeTool { STROKE_TOOL_PEN, STROKE_TOOL_ERASER, STROKE_TOOL_HIGHLIGHTER };
 
 class EraseableStroke;
+class StrokeRenderCache;
 
 class Stroke: public AudioElement {
 public:
@@ -61,14 +66,24 @@ public:
     void setFill(int fill);
 
     void addPoint(const Point& p);
+
+    /**
+     * Replaces all points, cheaper than adding them one by one, e.g. while loading a document
+     */
+    void setPoints(const std::vector<Point>& points);
+    void setPoints(StrokePoints points);
     void setLastPoint(double x, double y);
     void setFirstPoint(double x, double y);
     void setLastPoint(const Point& p);
     int getPointCount() const;
     void freeUnusedPointItems();
-    std::vector<Point> const& getPointVector() const;
+
+    /**
+     * @return A copy of the points, use getPointData() to iterate the points
+     */
+    std::vector<Point> getPointVector() const;
+    StrokePoints const& getPointData() const;
     Point getPoint(int index) const;
-    const Point* getPoints() const;
 
     void deletePoint(int index);
     void deletePointsFrom(int index);
@@ -100,6 +115,30 @@ public:
     EraseableStroke* getEraseable();
     void setEraseable(EraseableStroke* eraseable);
 
+    /**
+     * @return Incremented on each change of the geometry of the stroke, see StrokeRenderCache
+     */
+    uint64_t getRevision() const;
+
+    /**
+     * @return The geometry cached for drawing the stroke, nullptr if there is none. It may have been created for an
+     * older revision of the stroke, use StrokeRenderCache::get().
+     */
+    std::shared_ptr<StrokeRenderCache> getRenderCache() const;
+
+    /**
+     * Replaces the cached geometry, if it is still expected
+     *
+     * @return The cache of the stroke afterwards, the one of another rendering thread if it was faster
+     */
+    std::shared_ptr<StrokeRenderCache> replaceRenderCache(std::shared_ptr<StrokeRenderCache> expected,
+                                                          std::shared_ptr<StrokeRenderCache> cache) const;
+
+    /**
+     * Drops the cached geometry, e.g. if the page of the stroke is not shown anymore
+     */
+    void resetRenderCache();
+
     [[maybe_unused]] void debugPrint();
 
 public:
@@ -118,8 +157,8 @@ private:
 
     StrokeTool toolType = STROKE_TOOL_PEN;
 
-    // The array with the points
-    std::vector<Point> points{};
+    // The points, see StrokePoints
+    StrokePoints points;
 
     /**
      * Dashed line
@@ -128,6 +167,17 @@ private:
 
     EraseableStroke* eraseable = nullptr;
 
+    /**
+     * See getRevision()
+     */
+    uint64_t revision = 0;
+
+    /**
+     * See StrokeRenderCache. Only accessed with std::atomic_load / std::atomic_store, as the pages are rendered by
+     * several threads at once.
+     */
+    mutable std::shared_ptr<StrokeRenderCache> renderCache;
+
     /**
      * Option to fill the shape:
      *  -1: The shape is not filled
@@ -0,0 +1,312 @@
+#include "StrokePoints.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+/**
+ * The loops over the points are unrolled by this count with independent accumulators,
+ * so the compiler can map them to SIMD instructions (2 x SSE2 or 1 x AVX register of doubles)
+ */
+constexpr size_t LANES = 4;
+
+struct Extent {
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+};
+
+/**
+ * @param halfThick Returns the half thickness of the point at the index
+ */
+template <typename HalfThick>
+auto computeExtent(const double* x, const double* y, size_t count, HalfThick halfThick) -> Extent {
+    double minX[LANES];
+    double minY[LANES];
+    double maxX[LANES];
+    double maxY[LANES];
+    std::fill(minX, minX + LANES, x[0] - halfThick(0));
+    std::fill(minY, minY + LANES, y[0] - halfThick(0));
+    std::fill(maxX, maxX + LANES, x[0] + halfThick(0));
+    std::fill(maxY, maxY + LANES, y[0] + halfThick(0));
+
+    // Written as conditional expressions instead of std::min / std::max, GCC only vectorizes these without -ffast-math
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (size_t l = 0; l < LANES; l++) {
+            double h = halfThick(i + l);
+            double left = x[i + l] - h;
+            double top = y[i + l] - h;
+            double right = x[i + l] + h;
+            double bottom = y[i + l] + h;
+            minX[l] = left < minX[l] ? left : minX[l];
+            minY[l] = top < minY[l] ? top : minY[l];
+            maxX[l] = right > maxX[l] ? right : maxX[l];
+            maxY[l] = bottom > maxY[l] ? bottom : maxY[l];
+        }
+    }
+    for (; i < count; i++) {
+        double h = halfThick(i);
+        minX[0] = std::min(minX[0], x[i] - h);
+        minY[0] = std::min(minY[0], y[i] - h);
+        maxX[0] = std::max(maxX[0], x[i] + h);
+        maxY[0] = std::max(maxY[0], y[i] + h);
+    }
+
+    Extent extent{minX[0], minY[0], maxX[0], maxY[0]};
+    for (size_t l = 1; l < LANES; l++) {
+        extent.minX = std::min(extent.minX, minX[l]);
+        extent.minY = std::min(extent.minY, minY[l]);
+        extent.maxX = std::max(extent.maxX, maxX[l]);
+        extent.maxY = std::max(extent.maxY, maxY[l]);
+    }
+    return extent;
+}
+
+/**
+ * Distance of the point (px, py) to the line segment from (x1, y1) to (x2, y2)
+ */
+auto segmentDistance(double px, double py, double x1, double y1, double x2, double y2) -> double {
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    double lengthSquared = dx * dx + dy * dy;
+    double t = lengthSquared > 0 ? ((px - x1) * dx + (py - y1) * dy) / lengthSquared : 0;
+    t = std::clamp(t, 0.0, 1.0);
+    return std::hypot(px - x1 - t * dx, py - y1 - t * dy);
+}
+
+}  // namespace
+
+StrokePoints::StrokePoints(const std::vector<Point>& points) {
+    reserve(points.size());
+    for (const Point& p: points) {
+        add(p);
+    }
+}
+
+auto StrokePoints::size() const -> size_t { return this->x.size(); }
+
+auto StrokePoints::empty() const -> bool { return this->x.empty(); }
+
+void StrokePoints::reserve(size_t count) {
+    this->x.reserve(count);
+    this->y.reserve(count);
+    if (!this->pressure.empty()) {
+        this->pressure.reserve(count);
+    }
+}
+
+void StrokePoints::shrinkToFit() {
+    this->x.shrink_to_fit();
+    this->y.shrink_to_fit();
+    this->pressure.shrink_to_fit();
+}
+
+auto StrokePoints::get(size_t index) const -> Point {
+    return Point(this->x[index], this->y[index], this->pressure.empty() ? Point::NO_PRESSURE : this->pressure[index]);
+}
+
+void StrokePoints::set(size_t index, const Point& p) {
+    this->x[index] = p.x;
+    this->y[index] = p.y;
+    setPressure(index, p.z);
+}
+
+void StrokePoints::add(const Point& p) {
+    this->x.push_back(p.x);
+    this->y.push_back(p.y);
+
+    if (!this->pressure.empty()) {
+        this->pressure.push_back(p.z);
+    } else if (p.z != Point::NO_PRESSURE) {
+        this->pressure.reserve(this->x.capacity());
+        this->pressure.assign(this->x.size() - 1, Point::NO_PRESSURE);
+        this->pressure.push_back(p.z);
+    }
+}
+
+void StrokePoints::truncate(size_t count) {
+    if (count >= size()) {
+        return;
+    }
+
+    this->x.resize(count);
+    this->y.resize(count);
+    if (!this->pressure.empty()) {
+        this->pressure.resize(count);
+    }
+}
+
+void StrokePoints::erase(size_t index) {
+    this->x.erase(this->x.begin() + index);
+    this->y.erase(this->y.begin() + index);
+    if (!this->pressure.empty()) {
+        this->pressure.erase(this->pressure.begin() + index);
+    }
+}
+
+auto StrokePoints::toVector() const -> std::vector<Point> {
+    std::vector<Point> points;
+    points.reserve(size());
+    for (size_t i = 0; i < size(); i++) {
+        points.push_back(get(i));
+    }
+    return points;
+}
+
+auto StrokePoints::getX() const -> const double* { return this->x.data(); }
+
+auto StrokePoints::getY() const -> const double* { return this->y.data(); }
+
+auto StrokePoints::getPressure() const -> const double* {
+    return this->pressure.empty() ? nullptr : this->pressure.data();
+}
+
+auto StrokePoints::hasPressure() const -> bool {
+    return !this->pressure.empty() && this->pressure[0] != Point::NO_PRESSURE;
+}
+
+void StrokePoints::setPressure(size_t index, double pressure) {
+    if (this->pressure.empty()) {
+        if (pressure == Point::NO_PRESSURE) {
+            return;
+        }
+        this->pressure.reserve(this->x.capacity());
+        this->pressure.assign(size(), Point::NO_PRESSURE);
+    }
+    this->pressure[index] = pressure;
+}
+
+void StrokePoints::clearPressure() { std::vector<double>().swap(this->pressure); }
+
+void StrokePoints::scalePressure(double factor) {
+    for (double& p: this->pressure) {
+        p = p == Point::NO_PRESSURE ? p : p * factor;
+    }
+}
+
+void StrokePoints::translate(double dx, double dy) {
+    for (double& px: this->x) {
+        px += dx;
+    }
+    for (double& py: this->y) {
+        py += dy;
+    }
+}
+
+void StrokePoints::transform(const cairo_matrix_t& matrix) {
+    // Same as cairo_matrix_transform_point(), but the compiler can vectorize the loop
+    const double xx = matrix.xx;
+    const double xy = matrix.xy;
+    const double yx = matrix.yx;
+    const double yy = matrix.yy;
+    const double x0 = matrix.x0;
+    const double y0 = matrix.y0;
+
+    double* px = this->x.data();
+    double* py = this->y.data();
+    for (size_t i = 0; i < size(); i++) {
+        double tx = px[i];
+        double ty = py[i];
+        px[i] = xx * tx + xy * ty + x0;
+        py[i] = yx * tx + yy * ty + y0;
+    }
+}
+
+auto StrokePoints::getBounds(double halfWidth, Rectangle<double>& snapped) const -> Rectangle<double> {
+    if (empty()) {
+        snapped = Rectangle<double>{};
+        return Rectangle<double>{};
+    }
+
+    Extent points = computeExtent(this->x.data(), this->y.data(), size(), [](size_t) { return 0.0; });
+    snapped = Rectangle<double>(points.minX, points.minY, points.maxX - points.minX, points.maxY - points.minY);
+
+    if (!hasPressure()) {
+        return Rectangle<double>(points.minX - halfWidth, points.minY - halfWidth,
+                                 points.maxX - points.minX + 2 * halfWidth, points.maxY - points.minY + 2 * halfWidth);
+    }
+
+    const double* p = this->pressure.data();
+    Extent stroke = computeExtent(this->x.data(), this->y.data(), size(), [p](size_t i) { return p[i] / 2.0; });
+    return Rectangle<double>(stroke.minX, stroke.minY, stroke.maxX - stroke.minX, stroke.maxY - stroke.minY);
+}
+
+auto StrokePoints::findFirstInRect(double x1, double y1, double x2, double y2) const -> size_t {
+    const double* px = this->x.data();
+    const double* py = this->y.data();
+    const size_t count = size();
+
+    // Find the first block with a hit without branches, the hit within the block is searched below
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        bool hit = false;
+        for (size_t l = 0; l < LANES; l++) {
+            hit |= (px[i + l] >= x1) & (py[i + l] >= y1) & (px[i + l] <= x2) & (py[i + l] <= y2);
+        }
+        if (hit) {
+            break;
+        }
+    }
+
+    for (; i < count; i++) {
+        if (px[i] >= x1 && py[i] >= y1 && px[i] <= x2 && py[i] <= y2) {
+            return i;
+        }
+    }
+    return count;
+}
+
+auto StrokePoints::simplify(double tolerance) const -> StrokePoints {
+    const size_t count = size();
+    if (count < 3) {
+        return *this;
+    }
+
+    const double* px = this->x.data();
+    const double* py = this->y.data();
+    const double* pz = this->pressure.empty() ? nullptr : this->pressure.data();
+
+    std::vector<bool> keep(count, false);
+    keep[0] = true;
+    keep[count - 1] = true;
+
+    // Ranges still to be checked, iterative instead of recursive as strokes may have many thousands of points
+    std::vector<std::pair<size_t, size_t>> ranges{{0, count - 1}};
+    while (!ranges.empty()) {
+        auto [first, last] = ranges.back();
+        ranges.pop_back();
+
+        double maxDistance = tolerance;
+        size_t farthest = first;
+        for (size_t i = first + 1; i < last; i++) {
+            double distance = segmentDistance(px[i], py[i], px[first], py[first], px[last], py[last]);
+            if (pz != nullptr) {
+                // The width of a segment is the pressure of its first point
+                distance = std::max(distance, std::abs(pz[i] - pz[first]) / 2);
+            }
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
+
+        if (farthest != first) {
+            keep[farthest] = true;
+            ranges.emplace_back(first, farthest);
+            ranges.emplace_back(farthest, last);
+        }
+    }
+
+    StrokePoints result;
+    result.reserve(static_cast<size_t>(std::count(keep.begin(), keep.end(), true)));
+    for (size_t i = 0; i < count; i++) {
+        if (keep[i]) {
+            result.add(get(i));
+        }
+    }
+    return result;
+}
@@ -0,0 +1,104 @@
+/*
+ * Xournal++
+ *
+ * The points of a stroke, stored as separate coordinate arrays
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <cairo.h>
+
+#include "Point.h"
+#include "Rectangle.h"
+
+/**
+ * @brief The points of a stroke as structure of arrays
+ *
+ * The x and y coordinates are stored in separate arrays, the pressure array is only allocated for strokes with
+ * pressure. A stroke without pressure needs 16 instead of 24 bytes per point, and the loops over all points
+ * (bounds, transformations, hit tests) work on contiguous arrays, so the compiler can vectorize them.
+ *
+ * The pressure array is either empty or has one value per point, Point::NO_PRESSURE for points without pressure.
+ */
+class StrokePoints {
+public:
+    StrokePoints() = default;
+    explicit StrokePoints(const std::vector<Point>& points);
+
+public:
+    size_t size() const;
+    bool empty() const;
+    void reserve(size_t count);
+
+    /**
+     * Releases the memory which is not used by the points
+     */
+    void shrinkToFit();
+
+    Point get(size_t index) const;
+    void set(size_t index, const Point& p);
+    void add(const Point& p);
+
+    /**
+     * Keeps only the first count points
+     */
+    void truncate(size_t count);
+    void erase(size_t index);
+
+    std::vector<Point> toVector() const;
+
+    const double* getX() const;
+    const double* getY() const;
+
+    /**
+     * @return The pressure of the points, nullptr if no point has pressure
+     */
+    const double* getPressure() const;
+
+    /**
+     * @return true if the first point has pressure
+     */
+    bool hasPressure() const;
+    void setPressure(size_t index, double pressure);
+
+    /**
+     * Removes the pressure of all points
+     */
+    void clearPressure();
+    void scalePressure(double factor);
+
+    void translate(double dx, double dy);
+    void transform(const cairo_matrix_t& matrix);
+
+    /**
+     * @param halfWidth Half the width of the stroke, used for points without pressure
+     * @param snapped Set to the bounds of the points, without the width of the stroke
+     * @return The bounds of the stroke, including its width
+     */
+    Rectangle<double> getBounds(double halfWidth, Rectangle<double>& snapped) const;
+
+    /**
+     * @return The index of the first point within the rectangle (edges included), or size() if there is none
+     */
+    size_t findFirstInRect(double x1, double y1, double x2, double y2) const;
+
+    /**
+     * Simplifies the points with the Douglas-Peucker algorithm, the first and the last point are always kept
+     *
+     * @param tolerance Maximum distance of a removed point to the simplified line. For points with pressure,
+     * also the maximum change of the half width.
+     */
+    StrokePoints simplify(double tolerance) const;
+
+private:
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> pressure;
+};
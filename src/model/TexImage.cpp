@@ -1,5 +1,6 @@
 #include "TexImage.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "serializing/ObjectInputStream.h"
@@ -7,11 +8,18 @@
 
 #include "pixbuf-utils.h"
 
+/**
+ * Rendered sizes kept per TexImage, e.g. the main view, the sidebar preview and the previous zoom step
+ */
+constexpr size_t MAX_TEX_RASTERS = 3;
+
 TexImage::TexImage(): Element(ELEMENT_TEXIMAGE) { this->sizeCalculated = true; }
 
 TexImage::~TexImage() { freeImageAndPdf(); }
 
 void TexImage::freeImageAndPdf() {
+    releaseRaster();
+
     if (this->image) {
         cairo_surface_destroy(this->image);
         this->image = nullptr;
@@ -46,11 +54,13 @@ auto TexImage::clone() -> Element* {
 void TexImage::setWidth(double width) {
     this->width = width;
     this->calcSize();
+    boundsChanged();
 }
 
 void TexImage::setHeight(double height) {
     this->height = height;
     this->calcSize();
+    boundsChanged();
 }
 
 auto TexImage::cairoReadFunction(TexImage* image, unsigned char* data, unsigned int length) -> cairo_status_t {
@@ -106,6 +116,55 @@ auto TexImage::getImage() -> cairo_surface_t* { return this->image; }
 
 auto TexImage::getPdf() -> PopplerDocument* { return this->pdf; }
 
+auto TexImage::getPdfRaster(int width, int height) -> cairo_surface_t* {
+    std::lock_guard<std::mutex> lock(this->rasterMutex);
+
+    if (this->pdf == nullptr || poppler_document_get_n_pages(this->pdf) < 1) {
+        return nullptr;
+    }
+
+    for (Raster& raster: this->rasters) {
+        if (cairo_image_surface_get_width(raster.surface) == width &&
+            cairo_image_surface_get_height(raster.surface) == height) {
+            raster.lastUse = ++this->rasterUse;
+            return cairo_surface_reference(raster.surface);
+        }
+    }
+
+    PopplerPage* page = poppler_document_get_page(this->pdf, 0);
+
+    double pageWidth = 0;
+    double pageHeight = 0;
+    poppler_page_get_size(page, &pageWidth, &pageHeight);
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cairo_t* cr = cairo_create(surface);
+    cairo_scale(cr, width / pageWidth, height / pageHeight);
+    poppler_page_render(page, cr);
+    cairo_destroy(cr);
+
+    g_object_unref(page);
+
+    if (this->rasters.size() >= MAX_TEX_RASTERS) {
+        auto oldest = std::min_element(this->rasters.begin(), this->rasters.end(),
+                                       [](const Raster& a, const Raster& b) { return a.lastUse < b.lastUse; });
+        cairo_surface_destroy(oldest->surface);
+        this->rasters.erase(oldest);
+    }
+    this->rasters.push_back({surface, ++this->rasterUse});
+
+    return cairo_surface_reference(surface);
+}
+
+void TexImage::releaseRaster() {
+    std::lock_guard<std::mutex> lock(this->rasterMutex);
+
+    for (Raster& raster: this->rasters) {
+        cairo_surface_destroy(raster.surface);
+    }
+    this->rasters.clear();
+}
+
 void TexImage::scale(double x0, double y0, double fx, double fy, double rotation,
                      bool) {  // line width scaling option is not used
 
@@ -115,6 +174,7 @@ void TexImage::scale(double x0, double y0, double fx, double fy, double rotation
     this->width *= fx;
     this->height *= fy;
     this->calcSize();
+    boundsChanged();
 }
 
 void TexImage::rotate(double x0, double y0, double th) {
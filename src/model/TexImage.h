@@ -11,7 +11,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -51,6 +53,21 @@ public:
      */
     PopplerDocument* getPdf();
 
+    /**
+     * Returns the PDF rendered to an image of the size in pixels, the caller owns a reference.
+     *
+     * The last few sizes are kept, one per zoom step (the size is chosen from the scale rounded to a power of two),
+     * so the sidebar previews and the main view do not evict each other.
+     *
+     * @return nullptr if there is no PDF
+     */
+    cairo_surface_t* getPdfRaster(int width, int height);
+
+    /**
+     * Frees the rendered sizes of the PDF, e.g. if the page is not shown anymore
+     */
+    void releaseRaster();
+
     virtual void scale(double x0, double y0, double fx, double fy, double rotation, bool restoreLineWidth);
     virtual void rotate(double x0, double y0, double th);
 
@@ -86,6 +103,21 @@ private:
      */
     PopplerDocument* pdf = nullptr;
 
+    /**
+     * A size of the PDF rendered by getPdfRaster()
+     */
+    struct Raster {
+        cairo_surface_t* surface;
+        uint64_t lastUse;
+    };
+
+    /**
+     * The PDF rendered by getPdfRaster(), used by the render threads
+     */
+    std::mutex rasterMutex;
+    vector<Raster> rasters;
+    uint64_t rasterUse = 0;
+
     /**
      * Tex image, if rendered as image. Note: this is deprecated and subject to removal in a later version.
      */
@@ -13,7 +13,7 @@ Text::Text(): AudioElement(ELEMENT_TEXT) {
     this->font.setSize(12);
 }
 
-Text::~Text() = default;
+Text::~Text() { TextView::releaseLayout(this); }
 
 auto Text::clone() -> Element* {
     Text* text = new Text();
@@ -34,7 +34,11 @@ auto Text::clone() -> Element* {
 
 auto Text::getFont() -> XojFont& { return font; }
 
-void Text::setFont(const XojFont& font) { this->font = font; }
+void Text::setFont(const XojFont& font) {
+    this->font = font;
+    this->sizeCalculated = false;
+    boundsChanged();
+}
 
 auto Text::getFontSize() const -> double { return font.getSize(); }
 
@@ -44,8 +48,10 @@ auto Text::getText() const -> string { return this->text; }
 
 void Text::setText(string text) {
     this->text = std::move(text);
+    TextView::invalidateLayout(this);
 
     calcSize();
+    boundsChanged();
 }
 
 void Text::calcSize() const {
@@ -56,11 +62,13 @@ void Text::calcSize() const {
 void Text::setWidth(double width) {
     this->width = width;
     this->updateSnapping();
+    boundsChanged();
 }
 
 void Text::setHeight(double height) {
     this->height = height;
     this->updateSnapping();
+    boundsChanged();
 }
 
 void Text::setInEditing(bool inEditing) { this->inEditing = inEditing; }
@@ -84,6 +92,7 @@ void Text::scale(double x0, double y0, double fx, double fy, double rotation,
     this->font.setSize(size);
 
     calcSize();
+    boundsChanged();
 }
 
 void Text::rotate(double x0, double y0, double th) {}
@@ -123,6 +132,7 @@ void Text::readSerialized(ObjectInputStream& in) {
     readSerializedAudioElement(in);
 
     this->text = in.readString();
+    TextView::invalidateLayout(this);
 
     font.readSerialized(in);
 
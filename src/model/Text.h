@@ -65,4 +65,14 @@ private:
     string text;
 
     bool inEditing = false;
+
+    friend class TextView;
+
+    /**
+     * The shaped text, cached by TextView. Replaced by a new layout if the text, the font or the text DPI changes.
+     */
+    mutable PangoLayout* layout = nullptr;
+    mutable string layoutFontName;
+    mutable double layoutFontSize = 0;
+    mutable bool layoutTextValid = false;
 };
@@ -24,49 +24,173 @@ XojPage::XojPage(XojPage const& page):
         currentLayer(page.currentLayer),
         bgType(page.bgType),
         pdfBackgroundPage(page.pdfBackgroundPage),
-        backgroundColor(page.backgroundColor) {
+        backgroundColor(page.backgroundColor),
+        backgroundVisible(page.backgroundVisible) {
+    {
+        // Pages which are not loaded yet are copied without parsing them
+        std::lock_guard<std::recursive_mutex> lock(const_cast<XojPage&>(page).contentMutex);
+        if (!page.contentLoaded && page.lazyContent) {
+            this->lazyContent = page.lazyContent->clone();
+            this->contentLoaded = false;
+            return;
+        }
+    }
+
     this->layer.reserve(page.layer.size());
     std::transform(begin(page.layer), end(page.layer), std::back_inserter(this->layer),
                    [](auto* layer) { return layer->clone(); });
+
+    for (Layer* l: this->layer) {
+        l->setPage(this);
+    }
 }
 
 auto XojPage::clone() -> XojPage* { return new XojPage(*this); }
 
+auto XojPage::nextRevision() -> uint64_t {
+    static std::atomic<uint64_t> revisionCounter{1};
+    return revisionCounter++;
+}
+
+void XojPage::markChanged() { this->revision = nextRevision(); }
+
+auto XojPage::getRevision() const -> uint64_t { return this->revision; }
+
+void XojPage::lock() { this->pageLock.lock(); }
+
+void XojPage::unlock() { this->pageLock.unlock(); }
+
+void XojPage::lockShared() { this->pageLock.lock_shared(); }
+
+void XojPage::unlockShared() { this->pageLock.unlock_shared(); }
+
+auto XojPage::getSnapshot() -> std::shared_ptr<XojPage> {
+    // Several readers can request a snapshot with the shared lock at the same time
+    std::lock_guard<std::mutex> lock(this->snapshotMutex);
+
+    uint64_t currentRevision = this->revision;
+    std::shared_ptr<XojPage> copy = this->snapshot.lock();
+    if (copy && this->snapshotRevision == currentRevision) {
+        return copy;
+    }
+
+    copy = std::make_shared<XojPage>(*this);
+    copy->revision = currentRevision;
+
+    // Layer::clone() does not copy the visibility, but the snapshot is drawn like this page
+    for (size_t i = 0; i < this->layer.size(); i++) {
+        copy->layer[i]->setVisible(this->layer[i]->isVisible());
+    }
+
+    this->snapshot = copy;
+    this->snapshotRevision = currentRevision;
+    return copy;
+}
+
+void XojPage::setLazyContent(std::unique_ptr<LazyPageContent> content) {
+    std::lock_guard<std::recursive_mutex> lock(this->contentMutex);
+    this->lazyContent = std::move(content);
+    this->contentLoaded = this->lazyContent == nullptr;
+    this->unparsedContent = nullptr;
+}
+
+auto XojPage::isContentLoaded() const -> bool { return this->contentLoaded; }
+
+auto XojPage::getUnparsedLayersXml() -> std::shared_ptr<const string> {
+    std::lock_guard<std::recursive_mutex> lock(this->contentMutex);
+    if (!this->contentLoaded && this->lazyContent) {
+        return this->lazyContent->getLayersXml();
+    }
+    if (this->unparsedContent && this->revision == this->unparsedRevision) {
+        return this->unparsedContent->getLayersXml();
+    }
+    return nullptr;
+}
+
+void XojPage::ensureContentLoaded() {
+    if (this->contentLoaded) {
+        return;
+    }
+
+    // Concurrent readers wait here until the layers are loaded
+    std::lock_guard<std::recursive_mutex> lock(this->contentMutex);
+    if (this->contentLoaded || !this->lazyContent) {
+        // Loaded by another thread, or called by the content while it is loading
+        return;
+    }
+
+    std::unique_ptr<LazyPageContent> content = std::move(this->lazyContent);
+    uint64_t loadedRevision = this->revision;
+    bool parsed = content->load(*this);
+
+    // The content did not change, only its representation
+    this->revision = loadedRevision;
+    if (!parsed) {
+        // Saved as it was read until the page is changed, the layers parsed so far would be incomplete
+        this->unparsedContent = std::move(content);
+        this->unparsedRevision = loadedRevision;
+    }
+    this->contentLoaded = true;
+}
+
 void XojPage::addLayer(Layer* layer) {
+    ensureContentLoaded();
+
     this->layer.push_back(layer);
+    layer->setPage(this);
     this->currentLayer = npos;
+    markChanged();
 }
 
 void XojPage::insertLayer(Layer* layer, int index) {
+    ensureContentLoaded();
+
     if (index >= static_cast<int>(this->layer.size())) {
         addLayer(layer);
         return;
     }
 
     this->layer.insert(this->layer.begin() + index, layer);
+    layer->setPage(this);
     this->currentLayer = index + 1;
+    markChanged();
 }
 
 void XojPage::removeLayer(Layer* layer) {
+    ensureContentLoaded();
+
     for (unsigned int i = 0; i < this->layer.size(); i++) {
         if (layer == this->layer[i]) {
             this->layer.erase(this->layer.begin() + i);
+            layer->setPage(nullptr);
             break;
         }
     }
     this->currentLayer = npos;
+    markChanged();
 }
 
-void XojPage::setSelectedLayerId(int id) { this->currentLayer = id; }
+void XojPage::setSelectedLayerId(int id) {
+    ensureContentLoaded();
+    this->currentLayer = id;
+}
 
-auto XojPage::getLayers() -> vector<Layer*>* { return &this->layer; }
+auto XojPage::getLayers() -> vector<Layer*>* {
+    ensureContentLoaded();
+    return &this->layer;
+}
 
-auto XojPage::getLayerCount() -> size_t { return this->layer.size(); }
+auto XojPage::getLayerCount() -> size_t {
+    ensureContentLoaded();
+    return this->layer.size();
+}
 
 /**
  * Layer ID 0 = Background, Layer ID 1 = Layer 1
  */
 auto XojPage::getSelectedLayerId() -> int {
+    ensureContentLoaded();
+
     if (this->currentLayer == npos) {
         this->currentLayer = this->layer.size();
     }
@@ -81,15 +205,21 @@ void XojPage::setLayerVisible(int layerId, bool visible) {
 
     if (layerId == 0) {
         backgroundVisible = visible;
+        markChanged();
         return;
     }
 
+    ensureContentLoaded();
+
     layerId--;
     if (layerId >= static_cast<int>(this->layer.size())) {
         return;
     }
 
     this->layer[layerId]->setVisible(visible);
+
+    // The snapshots are drawn like the page
+    markChanged();
 }
 
 auto XojPage::isLayerVisible(int layerId) -> bool {
@@ -101,6 +231,8 @@ auto XojPage::isLayerVisible(int layerId) -> bool {
         return backgroundVisible;
     }
 
+    ensureContentLoaded();
+
     layerId--;
     if (layerId >= static_cast<int>(this->layer.size())) {
         return false;
@@ -133,6 +265,8 @@ auto XojPage::getHeight() const -> double { return this->height; }
 auto XojPage::getPdfPageNr() const -> size_t { return this->pdfBackgroundPage; }
 
 auto XojPage::isAnnotated() -> bool {
+    ensureContentLoaded();
+
     for (Layer* l: this->layer) {
         if (l->isAnnotated()) {
             return true;
@@ -159,6 +293,8 @@ auto XojPage::getBackgroundImage() -> BackgroundImage& { return this->background
 void XojPage::setBackgroundImage(BackgroundImage img) { this->backgroundImage = std::move(img); }
 
 auto XojPage::getSelectedLayer() -> Layer* {
+    ensureContentLoaded();
+
     if (this->layer.empty()) {
         addLayer(new Layer());
     }
@@ -11,6 +11,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
@@ -24,6 +29,33 @@
 template <class T>
 using optional = std::optional<T>;
 
+class XojPage;
+
+/**
+ * The layers of a page which are only parsed when they are accessed the first time, see XojPage::setLazyContent()
+ */
+class LazyPageContent {
+public:
+    virtual ~LazyPageContent() = default;
+
+    /**
+     * Adds the layers to the page
+     *
+     * @return false if the layers could not be parsed completely, the page contains the layers parsed so far
+     */
+    virtual bool load(XojPage& page) = 0;
+
+    /**
+     * @return The layers as they are written by SaveHandler, or nullptr if they can not be written unchanged
+     */
+    virtual std::shared_ptr<const string> getLayersXml() const = 0;
+
+    /**
+     * The content of a copy of the page, copying a page does not load its layers
+     */
+    virtual std::unique_ptr<LazyPageContent> clone() const = 0;
+};
+
 class XojPage: public PageHandler {
 public:
     XojPage(double width, double height);
@@ -82,7 +114,103 @@ public:
      */
     XojPage* clone();
 
+    /**
+     * Marks the content of the page as changed, called for each undo action, page change event and change of the
+     * elements of its layers.
+     * A new revision is assigned to the page.
+     */
+    void markChanged();
+
+    /**
+     * The revision is unique over all pages and changes, so it identifies the content of a page,
+     * e.g. to reuse the serialized layers of unchanged pages on autosave
+     */
+    uint64_t getRevision() const;
+
+    /**
+     * Exclusive lock of the content of the page, the document needs to be locked shared before.
+     * Not needed if the document is locked exclusively.
+     */
+    void lock();
+    void unlock();
+
+    /**
+     * Shared lock of the content of the page, to read the page while other pages are changed
+     */
+    void lockShared();
+    void unlockShared();
+
+    /**
+     * An immutable copy of the page, to save or export the page without holding the lock.
+     *
+     * The copy is shared by all callers as long as the revision of the page does not change and the copy is still
+     * in use, so a page is copied at most once per change, no matter how many jobs need it.
+     * The snapshot has the revision of this page, and must not be changed.
+     *
+     * The page needs to be locked (shared), or the document exclusively.
+     */
+    std::shared_ptr<XojPage> getSnapshot();
+
+    /**
+     * The layers of the page are loaded from content when they are accessed the first time, so huge documents
+     * can be opened without parsing all pages. Loading does not change the revision of the page.
+     */
+    void setLazyContent(std::unique_ptr<LazyPageContent> content);
+
+    /**
+     * @return false if the layers are not loaded yet, see setLazyContent()
+     */
+    bool isContentLoaded() const;
+
+    /**
+     * The layers as they were read from the file, as long as they are not loaded, or could not be parsed
+     * completely and the page was not changed since. Such pages are saved unchanged.
+     *
+     * @return nullptr if the layers need to be serialized
+     */
+    std::shared_ptr<const string> getUnparsedLayersXml();
+
 private:
+    static uint64_t nextRevision();
+
+    /**
+     * Loads the layers if they are not loaded yet, called by all methods accessing the layers
+     */
+    void ensureContentLoaded();
+
+private:
+    /**
+     * Protects the layers and elements of the page, see lock()
+     */
+    std::shared_mutex pageLock;
+
+    /**
+     * The revision of the content, see getRevision()
+     */
+    std::atomic<uint64_t> revision{nextRevision()};
+
+    /**
+     * The last snapshot and the revision it was taken from, see getSnapshot().
+     * The snapshot is not kept alive by the page, the page would need twice the memory otherwise.
+     */
+    std::mutex snapshotMutex;
+    std::weak_ptr<XojPage> snapshot;
+    uint64_t snapshotRevision = 0;
+
+    /**
+     * The layers which are not loaded yet, see setLazyContent().
+     * The mutex is recursive, the content adds the layers with the methods of the page while loading.
+     */
+    std::recursive_mutex contentMutex;
+    std::unique_ptr<LazyPageContent> lazyContent;
+    std::atomic<bool> contentLoaded{true};
+
+    /**
+     * The content which could not be parsed completely, and the revision of the page after loading it
+     */
+    std::unique_ptr<LazyPageContent> unparsedContent;
+    uint64_t unparsedRevision = 0;
+
     /**
      * The Background image if any
      */
@@ -1,59 +1,127 @@
 #include "EraseableStroke.h"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 #include "model/Stroke.h"
 
-#include "EraseableStrokePart.h"
-#include "PartList.h"
 #include "Range.h"
 
-EraseableStroke::EraseableStroke(Stroke* stroke): stroke(stroke) {
-    this->parts = new PartList();
-    g_mutex_init(&this->partLock);
+namespace {
+
+/**
+ * Remaining parts shorter than this (in segments) are dropped
+ */
+constexpr double MIN_PART_LENGTH = 1e-6;
+
+/**
+ * Clips the segment from (ax, ay) to (bx, by) to the rectangle (Liang-Barsky)
+ *
+ * @param u0 Set to the fraction along the segment where it enters the rectangle
+ * @param u1 Set to the fraction along the segment where it leaves the rectangle
+ * @return false if the segment does not intersect the rectangle
+ */
+auto clipSegment(double ax, double ay, double bx, double by, double x1, double y1, double x2, double y2, double& u0,
+                 double& u1) -> bool {
+    double dx = bx - ax;
+    double dy = by - ay;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {ax - x1, x2 - ax, ay - y1, y2 - ay};
+
+    u0 = 0;
+    u1 = 1;
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0) {
+            // Parallel to this edge
+            if (q[i] < 0) {
+                return false;
+            }
+            continue;
+        }
 
-    for (int i = 1; i < stroke->getPointCount(); i++) {
-        this->parts->add(new EraseableStrokePart(stroke->getPoint(i - 1), stroke->getPoint(i)));
+        double r = q[i] / p[i];
+        if (p[i] < 0) {
+            if (r > u1) {
+                return false;
+            }
+            u0 = std::max(u0, r);
+        } else {
+            if (r < u0) {
+                return false;
+            }
+            u1 = std::min(u1, r);
+        }
     }
+    return true;
 }
 
-EraseableStroke::~EraseableStroke() {
-    delete this->parts;
-    this->parts = nullptr;
+}  // namespace
+
+EraseableStroke::EraseableStroke(Stroke* stroke): stroke(stroke) {
+    if (stroke->getPointCount() >= 2) {
+        this->parts.push_back({0, static_cast<double>(stroke->getPointCount() - 1)});
+    }
 }
 
+EraseableStroke::~EraseableStroke() = default;
+
 ////////////////////////////////////////////////////////////////////////////////
 // This is done in a Thread, every thing else in the main loop /////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
 void EraseableStroke::draw(cairo_t* cr) {
-    g_mutex_lock(&this->partLock);
-    PartList* tmpCopy = this->parts->clone();
-    g_mutex_unlock(&this->partLock);
+    // Only the intervals are copied, the points are read from the original stroke
+    vector<Part> parts = getParts();
 
-    double w = this->stroke->getWidth();
+    const StrokePoints& points = this->stroke->getPointData();
+    const double* px = points.getX();
+    const double* py = points.getY();
+    bool pressure = points.getPressure() != nullptr;
 
-    for (GList* l = tmpCopy->data; l != nullptr; l = l->next) {
-        auto* part = static_cast<EraseableStrokePart*>(l->data);
-        if (part->getWidth() == Point::NO_PRESSURE) {
-            cairo_set_line_width(cr, w);
-        } else {
-            cairo_set_line_width(cr, part->getWidth());
-        }
+    if (!pressure) {
+        cairo_set_line_width(cr, this->stroke->getWidth());
+    }
 
-        GList* pl = part->getPoints();
-        auto* p = static_cast<Point*>(pl->data);
-        cairo_move_to(cr, p->x, p->y);
+    for (const Part& part: parts) {
+        double x = NAN;
+        double y = NAN;
+        double width = NAN;
+        pointAt(part.start, x, y, width);
+
+        double endX = NAN;
+        double endY = NAN;
+        double endWidth = NAN;
+        pointAt(part.end, endX, endY, endWidth);
+
+        auto i = static_cast<size_t>(part.start) + 1;
+        if (!pressure) {
+            cairo_move_to(cr, x, y);
+            for (; static_cast<double>(i) < part.end; i++) {
+                cairo_line_to(cr, px[i], py[i]);
+            }
+            cairo_line_to(cr, endX, endY);
+            cairo_stroke(cr);
+            continue;
+        }
 
-        pl = pl->next;
-        for (; pl != nullptr; pl = pl->next) {
-            auto* p = static_cast<Point*>(pl->data);
-            cairo_line_to(cr, p->x, p->y);
+        // Each segment has its own width
+        auto segment = static_cast<size_t>(part.start);
+        for (; static_cast<double>(i) < part.end; i++) {
+            cairo_set_line_width(cr, segmentWidth(segment));
+            cairo_move_to(cr, x, y);
+            cairo_line_to(cr, px[i], py[i]);
+            cairo_stroke(cr);
+
+            x = px[i];
+            y = py[i];
+            segment = i;
         }
+        cairo_set_line_width(cr, segmentWidth(segment));
+        cairo_move_to(cr, x, y);
+        cairo_line_to(cr, endX, endY);
         cairo_stroke(cr);
     }
-
-    delete tmpCopy;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -66,265 +134,154 @@ void EraseableStroke::draw(cairo_t* cr) {
 auto EraseableStroke::erase(double x, double y, double halfEraserSize, Range* range) -> Range* {
     this->repaintRect = range;
 
-    g_mutex_lock(&this->partLock);
-    PartList* tmpCopy = this->parts->clone();
-    g_mutex_unlock(&this->partLock);
-
-    for (GList* l = tmpCopy->data; l != nullptr;) {
-        auto* p = static_cast<EraseableStrokePart*>(l->data);
-        l = l->next;
-        erase(x, y, halfEraserSize, p, tmpCopy);
-    }
-
-    g_mutex_lock(&this->partLock);
-    PartList* old = this->parts;
-    this->parts = tmpCopy;
-    g_mutex_unlock(&this->partLock);
-
-    delete old;
-
-    return this->repaintRect;
-}
-
-void EraseableStroke::addRepaintRect(double x, double y, double width, double height) {
-    if (this->repaintRect) {
-        this->repaintRect->addPoint(x, y);
-    } else {
-        this->repaintRect = new Range(x, y);
-    }
-
-    this->repaintRect->addPoint(x + width, y + height);
-}
-
-void EraseableStroke::erase(double x, double y, double halfEraserSize, EraseableStrokePart* part, PartList* list) {
-    if (part->points->next == nullptr) {
-        return;
-    }
-
-    Point eraser(x, y);
-
-    auto* a = static_cast<Point*>(g_list_first(part->points)->data);
-    auto* b = static_cast<Point*>(g_list_last(part->points)->data);
-
-    if (eraser.lineLengthTo(*a) < halfEraserSize * 1.2 && eraser.lineLengthTo(*b) < halfEraserSize * 1.2) {
-        list->data = g_list_remove(list->data, part);
-        addRepaintRect(part->getX(), part->getY(), part->getElementWidth(), part->getElementHeight());
-
-        delete part;
-        return;
-    }
-
     double x1 = x - halfEraserSize;
     double x2 = x + halfEraserSize;
     double y1 = y - halfEraserSize;
     double y2 = y + halfEraserSize;
 
-    double aX = a->x;
-    double aY = a->y;
-    double bX = b->x;
-    double bY = b->y;
-
-    // check first point
-    if (aX >= x1 && aY >= y1 && aX <= x2 && aY <= y2) {
-        bool deleteAfter = false;
-
-        if (erasePart(x, y, halfEraserSize, part, list, &deleteAfter)) {
-            addRepaintRect(part->getX(), part->getY(), part->getElementWidth(), part->getElementHeight());
-            part->calcSize();
-        }
+    // The parts are only changed here, in the main loop, so they can be read without the lock
+    vector<Part> result;
+    result.reserve(this->parts.size() + 1);
 
-        if (deleteAfter) {
-            delete part;
-        }
-
-        return;
+    bool changed = false;
+    for (const Part& part: this->parts) {
+        changed |= erasePart(part, x1, y1, x2, y2, result);
     }
 
-    // check last point
-    if (bX >= x1 && bY >= y1 && bX <= x2 && bY <= y2) {
-        bool deleteAfter = false;
-
-        if (erasePart(x, y, halfEraserSize, part, list, &deleteAfter)) {
-            addRepaintRect(part->getX(), part->getY(), part->getElementWidth(), part->getElementHeight());
-            part->calcSize();
-        }
-
-        if (deleteAfter) {
-            delete part;
-        }
-
-        return;
+    if (changed) {
+        std::lock_guard<std::mutex> lock(this->partLock);
+        this->parts = std::move(result);
     }
 
-    double len = hypot(bX - aX, bY - aY);
-    /**
-     * The distance of the center of the eraser box to the line passing through (aX, aY) and (bX, bY)
-     */
-    double p = std::abs((x - aX) * (aY - bY) + (y - aY) * (bX - aX)) / len;
-
-    // If the distance p of the center of the eraser box to the (full) line is in the range,
-    // we check whether the eraser box is not too far from the line segment through the two points.
-
-    if (p <= halfEraserSize) {
-        double centerX = (aX + bX) / 2;
-        double centerY = (aY + bY) / 2;
-        double distance = hypot(x - centerX, y - centerY);
-
-        // For the above check we imagine a circle whose center is the mid point of the two points of the stroke
-        // and whose radius is half the length of the line segment plus half the diameter of the eraser box
-        // plus some small padding
-        // If the center of the eraser box lies within that circle then we consider it to be close enough
-
-        distance -= halfEraserSize * std::sqrt(2);
-
-        constexpr double PADDING = 0.1;
-
-        if (distance <= len / 2 + PADDING) {
-            bool deleteAfter = false;
-
-            if (erasePart(x, y, halfEraserSize, part, list, &deleteAfter)) {
-                addRepaintRect(part->getX(), part->getY(), part->getElementWidth(), part->getElementHeight());
-                part->calcSize();
-            }
+    return this->repaintRect;
+}
 
-            if (deleteAfter) {
-                delete part;
-            }
+auto EraseableStroke::erasePart(const Part& part, double x1, double y1, double x2, double y2, vector<Part>& result)
+        -> bool {
+    const StrokePoints& points = this->stroke->getPointData();
+    const double* px = points.getX();
+    const double* py = points.getY();
 
-            return;
-        }
-    }
-}
+    auto first = static_cast<size_t>(part.start);
+    auto last = std::min(points.size() - 2, static_cast<size_t>(std::ceil(part.end)) - 1);
 
-auto EraseableStroke::erasePart(double x, double y, double halfEraserSize, EraseableStrokePart* part, PartList* list,
-                                bool* deleteStrokeAfter) -> bool {
     bool changed = false;
+    double current = part.start;
+    for (size_t i = first; i <= last; i++) {
+        // Most segments are far away from the eraser
+        if (std::min(px[i], px[i + 1]) > x2 || std::max(px[i], px[i + 1]) < x1 ||  //
+            std::min(py[i], py[i + 1]) > y2 || std::max(py[i], py[i + 1]) < y1) {
+            continue;
+        }
 
-    part->splitFor(halfEraserSize);
+        double u0 = 0;
+        double u1 = 0;
+        if (!clipSegment(px[i], py[i], px[i + 1], py[i + 1], x1, y1, x2, y2, u0, u1)) {
+            continue;
+        }
 
-    double x1 = x - halfEraserSize;
-    double x2 = x + halfEraserSize;
-    double y1 = y - halfEraserSize;
-    double y2 = y + halfEraserSize;
+        double cutStart = std::max(static_cast<double>(i) + u0, part.start);
+        double cutEnd = std::min(static_cast<double>(i) + u1, part.end);
+        if (cutEnd <= cutStart) {
+            // Only touches the eraser, or outside of this part
+            continue;
+        }
 
-    /**
-     * erase the beginning
-     */
-    for (GList* l = part->getPoints(); l != nullptr;) {
-        auto* p = static_cast<Point*>(l->data);
-        l = l->next;
-        if (p->x >= x1 && p->y >= y1 && p->x <= x2 && p->y <= y2) {
-            part->points = g_list_remove(part->points, p);
-            delete p;
-            changed = true;
-        } else {
-            // only the beginning is handled here
-            break;
+        if (cutStart - current > MIN_PART_LENGTH) {
+            result.push_back({current, cutStart});
         }
+        current = std::max(current, cutEnd);
+        changed = true;
+
+        double ax = NAN;
+        double ay = NAN;
+        double bx = NAN;
+        double by = NAN;
+        double width = NAN;
+        pointAt(cutStart, ax, ay, width);
+        pointAt(cutEnd, bx, by, width);
+        addRepaintRect(std::min(ax, bx) - width / 2, std::min(ay, by) - width / 2, std::abs(bx - ax) + width,
+                       std::abs(by - ay) + width);
     }
 
-    /**
-     * erase the end
-     */
-    for (GList* l = g_list_last(part->getPoints()); l != nullptr;) {
-        auto* p = static_cast<Point*>(l->data);
-        l = l->prev;
-        if (p->x >= x1 && p->y >= y1 && p->x <= x2 && p->y <= y2) {
-            part->points = g_list_remove(part->points, p);
-            delete p;
-            changed = true;
-        } else {
-            // only the end is handled here
-            break;
-        }
+    if (!changed) {
+        result.push_back(part);
+        return false;
     }
 
-    /**
-     * handle the rest
-     */
-
-    GList* lists = nullptr;
-    GList* current = nullptr;
-
-    for (GList* l = part->points; l != nullptr;) {
-        auto* p = static_cast<Point*>(l->data);
-        l = l->next;
-        if (p->x >= x1 && p->y >= y1 && p->x <= x2 && p->y <= y2) {
-            part->points = g_list_remove(part->points, p);
-            delete p;
-            if (current) {
-                lists = g_list_append(lists, current);
-                current = nullptr;
-            }
-            changed = true;
-        } else {
-            current = g_list_append(current, p);
-        }
+    if (part.end - current > MIN_PART_LENGTH) {
+        result.push_back({current, part.end});
     }
+    return true;
+}
 
-    if (current) {
-        lists = g_list_append(lists, current);
-        current = nullptr;
+void EraseableStroke::addRepaintRect(double x, double y, double width, double height) {
+    if (this->repaintRect) {
+        this->repaintRect->addPoint(x, y);
+    } else {
+        this->repaintRect = new Range(x, y);
     }
 
-    g_list_free(part->points);
-    part->points = nullptr;
-    if (lists) {
-        part->points = static_cast<GList*>(lists->data);
-        lists = g_list_delete_link(lists, lists);
+    this->repaintRect->addPoint(x + width, y + height);
+}
 
-        int pos = g_list_index(list->data, part) + 1;
+void EraseableStroke::pointAt(double position, double& x, double& y, double& width) const {
+    const StrokePoints& points = this->stroke->getPointData();
+    const double* px = points.getX();
+    const double* py = points.getY();
 
-        // create data structure for all new (splitted) parts
-        for (GList* l = lists; l != nullptr; l = l->next) {
-            auto* newPart = new EraseableStrokePart(part->width);
-            newPart->points = static_cast<GList*>(l->data);
-            list->data = g_list_insert(list->data, newPart, pos++);
-        }
+    auto segment = std::min(static_cast<size_t>(position), points.size() - 2);
+    double u = position - static_cast<double>(segment);
 
-        g_list_free(lists);
-    } else {
-        // no parts, all deleted
-        list->data = g_list_remove(list->data, part);
-        *deleteStrokeAfter = true;
+    x = px[segment] + u * (px[segment + 1] - px[segment]);
+    y = py[segment] + u * (py[segment + 1] - py[segment]);
+    width = segmentWidth(segment);
+}
+
+auto EraseableStroke::segmentWidth(size_t segment) const -> double {
+    const double* pressure = this->stroke->getPointData().getPressure();
+    if (pressure == nullptr || pressure[segment] == Point::NO_PRESSURE) {
+        return this->stroke->getWidth();
     }
+    return pressure[segment];
+}
 
-    return changed;
+auto EraseableStroke::getParts() -> vector<Part> {
+    std::lock_guard<std::mutex> lock(this->partLock);
+    return this->parts;
 }
 
-auto EraseableStroke::getStroke(Stroke* original) -> GList* {
-    GList* list = nullptr;
+auto EraseableStroke::createStrokes() const -> vector<Stroke*> {
+    const StrokePoints& original = this->stroke->getPointData();
+    bool pressure = original.getPressure() != nullptr;
 
-    Stroke* s = nullptr;
-    Point lastPoint(NAN, NAN);
-    for (GList* l = this->parts->data; l != nullptr; l = l->next) {
-        auto* p = static_cast<EraseableStrokePart*>(l->data);
-        GList* points = p->getPoints();
-        if (g_list_length(points) < 2) {
-            continue;
-        }
+    vector<Stroke*> strokes;
+    strokes.reserve(this->parts.size());
+    for (const Part& part: this->parts) {
+        auto first = static_cast<size_t>(part.start) + 1;
+        auto last = static_cast<size_t>(std::ceil(part.end)) - 1;
 
-        Point a = *(static_cast<Point*>(g_list_first(points)->data));
-        Point b = *(static_cast<Point*>(g_list_last(points)->data));
-        a.z = p->width;
+        StrokePoints points;
+        points.reserve(last >= first ? last - first + 3 : 2);
 
-        if (!lastPoint.equalsPos(a) || s == nullptr) {
-            if (s) {
-                s->addPoint(lastPoint);
-            }
-            s = new Stroke();
-            s->setColor(original->getColor());
-            s->setToolType(original->getToolType());
-            s->setLineStyle(original->getLineStyle());
-            s->setWidth(original->getWidth());
-            list = g_list_append(list, s);
+        double x = NAN;
+        double y = NAN;
+        double width = NAN;
+        pointAt(part.start, x, y, width);
+        points.add(Point(x, y, pressure ? width : Point::NO_PRESSURE));
+
+        for (size_t i = first; i <= last; i++) {
+            points.add(original.get(i));
         }
-        s->addPoint(a);
-        lastPoint = b;
-    }
-    if (s) {
-        s->addPoint(lastPoint);
+
+        pointAt(part.end, x, y, width);
+        points.add(Point(x, y, pressure ? width : Point::NO_PRESSURE));
+
+        auto* s = new Stroke();
+        s->applyStyleFrom(this->stroke);
+        s->setPoints(std::move(points));
+        strokes.push_back(s);
     }
 
-    return list;
+    return strokes;
 }
@@ -11,20 +11,27 @@
 
 #pragma once
 
-#include <string>
+#include <mutex>
 #include <vector>
 
-#include <gtk/gtk.h>
-
-#include "model/Point.h"
+#include <cairo.h>
 
 #include "XournalType.h"
 
-class EraseableStrokePart;
-class PartList;
 class Range;
 class Stroke;
 
+/**
+ * @brief The parts of a stroke which are not erased yet
+ *
+ * The points of the original stroke are not copied. A position on the stroke is the index of a segment plus the
+ * fraction along the segment, e.g. 2.5 is the middle between the points 2 and 3. The remaining parts are sorted,
+ * disjoint intervals of positions. Erasing cuts the area of the eraser out of the intervals, the ends of the
+ * intervals are the split points within the segments.
+ *
+ * The original stroke must not be changed while it is erased, its points are drawn directly.
+ * erase() is called from the main loop, draw() from the render threads.
+ */
 class EraseableStroke {
 public:
     EraseableStroke(Stroke* stroke);
@@ -36,20 +43,45 @@ public:
      */
     Range* erase(double x, double y, double halfEraserSize, Range* range = nullptr);
 
-    GList* getStroke(Stroke* original);
+    /**
+     * Creates one new stroke for each remaining part, with the style (including fill and audio) of the original stroke
+     *
+     * @return The new strokes, owned by the caller. Empty if the stroke was erased completely.
+     */
+    vector<Stroke*> createStrokes() const;
 
     void draw(cairo_t* cr);
 
 private:
-    void erase(double x, double y, double halfEraserSize, EraseableStrokePart* part, PartList* list);
-    static bool erasePart(double x, double y, double halfEraserSize, EraseableStrokePart* part, PartList* list,
-                          bool* deleteStrokeAfter);
+    struct Part {
+        double start;
+        double end;
+    };
+
+    /**
+     * Cuts the eraser rectangle out of one part, the remaining pieces are appended to result
+     *
+     * @return true if something was erased
+     */
+    bool erasePart(const Part& part, double x1, double y1, double x2, double y2, vector<Part>& result);
+
+    /**
+     * The point at a position, with the pressure of its segment
+     */
+    void pointAt(double position, double& x, double& y, double& width) const;
+
+    /**
+     * The width of the segment starting at the point with the index
+     */
+    double segmentWidth(size_t segment) const;
+
+    vector<Part> getParts();
 
     void addRepaintRect(double x, double y, double width, double height);
 
 private:
-    GMutex partLock{};
-    PartList* parts = nullptr;
+    std::mutex partLock;
+    vector<Part> parts;
 
     Range* repaintRect = nullptr;
 
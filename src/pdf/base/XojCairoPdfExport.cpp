@@ -8,6 +8,7 @@
 
 #include "view/DocumentView.h"
 
+#include "ParallelUtil.h"
 #include "Util.h"
 #include "filesystem.h"
 #include "i18n.h"
@@ -98,32 +99,31 @@ void XojCairoPdfExport::endPdf() {
     this->surface = nullptr;
 }
 
-void XojCairoPdfExport::exportPage(size_t page) {
-    PageRef p = doc->getPage(page);
+auto XojCairoPdfExport::recordPage(const PageRef& p) -> cairo_surface_t* {
+    cairo_rectangle_t extents = {0, 0, p->getWidth(), p->getHeight()};
+    cairo_surface_t* recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents);
+    cairo_t* cr = cairo_create(recording);
 
-    cairo_pdf_surface_set_size(this->surface, p->getWidth(), p->getHeight());
-
-    DocumentView view;
-
-    cairo_save(this->cr);
     if (p->getBackgroundType().isPdfPage() && (exportBackground >= EXPORT_BACKGROUND_UNRULED)) {
         int pgNo = p->getPdfPageNr();
+        doc->lockShared();
         XojPdfPageSPtr popplerPage = doc->getPdfPage(pgNo);
+        doc->unlockShared();
 
         popplerPage->render(cr, true);
     }
 
-    view.drawPage(p, this->cr, true /* dont render eraseable */, exportBackground == EXPORT_BACKGROUND_NONE,
+    DocumentView view;
+    view.drawPage(p, cr, true /* dont render eraseable */, exportBackground == EXPORT_BACKGROUND_NONE,
                   exportBackground == EXPORT_BACKGROUND_NONE, exportBackground <= EXPORT_BACKGROUND_UNRULED);
 
-    // next page
-    cairo_show_page(this->cr);
-    cairo_restore(this->cr);
+    cairo_destroy(cr);
+    return recording;
 }
 
-// export layers one by one to produce as many PDF pages as there are layers.
-void XojCairoPdfExport::exportPageLayers(size_t page) {
-    PageRef p = doc->getPage(page);
+// record layers one by one to produce as many PDF pages as there are layers.
+auto XojCairoPdfExport::recordPageLayers(const PageRef& p) -> vector<cairo_surface_t*> {
+    vector<cairo_surface_t*> recordings;
 
     // We keep a copy of the layers initial Visible state
     std::map<Layer*, bool> initialVisibility;
@@ -136,11 +136,58 @@ void XojCairoPdfExport::exportPageLayers(size_t page) {
     // only Layer 1 visible, the last has all layers visible.
     for (const auto& layer: *p->getLayers()) {
         layer->setVisible(true);
-        exportPage(page);
+        recordings.push_back(recordPage(p));
     }
 
     // We restore the initial visibilities
     for (const auto& layer: *p->getLayers()) layer->setVisible(initialVisibility[layer]);
+
+    return recordings;
+}
+
+void XojCairoPdfExport::replayPage(cairo_surface_t* recording) {
+    cairo_rectangle_t extents;
+    cairo_recording_surface_get_extents(recording, &extents);
+    cairo_pdf_surface_set_size(this->surface, extents.width, extents.height);
+
+    // The recording is painted as vector data, nothing is rasterized
+    cairo_save(this->cr);
+    cairo_set_source_surface(this->cr, recording, 0, 0);
+    cairo_paint(this->cr);
+
+    // next page
+    cairo_show_page(this->cr);
+    cairo_restore(this->cr);
+
+    cairo_surface_destroy(recording);
+}
+
+void XojCairoPdfExport::exportPages(const vector<PageRef>& pages, bool progressiveMode) {
+    if (this->progressListener) {
+        this->progressListener->setMaximumState(static_cast<int>(pages.size()));
+    }
+
+    // The recordings of the pages in the window are kept in memory until they are written
+    unsigned int threads = Util::getParallelThreadCount();
+    Util::orderedParallelFor(
+            pages.size(), threads, 2 * threads,
+            [&](size_t i) {
+                if (progressiveMode) {
+                    // The visibility of the layers is changed, snapshots are shared and must not be changed
+                    PageRef copy(pages[i]->clone());
+                    return recordPageLayers(copy);
+                }
+                return vector<cairo_surface_t*>{recordPage(pages[i])};
+            },
+            [&](size_t i, const vector<cairo_surface_t*>& recordings) {
+                for (cairo_surface_t* recording: recordings) {
+                    replayPage(recording);
+                }
+
+                if (this->progressListener) {
+                    this->progressListener->setCurrentState(static_cast<int>(i));
+                }
+            });
 }
 
 auto XojCairoPdfExport::createPdf(fs::path const& file, PageRangeVector& range, bool progressiveMode) -> bool {
@@ -153,33 +200,20 @@ auto XojCairoPdfExport::createPdf(fs::path const& file, PageRangeVector& range,
         return false;
     }
 
-    int count = 0;
-    for (PageRangeEntry* e: range) {
-        count += e->getLast() - e->getFirst() + 1;
-    }
-
-    if (this->progressListener) {
-        this->progressListener->setMaximumState(count);
-    }
-
-    int c = 0;
+    // The snapshots are drawn without lock
+    vector<PageRef> pages;
+    doc->lockShared();
     for (PageRangeEntry* e: range) {
         for (int i = e->getFirst(); i <= e->getLast(); i++) {
             if (i < 0 || i >= static_cast<int>(doc->getPageCount())) {
                 continue;
             }
-
-            if (progressiveMode) {
-                exportPageLayers(i);
-            } else {
-                exportPage(i);
-            }
-
-            if (this->progressListener) {
-                this->progressListener->setCurrentState(c++);
-            }
+            pages.push_back(doc->getPageSnapshot(i));
         }
     }
+    doc->unlockShared();
+
+    exportPages(pages, progressiveMode);
 
     endPdf();
     return true;
@@ -195,23 +229,15 @@ auto XojCairoPdfExport::createPdf(fs::path const& file, bool progressiveMode) ->
         return false;
     }
 
-    int count = doc->getPageCount();
-    if (this->progressListener) {
-        this->progressListener->setMaximumState(count);
+    // The snapshots are drawn without lock
+    vector<PageRef> pages;
+    doc->lockShared();
+    for (size_t i = 0; i < doc->getPageCount(); i++) {
+        pages.push_back(doc->getPageSnapshot(i));
     }
+    doc->unlockShared();
 
-    for (int i = 0; i < count; i++) {
-
-        if (progressiveMode) {
-            exportPageLayers(i);
-        } else {
-            exportPage(i);
-        }
-
-        if (this->progressListener) {
-            this->progressListener->setCurrentState(i);
-        }
-    }
+    exportPages(pages, progressiveMode);
 
     endPdf();
     return true;
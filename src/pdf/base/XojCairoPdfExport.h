@@ -47,11 +47,26 @@ private:
     void populatePdfOutline(GtkTreeModel* tocModel);
 #endif
     void endPdf();
-    void exportPage(size_t page);
+
+    /**
+     * Records the pages on worker threads and replays the recordings in order into the PDF surface
+     */
+    void exportPages(const vector<PageRef>& pages, bool progressiveMode);
+
+    /**
+     * Draws the page into a recording surface, called from several threads at the same time
+     */
+    cairo_surface_t* recordPage(const PageRef& page);
+
     /**
-     * Export as a PDF document where each additional layer creates a
+     * Records one page per layer, to export as a PDF document where each additional layer creates a
      * new page */
-    void exportPageLayers(size_t page);
+    vector<cairo_surface_t*> recordPageLayers(const PageRef& page);
+
+    /**
+     * Appends the recorded page to the PDF, and frees the recording
+     */
+    void replayPage(cairo_surface_t* recording);
 
 private:
     Document* doc = nullptr;
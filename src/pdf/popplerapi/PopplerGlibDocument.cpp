@@ -11,7 +11,8 @@
 
 PopplerGlibDocument::PopplerGlibDocument() = default;
 
-PopplerGlibDocument::PopplerGlibDocument(const PopplerGlibDocument& doc): document(doc.document) {
+PopplerGlibDocument::PopplerGlibDocument(const PopplerGlibDocument& doc):
+        document(doc.document), renderMutex(doc.renderMutex) {
     if (document) {
         g_object_ref(document);
     }
@@ -30,6 +31,7 @@ void PopplerGlibDocument::assign(XojPdfDocumentInterface* doc) {
     }
 
     document = (dynamic_cast<PopplerGlibDocument*>(doc))->document;
+    renderMutex = (dynamic_cast<PopplerGlibDocument*>(doc))->renderMutex;
     if (document) {
         g_object_ref(document);
     }
@@ -63,6 +65,7 @@ auto PopplerGlibDocument::load(fs::path const& file, string password, GError** e
     }
 
     this->document = poppler_document_new_from_file(uri->c_str(), password.c_str(), error);
+    this->renderMutex = std::make_shared<std::mutex>();
     return this->document != nullptr;
 }
 
@@ -73,6 +76,7 @@ auto PopplerGlibDocument::load(gpointer data, gsize length, string password, GEr
 
     this->document =
             poppler_document_new_from_data(static_cast<char*>(data), static_cast<int>(length), password.c_str(), error);
+    this->renderMutex = std::make_shared<std::mutex>();
     return this->document != nullptr;
 }
 
@@ -84,7 +88,7 @@ auto PopplerGlibDocument::getPage(size_t page) -> XojPdfPageSPtr {
     }
 
     PopplerPage* pg = poppler_document_get_page(document, page);
-    XojPdfPageSPtr pageptr = std::make_shared<PopplerGlibPage>(pg);
+    XojPdfPageSPtr pageptr = std::make_shared<PopplerGlibPage>(pg, this->renderMutex);
     g_object_unref(pg);
 
     return pageptr;
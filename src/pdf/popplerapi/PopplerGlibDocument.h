@@ -11,6 +11,9 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+
 #include <poppler.h>
 
 #include "pdf/base/XojPdfDocumentInterface.h"
@@ -39,4 +42,10 @@ public:
 
 private:
     PopplerDocument* document = nullptr;
+
+    /**
+     * Serializes the rendering of the pages of the document, poppler does not allow rendering one document from
+     * several threads at the same time
+     */
+    std::shared_ptr<std::mutex> renderMutex = std::make_shared<std::mutex>();
 };
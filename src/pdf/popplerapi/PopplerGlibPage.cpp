@@ -1,13 +1,15 @@
 #include "PopplerGlibPage.h"
 
+#include <utility>
 
-PopplerGlibPage::PopplerGlibPage(PopplerPage* page): page(page) {
+PopplerGlibPage::PopplerGlibPage(PopplerPage* page, std::shared_ptr<std::mutex> renderMutex):
+        page(page), renderMutex(std::move(renderMutex)) {
     if (page != nullptr) {
         g_object_ref(page);
     }
 }
 
-PopplerGlibPage::PopplerGlibPage(const PopplerGlibPage& other): page(other.page) {
+PopplerGlibPage::PopplerGlibPage(const PopplerGlibPage& other): page(other.page), renderMutex(other.renderMutex) {
     if (page != nullptr) {
         g_object_ref(page);
     }
@@ -30,6 +32,7 @@ PopplerGlibPage& PopplerGlibPage::operator=(const PopplerGlibPage& other) {
     }
 
     page = other.page;
+    renderMutex = other.renderMutex;
     if (page != nullptr) {
         g_object_ref(page);
     }
@@ -52,6 +55,8 @@ auto PopplerGlibPage::getHeight() -> double {
 
 void PopplerGlibPage::render(cairo_t* cr, bool forPrinting)  // NOLINT(google-default-arguments)
 {
+    std::lock_guard<std::mutex> lock(*this->renderMutex);
+
     if (forPrinting) {
         poppler_page_render_for_printing(page, cr);
     } else {
@@ -65,6 +70,8 @@ auto PopplerGlibPage::findText(string& text) -> vector<XojPdfRectangle> {
     vector<XojPdfRectangle> findings;
 
     double height = getHeight();
+
+    std::lock_guard<std::mutex> lock(*this->renderMutex);
     GList* matches = poppler_page_find_text(page, text.c_str());
 
     for (GList* l = matches; l && l->data; l = g_list_next(l)) {
@@ -11,6 +11,9 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+
 #include <poppler.h>
 
 #include "pdf/base/XojPdfPage.h"
@@ -18,7 +21,10 @@
 
 class PopplerGlibPage: public XojPdfPage {
 public:
-    PopplerGlibPage(PopplerPage* page);
+    /**
+     * @param renderMutex The render lock of the document of the page
+     */
+    PopplerGlibPage(PopplerPage* page, std::shared_ptr<std::mutex> renderMutex);
     PopplerGlibPage(const PopplerGlibPage& other);
     virtual ~PopplerGlibPage();
     PopplerGlibPage& operator=(const PopplerGlibPage& other);
@@ -35,4 +41,6 @@ public:
 
 private:
     PopplerPage* page;
+
+    std::shared_ptr<std::mutex> renderMutex;
 };
@@ -70,9 +70,7 @@ void EraseUndoAction::finalize() {
             int pos = p->layer->removeElement(p->element, false);
 
             EraseableStroke* e = p->element->getEraseable();
-            GList* stroke = e->getStroke(p->element);
-            for (GList* ls = stroke; ls != nullptr; ls = ls->next) {
-                auto* copy = static_cast<Stroke*>(ls->data);
+            for (Stroke* copy: e->createStrokes()) {
                 p->layer->insertElement(copy, pos);
                 this->addEdited(p->layer, copy, pos);
                 pos++;
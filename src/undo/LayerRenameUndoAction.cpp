@@ -2,8 +2,11 @@
 
 #include "i18n.h"
 
-LayerRenameUndoAction::LayerRenameUndoAction(Layer* layer, const string& newName, const string& oldName):
-        UndoAction("LayerUndoAction"), layer(layer), newName(newName), oldName(oldName) {}
+LayerRenameUndoAction::LayerRenameUndoAction(const PageRef& page, Layer* layer, const string& newName,
+                                             const string& oldName):
+        UndoAction("LayerUndoAction"), layer(layer), newName(newName), oldName(oldName) {
+    this->page = page;
+}
 
 LayerRenameUndoAction::~LayerRenameUndoAction() = default;
 
@@ -22,7 +22,7 @@ class XojPage;
 
 class LayerRenameUndoAction: public UndoAction {
 public:
-    LayerRenameUndoAction(Layer* layer, const string& newName, const string& oldName);
+    LayerRenameUndoAction(const PageRef& page, Layer* layer, const string& newName, const string& oldName);
     virtual ~LayerRenameUndoAction();
 
 public:
@@ -65,10 +65,8 @@ auto MoveUndoAction::redo(Control* control) -> bool {
 }
 
 void MoveUndoAction::switchLayer(vector<Element*>* entries, Layer* oldLayer, Layer* newLayer) {
-    for (Element* e: this->elements) {
-        oldLayer->removeElement(e, false);
-        newLayer->addElement(e);
-    }
+    oldLayer->removeElements(this->elements, false);
+    newLayer->addElements(this->elements);
 }
 
 void MoveUndoAction::repaint() {
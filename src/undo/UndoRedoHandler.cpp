@@ -225,6 +225,8 @@ void UndoRedoHandler::fireUpdateUndoRedoButtons(const vector<PageRef>& pages) {
             continue;
         }
 
+        page->markChanged();
+
         for (auto&& undoRedoListener: this->listener) {
             undoRedoListener->undoRedoPageChanged(page);
         }
@@ -0,0 +1,193 @@
+#include "FloatParser.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <glib.h>
+
+namespace {
+
+/**
+ * All powers of ten which are exactly representable as double
+ */
+constexpr double POWERS_OF_TEN[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+constexpr int MAX_EXACT_POWER = 22;
+
+/**
+ * Integers up to 2^53 are exactly representable as double
+ */
+constexpr uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53U;
+
+/**
+ * Digits are only added to the mantissa while it can not overflow
+ */
+constexpr uint64_t MAX_MANTISSA = 1000000000000000000ULL;
+
+inline auto isDigit(char c) -> bool { return static_cast<unsigned char>(c - '0') < 10; }
+
+inline auto isSpace(char c) -> bool { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+inline auto isTokenChar(char c) -> bool {
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.' || c == '+' || c == '-';
+}
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+/**
+ * Checks 8 characters at once if they are all digits
+ */
+inline auto isEightDigits(uint64_t chars) -> bool {
+    return (((chars + 0x4646464646464646ULL) | (chars - 0x3030303030303030ULL)) & 0x8080808080808080ULL) == 0;
+}
+
+/**
+ * Converts 8 digits at once, see "Fast numeric string parsing" by Daniel Lemire
+ */
+inline auto parseEightDigits(uint64_t chars) -> uint64_t {
+    constexpr uint64_t mask = 0x000000FF000000FFULL;
+    constexpr uint64_t mul1 = 0x000F424000000064ULL;  // 100 + (1000000ULL << 32)
+    constexpr uint64_t mul2 = 0x0000271000000001ULL;  // 1 + (10000ULL << 32)
+    chars -= 0x3030303030303030ULL;
+    chars = (chars * 10) + (chars >> 8U);
+    chars = (((chars & mask) * mul1) + (((chars >> 16U) & mask) * mul2)) >> 32U;
+    return chars;
+}
+#endif
+
+/**
+ * Adds the digits at p to the mantissa, the number of digits which did not fit in the mantissa is returned in dropped
+ */
+inline auto parseDigits(const char* p, const char* end, uint64_t& mantissa, int& digits, int& dropped) -> const char* {
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    while (end - p >= 8 && mantissa < MAX_MANTISSA / 100000000ULL) {
+        uint64_t chars = 0;
+        memcpy(&chars, p, sizeof(chars));
+        if (!isEightDigits(chars)) {
+            break;
+        }
+        mantissa = mantissa * 100000000ULL + parseEightDigits(chars);
+        digits += 8;
+        p += 8;
+    }
+#endif
+
+    for (; p < end && isDigit(*p); p++) {
+        if (mantissa < MAX_MANTISSA) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        } else {
+            dropped++;
+        }
+        digits++;
+    }
+    return p;
+}
+
+/**
+ * Parses the number with g_ascii_strtod, which needs a null terminated string
+ */
+auto parseSlow(const char* str, const char* end, double& value) -> const char* {
+    const char* tokenEnd = str;
+    while (tokenEnd < end && isTokenChar(*tokenEnd)) {
+        tokenEnd++;
+    }
+
+    std::string token(str, tokenEnd);
+    char* endPtr = nullptr;
+    value = g_ascii_strtod(token.c_str(), &endPtr);
+    return str + (endPtr - token.c_str());
+}
+
+}  // namespace
+
+auto Util::parseDouble(const char* str, const char* end, double& value) -> const char* {
+    const char* p = str;
+    while (p < end && isSpace(*p)) {
+        p++;
+    }
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int dropped = 0;
+    int exponent = 0;
+
+    const char* intStart = p;
+    p = parseDigits(p, end, mantissa, digits, dropped);
+    bool leadingZero = p - intStart == 1 && *intStart == '0';
+
+    if (p < end && *p == '.') {
+        p++;
+        int fractionDigits = 0;
+        p = parseDigits(p, end, mantissa, fractionDigits, dropped);
+        digits += fractionDigits;
+        exponent -= fractionDigits;
+    }
+
+    if (digits == 0 || dropped > 0 || (leadingZero && p < end && (*p == 'x' || *p == 'X'))) {
+        // inf, nan, hexadecimal numbers, or more digits than we can handle
+        value = 0;
+        const char* next = parseSlow(start, end, value);
+        return next == start ? str : next;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* e = p + 1;
+        bool negativeExponent = false;
+        if (e < end && (*e == '-' || *e == '+')) {
+            negativeExponent = *e == '-';
+            e++;
+        }
+
+        // Without digits the 'e' is not part of the number
+        if (e < end && isDigit(*e)) {
+            int exp = 0;
+            for (; e < end && isDigit(*e); e++) {
+                if (exp < 100000) {
+                    exp = exp * 10 + (*e - '0');
+                }
+            }
+            exponent += negativeExponent ? -exp : exp;
+            p = e;
+        }
+    }
+
+    if (mantissa == 0) {
+        value = negative ? -0.0 : 0.0;
+        return p;
+    }
+
+    if (mantissa > MAX_EXACT_MANTISSA || exponent > MAX_EXACT_POWER || exponent < -MAX_EXACT_POWER) {
+        // The result would need more than a single rounding step
+        return parseSlow(start, end, value);
+    }
+
+    // Both operands are exact, so the result is correctly rounded
+    auto result = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        result /= POWERS_OF_TEN[-exponent];
+    } else {
+        result *= POWERS_OF_TEN[exponent];
+    }
+
+    value = negative ? -result : result;
+    return p;
+}
+
+auto Util::parseDoubles(const char* str, const char* end, std::vector<double>& values) -> const char* {
+    double value = 0;
+    while (true) {
+        const char* next = parseDouble(str, end, value);
+        if (next == str) {
+            return str;
+        }
+        values.push_back(value);
+        str = next;
+    }
+}
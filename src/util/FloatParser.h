@@ -0,0 +1,42 @@
+/*
+ * Xournal++
+ *
+ * Fast, locale independent parsing of floating point numbers
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Util {
+
+/**
+ * Parses a floating point number, like g_ascii_strtod (leading whitespace is skipped, the decimal separator is
+ * always '.'), but much faster for the plain decimal numbers written to our files. Numbers which can not be converted
+ * exactly on the fast path (very long mantissas, large exponents, hexadecimal, inf, nan) are passed to
+ * g_ascii_strtod, so the result is always the same as the one of g_ascii_strtod.
+ *
+ * The string does not need to be null terminated, nothing after end is read.
+ *
+ * @param str The start of the number
+ * @param end The end of the string
+ * @param[out] value The parsed number, 0 if no number was found
+ * @return The position after the number, str if no number was found
+ */
+const char* parseDouble(const char* str, const char* end, double& value);
+
+/**
+ * Parses a whitespace separated list of numbers, until end or until the first token which is not a number
+ *
+ * @param[out] values The numbers are appended to this vector
+ * @return The position after the last parsed number
+ */
+const char* parseDoubles(const char* str, const char* end, std::vector<double>& values);
+
+}  // namespace Util
@@ -0,0 +1,61 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(size_t capacity): capacity(std::max<size_t>(capacity, 1)) {
+    this->samples.reserve(this->capacity);
+}
+
+void LatencyHistogram::add(int64_t microseconds) {
+    microseconds = std::max<int64_t>(microseconds, 0);
+
+    if (this->samples.size() < this->capacity) {
+        this->samples.push_back(microseconds);
+    } else {
+        this->samples[this->next] = microseconds;
+    }
+    this->next = (this->next + 1) % this->capacity;
+    this->totalCount++;
+}
+
+void LatencyHistogram::clear() {
+    this->samples.clear();
+    this->next = 0;
+    this->totalCount = 0;
+}
+
+auto LatencyHistogram::size() const -> size_t { return this->samples.size(); }
+
+auto LatencyHistogram::getTotalCount() const -> uint64_t { return this->totalCount; }
+
+auto LatencyHistogram::getPercentile(double p) const -> int64_t {
+    if (this->samples.empty()) {
+        return 0;
+    }
+
+    std::vector<int64_t> sorted = this->samples;
+    auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    rank = std::clamp<size_t>(rank, 1, sorted.size()) - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+auto LatencyHistogram::getBuckets() const -> std::array<size_t, BUCKET_COUNT> {
+    std::array<size_t, BUCKET_COUNT> buckets{};
+    for (int64_t sample: this->samples) {
+        size_t bucket = 0;
+        while (bucket + 1 < BUCKET_COUNT && sample >= getBucketLimit(bucket)) {
+            bucket++;
+        }
+        buckets[bucket]++;
+    }
+    return buckets;
+}
+
+auto LatencyHistogram::getBucketLimit(size_t bucket) -> int64_t {
+    if (bucket + 1 >= BUCKET_COUNT) {
+        return -1;
+    }
+    return FIRST_BUCKET_LIMIT << bucket;
+}
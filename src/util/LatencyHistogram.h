@@ -0,0 +1,80 @@
+/*
+ * Xournal++
+ *
+ * Histogram of the most recent latency samples
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Keeps the most recent latency samples in a ring buffer
+ *
+ * Adding a sample never allocates, so it can be done for every input event. The histogram and the percentiles are
+ * computed from the samples in the buffer when they are requested.
+ */
+class LatencyHistogram {
+public:
+    /**
+     * The upper limit of bucket i is FIRST_BUCKET_LIMIT * 2^i microseconds, the last bucket has no limit
+     */
+    static constexpr size_t BUCKET_COUNT = 16;
+    static constexpr int64_t FIRST_BUCKET_LIMIT = 64;
+
+    /**
+     * @param capacity The number of samples kept, older samples are overwritten
+     */
+    explicit LatencyHistogram(size_t capacity);
+
+public:
+    /**
+     * @param microseconds The latency, negative values are recorded as 0
+     */
+    void add(int64_t microseconds);
+    void clear();
+
+    /**
+     * @return The number of samples in the buffer
+     */
+    size_t size() const;
+
+    /**
+     * @return The total number of samples added, including the overwritten ones
+     */
+    uint64_t getTotalCount() const;
+
+    /**
+     * @param p The percentile, from 0 to 100
+     * @return The sample at the percentile (nearest rank), 0 if there are no samples
+     */
+    int64_t getPercentile(double p) const;
+
+    /**
+     * @return The number of samples in the buffer per bucket
+     */
+    std::array<size_t, BUCKET_COUNT> getBuckets() const;
+
+    /**
+     * @return The (exclusive) upper limit of the bucket in microseconds, -1 for the last bucket
+     */
+    static int64_t getBucketLimit(size_t bucket);
+
+private:
+    size_t capacity;
+    std::vector<int64_t> samples;
+
+    /**
+     * The position of the next sample in the buffer
+     */
+    size_t next = 0;
+    uint64_t totalCount = 0;
+};
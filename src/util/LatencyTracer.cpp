@@ -0,0 +1,123 @@
+#include "LatencyTracer.h"
+
+#include <fstream>
+
+#include <glib.h>
+
+LatencyTracer::LatencyTracer():
+        histograms{LatencyHistogram(CAPACITY), LatencyHistogram(CAPACITY), LatencyHistogram(CAPACITY)} {}
+
+auto LatencyTracer::getInstance() -> LatencyTracer& {
+    static LatencyTracer instance;
+    return instance;
+}
+
+void LatencyTracer::setEnabled(bool enabled) {
+    this->enabled = enabled;
+    this->eventTime = 0;
+    this->pointTime = 0;
+    this->repaintTime = 0;
+}
+
+auto LatencyTracer::isEnabled() const -> bool { return this->enabled; }
+
+void LatencyTracer::eventReceived() {
+    if (!this->enabled) {
+        return;
+    }
+    this->eventTime = g_get_monotonic_time();
+}
+
+void LatencyTracer::pointAdded() {
+    if (!this->enabled || this->eventTime == 0) {
+        return;
+    }
+
+    // Stabilizers may add several points for one event, only the first one is measured
+    this->pointTime = g_get_monotonic_time();
+    this->histograms[EVENT_TO_MODEL].add(this->pointTime - this->eventTime);
+    this->eventTime = 0;
+}
+
+void LatencyTracer::repaintQueued() {
+    if (!this->enabled || this->pointTime == 0) {
+        return;
+    }
+
+    int64_t now = g_get_monotonic_time();
+    this->histograms[MODEL_TO_REPAINT].add(now - this->pointTime);
+    this->pointTime = 0;
+
+    // The next frame draws all repaints queued until then, the oldest one has the highest latency
+    if (this->repaintTime == 0) {
+        this->repaintTime = now;
+    }
+}
+
+void LatencyTracer::frameDrawn() {
+    if (!this->enabled || this->repaintTime == 0) {
+        return;
+    }
+
+    this->histograms[REPAINT_TO_FRAME].add(g_get_monotonic_time() - this->repaintTime);
+    this->repaintTime = 0;
+}
+
+auto LatencyTracer::getHistogram(Stage stage) const -> const LatencyHistogram& { return this->histograms[stage]; }
+
+auto LatencyTracer::getStageName(Stage stage) -> const char* {
+    switch (stage) {
+        case EVENT_TO_MODEL:
+            return "event_to_model";
+        case MODEL_TO_REPAINT:
+            return "model_to_repaint";
+        case REPAINT_TO_FRAME:
+            return "repaint_to_frame";
+        default:
+            return "unknown";
+    }
+}
+
+auto LatencyTracer::writeReport(const fs::path& file) const -> bool {
+    std::ofstream out(file);
+    if (!out) {
+        return false;
+    }
+
+    // Latencies in ms
+    auto ms = [](int64_t microseconds) { return static_cast<double>(microseconds) / 1000.0; };
+
+    out << "{\n  \"stages\": [\n";
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        const LatencyHistogram& histogram = this->histograms[s];
+
+        out << "    {\n";
+        out << "      \"name\": \"" << getStageName(static_cast<Stage>(s)) << "\",\n";
+        out << "      \"total_samples\": " << histogram.getTotalCount() << ",\n";
+        out << "      \"samples\": " << histogram.size() << ",\n";
+        out << "      \"latency_ms\": {";
+        out << "\"p50\": " << ms(histogram.getPercentile(50)) << ", ";
+        out << "\"p90\": " << ms(histogram.getPercentile(90)) << ", ";
+        out << "\"p99\": " << ms(histogram.getPercentile(99)) << ", ";
+        out << "\"max\": " << ms(histogram.getPercentile(100)) << "},\n";
+
+        // Upper limit of each bucket in ms, null for the last bucket
+        out << "      \"histogram\": [";
+        auto buckets = histogram.getBuckets();
+        for (size_t b = 0; b < buckets.size(); b++) {
+            int64_t limit = LatencyHistogram::getBucketLimit(b);
+            out << (b > 0 ? ", " : "") << "{\"below_ms\": ";
+            if (limit < 0) {
+                out << "null";
+            } else {
+                out << ms(limit);
+            }
+            out << ", \"count\": " << buckets[b] << "}";
+        }
+        out << "]\n";
+        out << "    }" << (s + 1 < STAGE_COUNT ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+
+    return out.good();
+}
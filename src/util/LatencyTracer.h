@@ -0,0 +1,79 @@
+/*
+ * Xournal++
+ *
+ * Measures the latency from pen input to ink on the screen
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "LatencyHistogram.h"
+#include "filesystem.h"
+
+/**
+ * @brief Optional tracing of the input latency, enabled with the command line option --trace-latency
+ *
+ * The latency is split into three stages, each with its own LatencyHistogram:
+ *  - event to model: the input event is received (InputEvents::translateEvent) until its point is added to the stroke
+ *  - model to repaint: the point is added until the repaint of the stroke is queued
+ *  - repaint to frame: the repaint is queued until the next frame is drawn (gtk_xournal_draw)
+ *
+ * The timestamps are taken with g_get_monotonic_time() when the event is received: the GDK timestamp of the events
+ * uses the clock of the windowing system, which cannot be compared with the monotonic clock on all platforms.
+ *
+ * Only used from the UI thread. All methods return immediately if the tracing is disabled.
+ */
+class LatencyTracer {
+public:
+    enum Stage { EVENT_TO_MODEL, MODEL_TO_REPAINT, REPAINT_TO_FRAME, STAGE_COUNT };
+
+    /**
+     * The number of samples kept per stage
+     */
+    static constexpr size_t CAPACITY = 8192;
+
+    static LatencyTracer& getInstance();
+
+private:
+    LatencyTracer();
+
+public:
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void eventReceived();
+    void pointAdded();
+    void repaintQueued();
+    void frameDrawn();
+
+    const LatencyHistogram& getHistogram(Stage stage) const;
+
+    /**
+     * Writes the histograms of all stages as JSON
+     *
+     * @return false if the file could not be written
+     */
+    bool writeReport(const fs::path& file) const;
+
+    static const char* getStageName(Stage stage);
+
+private:
+    bool enabled = false;
+
+    std::array<LatencyHistogram, STAGE_COUNT> histograms;
+
+    /**
+     * Time of the pending event / point / repaint in microseconds, 0 if there is none
+     */
+    int64_t eventTime = 0;
+    int64_t pointTime = 0;
+    int64_t repaintTime = 0;
+};
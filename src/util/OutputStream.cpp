@@ -1,8 +1,11 @@
 #include "OutputStream.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <utility>
 
 #include "GzUtil.h"
+#include "ParallelUtil.h"
 #include "i18n.h"
 
 OutputStream::OutputStream() = default;
@@ -41,3 +44,255 @@ void GzOutputStream::close() {
         this->fp = nullptr;
     }
 }
+
+////////////////////////////////////////////////////////
+/// ParallelGzOutputStream /////////////////////////////
+////////////////////////////////////////////////////////
+
+/**
+ * Size of the uncompressed blocks, compressed independently
+ */
+constexpr size_t GZ_BLOCK_SIZE = 256 * 1024;
+
+/**
+ * Size of the deflate window, the end of the previous block is used as dictionary
+ */
+constexpr size_t GZ_DICTIONARY_SIZE = 32 * 1024;
+
+ParallelGzOutputStream::ParallelGzOutputStream(fs::path file, int level):
+        level(level), crc(crc32(0L, Z_NULL, 0)), file(std::move(file)) {
+    this->window = 2 * static_cast<size_t>(Util::getParallelThreadCount());
+
+    // The data is compressed here, zlib only writes it ("T" is transparent mode)
+    this->fp = GzUtil::openPath(this->file, "wT");
+    if (this->fp == nullptr) {
+        this->error = FS(_F("Error opening file: \"{1}\"") % this->file.u8string());
+        return;
+    }
+
+    // gzip header: magic, deflate, no flags, no time, extra flags for the level, Unix
+    unsigned char xfl = level == 9 ? 2 : (level == 1 ? 4 : 0);
+    const unsigned char header[] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, xfl, 3};
+    writeRaw(header, sizeof(header));
+
+    this->input.reserve(GZ_BLOCK_SIZE);
+}
+
+ParallelGzOutputStream::~ParallelGzOutputStream() {
+    if (this->fp) {
+        close();
+    }
+    this->fp = nullptr;
+
+    stopWorkers();
+}
+
+auto ParallelGzOutputStream::getLastError() -> string& { return this->error; }
+
+void ParallelGzOutputStream::write(const char* data, int len) {
+    if (this->fp == nullptr) {
+        return;
+    }
+
+    auto remaining = static_cast<size_t>(len);
+    while (remaining > 0) {
+        size_t count = std::min(remaining, GZ_BLOCK_SIZE - this->input.size());
+        this->input.append(data, count);
+        data += count;
+        remaining -= count;
+
+        if (this->input.size() == GZ_BLOCK_SIZE) {
+            submitBlock(false);
+        }
+    }
+}
+
+auto ParallelGzOutputStream::compressBlock(const string& input, const string& dictionary, int level, bool last)
+        -> Block {
+    Block block;
+    block.crc = crc32(0L, reinterpret_cast<const Bytef*>(input.data()), static_cast<uInt>(input.size()));
+    block.length = input.size();
+
+    z_stream strm{};
+    // Raw deflate, the gzip header and trailer are written by the stream
+    if (deflateInit2(&strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        block.failed = true;
+        return block;
+    }
+    if (!dictionary.empty() && deflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(dictionary.data()),
+                                                    static_cast<uInt>(dictionary.size())) != Z_OK) {
+        deflateEnd(&strm);
+        block.failed = true;
+        return block;
+    }
+
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    strm.avail_in = static_cast<uInt>(input.size());
+
+    // All blocks but the last end with a sync flush, so they end on a byte boundary and can be concatenated
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    size_t written = 0;
+    block.data.resize(deflateBound(&strm, strm.avail_in) + 16);
+    while (true) {
+        strm.next_out = reinterpret_cast<Bytef*>(&block.data[written]);
+        strm.avail_out = static_cast<uInt>(block.data.size() - written);
+        int ret = deflate(&strm, flush);
+        written = block.data.size() - strm.avail_out;
+
+        // Z_BUF_ERROR only means no progress was possible, the output buffer is enlarged then
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            block.failed = true;
+            break;
+        }
+
+        if (strm.avail_out != 0) {
+            break;
+        }
+        block.data.resize(block.data.size() * 2);
+    }
+    deflateEnd(&strm);
+
+    block.data.resize(written);
+    return block;
+}
+
+void ParallelGzOutputStream::submitBlock(bool last) {
+    string nextDictionary;
+    if (this->input.size() > GZ_DICTIONARY_SIZE) {
+        nextDictionary = this->input.substr(this->input.size() - GZ_DICTIONARY_SIZE);
+    } else {
+        nextDictionary = this->input;
+    }
+
+    std::packaged_task<Block()> task([input = std::move(this->input), dictionary = std::move(this->dictionary),
+                                      level = this->level, last]() {
+        return compressBlock(input, dictionary, level, last);
+    });
+    this->pending.push_back(task.get_future());
+
+    if (last && this->workers.empty()) {
+        // The whole file fits into one block, no threads are needed
+        task();
+    } else {
+        if (this->workers.empty()) {
+            for (unsigned int i = 0; i < Util::getParallelThreadCount(); i++) {
+                this->workers.emplace_back([this]() { compressBlocks(); });
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->taskMutex);
+            this->tasks.push_back(std::move(task));
+        }
+        this->taskQueued.notify_one();
+    }
+
+    this->dictionary = std::move(nextDictionary);
+    this->input = string();
+    this->input.reserve(GZ_BLOCK_SIZE);
+
+    // Limits the memory used by the pending blocks
+    while (this->pending.size() > this->window) {
+        writeBlock();
+    }
+}
+
+void ParallelGzOutputStream::compressBlocks() {
+    std::unique_lock<std::mutex> lock(this->taskMutex);
+    while (true) {
+        this->taskQueued.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+        if (this->tasks.empty()) {
+            return;
+        }
+
+        std::packaged_task<Block()> task = std::move(this->tasks.front());
+        this->tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+void ParallelGzOutputStream::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(this->taskMutex);
+        this->stopping = true;
+    }
+    this->taskQueued.notify_all();
+
+    for (std::thread& worker: this->workers) {
+        worker.join();
+    }
+    this->workers.clear();
+}
+
+void ParallelGzOutputStream::writeBlock() {
+    Block block = this->pending.front().get();
+    this->pending.pop_front();
+
+    if (block.failed && this->error.empty()) {
+        this->error = FS(_F("Error compressing file: \"{1}\"") % this->file.u8string());
+    }
+
+    this->crc = crc32_combine(this->crc, block.crc, static_cast<z_off_t>(block.length));
+    this->length += block.length;
+    writeRaw(block.data.data(), block.data.size());
+}
+
+void ParallelGzOutputStream::writeRaw(const void* data, size_t len) {
+    if (len == 0 || !this->error.empty()) {
+        return;
+    }
+
+    if (gzwrite(this->fp, data, static_cast<unsigned>(len)) == 0) {
+        this->error = FS(_F("Error writing file: \"{1}\"") % this->file.u8string());
+    }
+}
+
+void ParallelGzOutputStream::close() {
+    if (!this->fp) {
+        return;
+    }
+
+    submitBlock(true);
+    while (!this->pending.empty()) {
+        writeBlock();
+    }
+    stopWorkers();
+
+    // gzip trailer: CRC32 and size modulo 2^32, little endian
+    unsigned char trailer[8];
+    for (int i = 0; i < 4; i++) {
+        trailer[i] = static_cast<unsigned char>((this->crc >> (8 * i)) & 0xff);
+        trailer[4 + i] = static_cast<unsigned char>((this->length >> (8 * i)) & 0xff);
+    }
+    writeRaw(trailer, sizeof(trailer));
+
+    if (gzclose(this->fp) != Z_OK && this->error.empty()) {
+        this->error = FS(_F("Error writing file: \"{1}\"") % this->file.u8string());
+    }
+    this->fp = nullptr;
+}
+
+////////////////////////////////////////////////////////
+/// StringOutputStream /////////////////////////////////
+////////////////////////////////////////////////////////
+
+StringOutputStream::StringOutputStream() = default;
+
+StringOutputStream::~StringOutputStream() = default;
+
+void StringOutputStream::write(const char* data, int len) { this->buffer.append(data, static_cast<size_t>(len)); }
+
+void StringOutputStream::close() {}
+
+auto StringOutputStream::getString() const -> const string& { return this->buffer; }
+
+auto StringOutputStream::takeString() -> string {
+    string data;
+    data.swap(this->buffer);
+    return data;
+}
+
+void StringOutputStream::clear() { string().swap(this->buffer); }
@@ -11,7 +11,13 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <zlib.h>
@@ -52,3 +58,135 @@ private:
     string target;
     fs::path file;
 };
+
+/**
+ * Writes a gzip file, compressed on several threads
+ *
+ * The data is split into blocks, which are compressed independently as raw deflate streams and concatenated
+ * to one gzip member, like pigz does. The last 32 KiB of each block are used as dictionary for the next block,
+ * so the file is only slightly larger than with a single deflate stream.
+ */
+class ParallelGzOutputStream: public OutputStream {
+public:
+    /**
+     * @param level The zlib compression level, 0 (no compression) to 9 (best compression),
+     * or Z_DEFAULT_COMPRESSION
+     */
+    ParallelGzOutputStream(fs::path file, int level = Z_DEFAULT_COMPRESSION);
+    virtual ~ParallelGzOutputStream();
+
+public:
+    using OutputStream::write;
+    virtual void write(const char* data, int len);
+
+    virtual void close();
+
+    string& getLastError();
+
+private:
+    /**
+     * A compressed block
+     */
+    struct Block {
+        string data;
+        uLong crc = 0;
+        size_t length = 0;
+
+        /**
+         * zlib reported an error, the data is incomplete
+         */
+        bool failed = false;
+    };
+
+    /**
+     * Compresses a block, called on a worker thread
+     */
+    static Block compressBlock(const string& input, const string& dictionary, int level, bool last);
+
+    /**
+     * Starts the compression of the current block, and writes the oldest blocks if too many are pending
+     */
+    void submitBlock(bool last);
+
+    /**
+     * Waits for the oldest pending block and writes it to the file
+     */
+    void writeBlock();
+
+    /**
+     * Worker thread, compresses the queued blocks
+     */
+    void compressBlocks();
+
+    /**
+     * Stops and joins the worker threads
+     */
+    void stopWorkers();
+
+    void writeRaw(const void* data, size_t len);
+
+private:
+    gzFile fp = nullptr;
+    int level;
+
+    /**
+     * Maximum number of blocks compressed at the same time
+     */
+    size_t window;
+
+    /**
+     * The data of the block being filled, and the end of the previous block
+     */
+    string input;
+    string dictionary;
+
+    std::deque<std::future<Block>> pending;
+
+    /**
+     * The worker threads, started with the first block, and the blocks waiting for a worker
+     */
+    std::vector<std::thread> workers;
+    std::mutex taskMutex;
+    std::condition_variable taskQueued;
+    std::deque<std::packaged_task<Block()>> tasks;
+    bool stopping = false;
+
+    /**
+     * CRC and size of the data written so far, for the gzip trailer
+     */
+    uLong crc;
+    size_t length = 0;
+
+    string error;
+    fs::path file;
+};
+
+/**
+ * Writes to a string in memory
+ */
+class StringOutputStream: public OutputStream {
+public:
+    StringOutputStream();
+    virtual ~StringOutputStream();
+
+public:
+    using OutputStream::write;
+    virtual void write(const char* data, int len);
+
+    virtual void close();
+
+    const string& getString() const;
+
+    /**
+     * Moves the written data out of the stream, the stream is empty afterwards
+     */
+    string takeString();
+
+    /**
+     * Frees the memory of the written data
+     */
+    void clear();
+
+private:
+    string buffer;
+};
@@ -0,0 +1,102 @@
+/*
+ * Xournal++
+ *
+ * Utility to process independent items on several threads
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Util {
+
+/**
+ * @return The number of threads to use for parallel work, one per CPU core, at least 1
+ */
+inline auto getParallelThreadCount() -> unsigned int { return std::max(std::thread::hardware_concurrency(), 1U); }
+
+/**
+ * Calls produce(i) for each i in [0, count) on up to threadCount worker threads, and consume(i, result) on the
+ * calling thread, strictly in the order of i.
+ *
+ * At most `window` results are produced ahead of the consumer, so the memory of the pending results is bounded.
+ * With only one thread, everything is done on the calling thread.
+ */
+template <typename Produce, typename Consume>
+void orderedParallelFor(size_t count, unsigned int threadCount, size_t window, Produce&& produce,
+                        Consume&& consume) {
+    using Result = decltype(produce(size_t{0}));
+
+    if (threadCount <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            consume(i, produce(i));
+        }
+        return;
+    }
+
+    window = std::max(window, static_cast<size_t>(threadCount));
+
+    std::mutex mutex;
+    std::condition_variable producedCond;
+    std::condition_variable consumedCond;
+    std::map<size_t, Result> results;
+    size_t next = 0;
+    size_t consumed = 0;
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            consumedCond.wait(lock, [&]() { return next >= count || next < consumed + window; });
+            if (next >= count) {
+                return;
+            }
+            size_t i = next++;
+
+            lock.unlock();
+            Result result = produce(i);
+            lock.lock();
+
+            results.emplace(i, std::move(result));
+            producedCond.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t threadsNeeded = std::min(static_cast<size_t>(threadCount), count);
+    for (size_t t = 0; t < threadsNeeded; t++) {
+        threads.emplace_back(worker);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        std::unique_lock<std::mutex> lock(mutex);
+        producedCond.wait(lock, [&]() { return results.find(i) != results.end(); });
+
+        auto it = results.find(i);
+        Result result = std::move(it->second);
+        results.erase(it);
+
+        consumed = i + 1;
+        consumedCond.notify_all();
+        lock.unlock();
+
+        consume(i, std::move(result));
+    }
+
+    for (std::thread& thread: threads) {
+        thread.join();
+    }
+}
+
+}  // namespace Util
@@ -2,7 +2,9 @@
 
 #include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
 
 #include <unistd.h>
 
@@ -62,13 +64,58 @@ auto Util::paintBackgroundWhite(GtkWidget* widget, cairo_t* cr, void*) -> gboole
     return false;
 }
 
+auto Util::formatDouble(char* buffer, double value) -> size_t {
+    // The number of decimals of PRECISION_FORMAT_STRING
+    constexpr double SCALE = 1e8;
+    constexpr uint64_t DECIMALS = 8;
+
+    // The scaled value must be exact as integer, larger values are formatted by printf
+    constexpr double LIMIT = 9e15 / SCALE;
+
+    if (!(std::abs(value) < LIMIT)) {
+        g_ascii_formatd(buffer, G_ASCII_DTOSTR_BUF_SIZE, Util::PRECISION_FORMAT_STRING, value);
+        return strlen(buffer);
+    }
+
+    // The exact product is scaled + error, rounded half to even like printf does it
+    double scaled = std::abs(value) * SCALE;
+    double error = std::fma(std::abs(value), SCALE, -scaled);
+    double rounded = std::floor(scaled);
+    double fraction = scaled - rounded;
+    if (fraction > 0.5 || (fraction == 0.5 && (error > 0 || (error == 0 && std::fmod(rounded, 2.0) != 0)))) {
+        rounded += 1;
+    }
+
+    auto number = static_cast<uint64_t>(rounded);
+
+    // Write the digits from the end
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    for (uint64_t i = 0; i < DECIMALS; i++) {
+        *--p = static_cast<char>('0' + number % 10);
+        number /= 10;
+    }
+    *--p = '.';
+    do {
+        *--p = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while (number > 0);
+    if (std::signbit(value)) {
+        *--p = '-';
+    }
+
+    auto length = static_cast<size_t>(digits + sizeof(digits) - p);
+    memcpy(buffer, p, length);
+    buffer[length] = 0;
+    return length;
+}
+
 void Util::writeCoordinateString(OutputStream* out, double xVal, double yVal) {
-    std::array<char, G_ASCII_DTOSTR_BUF_SIZE> coordString{};
-    g_ascii_formatd(coordString.data(), G_ASCII_DTOSTR_BUF_SIZE, Util::PRECISION_FORMAT_STRING, xVal);
-    out->write(coordString.data());
-    out->write(" ");
-    g_ascii_formatd(coordString.data(), G_ASCII_DTOSTR_BUF_SIZE, Util::PRECISION_FORMAT_STRING, yVal);
-    out->write(coordString.data());
+    std::array<char, 2 * G_ASCII_DTOSTR_BUF_SIZE> coordString{};
+    size_t length = formatDouble(coordString.data(), xVal);
+    coordString[length++] = ' ';
+    length += formatDouble(coordString.data() + length, yVal);
+    out->write(coordString.data(), static_cast<int>(length));
 }
 
 void Util::systemWithMessage(const char* command) {
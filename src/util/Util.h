@@ -49,6 +49,15 @@ extern void writeCoordinateString(OutputStream* out, double xVal, double yVal);
 
 constexpr const gchar* PRECISION_FORMAT_STRING = "%.8f";
 
+/**
+ * Formats the value exactly like g_ascii_formatd with PRECISION_FORMAT_STRING, but without the overhead of printf
+ * for the values in the range of page coordinates
+ *
+ * @param buffer At least G_ASCII_DTOSTR_BUF_SIZE characters
+ * @return The length of the (null terminated) string
+ */
+size_t formatDouble(char* buffer, double value);
+
 constexpr const auto DPI_NORMALIZATION_FACTOR = 72.0;
 
 }  // namespace Util
@@ -1,15 +1,24 @@
 #include "DocumentView.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "background/MainBackgroundPainter.h"
 #include "control/tools/EditSelection.h"
 #include "control/tools/Selection.h"
 #include "model/Layer.h"
 #include "model/eraser/EraseableStroke.h"
 
+#include "ImageCache.h"
 #include "StrokeView.h"
 #include "TextView.h"
 
 
+/**
+ * Formulas larger than this (in pixels on the target) are not cached as image
+ */
+constexpr double MAX_TEX_RASTER_PIXELS = 4096.0 * 4096.0;
+
 DocumentView::DocumentView() { this->backgroundPainter = new MainBackgroundPainter(); }
 
 DocumentView::~DocumentView() {
@@ -22,6 +31,10 @@ DocumentView::~DocumentView() {
  */
 void DocumentView::setMarkAudioStroke(bool markAudioStroke) { this->markAudioStroke = markAudioStroke; }
 
+void DocumentView::setAllowIncompleteImages(bool allow) { this->allowIncompleteImages = allow; }
+
+auto DocumentView::hasIncompleteImages() const -> bool { return this->incompleteImages; }
+
 void DocumentView::applyColor(cairo_t* cr, Stroke* s) {
     if (s->getToolType() == STROKE_TOOL_HIGHLIGHTER) {
         if (s->getFill() != -1) {
@@ -71,25 +84,14 @@ void DocumentView::drawText(cairo_t* cr, Text* t) {
     cairo_set_matrix(cr, &defaultMatrix);
 }
 
-void DocumentView::drawImage(cairo_t* cr, Image* i) {
-    cairo_matrix_t defaultMatrix = {0};
-    cairo_get_matrix(cr, &defaultMatrix);
-
-    cairo_surface_t* img = i->getImage();
-    int width = cairo_image_surface_get_width(img);
-    int height = cairo_image_surface_get_height(img);
-
+void DocumentView::drawImage(cairo_t* cr, Image* i) const {
     cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
-    double xFactor = i->getElementWidth() / width;
-    double yFactor = i->getElementHeight() / height;
-
-    cairo_scale(cr, xFactor, yFactor);
-
-    cairo_set_source_surface(cr, img, i->getX() / xFactor, i->getY() / yFactor);
-    cairo_paint(cr);
-
-    cairo_set_matrix(cr, &defaultMatrix);
+    bool exact = ImageCache::getInstance().paint(cr, i->getPngData(), i->getX(), i->getY(), i->getElementWidth(),
+                                                 i->getElementHeight(), !this->allowIncompleteImages);
+    if (!exact) {
+        this->incompleteImages = true;
+    }
 }
 
 void DocumentView::drawTexImage(cairo_t* cr, TexImage* texImage) {
@@ -105,6 +107,27 @@ void DocumentView::drawTexImage(cairo_t* cr, TexImage* texImage) {
             return;
         }
 
+        cairo_surface_t* raster = nullptr;
+        int rasterWidth = 0;
+        int rasterHeight = 0;
+        getTexRasterSize(cr, texImage, rasterWidth, rasterHeight);
+        if (rasterWidth > 0) {
+            raster = texImage->getPdfRaster(rasterWidth, rasterHeight);
+        }
+
+        if (raster != nullptr) {
+            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+            cairo_translate(cr, texImage->getX(), texImage->getY());
+            cairo_scale(cr, texImage->getElementWidth() / rasterWidth, texImage->getElementHeight() / rasterHeight);
+            cairo_set_source_surface(cr, raster, 0, 0);
+            cairo_paint(cr);
+
+            cairo_surface_destroy(raster);
+            cairo_set_matrix(cr, &defaultMatrix);
+            return;
+        }
+
         PopplerPage* page = poppler_document_get_page(pdf, 0);
 
         double pageWidth = 0;
@@ -137,6 +160,44 @@ void DocumentView::drawTexImage(cairo_t* cr, TexImage* texImage) {
     cairo_set_matrix(cr, &defaultMatrix);
 }
 
+void DocumentView::getTexRasterSize(cairo_t* cr, TexImage* texImage, int& width, int& height) {
+    width = 0;
+    height = 0;
+
+    // Printing and vector exports keep the formula as vector graphics
+    if (ImageCache::isVectorTarget(cr)) {
+        return;
+    }
+
+    double elementWidth = texImage->getElementWidth();
+    double elementHeight = texImage->getElementHeight();
+    if (elementWidth <= 0 || elementHeight <= 0) {
+        return;
+    }
+
+    double wx = elementWidth;
+    double wy = 0;
+    double hx = 0;
+    double hy = elementHeight;
+    cairo_user_to_device_distance(cr, &wx, &wy);
+    cairo_user_to_device_distance(cr, &hx, &hy);
+
+    // Pixels per unit, rounded up to the next power of two so the formula is only rendered again at every doubling
+    // of the zoom
+    double scale = std::max(std::hypot(wx, wy) / elementWidth, std::hypot(hx, hy) / elementHeight);
+    scale = std::exp2(std::ceil(std::log2(scale)));
+
+    double rasterWidth = std::ceil(elementWidth * scale);
+    double rasterHeight = std::ceil(elementHeight * scale);
+    if (!(rasterWidth * rasterHeight <= MAX_TEX_RASTER_PIXELS)) {
+        // Very large formulas are drawn directly
+        return;
+    }
+
+    width = std::max(1, static_cast<int>(rasterWidth));
+    height = std::max(1, static_cast<int>(rasterHeight));
+}
+
 void DocumentView::drawElement(cairo_t* cr, Element* e) const {
     if (e->getType() == ELEMENT_STROKE) {
         drawStroke(cr, dynamic_cast<Stroke*>(e));
@@ -157,11 +218,15 @@ void DocumentView::drawElement(cairo_t* cr, Element* e) const {
 void DocumentView::drawLayer(cairo_t* cr, Layer* l) {
     cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
 
-#ifdef DEBUG_SHOW_REPAINT_BOUNDS
-    int drawn = 0;
-    int notDrawn = 0;
-#endif  // DEBUG_SHOW_REPAINT_BOUNDS
-    for (Element* e: *l->getElements()) {
+    // Only look up the elements in the repaint area, if the area is limited
+    vector<Element*> limitedElements;
+    vector<Element*>* elements = l->getElements();
+    if (this->lX != -1) {
+        limitedElements = l->getElementsInArea(Rectangle<double>(this->lX, this->lY, this->lWidth, this->lHeight));
+        elements = &limitedElements;
+    }
+
+    for (Element* e: *elements) {
 #ifdef DEBUG_SHOW_ELEMENT_BOUNDS
         cairo_set_source_rgb(cr, 0, 1, 0);
         cairo_set_line_width(cr, 1);
@@ -170,50 +235,37 @@ void DocumentView::drawLayer(cairo_t* cr, Layer* l) {
 #endif  // DEBUG_SHOW_REPAINT_BOUNDS
         // cairo_new_path(cr);
 
-        if (this->lX != -1) {
-            if (e->intersectsArea(this->lX, this->lY, this->width, this->height)) {
-                drawElement(cr, e);
-#ifdef DEBUG_SHOW_REPAINT_BOUNDS
-                drawn++;
-#endif  // DEBUG_SHOW_REPAINT_BOUNDS
-            }
-#ifdef DEBUG_SHOW_REPAINT_BOUNDS
-            else {
-                notDrawn++;
-            }
-#endif  // DEBUG_SHOW_REPAINT_BOUNDS
-
-        } else {
-#ifdef DEBUG_SHOW_REPAINT_BOUNDS
-            drawn++;
-#endif  // DEBUG_SHOW_REPAINT_BOUNDS
-            drawElement(cr, e);
-        }
+        drawElement(cr, e);
     }
 
 #ifdef DEBUG_SHOW_REPAINT_BOUNDS
-    g_message("DBG:DocumentView: draw %i / not draw %i", drawn, notDrawn);
+    g_message("DBG:DocumentView: draw %i / not draw %i", static_cast<int>(elements->size()),
+              static_cast<int>(l->getElements()->size() - elements->size()));
 #endif  // DEBUG_SHOW_REPAINT_BOUNDS
 }
 
 void DocumentView::paintBackgroundImage() {
-    GdkPixbuf* pixbuff = page->getBackgroundImage().getPixbuf();
+    BackgroundImage& image = page->getBackgroundImage();
+    GdkPixbuf* pixbuff = image.getPixbuf();
     if (pixbuff) {
-        cairo_matrix_t matrix = {0};
-        cairo_get_matrix(cr, &matrix);
-
-        int width = gdk_pixbuf_get_width(pixbuff);
-        int height = gdk_pixbuf_get_height(pixbuff);
-
-        double sx = page->getWidth() / width;
-        double sy = page->getHeight() / height;
-
-        cairo_scale(cr, sx, sy);
-
-        gdk_cairo_set_source_pixbuf(cr, pixbuff, 0, 0);
-        cairo_paint(cr);
+        if (ImageCache::isVectorTarget(cr)) {
+            // Printed and exported once, the full resolution is not kept
+            cairo_matrix_t matrix = {0};
+            cairo_get_matrix(cr, &matrix);
+            cairo_scale(cr, page->getWidth() / gdk_pixbuf_get_width(pixbuff),
+                        page->getHeight() / gdk_pixbuf_get_height(pixbuff));
+            gdk_cairo_set_source_pixbuf(cr, pixbuff, 0, 0);
+            cairo_paint(cr);
+            cairo_set_matrix(cr, &matrix);
+            return;
+        }
 
-        cairo_set_matrix(cr, &matrix);
+        // The levels are shared by all pages with this background and evicted with the other images
+        bool exact = ImageCache::getInstance().paint(cr, pixbuff, 0, 0, page->getWidth(), page->getHeight(),
+                                                     !this->allowIncompleteImages);
+        if (!exact) {
+            this->incompleteImages = true;
+        }
     }
 }
 
@@ -64,6 +64,17 @@ public:
      */
     void setMarkAudioStroke(bool markAudioStroke);
 
+    /**
+     * Draw images which are not decoded at the needed resolution yet with a lower resolution (or not at all) instead
+     * of waiting for them, they are decoded in the background. See ImageCache.
+     */
+    void setAllowIncompleteImages(bool allow);
+
+    /**
+     * @return true if an image was not drawn at the needed resolution, see setAllowIncompleteImages()
+     */
+    bool hasIncompleteImages() const;
+
     // API for special drawing, usually you won't call this methods
 public:
     /**
@@ -99,9 +110,16 @@ public:
 
 private:
     static void drawText(cairo_t* cr, Text* t);
-    static void drawImage(cairo_t* cr, Image* i);
+    void drawImage(cairo_t* cr, Image* i) const;
     static void drawTexImage(cairo_t* cr, TexImage* texImage);
 
+    /**
+     * The size of the rendered formula for the target of cr, see TexImage::getPdfRaster()
+     *
+     * @param width Set to 0 if the formula is drawn as vector graphics
+     */
+    static void getTexRasterSize(cairo_t* cr, TexImage* texImage, int& width, int& height);
+
     void drawElement(cairo_t* cr, Element* e) const;
 
     void paintBackgroundImage();
@@ -114,6 +132,9 @@ private:
     bool dontRenderEditingStroke = false;
     bool markAudioStroke = false;
 
+    bool allowIncompleteImages = false;
+    mutable bool incompleteImages = false;
+
     double lX = -1;
     double lY = -1;
     double lWidth = -1;
@@ -0,0 +1,501 @@
+#include "ImageCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glib.h>
+
+#include "pixbuf-utils.h"
+
+struct ImageCache::Entry {
+    Entry() = default;
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+
+    ~Entry() {
+        if (this->pixbuf) {
+            g_object_unref(this->pixbuf);
+        }
+    }
+
+    /**
+     * Keeps the data alive while the image is cached, the address of the data is the key
+     */
+    std::shared_ptr<const string> png;
+
+    /**
+     * A referenced background image instead of PNG data, the pixbuf is the key
+     */
+    GdkPixbuf* pixbuf = nullptr;
+
+    // Size of the full resolution image
+    int width = 0;
+    int height = 0;
+
+    /**
+     * The image could not be decoded
+     */
+    bool failed = false;
+
+    std::array<cairo_surface_t*, LEVEL_COUNT> levels{};
+    std::array<LruList::iterator, LEVEL_COUNT> lruPositions{};
+    std::array<bool, LEVEL_COUNT> decoding{};
+    std::array<bool, LEVEL_COUNT> requested{};
+
+    LruList::iterator failedPosition{};
+};
+
+namespace {
+
+/**
+ * The level of failed images in the LRU list
+ */
+constexpr int FAILED_LEVEL = -1;
+
+struct PngReader {
+    const string* data;
+    size_t pos;
+};
+
+auto readPng(PngReader* reader, unsigned char* data, unsigned int length) -> cairo_status_t {
+    if (reader->pos + length > reader->data->size()) {
+        return CAIRO_STATUS_READ_ERROR;
+    }
+
+    std::copy_n(reader->data->data() + reader->pos, length, data);
+    reader->pos += length;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * The size of the encoded data, accounted for images which could not be decoded
+ */
+auto dataBytes(const std::shared_ptr<const string>& png) -> size_t { return png ? png->size() : 0; }
+
+auto surfaceBytes(cairo_surface_t* surface) -> size_t {
+    return static_cast<size_t>(cairo_image_surface_get_stride(surface)) *
+           static_cast<size_t>(cairo_image_surface_get_height(surface));
+}
+
+}  // namespace
+
+ImageCache::ImageCache() { this->decoder = std::thread(&ImageCache::decoderLoop, this); }
+
+ImageCache::~ImageCache() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopDecoder = true;
+    }
+    this->requestCond.notify_all();
+    this->decoder.join();
+
+    clear();
+}
+
+auto ImageCache::getInstance() -> ImageCache& {
+    static ImageCache instance;
+    return instance;
+}
+
+void ImageCache::setMaxBytes(size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->maxBytes = maxBytes;
+    evict();
+}
+
+auto ImageCache::getBytes() -> size_t {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->bytes;
+}
+
+auto ImageCache::readPngSize(const string& png, int& width, int& height) -> bool {
+    // Signature, followed by the IHDR chunk: length, type, width and height as big endian
+    static const char SIGNATURE[] = "\x89PNG\r\n\x1a\n";
+    constexpr size_t HEADER_SIZE = 24;
+
+    if (png.size() < HEADER_SIZE || png.compare(0, 8, SIGNATURE, 8) != 0 || png.compare(12, 4, "IHDR") != 0) {
+        return false;
+    }
+
+    auto readInt = [&png](size_t pos) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < 4; i++) {
+            value = (value << 8U) | static_cast<unsigned char>(png[pos + i]);
+        }
+        return value;
+    };
+
+    uint32_t w = readInt(16);
+    uint32_t h = readInt(20);
+    if (w == 0 || h == 0 || w > INT32_MAX || h > INT32_MAX) {
+        return false;
+    }
+
+    width = static_cast<int>(w);
+    height = static_cast<int>(h);
+    return true;
+}
+
+auto ImageCache::getEntry(const std::shared_ptr<const string>& png) -> Entry& {
+    auto [it, inserted] = this->entries.try_emplace(png.get());
+    Entry& entry = it->second;
+    if (inserted) {
+        entry.png = png;
+        if (!readPngSize(*png, entry.width, entry.height)) {
+            setFailed(png.get(), entry);
+        }
+    }
+    return entry;
+}
+
+auto ImageCache::getEntry(GdkPixbuf* pixbuf) -> Entry& {
+    auto [it, inserted] = this->entries.try_emplace(pixbuf);
+    Entry& entry = it->second;
+    if (inserted) {
+        entry.pixbuf = GDK_PIXBUF(g_object_ref(pixbuf));
+        entry.width = gdk_pixbuf_get_width(pixbuf);
+        entry.height = gdk_pixbuf_get_height(pixbuf);
+    }
+    return entry;
+}
+
+auto ImageCache::isVectorTarget(cairo_t* cr) -> bool {
+    return cairo_surface_get_type(cairo_get_group_target(cr)) != CAIRO_SURFACE_TYPE_IMAGE;
+}
+
+auto ImageCache::chooseLevel(cairo_t* cr, int imageWidth, int imageHeight, double width, double height) -> int {
+    // Printing and vector exports keep the full resolution
+    if (isVectorTarget(cr)) {
+        return 0;
+    }
+
+    double wx = width;
+    double wy = 0;
+    double hx = 0;
+    double hy = height;
+    cairo_user_to_device_distance(cr, &wx, &wy);
+    cairo_user_to_device_distance(cr, &hx, &hy);
+
+    // Pixels of the image per pixel of the target, the image is never upscaled from a lower level
+    double ratio = std::min(imageWidth / std::hypot(wx, wy), imageHeight / std::hypot(hx, hy));
+    if (!(ratio >= 2)) {
+        return 0;
+    }
+    return std::min(static_cast<int>(std::floor(std::log2(ratio))), LEVEL_COUNT - 1);
+}
+
+auto ImageCache::findAvailable(const Entry& entry, int level) -> cairo_surface_t* {
+    for (int l = level - 1; l >= 0; l--) {
+        if (entry.levels[l]) {
+            return entry.levels[l];
+        }
+    }
+    for (int l = level + 1; l < LEVEL_COUNT; l++) {
+        if (entry.levels[l]) {
+            return entry.levels[l];
+        }
+    }
+    return nullptr;
+}
+
+auto ImageCache::paint(cairo_t* cr, const std::shared_ptr<const string>& png, double x, double y, double width,
+                       double height, bool wait) -> bool {
+    if (!png || png->empty() || width <= 0 || height <= 0) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return paintEntry(lock, cr, png.get(), getEntry(png), x, y, width, height, wait);
+}
+
+auto ImageCache::paint(cairo_t* cr, GdkPixbuf* pixbuf, double x, double y, double width, double height, bool wait)
+        -> bool {
+    if (pixbuf == nullptr || width <= 0 || height <= 0) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    return paintEntry(lock, cr, pixbuf, getEntry(pixbuf), x, y, width, height, wait);
+}
+
+auto ImageCache::paintEntry(std::unique_lock<std::mutex>& lock, cairo_t* cr, Key key, Entry& entry, double x,
+                            double y, double width, double height, bool wait) -> bool {
+    if (entry.failed) {
+        this->lru.splice(this->lru.begin(), this->lru, entry.failedPosition);
+        return true;
+    }
+
+    int level = chooseLevel(cr, entry.width, entry.height, width, height);
+    cairo_surface_t* surface = entry.levels[level];
+    bool exact = true;
+
+    if (surface == nullptr && wait) {
+        surface = decodeLevel(lock, key, level);
+    } else if (surface == nullptr) {
+        requestDecode(key, entry, level);
+        surface = findAvailable(entry, level);
+        exact = false;
+    }
+
+    if (surface == nullptr) {
+        return exact;
+    }
+
+    // The entry may be evicted while painting, the reference keeps the surface alive
+    cairo_surface_reference(surface);
+    auto it = this->entries.find(key);
+    if (it != this->entries.end()) {
+        for (int l = 0; l < LEVEL_COUNT; l++) {
+            if (it->second.levels[l] == surface) {
+                touch(it->second, l);
+            }
+        }
+    }
+    lock.unlock();
+
+    cairo_save(cr);
+    cairo_translate(cr, x, y);
+    cairo_scale(cr, width / cairo_image_surface_get_width(surface), height / cairo_image_surface_get_height(surface));
+    cairo_set_source_surface(cr, surface, 0, 0);
+    cairo_paint(cr);
+    cairo_restore(cr);
+
+    cairo_surface_destroy(surface);
+
+    return exact;
+}
+
+auto ImageCache::decodeLevel(std::unique_lock<std::mutex>& lock, Key key, int level) -> cairo_surface_t* {
+    // Another thread may be decoding the level already
+    this->decodedCond.wait(lock, [this, key, level]() {
+        auto it = this->entries.find(key);
+        return it == this->entries.end() || !it->second.decoding[level];
+    });
+
+    auto it = this->entries.find(key);
+    if (it == this->entries.end()) {
+        // Released meanwhile
+        return nullptr;
+    }
+
+    // Entries which are decoding are never removed, so the reference stays valid while the lock is released
+    Entry& entry = it->second;
+    if (entry.levels[level] || entry.failed) {
+        return entry.levels[level];
+    }
+
+    entry.decoding[level] = true;
+    entry.requested[level] = false;
+
+    cairo_surface_t* finer = nullptr;
+    for (int l = level - 1; l >= 0 && finer == nullptr; l--) {
+        finer = entry.levels[l];
+    }
+    if (finer) {
+        cairo_surface_reference(finer);
+    }
+    std::shared_ptr<const string> png = entry.png;
+    GdkPixbuf* pixbuf = entry.pixbuf ? GDK_PIXBUF(g_object_ref(entry.pixbuf)) : nullptr;
+
+    lock.unlock();
+    cairo_surface_t* surface = createLevel(png.get(), pixbuf, finer, level, entry.width, entry.height);
+    if (pixbuf) {
+        g_object_unref(pixbuf);
+    }
+    lock.lock();
+
+    entry.decoding[level] = false;
+    if (surface) {
+        entry.levels[level] = surface;
+        this->lru.emplace_front(key, level);
+        entry.lruPositions[level] = this->lru.begin();
+        this->bytes += surfaceBytes(surface);
+        evict();
+    } else if (!entry.failed) {
+        g_warning("ImageCache: Could not decode image");
+        setFailed(key, entry);
+    }
+
+    this->decodedCond.notify_all();
+
+    return entry.levels[level];
+}
+
+auto ImageCache::createLevel(const string* png, GdkPixbuf* pixbuf, cairo_surface_t* finer, int level, int width,
+                             int height) -> cairo_surface_t* {
+    cairo_surface_t* source = finer;
+    if (source == nullptr) {
+        if (pixbuf) {
+            source = f_pixbuf_to_cairo_surface(pixbuf);
+        } else {
+            PngReader reader{png, 0};
+            source = cairo_image_surface_create_from_png_stream(reinterpret_cast<cairo_read_func_t>(&readPng),
+                                                                &reader);
+        }
+        if (cairo_surface_status(source) != CAIRO_STATUS_SUCCESS) {
+            cairo_surface_destroy(source);
+            return nullptr;
+        }
+
+        if (level == 0) {
+            return source;
+        }
+    }
+
+    cairo_surface_t* surface = downscale(source, level, width, height);
+    cairo_surface_destroy(source);
+
+    return surface;
+}
+
+auto ImageCache::downscale(cairo_surface_t* source, int level, int imageWidth, int imageHeight) -> cairo_surface_t* {
+    int levelWidth = std::max(1, (imageWidth + (1 << level) - 1) >> level);
+    int levelHeight = std::max(1, (imageHeight + (1 << level) - 1) >> level);
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, levelWidth, levelHeight);
+
+    cairo_t* cr = cairo_create(surface);
+    cairo_scale(cr, static_cast<double>(levelWidth) / cairo_image_surface_get_width(source),
+                static_cast<double>(levelHeight) / cairo_image_surface_get_height(source));
+    cairo_set_source_surface(cr, source, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+
+    return surface;
+}
+
+void ImageCache::requestDecode(Key key, Entry& entry, int level) {
+    if (entry.requested[level] || entry.decoding[level]) {
+        return;
+    }
+
+    entry.requested[level] = true;
+    this->requests.emplace_back(key, level);
+    this->requestCond.notify_one();
+}
+
+void ImageCache::touch(Entry& entry, int level) {
+    this->lru.splice(this->lru.begin(), this->lru, entry.lruPositions[level]);
+}
+
+void ImageCache::removeLevel(Entry& entry, int level) {
+    this->bytes -= surfaceBytes(entry.levels[level]);
+    cairo_surface_destroy(entry.levels[level]);
+    entry.levels[level] = nullptr;
+    this->lru.erase(entry.lruPositions[level]);
+}
+
+void ImageCache::setFailed(Key key, Entry& entry) {
+    entry.failed = true;
+    this->lru.emplace_front(key, FAILED_LEVEL);
+    entry.failedPosition = this->lru.begin();
+    this->bytes += dataBytes(entry.png);
+    evict();
+}
+
+void ImageCache::removeFailed(Entry& entry) {
+    // The image is decoded again if it is painted again
+    this->bytes -= dataBytes(entry.png);
+    this->lru.erase(entry.failedPosition);
+    entry.failed = false;
+}
+
+void ImageCache::removeIfUnused(Key key) {
+    auto it = this->entries.find(key);
+    if (it == this->entries.end()) {
+        return;
+    }
+
+    const Entry& entry = it->second;
+    if (entry.failed) {
+        return;
+    }
+    for (int l = 0; l < LEVEL_COUNT; l++) {
+        if (entry.levels[l] || entry.decoding[l]) {
+            return;
+        }
+    }
+
+    // The pending requests of the image are skipped
+    this->entries.erase(it);
+}
+
+void ImageCache::evict() {
+    // Keep the most recently used level
+    while (this->bytes > this->maxBytes && this->lru.size() > 1) {
+        auto [key, level] = this->lru.back();
+        if (level == FAILED_LEVEL) {
+            removeFailed(this->entries.at(key));
+        } else {
+            removeLevel(this->entries.at(key), level);
+        }
+        removeIfUnused(key);
+    }
+}
+
+void ImageCache::release(const std::shared_ptr<const string>& png) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->entries.find(png.get());
+    if (it == this->entries.end()) {
+        return;
+    }
+
+    for (int l = 0; l < LEVEL_COUNT; l++) {
+        it->second.requested[l] = false;
+        if (it->second.levels[l]) {
+            removeLevel(it->second, l);
+        }
+    }
+    if (it->second.failed) {
+        removeFailed(it->second);
+    }
+    removeIfUnused(png.get());
+}
+
+void ImageCache::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->requests.clear();
+
+    for (auto it = this->entries.begin(); it != this->entries.end();) {
+        Entry& entry = it->second;
+        bool decoding = false;
+        for (int l = 0; l < LEVEL_COUNT; l++) {
+            entry.requested[l] = false;
+            decoding |= entry.decoding[l];
+            if (entry.levels[l]) {
+                removeLevel(entry, l);
+            }
+        }
+        if (entry.failed) {
+            removeFailed(entry);
+        }
+
+        it = decoding ? std::next(it) : this->entries.erase(it);
+    }
+}
+
+void ImageCache::decoderLoop() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+        this->requestCond.wait(lock, [this]() { return this->stopDecoder || !this->requests.empty(); });
+        if (this->stopDecoder) {
+            return;
+        }
+
+        // The most recent requests first, they are the ones currently shown
+        auto [key, level] = this->requests.back();
+        this->requests.pop_back();
+
+        auto it = this->entries.find(key);
+        if (it == this->entries.end() || !it->second.requested[level]) {
+            // Released, or already decoded by a painting thread
+            continue;
+        }
+
+        decodeLevel(lock, key, level);
+    }
+}
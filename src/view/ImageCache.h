@@ -0,0 +1,213 @@
+/*
+ * Xournal++
+ *
+ * Caches the decoded images of the Image elements
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include <cairo.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "XournalType.h"
+
+/**
+ * @brief Decoded images at the resolutions they are drawn with, bounded by the memory used
+ *
+ * The Image elements only keep their encoded PNG data, which is also the key of the cache. Each image is decoded
+ * into a pyramid of levels, level n is the image downscaled by 2^n. Only the levels matching the zoom they are
+ * drawn with are decoded, so a photo shown in a small frame never keeps its full resolution in memory.
+ *
+ * The levels are decoded by a background thread. Painting either waits for the level (or decodes it on the calling
+ * thread), or paints the best level already decoded and requests the missing one. Least recently used levels are
+ * evicted once the memory budget is exceeded, the levels of the images of pages which are not shown anymore can be
+ * dropped with release().
+ *
+ * The background images of the pages are cached the same way, keyed by their pixbuf. They are shared by all pages
+ * with the same background, so they are only evicted, not released with a page.
+ */
+class ImageCache {
+public:
+    static ImageCache& getInstance();
+
+    ~ImageCache();
+
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+private:
+    ImageCache();
+
+public:
+    /**
+     * @param maxBytes The memory budget of the decoded images
+     */
+    void setMaxBytes(size_t maxBytes);
+
+    /**
+     * @return The memory used by the decoded levels and the data of the failed images
+     */
+    size_t getBytes();
+
+    /**
+     * Paints the image scaled to the rectangle (in user coordinates of cr)
+     *
+     * The level is chosen from the size of the rectangle on the target surface. Vector targets (PDF, SVG, printing)
+     * always get the full resolution.
+     *
+     * @param png The encoded image
+     * @param wait Wait for the level to be decoded. Otherwise the best level already decoded is painted (or nothing),
+     * and the missing level is decoded in the background.
+     * @return false if the image was not painted at the requested level
+     */
+    bool paint(cairo_t* cr, const std::shared_ptr<const string>& png, double x, double y, double width, double height,
+               bool wait);
+
+    /**
+     * Paints a background image scaled to the rectangle, see the other paint(). The cache keeps a reference to the
+     * pixbuf while its levels are cached.
+     */
+    bool paint(cairo_t* cr, GdkPixbuf* pixbuf, double x, double y, double width, double height, bool wait);
+
+    /**
+     * Drops all decoded levels of the image, e.g. if its page is not shown anymore
+     */
+    void release(const std::shared_ptr<const string>& png);
+
+    /**
+     * Drops all decoded levels of all images
+     */
+    void clear();
+
+    /**
+     * Reads the size of the image from the PNG header, without decoding the image
+     *
+     * @return false if the data is no PNG image
+     */
+    static bool readPngSize(const string& png, int& width, int& height);
+
+    /**
+     * @return true if cr paints to a vector target (PDF, SVG, printing), which gets the full resolution
+     */
+    static bool isVectorTarget(cairo_t* cr);
+
+    /**
+     * @param imageWidth The width of the full resolution image in pixels
+     * @param width The width the image is painted with, in user coordinates of cr
+     * @return The level to paint the image with, for the target of cr. Always 0 for vector targets.
+     */
+    static int chooseLevel(cairo_t* cr, int imageWidth, int imageHeight, double width, double height);
+
+    /**
+     * Creates a level of the pyramid from a finer level
+     *
+     * @param source The full resolution image or a level finer than the requested level
+     * @param imageWidth The width of the full resolution image in pixels
+     */
+    static cairo_surface_t* downscale(cairo_surface_t* source, int level, int imageWidth, int imageHeight);
+
+private:
+    struct Entry;
+    /**
+     * The encoded PNG data or the pixbuf of the image
+     */
+    using Key = const void*;
+    using LruList = std::list<std::pair<Key, int>>;
+
+    /**
+     * Returns the entry of the image, creates it if needed
+     */
+    Entry& getEntry(const std::shared_ptr<const string>& png);
+    Entry& getEntry(GdkPixbuf* pixbuf);
+
+    bool paintEntry(std::unique_lock<std::mutex>& lock, cairo_t* cr, Key key, Entry& entry, double x, double y,
+                    double width, double height, bool wait);
+
+    /**
+     * Returns the decoded level, decodes it on this thread or waits for the thread decoding it.
+     * Called with the lock held, which is released while decoding.
+     *
+     * @return The level, or nullptr if the image could not be decoded
+     */
+    cairo_surface_t* decodeLevel(std::unique_lock<std::mutex>& lock, Key key, int level);
+
+    /**
+     * Creates the level from the nearest finer level, or by decoding the PNG data (or converting the pixbuf) if there
+     * is none. Called without the lock held.
+     */
+    static cairo_surface_t* createLevel(const string* png, GdkPixbuf* pixbuf, cairo_surface_t* finer, int level,
+                                        int width, int height);
+
+    /**
+     * @return The decoded level closest to the requested one, finer levels first, or nullptr
+     */
+    static cairo_surface_t* findAvailable(const Entry& entry, int level);
+
+    void requestDecode(Key key, Entry& entry, int level);
+    void touch(Entry& entry, int level);
+    void removeLevel(Entry& entry, int level);
+
+    /**
+     * Marks the image as not decodable. Failed images are kept in the LRU list (with the size of their data), so
+     * they are evicted like the levels, even if they are never released.
+     */
+    void setFailed(Key key, Entry& entry);
+    void removeFailed(Entry& entry);
+
+    /**
+     * Removes the entry if no level is decoded or decoding, and it is not kept as failed
+     */
+    void removeIfUnused(Key key);
+    void evict();
+
+    void decoderLoop();
+
+public:
+    /**
+     * Level n is the image downscaled by 2^n
+     */
+    static constexpr int LEVEL_COUNT = 8;
+
+private:
+    std::mutex mutex;
+
+    /**
+     * Notified if a level finished decoding, or a decode is requested
+     */
+    std::condition_variable decodedCond;
+    std::condition_variable requestCond;
+
+    std::unordered_map<Key, Entry> entries;
+
+    /**
+     * Decoded levels and failed images, most recently used first
+     */
+    LruList lru;
+
+    /**
+     * Levels to decode in the background
+     */
+    std::deque<std::pair<Key, int>> requests;
+
+    std::thread decoder;
+    bool stopDecoder = false;
+
+    size_t bytes = 0;
+    size_t maxBytes = 256 * 1024 * 1024;
+};
@@ -8,8 +8,8 @@ PdfView::PdfView() = default;
 
 PdfView::~PdfView() = default;
 
-void PdfView::drawPage(PdfCache* cache, const XojPdfPageSPtr& popplerPage, cairo_t* cr, double zoom, double width,
-                       double height, bool forPrinting) {
+auto PdfView::drawPage(PdfCache* cache, const XojPdfPageSPtr& popplerPage, cairo_t* cr, double zoom, double width,
+                       double height, bool forPrinting, bool allowLowResolution) -> bool {
     if (popplerPage) {
         if (!forPrinting) {
             cairo_set_source_rgb(cr, 1., 1., 1.);
@@ -17,10 +17,9 @@ void PdfView::drawPage(PdfCache* cache, const XojPdfPageSPtr& popplerPage, cairo
         }
 
         if (cache && !forPrinting) {
-            cache->render(cr, popplerPage, zoom);
-        } else {
-            popplerPage->render(cr, forPrinting);
+            return cache->render(cr, popplerPage, zoom, allowLowResolution);
         }
+        popplerPage->render(cr, forPrinting);
     } else {
         cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
         cairo_set_font_size(cr, 26);
@@ -34,4 +33,6 @@ void PdfView::drawPage(PdfCache* cache, const XojPdfPageSPtr& popplerPage, cairo
         cairo_move_to(cr, width / 2 - extents.width / 2, height / 2 - extents.height / 2);
         cairo_show_text(cr, strMissing.c_str());
     }
+
+    return true;
 }
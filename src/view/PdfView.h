@@ -22,6 +22,10 @@ private:
     virtual ~PdfView();
 
 public:
-    static void drawPage(PdfCache* cache, const XojPdfPageSPtr& popplerPage, cairo_t* cr, double zoom, double width,
-                         double height, bool forPrinting = false);
+    /**
+     * @param allowLowResolution Paint a lower resolution version of the page if the page is not cached at the zoom
+     * @return false if a lower resolution version of the page was painted
+     */
+    static bool drawPage(PdfCache* cache, const XojPdfPageSPtr& popplerPage, cairo_t* cr, double zoom, double width,
+                         double height, bool forPrinting = false, bool allowLowResolution = false);
 };
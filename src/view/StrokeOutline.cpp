@@ -0,0 +1,230 @@
+#include "StrokeOutline.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "model/StrokePoints.h"
+
+namespace {
+
+struct Segment {
+    double x1;
+    double y1;
+    double x2;
+    double y2;
+
+    // Unit direction, the normal (-dy, dx) points to the left side
+    double dx;
+    double dy;
+    double length;
+    double radius;
+
+    // Distance from the start / end at which the edges enter the disk of the join
+    double startInset;
+    double endInset;
+
+    /**
+     * @param side 1 for the left edge, -1 for the right edge
+     * @param along Offset in the direction of the segment
+     */
+    void offset(double px, double py, double side, double along, double& ox, double& oy) const {
+        ox = px - side * this->dy * this->radius + this->dx * along;
+        oy = py + side * this->dx * this->radius + this->dy * along;
+    }
+};
+
+/**
+ * Bezier curves are used for arcs up to a quarter circle
+ */
+constexpr double MAX_BEZIER_ARC = M_PI / 2;
+
+}  // namespace
+
+StrokeOutline::StrokeOutline(const StrokePoints& points, double width, double widthFactor): widthFactor(widthFactor) {
+    if (points.size() < 2) {
+        return;
+    }
+
+    const double* x = points.getX();
+    const double* y = points.getY();
+    const double* pressure = points.getPressure();
+
+    std::vector<Segment> segments;
+    segments.reserve(points.size() - 1);
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        double segmentWidth = pressure != nullptr && pressure[i] != Point::NO_PRESSURE ? pressure[i] : width;
+        double radius = segmentWidth * widthFactor / 2;
+
+        double dx = x[i + 1] - x[i];
+        double dy = y[i + 1] - y[i];
+        double length = std::hypot(dx, dy);
+        if (length == 0) {
+            // Drawn as dot with a round cap
+            circle(x[i], y[i], radius);
+            continue;
+        }
+        segments.push_back({x[i], y[i], x[i + 1], y[i + 1], dx / length, dy / length, length, radius, 0, 0});
+    }
+
+    if (segments.empty()) {
+        return;
+    }
+
+    size_t n = segments.size();
+    for (size_t i = 0; i + 1 < n; i++) {
+        Segment& a = segments[i];
+        Segment& b = segments[i + 1];
+        double r = std::max(a.radius, b.radius);
+        a.endInset = std::sqrt(r * r - a.radius * a.radius);
+        b.startInset = std::sqrt(r * r - b.radius * b.radius);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        Segment& s = segments[i];
+        double half = s.length / 2;
+        if (s.startInset <= half && s.endInset <= half) {
+            continue;
+        }
+
+        // The segment is shorter than the disks of its joins, which are added as full circles then
+        circle(s.x1, s.y1, i > 0 ? std::max(s.radius, segments[i - 1].radius) : s.radius);
+        circle(s.x2, s.y2, i + 1 < n ? std::max(s.radius, segments[i + 1].radius) : s.radius);
+
+        s.startInset = std::min(s.startInset, half);
+        s.endInset = std::min(s.endInset, half);
+    }
+
+    for (size_t i = 0; i + 1 < n; i++) {
+        const Segment& a = segments[i];
+        const Segment& b = segments[i + 1];
+        if (a.radius != b.radius) {
+            // The inner side of the join passes through the joint, which cuts into the wider segment. The disk of
+            // the join covers the wider segment up to the point where the narrower one leaves it.
+            circle(a.x2, a.y2, std::max(a.radius, b.radius));
+        }
+    }
+
+    double ox = 0;
+    double oy = 0;
+    double ex = 0;
+    double ey = 0;
+
+    // Left edge, forward
+    const Segment& first = segments.front();
+    first.offset(first.x1, first.y1, 1, 0, ox, oy);
+    moveTo(ox, oy);
+    for (size_t i = 0; i + 1 < n; i++) {
+        const Segment& a = segments[i];
+        const Segment& b = segments[i + 1];
+        a.offset(a.x2, a.y2, 1, -a.endInset, ex, ey);
+        b.offset(b.x1, b.y1, 1, b.startInset, ox, oy);
+        join(a.x2, a.y2, std::max(a.radius, b.radius), ex, ey, ox, oy);
+    }
+
+    const Segment& last = segments.back();
+    last.offset(last.x2, last.y2, 1, 0, ox, oy);
+    lineTo(ox, oy);
+    arc(last.x2, last.y2, last.radius, std::atan2(last.dx, -last.dy), -M_PI);
+
+    // Right edge, backward
+    for (size_t i = n - 1; i > 0; i--) {
+        const Segment& a = segments[i];
+        const Segment& b = segments[i - 1];
+        a.offset(a.x1, a.y1, -1, a.startInset, ex, ey);
+        b.offset(b.x2, b.y2, -1, -b.endInset, ox, oy);
+        join(a.x1, a.y1, std::max(a.radius, b.radius), ex, ey, ox, oy);
+    }
+
+    first.offset(first.x1, first.y1, -1, 0, ox, oy);
+    lineTo(ox, oy);
+    arc(first.x1, first.y1, first.radius, std::atan2(-first.dx, first.dy), -M_PI);
+    closePath();
+}
+
+auto StrokeOutline::getWidthFactor() const -> double { return this->widthFactor; }
+
+void StrokeOutline::appendPath(cairo_t* cr) const {
+    cairo_path_t path{CAIRO_STATUS_SUCCESS, const_cast<cairo_path_data_t*>(this->data.data()),
+                      static_cast<int>(this->data.size())};
+    cairo_append_path(cr, &path);
+}
+
+void StrokeOutline::join(double x, double y, double radius, double entryX, double entryY, double exitX,
+                         double exitY) {
+    lineTo(entryX, entryY);
+
+    double entryAngle = std::atan2(entryY - y, entryX - x);
+    double exitAngle = std::atan2(exitY - y, exitX - x);
+    double sweep = std::remainder(exitAngle - entryAngle, 2 * M_PI);
+    if (sweep <= 0) {
+        // Outer side
+        lineTo(x + radius * std::cos(entryAngle), y + radius * std::sin(entryAngle));
+        arc(x, y, radius, entryAngle, sweep);
+    } else {
+        // Inner side, the edges overlap
+        lineTo(x, y);
+    }
+
+    lineTo(exitX, exitY);
+}
+
+void StrokeOutline::arc(double cx, double cy, double radius, double angle, double sweep) {
+    int parts = std::max(1, static_cast<int>(std::ceil(std::abs(sweep) / MAX_BEZIER_ARC - 1e-9)));
+    double step = sweep / parts;
+    double handle = 4.0 / 3.0 * std::tan(step / 4) * radius;
+
+    double cosA = std::cos(angle);
+    double sinA = std::sin(angle);
+    for (int i = 1; i <= parts; i++) {
+        double b = angle + step * i;
+        double cosB = std::cos(b);
+        double sinB = std::sin(b);
+        curveTo(cx + radius * cosA - handle * sinA, cy + radius * sinA + handle * cosA,
+                cx + radius * cosB + handle * sinB, cy + radius * sinB - handle * cosB, cx + radius * cosB,
+                cy + radius * sinB);
+        cosA = cosB;
+        sinA = sinB;
+    }
+}
+
+void StrokeOutline::circle(double cx, double cy, double radius) {
+    if (radius <= 0) {
+        return;
+    }
+    moveTo(cx + radius, cy);
+    arc(cx, cy, radius, 0, -2 * M_PI);
+    closePath();
+}
+
+void StrokeOutline::moveTo(double x, double y) {
+    addHeader(CAIRO_PATH_MOVE_TO, 2);
+    addPoint(x, y);
+}
+
+void StrokeOutline::lineTo(double x, double y) {
+    addHeader(CAIRO_PATH_LINE_TO, 2);
+    addPoint(x, y);
+}
+
+void StrokeOutline::curveTo(double x1, double y1, double x2, double y2, double x3, double y3) {
+    addHeader(CAIRO_PATH_CURVE_TO, 4);
+    addPoint(x1, y1);
+    addPoint(x2, y2);
+    addPoint(x3, y3);
+}
+
+void StrokeOutline::closePath() { addHeader(CAIRO_PATH_CLOSE_PATH, 1); }
+
+void StrokeOutline::addHeader(cairo_path_data_type_t type, int length) {
+    cairo_path_data_t d;
+    d.header.type = type;
+    d.header.length = length;
+    this->data.push_back(d);
+}
+
+void StrokeOutline::addPoint(double x, double y) {
+    cairo_path_data_t d;
+    d.point.x = x;
+    d.point.y = y;
+    this->data.push_back(d);
+}
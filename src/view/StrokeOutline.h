@@ -0,0 +1,77 @@
+/*
+ * Xournal++
+ *
+ * Outline of a stroke with pressure, drawn with one fill
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <cairo.h>
+
+class StrokePoints;
+
+/**
+ * @brief The area covered by a stroke with pressure, as one closed cairo path
+ *
+ * Each segment of the stroke has its own width, the outline is the union of all segments drawn with round caps.
+ * It is built from the two offset curves of the stroke, connected by round joins and caps (approximated by
+ * bezier curves). Where a segment is too short for its neighbours, and at the joints where the width changes,
+ * the disk of the join is added as separate subpath. All subpaths have the same orientation, the path has to be filled with CAIRO_FILL_RULE_WINDING.
+ *
+ * The outline is immutable, it is cached in the StrokeRenderCache of the stroke.
+ */
+class StrokeOutline {
+public:
+    /**
+     * @param width The width of the segments without pressure
+     * @param widthFactor Factor applied to the width of all segments
+     */
+    StrokeOutline(const StrokePoints& points, double width, double widthFactor);
+
+public:
+    double getWidthFactor() const;
+
+    /**
+     * Appends the outline to the current path of cr
+     */
+    void appendPath(cairo_t* cr) const;
+
+private:
+    void moveTo(double x, double y);
+    void lineTo(double x, double y);
+    void curveTo(double x1, double y1, double x2, double y2, double x3, double y3);
+    void closePath();
+
+    /**
+     * Adds an arc starting at the current point, which has to be on the circle at the start angle
+     *
+     * @param sweep The angle of the arc, negative for counterclockwise (in the coordinate system of cairo)
+     */
+    void arc(double cx, double cy, double radius, double angle, double sweep);
+
+    /**
+     * Adds a closed circle with the same orientation as the outline
+     */
+    void circle(double cx, double cy, double radius);
+
+    /**
+     * Connects the edges of two segments at the point (x, y), the edges end at (entryX, entryY) and start
+     * at (exitX, exitY). The outer side is joined by an arc, the inner side through the point itself.
+     */
+    void join(double x, double y, double radius, double entryX, double entryY, double exitX, double exitY);
+
+    void addHeader(cairo_path_data_type_t type, int length);
+    void addPoint(double x, double y);
+
+private:
+    double widthFactor;
+
+    std::vector<cairo_path_data_t> data;
+};
@@ -0,0 +1,65 @@
+#include "StrokeRenderCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "model/Stroke.h"
+
+#include "StrokeOutline.h"
+
+namespace {
+
+/**
+ * Maximum deviation of the simplified points, in device pixels
+ */
+constexpr double TOLERANCE_PIXELS = 0.25;
+
+}  // namespace
+
+StrokeRenderCache::StrokeRenderCache(uint64_t revision): revision(revision) {}
+
+auto StrokeRenderCache::get(const Stroke& stroke) -> std::shared_ptr<StrokeRenderCache> {
+    std::shared_ptr<StrokeRenderCache> cache = stroke.getRenderCache();
+    if (cache && cache->revision == stroke.getRevision()) {
+        return cache;
+    }
+    return stroke.replaceRenderCache(cache, std::make_shared<StrokeRenderCache>(stroke.getRevision()));
+}
+
+auto StrokeRenderCache::getLevel(double pixelsPerUnit) -> int {
+    if (!(pixelsPerUnit > 0 && pixelsPerUnit < 1)) {
+        return FULL_DETAIL;
+    }
+
+    // Level n is used for pixelsPerUnit in [2^-(n+1), 2^-n)
+    auto level = static_cast<int>(std::floor(-std::log2(pixelsPerUnit)));
+    return std::min(level, LEVEL_COUNT - 1);
+}
+
+auto StrokeRenderCache::getPoints(const Stroke& stroke, int level) -> std::shared_ptr<const StrokePoints> {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return getPointsLocked(stroke, level);
+}
+
+auto StrokeRenderCache::getPointsLocked(const Stroke& stroke, int level) -> std::shared_ptr<const StrokePoints> {
+    std::shared_ptr<const StrokePoints>& cached = this->points[level];
+    if (!cached) {
+        // The largest scale of the level is 2^-level, the deviation stays below the tolerance there
+        double tolerance = TOLERANCE_PIXELS * std::ldexp(1.0, level);
+        cached = std::make_shared<const StrokePoints>(stroke.getPointData().simplify(tolerance));
+    }
+    return cached;
+}
+
+auto StrokeRenderCache::getOutline(const Stroke& stroke, int level, double widthFactor)
+        -> std::shared_ptr<const StrokeOutline> {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::shared_ptr<const StrokeOutline>& cached = this->outlines[level + 1];
+    if (!cached || cached->getWidthFactor() != widthFactor) {
+        const StrokePoints& levelPoints =
+                level == FULL_DETAIL ? stroke.getPointData() : *getPointsLocked(stroke, level);
+        cached = std::make_shared<const StrokeOutline>(levelPoints, stroke.getWidth(), widthFactor);
+    }
+    return cached;
+}
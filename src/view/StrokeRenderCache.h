@@ -0,0 +1,81 @@
+/*
+ * Xournal++
+ *
+ * Geometry cached for drawing a stroke
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+class Stroke;
+class StrokeOutline;
+class StrokePoints;
+
+/**
+ * @brief Geometry derived from the points of a stroke, kept by the stroke and replaced when it changes
+ *
+ * When zoomed out (overview, previews, thumbnails) many points of a stroke fall into one device pixel. For a few
+ * zoom levels, each half the scale of the previous one, the points are simplified (see StrokePoints::simplify)
+ * with a tolerance of a fraction of a device pixel. Also the outlines of strokes with pressure (see StrokeOutline)
+ * are cached per level.
+ *
+ * The pages are rendered by several threads, the levels are created on first use under a mutex. The cache is
+ * created for a revision of the stroke (see Stroke::getRevision()), the model does not know about the view.
+ */
+class StrokeRenderCache {
+public:
+    /**
+     * All points of the stroke, used when not zoomed out
+     */
+    static constexpr int FULL_DETAIL = -1;
+
+    static constexpr int LEVEL_COUNT = 6;
+
+    explicit StrokeRenderCache(uint64_t revision);
+
+    /**
+     * @return The cache of the stroke, created if there is none or it was created for an older revision
+     */
+    static std::shared_ptr<StrokeRenderCache> get(const Stroke& stroke);
+
+    /**
+     * @param pixelsPerUnit Device pixels per unit of the document
+     * @return The level of detail for drawing at this scale, or FULL_DETAIL
+     */
+    static int getLevel(double pixelsPerUnit);
+
+    /**
+     * @return The simplified points of the stroke for a level other than FULL_DETAIL
+     */
+    std::shared_ptr<const StrokePoints> getPoints(const Stroke& stroke, int level);
+
+    /**
+     * @param widthFactor See StrokeOutline, the outline is recreated if it was built with another factor
+     */
+    std::shared_ptr<const StrokeOutline> getOutline(const Stroke& stroke, int level, double widthFactor);
+
+private:
+    std::shared_ptr<const StrokePoints> getPointsLocked(const Stroke& stroke, int level);
+
+private:
+    /**
+     * The revision of the stroke the geometry was created from
+     */
+    uint64_t revision;
+
+    std::mutex mutex;
+
+    std::array<std::shared_ptr<const StrokePoints>, LEVEL_COUNT> points;
+
+    // Index 0 is FULL_DETAIL
+    std::array<std::shared_ptr<const StrokeOutline>, LEVEL_COUNT + 1> outlines;
+};
@@ -1,19 +1,50 @@
 #include "StrokeView.h"
 
+#include <cmath>
+#include <memory>
+
 #include "model/Stroke.h"
 #include "model/eraser/EraseableStroke.h"
-#include "util/LoopUtil.h"
 
 #include "DocumentView.h"
+#include "StrokeOutline.h"
+#include "StrokeRenderCache.h"
 
 StrokeView::StrokeView(cairo_t* cr, Stroke* s, int startPoint, double scaleFactor, bool noAlpha):
-        cr(cr), s(s), startPoint(startPoint), scaleFactor(scaleFactor), noAlpha(noAlpha) {}
+        cr(cr), s(s), startPoint(startPoint), scaleFactor(scaleFactor), noAlpha(noAlpha) {
+    double dx = 1;
+    double dy = 0;
+    cairo_user_to_device_distance(cr, &dx, &dy);
+    this->level = StrokeRenderCache::getLevel(std::hypot(dx, dy));
+}
 
+auto StrokeView::getPoints() -> const StrokePoints& {
+    if (this->level == StrokeRenderCache::FULL_DETAIL) {
+        return s->getPointData();
+    }
+
+    if (!this->levelPoints) {
+        this->levelPoints = StrokeRenderCache::get(*s)->getPoints(*s, this->level);
+    }
+    return *this->levelPoints;
+}
+
+void StrokeView::addStrokePath() {
+    const StrokePoints& points = getPoints();
+    if (points.empty()) {
+        return;
+    }
+
+    const double* x = points.getX();
+    const double* y = points.getY();
+    cairo_move_to(cr, x[0], y[0]);
+    for (size_t i = 1; i < points.size(); i++) {
+        cairo_line_to(cr, x[i], y[i]);
+    }
+}
 
 void StrokeView::drawFillStroke() {
-    for_first_then_each(
-            s->getPointVector(), [this](auto const& first) { cairo_move_to(this->cr, first.x, first.y); },
-            [this](auto const& other) { cairo_line_to(this->cr, other.x, other.y); });
+    addStrokePath();
 
     cairo_fill(cr);
 }
@@ -88,9 +119,7 @@ void StrokeView::drawNoPressure() {
     cairo_set_line_width(cr, width * scaleFactor);
     applyDashed(0);
 
-    for_first_then_each(
-            s->getPointVector(), [this](auto const& first) { cairo_move_to(cr, first.x, first.y); },
-            [this](auto const& other) { cairo_line_to(cr, other.x, other.y); });
+    addStrokePath();
     cairo_stroke(cr);
 
     if (group) {
@@ -106,21 +135,46 @@ void StrokeView::drawNoPressure() {
 }
 
 /**
- * Draw a stroke with pressure, for this multiple
- * lines with different widths needs to be drawn
+ * Draw a stroke with pressure, the outline of all segments is filled at once
  */
 void StrokeView::drawWithPressure() {
+    if (s->getLineStyle().hasDashes()) {
+        // The dash pattern is only known for stroked lines
+        drawDashedWithPressure();
+        return;
+    }
+
+    std::shared_ptr<const StrokeOutline> outline = StrokeRenderCache::get(*s)->getOutline(*s, this->level, scaleFactor);
+
+    cairo_new_path(cr);
+    outline->appendPath(cr);
+
+    cairo_fill_rule_t fillRule = cairo_get_fill_rule(cr);
+    cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+    cairo_fill(cr);
+    cairo_set_fill_rule(cr, fillRule);
+}
+
+/**
+ * Draw a dashed stroke with pressure, for this multiple
+ * lines with different widths needs to be drawn
+ */
+void StrokeView::drawDashedWithPressure() {
     double dashOffset = 0;
 
-    for (auto p1i = begin(s->getPointVector()), p2i = std::next(p1i), endi = end(s->getPointVector());
-         p1i != endi && p2i != endi; ++p1i, ++p2i) {
-        auto width = p1i->z != Point::NO_PRESSURE ? p1i->z : s->getWidth();
+    const StrokePoints& points = getPoints();
+    const double* x = points.getX();
+    const double* y = points.getY();
+    const double* pressure = points.getPressure();
+
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        auto width = pressure[i] != Point::NO_PRESSURE ? pressure[i] : s->getWidth();
         cairo_set_line_width(cr, width * scaleFactor);
         applyDashed(dashOffset);
-        cairo_move_to(cr, p1i->x, p1i->y);
-        cairo_line_to(cr, p2i->x, p2i->y);
+        cairo_move_to(cr, x[i], y[i]);
+        cairo_line_to(cr, x[i + 1], y[i + 1]);
         cairo_stroke(cr);
-        dashOffset += p1i->lineLengthTo(*p2i);
+        dashOffset += std::hypot(x[i + 1] - x[i], y[i + 1] - y[i]);
     }
 }
 
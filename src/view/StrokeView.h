@@ -11,9 +11,12 @@
 
 #pragma once
 
+#include <memory>
+
 #include <gtk/gtk.h>
 
 class Stroke;
+class StrokePoints;
 
 class StrokeView {
 public:
@@ -30,6 +33,15 @@ public:
     void changeCairoSource(bool markAudioStroke);
 
 private:
+    /**
+     * @return The points of the stroke, simplified if zoomed out (see StrokeRenderCache)
+     */
+    const StrokePoints& getPoints();
+
+    /**
+     * Adds the points of the stroke as path
+     */
+    void addStrokePath();
     void drawFillStroke();
     void applyDashed(double offset);
     static void drawEraseableStroke(cairo_t* cr, Stroke* s);
@@ -40,11 +52,16 @@ private:
     void drawNoPressure();
 
     /**
-     * Draw a stroke with pressure, for this multiple
-     * lines with different widths needs to be drawn
+     * Draw a stroke with pressure, the outline of all segments is filled at once
      */
     void drawWithPressure();
 
+    /**
+     * Draw a dashed stroke with pressure, for this multiple
+     * lines with different widths needs to be drawn
+     */
+    void drawDashedWithPressure();
+
 
 private:
     cairo_t* cr;
@@ -53,4 +70,10 @@ private:
     int startPoint;
     double scaleFactor;
     bool noAlpha;
+
+    /**
+     * Level of detail for the device scale of cr, see StrokeRenderCache
+     */
+    int level;
+    std::shared_ptr<const StrokePoints> levelPoints;
 };
@@ -1,5 +1,7 @@
 #include "TextView.h"
 
+#include <mutex>
+
 #include "control/settings/Settings.h"
 #include "model/Text.h"
 #include "pdf/base/XojPdfPage.h"
@@ -11,9 +13,40 @@ TextView::TextView() = default;
 
 TextView::~TextView() = default;
 
-static int textDpi = 72;
+namespace {
+
+int textDpi = 72;
+
+/**
+ * Guards the cached layouts of all Text models and their font map while they are shaped and measured. Pango font
+ * maps are not thread safe, but the layouts are used by all render threads.
+ */
+std::mutex layoutMutex;
+
+/**
+ * The context of the cached layouts, independent of the surface they are drawn to
+ */
+PangoContext* layoutContext = nullptr;
+int layoutContextDpi = 0;
+
+/**
+ * Texts are measured the same on screen, in the editor and in exports: without hinted metrics, which depend on the
+ * resolution of the target
+ */
+void setFontOptions(PangoContext* context) {
+    cairo_font_options_t* options = cairo_font_options_create();
+    cairo_font_options_set_hint_metrics(options, CAIRO_HINT_METRICS_OFF);
+    cairo_font_options_set_hint_style(options, CAIRO_HINT_STYLE_NONE);
+    pango_cairo_context_set_font_options(context, options);
+    cairo_font_options_destroy(options);
+}
+
+}  // namespace
 
-void TextView::setDpi(int dpi) { textDpi = dpi; }
+void TextView::setDpi(int dpi) {
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    textDpi = dpi;
+}
 
 auto TextView::initPango(cairo_t* cr, const Text* t) -> PangoLayout* {
     PangoLayout* layout = pango_cairo_create_layout(cr);
@@ -22,7 +55,9 @@ auto TextView::initPango(cairo_t* cr, const Text* t) -> PangoLayout* {
     // the next xournal release (with new fileformat...)
     // pango_layout_set_wrap
 
+    // Measured like the cached layouts, so the size does not change when the editor is closed
     pango_cairo_context_set_resolution(pango_layout_get_context(layout), textDpi);
+    setFontOptions(pango_layout_get_context(layout));
     pango_cairo_update_layout(cr, layout);
 
     pango_context_set_matrix(pango_layout_get_context(layout), nullptr);
@@ -38,37 +73,91 @@ void TextView::updatePangoFont(PangoLayout* layout, const Text* t) {
     pango_font_description_free(desc);
 }
 
+void TextView::invalidateLayout(const Text* t) {
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    t->layoutTextValid = false;
+}
+
+void TextView::releaseLayout(const Text* t) {
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    if (t->layout) {
+        g_object_unref(t->layout);
+        t->layout = nullptr;
+    }
+}
+
+auto TextView::getLayout(const Text* t) -> PangoLayout* {
+    if (layoutContext == nullptr || layoutContextDpi != textDpi) {
+        if (layoutContext) {
+            g_object_unref(layoutContext);
+        }
+
+        // Owns its font map, so the layouts never share fonts with the layouts of the widgets
+        PangoFontMap* fontMap = pango_cairo_font_map_new();
+        layoutContext = pango_font_map_create_context(fontMap);
+        g_object_unref(fontMap);
+
+        pango_cairo_context_set_resolution(layoutContext, textDpi);
+        setFontOptions(layoutContext);
+        layoutContextDpi = textDpi;
+    }
+
+    // The font may be changed in place with Text::getFont()
+    if (t->layout && pango_layout_get_context(t->layout) == layoutContext && t->layoutTextValid &&
+        t->layoutFontName == t->font.getName() && t->layoutFontSize == t->font.getSize()) {
+        return t->layout;
+    }
+
+    // A changed text gets a new layout, the old one may still be drawn by another thread
+    if (t->layout) {
+        g_object_unref(t->layout);
+    }
+
+    t->layout = pango_layout_new(layoutContext);
+    updatePangoFont(t->layout, t);
+    pango_layout_set_text(t->layout, t->text.c_str(), t->text.length());
+    t->layoutFontName = t->font.getName();
+    t->layoutFontSize = t->font.getSize();
+    t->layoutTextValid = true;
+
+    // Shapes the text and caches the extents of all lines, so drawing only reads the layout
+    PangoRectangle ink = {0};
+    PangoRectangle logical = {0};
+    pango_layout_get_extents(t->layout, &ink, &logical);
+
+    return t->layout;
+}
+
 void TextView::drawText(cairo_t* cr, const Text* t) {
-    cairo_save(cr);
+    PangoLayout* layout = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(layoutMutex);
+        layout = PANGO_LAYOUT(g_object_ref(getLayout(t)));
+    }
 
+    cairo_save(cr);
     cairo_translate(cr, t->getX(), t->getY());
 
-    PangoLayout* layout = initPango(cr, t);
-    string str = t->getText();
-    pango_layout_set_text(layout, str.c_str(), str.length());
-
+    // The layout is not changed anymore once it is shaped, so the glyphs are rasterized without the lock
     pango_cairo_show_layout(cr, layout);
 
-    g_object_unref(layout);
-
     cairo_restore(cr);
+
+    // Releasing the last reference frees its fonts, which changes the font map
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    g_object_unref(layout);
 }
 
 auto TextView::findText(const Text* t, string& search) -> vector<XojPdfRectangle> {
-    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
-    cairo_t* cr = cairo_create(surface);
-
-    PangoLayout* layout = initPango(cr, t);
-    string str = t->getText();
-    pango_layout_set_text(layout, str.c_str(), str.length());
-
-
     string text = t->getText();
 
     string srch = StringUtils::toLowerCase(search);
 
     vector<XojPdfRectangle> list;
 
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    PangoLayout* layout = getLayout(t);
+
     int pos = -1;
     do {
         pos = StringUtils::toLowerCase(text).find(srch, pos + 1);
@@ -87,27 +176,15 @@ auto TextView::findText(const Text* t, string& search) -> vector<XojPdfRectangle
         }
     } while (pos != -1);
 
-    g_object_unref(layout);
-    cairo_surface_destroy(surface);
-    cairo_destroy(cr);
-
     return list;
 }
 
 void TextView::calcSize(const Text* t, double& width, double& height) {
-    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
-    cairo_t* cr = cairo_create(surface);
+    std::lock_guard<std::mutex> lock(layoutMutex);
 
-    PangoLayout* layout = initPango(cr, t);
-    string str = t->getText();
-    pango_layout_set_text(layout, str.c_str(), str.length());
     int w = 0;
     int h = 0;
-    pango_layout_get_size(layout, &w, &h);
+    pango_layout_get_size(getLayout(t), &w, &h);
     width = (static_cast<double>(w)) / PANGO_SCALE;
     height = (static_cast<double>(h)) / PANGO_SCALE;
-    g_object_unref(layout);
-
-    cairo_surface_destroy(surface);
-    cairo_destroy(cr);
 }
@@ -23,6 +23,9 @@ private:
     virtual ~TextView();
 
 public:
+    /**
+     * Sets the resolution the texts are shaped with, the cached layouts are reshaped on their next use
+     */
     static void setDpi(int dpi);
 
     /**
@@ -41,7 +44,7 @@ public:
     static vector<XojPdfRectangle> findText(const Text* t, string& search);
 
     /**
-     * Initialize a Pango layout
+     * Initialize a Pango layout, e.g. for the text editor. Measures the text like the cached layouts.
      */
     static PangoLayout* initPango(cairo_t* cr, const Text* t);
 
@@ -49,4 +52,22 @@ public:
      * Sets the font name from Text model
      */
     static void updatePangoFont(PangoLayout* layout, const Text* t);
+
+    /**
+     * The text of the Text model changed, its cached layout is reshaped on the next use
+     */
+    static void invalidateLayout(const Text* t);
+
+    /**
+     * Frees the cached layout of the Text model
+     */
+    static void releaseLayout(const Text* t);
+
+private:
+    /**
+     * Returns the cached layout of the Text model, shaped with its current text, font and the text DPI.
+     * Has to be called with the layout lock held. The layout is never changed once it is returned, a reference
+     * to it can be drawn without the lock.
+     */
+    static PangoLayout* getLayout(const Text* t);
 };
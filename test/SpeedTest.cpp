@@ -10,48 +10,38 @@
  * @license GNU GPLv2 or later
  */
 
-#include <ctime>
-
-#include <StringUtils.h>
-using std::clock;
-#include <functional>
-using std::function;
+#include <chrono>
 #include <iostream>
-using std::cout;
-using std::endl;
 #include <string>
 
-#include <zconf.h>
+#include "benchmark/Benchmark.h"
 
+using std::cout;
+using std::endl;
 using std::string;
 
+/**
+ * Prints the runtime of a test, for detailed measurements use the benchmarks in test/benchmark
+ */
 class SpeedTest {
 
 public:
     void startTest(string target) {
         cout << endl << "== Speed test of " << target << " ==" << endl;
         this->target = target;
-        begin = clock();
+        begin = std::chrono::steady_clock::now();
     }
 
     void endTest() {
-        clock_t end = clock();
+        auto end = std::chrono::steady_clock::now();
 
-        printMemory();
+        cout << "Peak memory: " << Benchmark::getPeakRss() << " KiB" << endl;
 
-        double elapsed_secs = double(end - begin) / CLOCKS_PER_SEC;
+        double elapsed_secs = std::chrono::duration<double>(end - begin).count();
         cout << "Time to " << target << ": " << std::to_string(elapsed_secs) << endl;
     }
 
 private:
-    clock_t begin;
+    std::chrono::steady_clock::time_point begin;
     string target;
-
-    static void printMemory() {
-        string cmd = "bash -c \"cat /proc/";
-        cmd += std::to_string(::getpid()) + "/status | grep Vm\"";
-        if (system(cmd.c_str()) != 0) {
-            cout << "Error executing " << cmd.c_str() << endl;
-        };
-    }
 };
@@ -0,0 +1,134 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <fstream>
+
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+long Benchmark::earlierPeakRss = 0;
+
+Benchmark::Benchmark(std::string name, std::string unit, double itemsPerSample):
+        name(std::move(name)),
+        unit(std::move(unit)),
+        itemsPerSample(itemsPerSample) {
+    resetHighWaterMark();
+    this->startRss = getCurrentRss();
+    this->startPeakRss = getHighWaterMark();
+}
+
+Benchmark::~Benchmark() = default;
+
+void Benchmark::finish() {
+    // If the high-water mark grew, it was reached by this case. Otherwise the peak of the case is unknown (if the mark
+    // could not be reset), and what the case still holds is the best estimate.
+    long peak = getHighWaterMark();
+    long used = peak > this->startPeakRss ? peak : getCurrentRss();
+    this->peakRssIncrease = std::max(used - this->startRss, 0L);
+}
+
+auto Benchmark::getPeakRss() -> long { return std::max(earlierPeakRss, getHighWaterMark()); }
+
+void Benchmark::resetHighWaterMark() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    earlierPeakRss = getPeakRss();
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+#endif
+}
+
+auto Benchmark::getHighWaterMark() -> long {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    // Bytes on macOS, KiB everywhere else
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+auto Benchmark::getCurrentRss() -> long {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long>(counters.WorkingSetSize / 1024);
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) !=
+        KERN_SUCCESS) {
+        return 0;
+    }
+    return static_cast<long>(info.resident_size / 1024);
+#else
+    // Total and resident pages
+    long size = 0;
+    long resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (!(statm >> size >> resident)) {
+        return 0;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+}
+
+auto Benchmark::percentile(const std::vector<double>& sorted, double p) -> double {
+    if (sorted.empty()) {
+        return 0;
+    }
+    auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp(rank, static_cast<size_t>(1), sorted.size()) - 1];
+}
+
+void Benchmark::writeJson(std::ostream& out) const {
+    std::vector<double> sorted = this->samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+    double mean = sorted.empty() ? 0 : total / static_cast<double>(sorted.size());
+    double throughput = total > 0 ? this->itemsPerSample * static_cast<double>(sorted.size()) / total : 0;
+
+    // Latencies in ms
+    auto ms = [](double seconds) { return seconds * 1000.0; };
+
+    out << "    {\n";
+    out << "      \"name\": \"" << this->name << "\",\n";
+    out << "      \"samples\": " << sorted.size() << ",\n";
+    out << "      \"unit\": \"" << this->unit << "\",\n";
+    out << "      \"items_per_sample\": " << this->itemsPerSample << ",\n";
+    out << "      \"total_s\": " << total << ",\n";
+    out << "      \"throughput_per_s\": " << throughput << ",\n";
+    out << "      \"latency_ms\": {";
+    out << "\"min\": " << ms(sorted.empty() ? 0 : sorted.front()) << ", ";
+    out << "\"mean\": " << ms(mean) << ", ";
+    out << "\"p50\": " << ms(percentile(sorted, 50)) << ", ";
+    out << "\"p90\": " << ms(percentile(sorted, 90)) << ", ";
+    out << "\"p99\": " << ms(percentile(sorted, 99)) << ", ";
+    out << "\"max\": " << ms(sorted.empty() ? 0 : sorted.back()) << "},\n";
+    out << "      \"peak_rss_increase_kib\": " << this->peakRssIncrease << "\n";
+    out << "    }";
+}
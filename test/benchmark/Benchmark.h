@@ -0,0 +1,109 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal Benchmarks
+ * Measures the runtime of an operation
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Collects the runtime of the samples of one benchmark case
+ */
+class Benchmark {
+public:
+    /**
+     * Records the memory usage before the case, create the benchmark right before the first sample
+     *
+     * @param name The name of the case in the report
+     * @param unit What is processed by the case, e.g. "strokes" or "pages"
+     * @param itemsPerSample How many items are processed by one sample, for the throughput
+     */
+    Benchmark(std::string name, std::string unit, double itemsPerSample);
+    virtual ~Benchmark();
+
+public:
+    /**
+     * Runs the function once and adds its runtime as sample
+     */
+    template <typename Function>
+    void measure(Function&& function) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        this->samples.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    /**
+     * Records the memory used by the case, call after the last sample
+     */
+    void finish();
+
+    /**
+     * Writes the result as JSON object
+     */
+    void writeJson(std::ostream& out) const;
+
+    /**
+     * @return The peak resident set size of the process in KiB
+     */
+    static long getPeakRss();
+
+    /**
+     * @return The current resident set size of the process in KiB
+     */
+    static long getCurrentRss();
+
+private:
+    /**
+     * @return The peak resident set size in KiB since the start or the last resetHighWaterMark()
+     */
+    static long getHighWaterMark();
+
+    /**
+     * Resets the peak resident set size of the process to the current size, so the peak of a case can be measured.
+     * Only supported on Linux, getPeakRss() still returns the peak of the whole process.
+     */
+    static void resetHighWaterMark();
+
+    /**
+     * @return The runtime of the sample at the percentile in seconds, nearest rank
+     */
+    static double percentile(const std::vector<double>& sorted, double p);
+
+private:
+    std::string name;
+    std::string unit;
+    double itemsPerSample;
+
+    /**
+     * Runtime of each sample in seconds
+     */
+    std::vector<double> samples;
+
+    /**
+     * Resident set size and peak of the process when the case started, in KiB
+     */
+    long startRss = 0;
+    long startPeakRss = 0;
+
+    /**
+     * The peak of the process before the last resetHighWaterMark(), in KiB
+     */
+    static long earlierPeakRss;
+
+    /**
+     * Peak resident set size of the case over startRss, in KiB
+     */
+    long peakRssIncrease = 0;
+};
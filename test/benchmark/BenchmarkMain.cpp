@@ -0,0 +1,352 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal Benchmarks
+ *
+ * Measures loading, saving, rendering, erasing, selecting and PDF export of generated documents, and writes the
+ * results as JSON, so they can be compared between builds.
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+#include "control/ToolHandler.h"
+#include "control/settings/Settings.h"
+#include "control/tools/EraseHandler.h"
+#include "control/tools/Selection.h"
+#include "control/xojfile/LoadHandler.h"
+#include "control/xojfile/SaveHandler.h"
+#include "gui/Redrawable.h"
+#include "model/Document.h"
+#include "model/DocumentHandler.h"
+#include "pdf/base/XojCairoPdfExport.h"
+#include "undo/UndoRedoHandler.h"
+#include "view/DocumentView.h"
+
+#include "Benchmark.h"
+#include "DocumentGenerator.h"
+#include "StringUtils.h"
+#include "filesystem.h"
+
+namespace {
+
+/**
+ * Zoom of the render_overview case, about the scale of the sidebar previews
+ */
+constexpr double OVERVIEW_ZOOM = 0.15;
+
+/**
+ * The handlers need a view to repaint, there is nothing to repaint here
+ */
+class NullView: public Redrawable {
+public:
+    void repaintArea(double x1, double y1, double x2, double y2) override {}
+    void repaintPage() override {}
+    void rerenderPage() override {}
+    void rerenderRect(double x, double y, double width, double height) override {}
+    GdkRGBA getSelectionColor() override { return GdkRGBA{0, 0, 1, 1}; }
+    void deleteViewBuffer() override {}
+    int getX() const override { return 0; }
+    int getY() const override { return 0; }
+};
+
+struct BenchmarkConfig {
+    GeneratorOptions generator;
+    int iterations = 5;
+    double zoom = 1.0;
+    vector<string> cases;
+    fs::path workDir;
+};
+
+auto isEnabled(const BenchmarkConfig& config, const string& name) -> bool {
+    return config.cases.empty() || std::find(config.cases.begin(), config.cases.end(), name) != config.cases.end();
+}
+
+void benchmarkSave(const BenchmarkConfig& config, Document* doc, const DocumentGenerator& generator,
+                   vector<Benchmark>& results) {
+    Benchmark benchmark("save", "strokes", static_cast<double>(generator.getStrokeCount()));
+    fs::path file = config.workDir / "benchmark.xopp";
+
+    for (int i = 0; i < config.iterations; i++) {
+        benchmark.measure([&]() {
+            SaveHandler handler;
+            doc->lockShared();
+            handler.prepareSave(doc);
+            doc->unlockShared();
+            handler.saveTo(file);
+        });
+    }
+
+    benchmark.finish();
+    results.push_back(std::move(benchmark));
+}
+
+/**
+ * @param lazy Only measure opening the document, the layers of the pages are parsed when they are accessed
+ */
+void benchmarkLoad(const BenchmarkConfig& config, const DocumentGenerator& generator, bool lazy,
+                   vector<Benchmark>& results) {
+    string name = lazy ? "load_lazy" : "load";
+    Benchmark benchmark(name, "strokes", static_cast<double>(generator.getStrokeCount()));
+    fs::path file = config.workDir / "benchmark.xopp";
+
+    if (!fs::exists(file)) {
+        std::cerr << name << ": the saved document is missing, enable the save benchmark" << std::endl;
+        return;
+    }
+
+    for (int i = 0; i < config.iterations; i++) {
+        LoadHandler handler;
+        handler.setLazyLoadingEnabled(lazy);
+        benchmark.measure([&]() { handler.loadDocument(file); });
+        if (!handler.getLastError().empty()) {
+            std::cerr << name << ": " << handler.getLastError() << std::endl;
+        }
+    }
+
+    benchmark.finish();
+    results.push_back(std::move(benchmark));
+}
+
+void benchmarkRender(const BenchmarkConfig& config, Document* doc, const string& name, double zoom,
+                     vector<Benchmark>& results) {
+    Benchmark benchmark(name, "pages", 1);
+    DocumentView view;
+
+    for (int i = 0; i < config.iterations; i++) {
+        for (size_t p = 0; p < doc->getPageCount(); p++) {
+            PageRef page = doc->getPage(p);
+            cairo_surface_t* surface =
+                    cairo_image_surface_create(CAIRO_FORMAT_ARGB32, static_cast<int>(page->getWidth() * zoom),
+                                               static_cast<int>(page->getHeight() * zoom));
+            cairo_t* cr = cairo_create(surface);
+            cairo_scale(cr, zoom, zoom);
+
+            benchmark.measure([&]() { view.drawPage(page, cr, false); });
+
+            cairo_destroy(cr);
+            cairo_surface_destroy(surface);
+        }
+    }
+
+    benchmark.finish();
+    results.push_back(std::move(benchmark));
+}
+
+void benchmarkErase(const BenchmarkConfig& config, Document* doc, DocumentGenerator& generator,
+                    vector<Benchmark>& results) {
+    Benchmark eraseBenchmark("erase", "events", 1);
+    Benchmark finalizeBenchmark("erase_finalize", "sweeps", 1);
+
+    Settings settings(config.workDir / "settings.xml");
+    ToolHandler toolHandler(nullptr, nullptr, &settings);
+    toolHandler.selectTool(TOOL_ERASER);
+    toolHandler.setEraserType(ERASER_TYPE_DEFAULT);
+
+    NullView view;
+
+    for (int i = 0; i < config.iterations; i++) {
+        // Erasing changes the document, start each iteration with the same document
+        generator.generate(doc);
+        PageRef page = doc->getPage(0);
+
+        UndoRedoHandler undo(nullptr);
+        EraseHandler handler(&undo, doc, page, &toolHandler, &view);
+
+        // Sweeps over the page, like an eraser used on a tablet
+        for (double y = 50; y < page->getHeight(); y += 100) {
+            for (double x = 0; x < page->getWidth(); x += 2) {
+                eraseBenchmark.measure([&]() { handler.erase(x, y); });
+            }
+        }
+
+        finalizeBenchmark.measure([&]() { handler.finalize(); });
+    }
+
+    eraseBenchmark.finish();
+    finalizeBenchmark.finish();
+    results.push_back(std::move(eraseBenchmark));
+    results.push_back(std::move(finalizeBenchmark));
+
+    // Restore the document for the following cases
+    generator.generate(doc);
+}
+
+void benchmarkSelect(const BenchmarkConfig& config, Document* doc, vector<Benchmark>& results) {
+    Benchmark benchmark("select", "pages", 1);
+    NullView view;
+
+    for (int i = 0; i < config.iterations; i++) {
+        for (size_t p = 0; p < doc->getPageCount(); p++) {
+            PageRef page = doc->getPage(p);
+
+            // Select the center of the page
+            RectSelection selection(page->getWidth() / 4, page->getHeight() / 4, &view);
+            selection.currentPos(page->getWidth() * 3 / 4, page->getHeight() * 3 / 4);
+
+            benchmark.measure([&]() { selection.finalize(page); });
+        }
+    }
+
+    benchmark.finish();
+    results.push_back(std::move(benchmark));
+}
+
+void benchmarkPdfExport(const BenchmarkConfig& config, Document* doc, vector<Benchmark>& results) {
+    Benchmark benchmark("export_pdf", "pages", static_cast<double>(doc->getPageCount()));
+    fs::path file = config.workDir / "benchmark.pdf";
+
+    for (int i = 0; i < config.iterations; i++) {
+        XojCairoPdfExport pdfExport(doc, nullptr);
+        benchmark.measure([&]() { pdfExport.createPdf(file, false); });
+    }
+
+    benchmark.finish();
+    results.push_back(std::move(benchmark));
+}
+
+void writeReport(std::ostream& out, const BenchmarkConfig& config, const vector<Benchmark>& results) {
+    const GeneratorOptions& gen = config.generator;
+
+    out << "{\n";
+    out << "  \"config\": {";
+    out << "\"pages\": " << gen.pages << ", ";
+    out << "\"strokes_per_page\": " << gen.strokesPerPage << ", ";
+    out << "\"points_per_stroke\": " << gen.pointsPerStroke << ", ";
+    out << "\"pressure\": " << (gen.pressure ? "true" : "false") << ", ";
+    out << "\"images_per_page\": " << gen.imagesPerPage << ", ";
+    out << "\"texts_per_page\": " << gen.textsPerPage << ", ";
+    out << "\"seed\": " << gen.seed << ", ";
+    out << "\"iterations\": " << config.iterations << ", ";
+    out << "\"zoom\": " << config.zoom << "},\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        results[i].writeJson(out);
+        out << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n";
+    out << "  \"peak_rss_kib\": " << Benchmark::getPeakRss() << "\n";
+    out << "}\n";
+}
+
+}  // namespace
+
+/**
+ * Entry point of the benchmarks
+ */
+auto main(int argc, char* argv[]) -> int {
+    BenchmarkConfig config;
+    gboolean noPressure = false;
+    gint seed = static_cast<gint>(config.generator.seed);
+    gchar* cases = nullptr;
+    gchar* output = nullptr;
+
+    std::array options = {
+            GOptionEntry{"pages", 0, 0, G_OPTION_ARG_INT, &config.generator.pages, "Number of pages", "N"},
+            GOptionEntry{"strokes", 0, 0, G_OPTION_ARG_INT, &config.generator.strokesPerPage, "Strokes per page", "N"},
+            GOptionEntry{"points", 0, 0, G_OPTION_ARG_INT, &config.generator.pointsPerStroke, "Points per stroke",
+                         "N"},
+            GOptionEntry{"no-pressure", 0, 0, G_OPTION_ARG_NONE, &noPressure, "Strokes without pressure", nullptr},
+            GOptionEntry{"images", 0, 0, G_OPTION_ARG_INT, &config.generator.imagesPerPage, "Images per page", "N"},
+            GOptionEntry{"texts", 0, 0, G_OPTION_ARG_INT, &config.generator.textsPerPage, "Texts per page", "N"},
+            GOptionEntry{"seed", 0, 0, G_OPTION_ARG_INT, &seed, "Seed of the generated document", "N"},
+            GOptionEntry{"iterations", 0, 0, G_OPTION_ARG_INT, &config.iterations, "Iterations of each case", "N"},
+            GOptionEntry{"zoom", 0, 0, G_OPTION_ARG_DOUBLE, &config.zoom, "Zoom of the render case", "ZOOM"},
+            GOptionEntry{"cases", 0, 0, G_OPTION_ARG_STRING, &cases,
+                         "Comma separated cases to run: save, load, load_lazy, render, render_overview, erase, select, "
+                         "export_pdf",
+                         "CASES"},
+            GOptionEntry{"output", 'o', 0, G_OPTION_ARG_FILENAME, &output, "Write the JSON report to FILE", "FILE"},
+            GOptionEntry{nullptr}};  // Must be terminated by a nullptr
+
+    GOptionContext* context = g_option_context_new("- benchmarks of Xournal++");
+    g_option_context_add_main_entries(context, options.data(), nullptr);
+    GError* error = nullptr;
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        std::cerr << error->message << std::endl;
+        g_error_free(error);
+        g_option_context_free(context);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    config.generator.pressure = !noPressure;
+    config.generator.seed = static_cast<uint32_t>(seed);
+    if (cases) {
+        config.cases = StringUtils::split(cases, ',');
+        g_free(cases);
+    }
+
+    gchar* workDir = g_dir_make_tmp("xournalpp-benchmark-XXXXXX", nullptr);
+    config.workDir = workDir;
+    g_free(workDir);
+
+    DocumentHandler documentHandler;
+    Document doc(&documentHandler);
+    DocumentGenerator generator(config.generator);
+    generator.generate(&doc);
+
+    vector<Benchmark> results;
+    if (isEnabled(config, "save") || isEnabled(config, "load") || isEnabled(config, "load_lazy")) {
+        std::cerr << "Running save" << std::endl;
+        benchmarkSave(config, &doc, generator, results);
+        if (!isEnabled(config, "save")) {
+            // Only needed to create the file for loading
+            results.pop_back();
+        }
+    }
+    if (isEnabled(config, "load")) {
+        std::cerr << "Running load" << std::endl;
+        benchmarkLoad(config, generator, false, results);
+    }
+    if (isEnabled(config, "load_lazy")) {
+        std::cerr << "Running load_lazy" << std::endl;
+        benchmarkLoad(config, generator, true, results);
+    }
+    if (isEnabled(config, "render")) {
+        std::cerr << "Running render" << std::endl;
+        benchmarkRender(config, &doc, "render", config.zoom, results);
+    }
+    if (isEnabled(config, "render_overview")) {
+        // The iterations after the first one draw the cached simplified strokes
+        std::cerr << "Running render_overview" << std::endl;
+        benchmarkRender(config, &doc, "render_overview", OVERVIEW_ZOOM, results);
+    }
+    if (isEnabled(config, "erase")) {
+        std::cerr << "Running erase" << std::endl;
+        benchmarkErase(config, &doc, generator, results);
+    }
+    if (isEnabled(config, "select")) {
+        std::cerr << "Running select" << std::endl;
+        benchmarkSelect(config, &doc, results);
+    }
+    if (isEnabled(config, "export_pdf")) {
+        std::cerr << "Running export_pdf" << std::endl;
+        benchmarkPdfExport(config, &doc, results);
+    }
+
+    if (output) {
+        std::ofstream out(output);
+        writeReport(out, config, results);
+        g_free(output);
+    } else {
+        writeReport(std::cout, config, results);
+    }
+
+    std::error_code ec;
+    fs::remove_all(config.workDir, ec);
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "DocumentGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "model/Image.h"
+#include "model/Layer.h"
+#include "model/Stroke.h"
+#include "model/Text.h"
+#include "model/XojPage.h"
+
+namespace {
+
+// A4 in points
+constexpr double PAGE_WIDTH = 595.275591;
+constexpr double PAGE_HEIGHT = 841.889764;
+
+constexpr int IMAGE_SIZE = 256;
+
+auto createImageSurface(std::mt19937& random) -> cairo_surface_t* {
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, IMAGE_SIZE, IMAGE_SIZE);
+    cairo_t* cr = cairo_create(surface);
+
+    // A gradient with some noise, so the PNG compression has some work to do
+    cairo_pattern_t* gradient = cairo_pattern_create_linear(0, 0, IMAGE_SIZE, IMAGE_SIZE);
+    cairo_pattern_add_color_stop_rgb(gradient, 0, 0.2, 0.4, 0.8);
+    cairo_pattern_add_color_stop_rgb(gradient, 1, 0.9, 0.6, 0.1);
+    cairo_set_source(cr, gradient);
+    cairo_paint(cr);
+    cairo_pattern_destroy(gradient);
+
+    std::uniform_real_distribution<double> coordinate(0, IMAGE_SIZE);
+    for (int i = 0; i < 200; i++) {
+        cairo_set_source_rgba(cr, 0, 0, 0, 0.3);
+        cairo_arc(cr, coordinate(random), coordinate(random), 3, 0, 2 * M_PI);
+        cairo_fill(cr);
+    }
+
+    cairo_destroy(cr);
+    return surface;
+}
+
+}  // namespace
+
+DocumentGenerator::DocumentGenerator(const GeneratorOptions& options): options(options) {}
+
+DocumentGenerator::~DocumentGenerator() = default;
+
+void DocumentGenerator::generate(Document* doc) {
+    std::mt19937 random(this->options.seed);
+    std::uniform_real_distribution<double> xDist(20, PAGE_WIDTH - 20);
+    std::uniform_real_distribution<double> yDist(20, PAGE_HEIGHT - 20);
+    std::uniform_real_distribution<double> angleDist(0, 2 * M_PI);
+    std::uniform_real_distribution<double> unit(0, 1);
+    const Color colors[] = {Color{0x000000U}, Color{0x3333CCU}, Color{0xFF0000U}, Color{0x008000U}};
+
+    doc->lock();
+    doc->clearDocument();
+
+    for (int p = 0; p < this->options.pages; p++) {
+        auto page = std::make_shared<XojPage>(PAGE_WIDTH, PAGE_HEIGHT);
+        page->setBackgroundType(PageType(PageTypeFormat::Lined));
+
+        auto* layer = new Layer();
+
+        for (int s = 0; s < this->options.strokesPerPage; s++) {
+            auto* stroke = new Stroke();
+            stroke->setColor(colors[s % 4]);
+            stroke->setWidth(1.41);
+            stroke->setToolType(STROKE_TOOL_PEN);
+
+            // Handwriting like strokes: short, slowly turning segments
+            double x = xDist(random);
+            double y = yDist(random);
+            double angle = angleDist(random);
+            for (int i = 0; i < this->options.pointsPerStroke; i++) {
+                angle += (unit(random) - 0.5) * 0.8;
+                x = std::clamp(x + std::cos(angle) * 1.5, 0.0, PAGE_WIDTH);
+                y = std::clamp(y + std::sin(angle) * 1.5, 0.0, PAGE_HEIGHT);
+
+                if (this->options.pressure) {
+                    stroke->addPoint(Point(x, y, 0.3 + 0.7 * unit(random)));
+                } else {
+                    stroke->addPoint(Point(x, y));
+                }
+            }
+
+            layer->addElement(stroke);
+        }
+
+        for (int i = 0; i < this->options.imagesPerPage; i++) {
+            auto* image = new Image();
+            image->setImage(createImageSurface(random));
+            image->setX(xDist(random) / 2);
+            image->setY(yDist(random) / 2);
+            image->setWidth(IMAGE_SIZE / 2.0);
+            image->setHeight(IMAGE_SIZE / 2.0);
+            layer->addElement(image);
+        }
+
+        for (int i = 0; i < this->options.textsPerPage; i++) {
+            auto* text = new Text();
+            text->setText("The quick brown fox jumps over the lazy dog " + std::to_string(i));
+            text->setX(xDist(random) / 2);
+            text->setY(yDist(random));
+            text->setColor(colors[i % 4]);
+            layer->addElement(text);
+        }
+
+        page->addLayer(layer);
+        doc->addPage(page);
+    }
+
+    doc->unlock();
+}
+
+auto DocumentGenerator::getStrokeCount() const -> size_t {
+    return static_cast<size_t>(this->options.pages) * static_cast<size_t>(this->options.strokesPerPage);
+}
+
+auto DocumentGenerator::getElementCount() const -> size_t {
+    return static_cast<size_t>(this->options.pages) *
+           static_cast<size_t>(this->options.strokesPerPage + this->options.imagesPerPage + this->options.textsPerPage);
+}
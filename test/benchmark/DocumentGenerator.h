@@ -0,0 +1,68 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal Benchmarks
+ * Generates synthetic documents
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "model/Document.h"
+
+/**
+ * The content of the generated document
+ */
+struct GeneratorOptions {
+    int pages = 20;
+    int strokesPerPage = 500;
+    int pointsPerStroke = 60;
+
+    /**
+     * Generate strokes with pressure values
+     */
+    bool pressure = true;
+
+    int imagesPerPage = 1;
+    int textsPerPage = 5;
+
+    /**
+     * Seed of the random generator, the same seed generates the same document
+     */
+    uint32_t seed = 42;
+};
+
+class DocumentGenerator {
+public:
+    explicit DocumentGenerator(const GeneratorOptions& options);
+    virtual ~DocumentGenerator();
+
+private:
+    DocumentGenerator(const DocumentGenerator& generator);
+    void operator=(const DocumentGenerator& generator);
+
+public:
+    /**
+     * Replaces the content of the document with generated pages
+     */
+    void generate(Document* doc);
+
+    /**
+     * @return The number of strokes of a generated document
+     */
+    size_t getStrokeCount() const;
+
+    /**
+     * @return The number of elements of a generated document
+     */
+    size_t getElementCount() const;
+
+private:
+    GeneratorOptions options;
+};
@@ -0,0 +1,235 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "control/CrashJournal.h"
+#include "control/CrashJournalFile.h"
+#include "model/Layer.h"
+#include "model/Stroke.h"
+#include "model/XojPage.h"
+
+#include "filesystem.h"
+
+class CrashJournalTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(CrashJournalTest);
+
+    CPPUNIT_TEST(testWriteAndRead);
+    CPPUNIT_TEST(testCutOffRecord);
+    CPPUNIT_TEST(testCompaction);
+    CPPUNIT_TEST(testLockedJournalSkipped);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+        this->folder = fs::temp_directory_path() / "xournalpp-crash-journal-test";
+        fs::remove_all(this->folder);
+        fs::create_directories(this->folder);
+        this->file = this->folder / "1-1.journal";
+    }
+
+    void tearDown() { fs::remove_all(this->folder); }
+
+    void testWriteAndRead() {
+        XojPage first(100, 100);
+        addLayer(first, "", 3);
+        addLayer(first, "Named", 1);
+        XojPage second(100, 100);
+        addLayer(second, "", 5);
+
+        {
+            CrashJournalFile journal(this->file);
+            CPPUNIT_ASSERT(journal.open({"base.xopp", "document.xopp", 3}));
+            appendPage(journal, 3, 0, first);
+            appendPage(journal, 3, 1, second);
+        }
+
+        CrashJournalFile::Header header;
+        std::vector<CrashJournalFile::Record> records;
+        std::string error;
+        CPPUNIT_ASSERT(CrashJournalFile::read(this->file, header, records, error));
+        CPPUNIT_ASSERT(header.base == "base.xopp");
+        CPPUNIT_ASSERT(header.documentPath == "document.xopp");
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(3), header.baseGeneration);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), records.size());
+        checkRecord(records[0], 3, 0, first);
+        checkRecord(records[1], 3, 1, second);
+    }
+
+    void testCutOffRecord() {
+        XojPage page(100, 100);
+        addLayer(page, "", 2);
+
+        uint64_t complete = 0;
+        {
+            CrashJournalFile journal(this->file);
+            CPPUNIT_ASSERT(journal.open({"base.xopp", "", 1}));
+            appendPage(journal, 1, 0, page);
+            complete = journal.getSize();
+            appendPage(journal, 1, 1, page);
+        }
+
+        // The last record was only written partially when the instance crashed
+        fs::resize_file(this->file, complete + 10);
+
+        CrashJournalFile::Header header;
+        std::vector<CrashJournalFile::Record> records;
+        std::string error;
+        CPPUNIT_ASSERT(CrashJournalFile::read(this->file, header, records, error));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), records.size());
+        checkRecord(records[0], 1, 0, page);
+
+        // Without a complete header, there is nothing to restore
+        fs::resize_file(this->file, 3);
+        records.clear();
+        CPPUNIT_ASSERT(!CrashJournalFile::read(this->file, header, records, error));
+        CPPUNIT_ASSERT(!error.empty());
+    }
+
+    void testCompaction() {
+        XojPage before(100, 100);
+        addLayer(before, "", 1);
+        XojPage after(100, 100);
+        addLayer(after, "", 2);
+        XojPage last(100, 100);
+        addLayer(last, "", 3);
+
+        CrashJournalFile journal(this->file);
+        CPPUNIT_ASSERT(journal.open({"document.xopp", "document.xopp", 1}));
+        appendPage(journal, 1, 0, before);
+
+        // The autosave takes its snapshot here, the record after it may not be part of the autosave
+        uint64_t mark = journal.getSize();
+        appendPage(journal, 2, 1, after);
+
+        journal.rewrite({"autosave.xopp", "document.xopp", 2}, mark);
+        CPPUNIT_ASSERT_EQUAL(journal.getSize() - journal.getHeaderSize(), journal.getRecordSize());
+
+        // Records are appended to the compacted journal
+        appendPage(journal, 2, 2, last);
+
+        CrashJournalFile::Header header;
+        std::vector<CrashJournalFile::Record> records;
+        std::string error;
+        CPPUNIT_ASSERT(CrashJournalFile::read(this->file, header, records, error));
+        CPPUNIT_ASSERT(header.base == "autosave.xopp");
+        CPPUNIT_ASSERT(header.documentPath == "document.xopp");
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(2), header.baseGeneration);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), records.size());
+        checkRecord(records[0], 2, 1, after);
+        checkRecord(records[1], 2, 2, last);
+
+        journal.remove();
+        CPPUNIT_ASSERT(!fs::exists(this->file));
+    }
+
+    void testLockedJournalSkipped() {
+        std::ofstream(this->file) << "journal";
+
+        // A lock file of an instance which crashed before writing its journal
+        fs::path staleLock = this->folder / "2-2.journal.lock";
+        std::ofstream(staleLock) << "";
+
+        {
+            // Held by a running instance
+            std::unique_ptr<CrashJournal::Lock> lock = CrashJournal::Lock::tryLock(this->file);
+            CPPUNIT_ASSERT(lock != nullptr);
+            CPPUNIT_ASSERT(CrashJournal::Lock::tryLock(this->file) == nullptr);
+            CPPUNIT_ASSERT(CrashJournal::findJournals(this->folder).empty());
+        }
+        CPPUNIT_ASSERT(!fs::exists(staleLock));
+
+        // Released, e.g. as the instance crashed
+        auto journals = CrashJournal::findJournals(this->folder);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), journals.size());
+        CPPUNIT_ASSERT(journals[0]->getJournal() == this->file);
+
+        // Found journals stay locked until they are restored or deleted
+        CPPUNIT_ASSERT(CrashJournal::findJournals(this->folder).empty());
+
+        journals[0]->removeJournal();
+        journals.clear();
+        CPPUNIT_ASSERT(!fs::exists(this->file));
+        CPPUNIT_ASSERT(fs::is_empty(this->folder));
+    }
+
+private:
+    static void addLayer(XojPage& page, const std::string& name, int strokeCount) {
+        auto* layer = new Layer();
+        if (!name.empty()) {
+            layer->setName(name);
+        }
+        for (int i = 0; i < strokeCount; i++) {
+            auto* stroke = new Stroke();
+            stroke->setWidth(1.5);
+            for (int p = 0; p < 10; p++) {
+                stroke->addPoint(Point(i * 10 + p, p * p, 0.5 + p / 10.0));
+            }
+            layer->addElement(stroke);
+        }
+        // XojPage::addLayer() is only used by the LayerController, the page is not shown here
+        page.getLayers()->push_back(layer);
+        layer->setPage(&page);
+    }
+
+    static void appendPage(CrashJournalFile& journal, uint64_t generation, size_t pageIndex, XojPage& page) {
+        GString* data = CrashJournalFile::serializePage(generation, pageIndex, page);
+        journal.append(data);
+        g_string_free(data, true);
+    }
+
+    static void checkRecord(const CrashJournalFile::Record& record, uint64_t generation, size_t pageIndex,
+                            XojPage& page) {
+        CPPUNIT_ASSERT_EQUAL(generation, record.generation);
+        CPPUNIT_ASSERT_EQUAL(pageIndex, record.pageIndex);
+        CPPUNIT_ASSERT_EQUAL(page.getLayers()->size(), record.layers.size());
+
+        for (size_t l = 0; l < record.layers.size(); l++) {
+            Layer* expected = (*page.getLayers())[l];
+            Layer* actual = record.layers[l].get();
+            CPPUNIT_ASSERT_EQUAL(expected->hasName(), actual->hasName());
+            if (expected->hasName()) {
+                CPPUNIT_ASSERT_EQUAL(expected->getName(), actual->getName());
+            }
+
+            CPPUNIT_ASSERT_EQUAL(expected->getElements()->size(), actual->getElements()->size());
+            for (size_t e = 0; e < actual->getElements()->size(); e++) {
+                auto* expectedStroke = dynamic_cast<Stroke*>((*expected->getElements())[e]);
+                auto* actualStroke = dynamic_cast<Stroke*>((*actual->getElements())[e]);
+                CPPUNIT_ASSERT(actualStroke != nullptr);
+                CPPUNIT_ASSERT_EQUAL(expectedStroke->getWidth(), actualStroke->getWidth());
+
+                std::vector<Point> expectedPoints = expectedStroke->getPointVector();
+                std::vector<Point> actualPoints = actualStroke->getPointVector();
+                CPPUNIT_ASSERT_EQUAL(expectedPoints.size(), actualPoints.size());
+                for (size_t p = 0; p < actualPoints.size(); p++) {
+                    CPPUNIT_ASSERT_EQUAL(expectedPoints[p].x, actualPoints[p].x);
+                    CPPUNIT_ASSERT_EQUAL(expectedPoints[p].y, actualPoints[p].y);
+                    CPPUNIT_ASSERT_EQUAL(expectedPoints[p].z, actualPoints[p].z);
+                }
+            }
+        }
+    }
+
+private:
+    fs::path folder;
+    fs::path file;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CrashJournalTest);
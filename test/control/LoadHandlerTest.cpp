@@ -12,6 +12,7 @@
 #include <config-test.h>
 
 #include "control/xojfile/LoadHandler.h"
+#include "control/xojfile/SaveCache.h"
 #include "control/xojfile/SaveHandler.h"
 #include "util/PathUtil.h"
 
@@ -20,10 +21,12 @@
 #endif
 
 #include <cmath>
+#include <fstream>
 #include <iostream>
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "GzUtil.h"
 #include "filesystem.h"
 
 class LoadHandlerTest: public CppUnit::TestFixture {
@@ -48,6 +51,12 @@ class LoadHandlerTest: public CppUnit::TestFixture {
     CPPUNIT_TEST(testStroke);
     CPPUNIT_TEST(loadImage);
     CPPUNIT_TEST(testLoadStoreLoad);
+    CPPUNIT_TEST(testFastParser);
+    CPPUNIT_TEST(testFastParserFallback);
+    CPPUNIT_TEST(testLazyLoading);
+    CPPUNIT_TEST(testLazyLoadingSaveUnloaded);
+    CPPUNIT_TEST(testLazyLoadingSaveUnparsed);
+    CPPUNIT_TEST(testSaveCacheElementsReinserted);
 
 #ifdef __linux__
     CPPUNIT_TEST(testLoadStoreLoadGerman);
@@ -383,6 +392,245 @@ public:
         }
     }
 
+    void compareDocuments(Document* a, Document* b) {
+        CPPUNIT_ASSERT(a != nullptr);
+        CPPUNIT_ASSERT(b != nullptr);
+        CPPUNIT_ASSERT_EQUAL(a->getPageCount(), b->getPageCount());
+
+        for (size_t p = 0; p < a->getPageCount(); p++) {
+            PageRef pageA = a->getPage(p);
+            PageRef pageB = b->getPage(p);
+            CPPUNIT_ASSERT_EQUAL(pageA->getWidth(), pageB->getWidth());
+            CPPUNIT_ASSERT_EQUAL(pageA->getHeight(), pageB->getHeight());
+            CPPUNIT_ASSERT(pageA->getBackgroundType() == pageB->getBackgroundType());
+            CPPUNIT_ASSERT_EQUAL(pageA->getBackgroundColor(), pageB->getBackgroundColor());
+            CPPUNIT_ASSERT_EQUAL(pageA->getLayerCount(), pageB->getLayerCount());
+
+            for (size_t l = 0; l < pageA->getLayerCount(); l++) {
+                Layer* layerA = (*pageA->getLayers())[l];
+                Layer* layerB = (*pageB->getLayers())[l];
+                CPPUNIT_ASSERT_EQUAL(layerA->getName(), layerB->getName());
+                CPPUNIT_ASSERT_EQUAL(layerA->getElements()->size(), layerB->getElements()->size());
+
+                for (size_t i = 0; i < layerA->getElements()->size(); i++) {
+                    Element* elemA = (*layerA->getElements())[i];
+                    Element* elemB = (*layerB->getElements())[i];
+                    CPPUNIT_ASSERT_EQUAL(elemA->getType(), elemB->getType());
+                    CPPUNIT_ASSERT_EQUAL(elemA->getColor(), elemB->getColor());
+                    CPPUNIT_ASSERT_EQUAL(elemA->getX(), elemB->getX());
+                    CPPUNIT_ASSERT_EQUAL(elemA->getY(), elemB->getY());
+                    CPPUNIT_ASSERT_EQUAL(elemA->getElementWidth(), elemB->getElementWidth());
+                    CPPUNIT_ASSERT_EQUAL(elemA->getElementHeight(), elemB->getElementHeight());
+
+                    if (elemA->getType() == ELEMENT_STROKE) {
+                        auto* sA = dynamic_cast<Stroke*>(elemA);
+                        auto* sB = dynamic_cast<Stroke*>(elemB);
+                        CPPUNIT_ASSERT_EQUAL(sA->getWidth(), sB->getWidth());
+                        CPPUNIT_ASSERT_EQUAL(sA->getToolType(), sB->getToolType());
+                        CPPUNIT_ASSERT_EQUAL(sA->getPointCount(), sB->getPointCount());
+                        for (int j = 0; j < sA->getPointCount(); j++) {
+                            Point pA = sA->getPoint(j);
+                            Point pB = sB->getPoint(j);
+                            CPPUNIT_ASSERT_EQUAL(pA.x, pB.x);
+                            CPPUNIT_ASSERT_EQUAL(pA.y, pB.y);
+                            CPPUNIT_ASSERT_EQUAL(pA.z, pB.z);
+                        }
+                    } else if (elemA->getType() == ELEMENT_TEXT) {
+                        CPPUNIT_ASSERT_EQUAL(dynamic_cast<Text*>(elemA)->getText(),
+                                             dynamic_cast<Text*>(elemB)->getText());
+                    }
+                }
+            }
+        }
+    }
+
+    void testFastParser() {
+        const char* files[] = {"test1.xoj",
+                               "test1.unzipped.xoj",
+                               "load/pages.xoj",
+                               "load/layer.xoj",
+                               "load/text.xml",
+                               "packaged_xopp/test.xopp",
+                               "packaged_xopp/pages.xopp",
+                               "packaged_xopp/layer.xopp",
+                               "packaged_xopp/text.xopp",
+                               "packaged_xopp/suite.xopp"};
+
+        for (const char* file: files) {
+            LoadHandler fastHandler;
+            Document* fastDoc = fastHandler.loadDocument(string(GET_TESTFILE("")) + file);
+            CPPUNIT_ASSERT(fastHandler.isFastParserUsed());
+
+            LoadHandler handler;
+            handler.setFastParserEnabled(false);
+            Document* doc = handler.loadDocument(string(GET_TESTFILE("")) + file);
+            CPPUNIT_ASSERT(!handler.isFastParserUsed());
+
+            compareDocuments(fastDoc, doc);
+        }
+    }
+
+    void testFastParserFallback() {
+        // The fast parser does not support DTDs
+        LoadHandler handler;
+        Document* doc = handler.loadDocument(GET_TESTFILE("load/doctype.xml"));
+        CPPUNIT_ASSERT(!handler.isFastParserUsed());
+
+        CPPUNIT_ASSERT_EQUAL((size_t)1, doc->getPageCount());
+        PageRef page = doc->getPage(0);
+
+        CPPUNIT_ASSERT_EQUAL((size_t)1, (*page).getLayerCount());
+        Layer* layer = (*(*page).getLayers())[0];
+
+        Text* text = (Text*)(*layer->getElements())[0];
+        CPPUNIT_ASSERT_EQUAL(ELEMENT_TEXT, text->getType());
+        CPPUNIT_ASSERT_EQUAL(string("red & blue"), text->getText());
+    }
+
+    void testSaveCacheElementsReinserted() {
+        LoadHandler handler;
+        Document* doc = handler.loadDocument(GET_TESTFILE("packaged_xopp/suite.xopp"));
+        CPPUNIT_ASSERT(doc != nullptr);
+
+        Layer* layer = (*doc->getPage(0)->getLayers())[0];
+        vector<Element*> elements = *layer->getElements();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(8), elements.size());
+
+        // A selection takes its elements out of the layer while it is active
+        layer->removeElements({elements[1], elements[2]}, false);
+
+        SaveCache cache(nullptr);
+        SaveHandler autosave;
+        autosave.prepareSave(doc, &cache);
+        autosave.saveTo(Util::getTmpDirSubfolder() / "autosave1.xopp");
+
+        // Finalizing the selection puts them back
+        layer->insertElement(elements[1], 1);
+        layer->insertElement(elements[2], 2);
+
+        SaveHandler autosave2;
+        autosave2.prepareSave(doc, &cache);
+        auto tmp = Util::getTmpDirSubfolder() / "autosave2.xopp";
+        autosave2.saveTo(tmp);
+
+        LoadHandler handler2;
+        Document* saved = handler2.loadDocument(tmp);
+        CPPUNIT_ASSERT(saved != nullptr);
+        CPPUNIT_ASSERT_EQUAL(elements.size(), (*saved->getPage(0)->getLayers())[0]->getElements()->size());
+    }
+
+    void testLazyLoading() {
+        const char* files[] = {"test1.xoj",
+                               "load/pages.xoj",
+                               "load/layer.xoj",
+                               "load/text.xml",
+                               "load/doctype.xml",
+                               "packaged_xopp/layer.xopp",
+                               "packaged_xopp/text.xopp",
+                               "packaged_xopp/suite.xopp"};
+
+        for (const char* file: files) {
+            LoadHandler lazyHandler;
+            lazyHandler.setLazyLoadingEnabled(true);
+            Document* lazyDoc = lazyHandler.loadDocument(string(GET_TESTFILE("")) + file);
+            CPPUNIT_ASSERT(lazyDoc != nullptr);
+
+            LoadHandler handler;
+            Document* doc = handler.loadDocument(string(GET_TESTFILE("")) + file);
+
+            compareDocuments(lazyDoc, doc);
+        }
+
+        LoadHandler handler;
+        handler.setLazyLoadingEnabled(true);
+        Document* doc = handler.loadDocument(GET_TESTFILE("load/layer.xoj"));
+        PageRef page = doc->getPage(0);
+        uint64_t revision = page->getRevision();
+        CPPUNIT_ASSERT(!page->isContentLoaded());
+
+        CPPUNIT_ASSERT_EQUAL((size_t)3, (*page).getLayerCount());
+        CPPUNIT_ASSERT(page->isContentLoaded());
+        CPPUNIT_ASSERT_EQUAL(revision, page->getRevision());
+        checkLayer(page, 0, "l1");
+        checkLayer(page, 2, "l3");
+    }
+
+    void testLazyLoadingSaveUnloaded() {
+        LoadHandler handler;
+        handler.setLazyLoadingEnabled(true);
+        Document* doc = handler.loadDocument(GET_TESTFILE("packaged_xopp/suite.xopp"));
+        CPPUNIT_ASSERT(doc != nullptr);
+        PageRef page = doc->getPage(0);
+        CPPUNIT_ASSERT(!page->isContentLoaded());
+
+        // Copying and saving a page does not parse its layers
+        XojPage copy(*page);
+        CPPUNIT_ASSERT(!page->isContentLoaded());
+        CPPUNIT_ASSERT(!copy.isContentLoaded());
+
+        SaveHandler save;
+        save.prepareSave(doc);
+        auto tmp = Util::getTmpDirSubfolder() / "lazy.xopp";
+        save.saveTo(tmp);
+        CPPUNIT_ASSERT(save.getErrorMessage().empty());
+        CPPUNIT_ASSERT(!page->isContentLoaded());
+
+        LoadHandler savedHandler;
+        Document* saved = savedHandler.loadDocument(tmp);
+        CPPUNIT_ASSERT(saved != nullptr);
+
+        LoadHandler originalHandler;
+        Document* original = originalHandler.loadDocument(GET_TESTFILE("packaged_xopp/suite.xopp"));
+        compareDocuments(saved, original);
+
+        CPPUNIT_ASSERT_EQUAL(original->getPage(0)->getLayerCount(), copy.getLayerCount());
+    }
+
+    void testLazyLoadingSaveUnparsed() {
+        auto file = Util::getTmpDirSubfolder() / "unparsed.xopp";
+        {
+            std::ofstream out(file);
+            out << "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+                << "<xournal creator=\"Xournal++\" fileversion=\"4\">\n"
+                << "<page width=\"100\" height=\"100\">\n"
+                << "<background type=\"solid\" color=\"#ffffffff\" style=\"plain\"/>\n"
+                << "<layer><stroke tool=\"pen\" color=\"#000000ff\" width=\"1\">10 10 20 20</stroke>"
+                << "<stroke tool=\"pen\" color=\"#invalid\" width=\"1\">1 1 2 2</stroke></layer>\n"
+                << "</page>\n"
+                << "</xournal>\n";
+        }
+
+        LoadHandler handler;
+        handler.setLazyLoadingEnabled(true);
+        Document* doc = handler.loadDocument(file);
+        CPPUNIT_ASSERT(doc != nullptr);
+
+        // The layer can not be parsed completely, the page is saved as it was read
+        PageRef page = doc->getPage(0);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, page->getLayerCount());
+        CPPUNIT_ASSERT(page->getUnparsedLayersXml() != nullptr);
+
+        SaveHandler save;
+        save.prepareSave(doc);
+        auto tmp = Util::getTmpDirSubfolder() / "unparsed-saved.xopp";
+        save.saveTo(tmp);
+
+        string content;
+        gzFile in = GzUtil::openPath(tmp, "r");
+        CPPUNIT_ASSERT(in != nullptr);
+        char buffer[4096];
+        int read = 0;
+        while ((read = gzread(in, buffer, sizeof(buffer))) > 0) {
+            content.append(buffer, static_cast<size_t>(read));
+        }
+        gzclose(in);
+        CPPUNIT_ASSERT(content.find("color=\"#invalid\"") != string::npos);
+
+        // Once the page is changed, its layers are serialized
+        page->markChanged();
+        CPPUNIT_ASSERT(page->getUnparsedLayersXml() == nullptr);
+    }
+
 #ifdef __linux__
     void testLoadStoreLoadGerman() {
         constexpr auto testLocale = "de_DE.UTF-8";
@@ -0,0 +1,186 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "model/Stroke.h"
+#include "model/eraser/EraseableStroke.h"
+
+#include "Range.h"
+
+class EraseableStrokeTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(EraseableStrokeTest);
+
+    CPPUNIT_TEST(testEraseMiddle);
+    CPPUNIT_TEST(testEraseEnd);
+    CPPUNIT_TEST(testOverlappingErasures);
+    CPPUNIT_TEST(testEraseAll);
+    CPPUNIT_TEST(testPressure);
+    CPPUNIT_TEST(testStyle);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+        // A horizontal line from 0 to 100, with a point every 10
+        std::vector<Point> points;
+        for (int i = 0; i <= 10; i++) {
+            points.emplace_back(i * 10, 0);
+        }
+        this->stroke.setWidth(2);
+        this->stroke.setPoints(points);
+    }
+
+    void testEraseMiddle() {
+        EraseableStroke eraseable(&this->stroke);
+        std::unique_ptr<Range> range(eraseable.erase(50, 0, 5));
+        CPPUNIT_ASSERT(range != nullptr);
+        CPPUNIT_ASSERT(range->getX() <= 45 && range->getX2() >= 55);
+
+        auto strokes = createStrokes(eraseable);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), strokes.size());
+        checkLine(*strokes[0], 0, 45);
+        checkLine(*strokes[1], 55, 100);
+
+        // The points between the cuts are kept
+        CPPUNIT_ASSERT_EQUAL(6, strokes[0]->getPointCount());
+        CPPUNIT_ASSERT_EQUAL(6, strokes[1]->getPointCount());
+    }
+
+    void testEraseEnd() {
+        EraseableStroke eraseable(&this->stroke);
+        delete eraseable.erase(100, 0, 5);
+        delete eraseable.erase(0, 0, 3);
+
+        auto strokes = createStrokes(eraseable);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), strokes.size());
+        checkLine(*strokes[0], 3, 95);
+    }
+
+    void testOverlappingErasures() {
+        EraseableStroke eraseable(&this->stroke);
+        delete eraseable.erase(50, 0, 5);
+        delete eraseable.erase(57, 0, 5);
+        delete eraseable.erase(44, 0, 5);
+
+        // Erasing the same area again changes nothing
+        CPPUNIT_ASSERT(eraseable.erase(50, 0, 5) == nullptr);
+
+        auto strokes = createStrokes(eraseable);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), strokes.size());
+        checkLine(*strokes[0], 0, 39);
+        checkLine(*strokes[1], 62, 100);
+    }
+
+    void testEraseAll() {
+        {
+            EraseableStroke eraseable(&this->stroke);
+            delete eraseable.erase(50, 0, 60);
+            CPPUNIT_ASSERT(createStrokes(eraseable).empty());
+        }
+
+        // Erased in pieces
+        EraseableStroke eraseable(&this->stroke);
+        for (int x = 0; x <= 100; x += 8) {
+            delete eraseable.erase(x, 0, 5);
+        }
+        CPPUNIT_ASSERT(createStrokes(eraseable).empty());
+    }
+
+    void testPressure() {
+        std::vector<Point> points;
+        for (int i = 0; i <= 10; i++) {
+            points.emplace_back(i * 10, 0, 1 + i);
+        }
+        this->stroke.setPoints(points);
+
+        EraseableStroke eraseable(&this->stroke);
+        delete eraseable.erase(45, 0, 2);
+
+        auto strokes = createStrokes(eraseable);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), strokes.size());
+        checkLine(*strokes[0], 0, 43);
+        checkLine(*strokes[1], 47, 100);
+
+        // The cut points get the pressure of the segment they are on
+        std::vector<Point> first = strokes[0]->getPointVector();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(6), first.size());
+        for (size_t i = 0; i < 5; i++) {
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0 + i, first[i].z, 1e-9);
+        }
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, first[5].z, 1e-9);
+
+        std::vector<Point> second = strokes[1]->getPointVector();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(7), second.size());
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, second[0].z, 1e-9);
+        for (size_t i = 1; i + 1 < second.size(); i++) {
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0 + i, second[i].z, 1e-9);
+        }
+        // The end of the stroke is on its last segment
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(10.0, second.back().z, 1e-9);
+    }
+
+    void testStyle() {
+        this->stroke.setColor(0x00ff00U);
+        this->stroke.setToolType(STROKE_TOOL_HIGHLIGHTER);
+        this->stroke.setFill(128);
+        this->stroke.setTimestamp(42);
+        this->stroke.setAudioFilename("recording.mp3");
+
+        EraseableStroke eraseable(&this->stroke);
+        delete eraseable.erase(50, 0, 5);
+
+        auto strokes = createStrokes(eraseable);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), strokes.size());
+        for (const auto& s: strokes) {
+            CPPUNIT_ASSERT(s->getColor() == this->stroke.getColor());
+            CPPUNIT_ASSERT(s->getToolType() == STROKE_TOOL_HIGHLIGHTER);
+            CPPUNIT_ASSERT_EQUAL(2.0, s->getWidth());
+            CPPUNIT_ASSERT_EQUAL(128, s->getFill());
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(42), s->getTimestamp());
+            CPPUNIT_ASSERT_EQUAL(std::string("recording.mp3"), s->getAudioFilename());
+        }
+    }
+
+private:
+    static std::vector<std::unique_ptr<Stroke>> createStrokes(const EraseableStroke& eraseable) {
+        std::vector<std::unique_ptr<Stroke>> strokes;
+        for (Stroke* s: eraseable.createStrokes()) {
+            strokes.emplace_back(s);
+        }
+        return strokes;
+    }
+
+    /**
+     * Checks that the stroke is a part of the horizontal line from x1 to x2
+     */
+    static void checkLine(const Stroke& s, double x1, double x2) {
+        std::vector<Point> points = s.getPointVector();
+        CPPUNIT_ASSERT(points.size() >= 2);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(x1, points.front().x, 1e-9);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(x2, points.back().x, 1e-9);
+        for (size_t i = 0; i < points.size(); i++) {
+            CPPUNIT_ASSERT_EQUAL(0.0, points[i].y);
+            if (i > 0) {
+                CPPUNIT_ASSERT(points[i].x > points[i - 1].x);
+            }
+        }
+    }
+
+private:
+    Stroke stroke;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(EraseableStrokeTest);
@@ -0,0 +1,143 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "model/Image.h"
+#include "model/Layer.h"
+
+#include "Rectangle.h"
+
+class SpatialIndexTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(SpatialIndexTest);
+
+    CPPUNIT_TEST(testAddAndRemove);
+    CPPUNIT_TEST(testBoundsChanged);
+    CPPUNIT_TEST(testQueryBelowOrder);
+    CPPUNIT_TEST(testSpanningCells);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testAddAndRemove() {
+        Layer layer;
+        Element* a = addImage(layer, 10, 10, 20, 20);
+        Element* b = addImage(layer, 300, 10, 20, 20);
+        Element* c = addImage(layer, 15, 15, 5, 5);
+
+        checkElements({a, c}, layer.getElementsInArea(Rectangle<double>(0, 0, 100, 100)));
+        checkElements({a, b, c}, layer.getElementsInArea(Rectangle<double>(0, 0, 400, 100)));
+        checkElements({}, layer.getElementsInArea(Rectangle<double>(100, 100, 50, 50)));
+
+        layer.removeElement(a, true);
+        checkElements({c}, layer.getElementsInArea(Rectangle<double>(0, 0, 100, 100)));
+
+        layer.removeElement(c, true);
+        checkElements({}, layer.getElementsInArea(Rectangle<double>(0, 0, 100, 100)));
+        checkElements({b}, layer.getElementsInArea(Rectangle<double>(0, 0, 400, 100)));
+    }
+
+    void testBoundsChanged() {
+        Layer layer;
+        auto* image = addImage(layer, 10, 10, 20, 20);
+
+        // Moved to another cell
+        image->move(500, 500);
+        checkElements({}, layer.getElementsInArea(Rectangle<double>(0, 0, 100, 100)));
+        checkElements({image}, layer.getElementsInArea(Rectangle<double>(500, 500, 40, 40)));
+
+        // Grown into the neighbouring cells
+        image->setWidth(200);
+        checkElements({image}, layer.getElementsInArea(Rectangle<double>(700, 500, 10, 10)));
+
+        // Changed several times between two queries
+        image->setX(0);
+        image->setY(0);
+        image->setWidth(10);
+        checkElements({}, layer.getElementsInArea(Rectangle<double>(500, 500, 300, 100)));
+        checkElements({image}, layer.getElementsInArea(Rectangle<double>(0, 0, 10, 10)));
+        checkElements({image}, layer.getElementsBelow(0));
+        checkElements({}, layer.getElementsBelow(1));
+    }
+
+    void testQueryBelowOrder() {
+        Layer layer;
+        Element* a = addImage(layer, 0, 300, 10, 10);
+        Element* b = addImage(layer, 0, 200, 10, 10);
+        Element* c = addImage(layer, 0, 100, 10, 10);
+
+        // The result is in drawing order, not sorted by the top edge
+        checkElements({a, b, c}, layer.getElementsBelow(0));
+        checkElements({a, b}, layer.getElementsBelow(150));
+        checkElements({a, b}, layer.getElementsBelow(200));
+        checkElements({}, layer.getElementsBelow(301));
+
+        // Inserted below the other elements
+        auto* d = new Image();
+        setBounds(d, 0, 250, 10, 10);
+        layer.insertElement(d, 0);
+        checkElements({d, a, b}, layer.getElementsBelow(150));
+
+        c->move(0, 200);
+        checkElements({d, a, b, c}, layer.getElementsBelow(150));
+        checkElements({a, c}, layer.getElementsBelow(260));
+    }
+
+    void testSpanningCells() {
+        Layer layer;
+
+        // Spans several cells in both directions
+        Element* wide = addImage(layer, 10, 10, 300, 150);
+
+        // Covers too many cells, tested on every query
+        Element* page = addImage(layer, 0, 0, 2000, 3000);
+
+        Element* small = addImage(layer, 200, 100, 5, 5);
+
+        // Found once, although it is stored in all cells of the area
+        checkElements({wide, page}, layer.getElementsInArea(Rectangle<double>(0, 0, 150, 80)));
+        checkElements({wide, page, small}, layer.getElementsInArea(Rectangle<double>(150, 50, 100, 100)));
+        checkElements({page}, layer.getElementsInArea(Rectangle<double>(1500, 2500, 10, 10)));
+
+        // Touching the bounds is enough
+        checkElements({wide, page}, layer.getElementsInArea(Rectangle<double>(310, 160, 10, 10)));
+        checkElements({}, layer.getElementsInArea(Rectangle<double>(2001, 0, 10, 10)));
+
+        // The whole page, more cells than the index contains
+        checkElements({wide, page, small}, layer.getElementsInArea(Rectangle<double>(-100, -100, 5000, 5000)));
+    }
+
+private:
+    static void setBounds(Image* image, double x, double y, double width, double height) {
+        image->setX(x);
+        image->setY(y);
+        image->setWidth(width);
+        image->setHeight(height);
+    }
+
+    static Image* addImage(Layer& layer, double x, double y, double width, double height) {
+        auto* image = new Image();
+        setBounds(image, x, y, width, height);
+        layer.addElement(image);
+        return image;
+    }
+
+    static void checkElements(const std::vector<Element*>& expected, const std::vector<Element*>& actual) {
+        CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            CPPUNIT_ASSERT(expected[i] == actual[i]);
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SpatialIndexTest);
@@ -0,0 +1,114 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <FloatParser.h>
+#include <Util.h>
+#include <config-test.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <glib.h>
+
+class FloatParserTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(FloatParserTest);
+
+    CPPUNIT_TEST(testSameAsStrtod);
+    CPPUNIT_TEST(testCoordinates);
+    CPPUNIT_TEST(testList);
+    CPPUNIT_TEST(testFormatDouble);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+    void tearDown() {}
+
+    void checkSameAsStrtod(const std::string& str) {
+        char* strtodEnd = nullptr;
+        double expected = g_ascii_strtod(str.c_str(), &strtodEnd);
+
+        double value = 0;
+        const char* end = Util::parseDouble(str.data(), str.data() + str.size(), value);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(str, static_cast<long>(strtodEnd - str.c_str()),
+                                     static_cast<long>(end - str.data()));
+        if (!std::isnan(expected)) {
+            // Compare the bits, to also check the sign of zero
+            CPPUNIT_ASSERT_MESSAGE(str, memcmp(&expected, &value, sizeof(double)) == 0);
+        }
+    }
+
+    void testSameAsStrtod() {
+        const char* numbers[] = {"", "1", "-1", "+1", "0", "-0", "1.", "1.5", ".5", "-.5", ".", "-", "e5", "1e", "1e+",
+                                 "1e5", "1e-5", "1.5E3x", "0x10", "inf", "-nan", " \n\t12.25 3", "1,5", "1.2.3", "abc",
+                                 "1e400", "1e-400", "4.9e-324", "9007199254740993", "12345678901234567890",
+                                 "0.000000000000000000000000001", "1.7976931348623157e308", "3.14159265358979323846"};
+        for (const char* number: numbers) {
+            checkSameAsStrtod(number);
+        }
+    }
+
+    void testCoordinates() {
+        char buffer[64];
+        for (int i = -100000; i < 100000; i += 7) {
+            double value = i * 0.0123456789;
+            snprintf(buffer, sizeof(buffer), "%.8f", value);
+            checkSameAsStrtod(buffer);
+            snprintf(buffer, sizeof(buffer), "%.17g", value);
+            checkSameAsStrtod(buffer);
+        }
+    }
+
+    void testList() {
+        std::string str = "1.5 2.25\n-3e2\t4 x 5";
+
+        std::vector<double> values;
+        const char* end = Util::parseDoubles(str.data(), str.data() + str.size(), values);
+
+        CPPUNIT_ASSERT_EQUAL((size_t)4, values.size());
+        CPPUNIT_ASSERT_EQUAL(1.5, values[0]);
+        CPPUNIT_ASSERT_EQUAL(2.25, values[1]);
+        CPPUNIT_ASSERT_EQUAL(-300.0, values[2]);
+        CPPUNIT_ASSERT_EQUAL(4.0, values[3]);
+        CPPUNIT_ASSERT_EQUAL(std::string(" x 5"), std::string(end));
+    }
+
+    void checkFormatDouble(double value) {
+        char expected[G_ASCII_DTOSTR_BUF_SIZE];
+        g_ascii_formatd(expected, G_ASCII_DTOSTR_BUF_SIZE, Util::PRECISION_FORMAT_STRING, value);
+
+        char buffer[G_ASCII_DTOSTR_BUF_SIZE];
+        size_t length = Util::formatDouble(buffer, value);
+
+        CPPUNIT_ASSERT_EQUAL(std::string(expected), std::string(buffer));
+        CPPUNIT_ASSERT_EQUAL(strlen(expected), length);
+    }
+
+    void testFormatDouble() {
+        double values[] = {0.0, -0.0, 1.0, -1.0, 0.5, 1e-9, -1e-9, 5e-9, 1.5e-8, 2.5e-8, 123.456, 1e7, 1e9, 1e20, -1e20};
+        for (double value: values) {
+            checkFormatDouble(value);
+        }
+
+        for (int i = -100000; i < 100000; i += 7) {
+            checkFormatDouble(i * 0.0123456789);
+            checkFormatDouble(i / 3.0);
+        }
+    }
+};
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION(FloatParserTest);
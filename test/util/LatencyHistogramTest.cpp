@@ -0,0 +1,78 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "LatencyHistogram.h"
+
+class LatencyHistogramTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(LatencyHistogramTest);
+
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testPercentile);
+    CPPUNIT_TEST(testRingBuffer);
+    CPPUNIT_TEST(testBuckets);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void testEmpty() {
+        LatencyHistogram histogram(10);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), histogram.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(0), histogram.getPercentile(50));
+    }
+
+    void testPercentile() {
+        LatencyHistogram histogram(100);
+        for (int64_t i = 100; i >= 1; i--) {
+            histogram.add(i);
+        }
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(1), histogram.getPercentile(0));
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(50), histogram.getPercentile(50));
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(99), histogram.getPercentile(99));
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(100), histogram.getPercentile(100));
+    }
+
+    void testRingBuffer() {
+        LatencyHistogram histogram(3);
+        histogram.add(1000);
+        histogram.add(-5);
+        for (int64_t i = 1; i <= 3; i++) {
+            histogram.add(i);
+        }
+
+        // Only the last 3 samples are kept
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), histogram.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(5), histogram.getTotalCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(3), histogram.getPercentile(100));
+
+        histogram.clear();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), histogram.size());
+    }
+
+    void testBuckets() {
+        LatencyHistogram histogram(10);
+        histogram.add(0);
+        histogram.add(LatencyHistogram::FIRST_BUCKET_LIMIT - 1);
+        histogram.add(LatencyHistogram::FIRST_BUCKET_LIMIT);
+        histogram.add(INT64_MAX);
+
+        auto buckets = histogram.getBuckets();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), buckets[0]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), buckets[1]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), buckets[LatencyHistogram::BUCKET_COUNT - 1]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<int64_t>(-1),
+                             LatencyHistogram::getBucketLimit(LatencyHistogram::BUCKET_COUNT - 1));
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LatencyHistogramTest);
@@ -0,0 +1,101 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <algorithm>
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <zlib.h>
+
+#include "GzUtil.h"
+#include "OutputStream.h"
+#include "filesystem.h"
+
+class ParallelGzOutputStreamTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ParallelGzOutputStreamTest);
+
+    CPPUNIT_TEST(testRoundTrip);
+    CPPUNIT_TEST(testNoCompression);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testCompressionError);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() { this->file = fs::temp_directory_path() / "xournalpp-parallel-gz-test.gz"; }
+
+    void tearDown() { fs::remove(this->file); }
+
+    void testRoundTrip() {
+        // Several blocks, written in chunks which do not match the block size
+        std::string data;
+        for (int i = 0; data.size() < 3 * 1024 * 1024; i++) {
+            data += "<stroke tool=\"pen\" color=\"#000000ff\" width=\"1.41\">" + std::to_string(i * 7919 % 10007) +
+                    "</stroke>\n";
+        }
+
+        writeFile(data, 6, 12345);
+        CPPUNIT_ASSERT(data == readFile());
+        CPPUNIT_ASSERT(fs::file_size(this->file) < data.size() / 4);
+    }
+
+    void testNoCompression() {
+        std::string data(100000, 'x');
+        writeFile(data, 0, 4096);
+        CPPUNIT_ASSERT(data == readFile());
+    }
+
+    void testEmpty() {
+        writeFile("", Z_DEFAULT_COMPRESSION, 1);
+        CPPUNIT_ASSERT(readFile().empty());
+    }
+
+    void testCompressionError() {
+        // zlib rejects the level, the error is reported instead of writing a broken file silently
+        ParallelGzOutputStream out(this->file, 42);
+        std::string data(1024 * 1024, 'x');
+        out.write(data.data(), static_cast<int>(data.size()));
+        out.close();
+        CPPUNIT_ASSERT(!out.getLastError().empty());
+    }
+
+private:
+    void writeFile(const std::string& data, int level, size_t chunkSize) {
+        ParallelGzOutputStream out(this->file, level);
+        CPPUNIT_ASSERT(out.getLastError().empty());
+
+        for (size_t offset = 0; offset < data.size(); offset += chunkSize) {
+            out.write(data.data() + offset, static_cast<int>(std::min(chunkSize, data.size() - offset)));
+        }
+        out.close();
+        CPPUNIT_ASSERT(out.getLastError().empty());
+    }
+
+    std::string readFile() {
+        gzFile fp = GzUtil::openPath(this->file, "r");
+        CPPUNIT_ASSERT(fp != nullptr);
+
+        std::string result;
+        char buffer[4096];
+        int read = 0;
+        while ((read = gzread(fp, buffer, sizeof(buffer))) > 0) {
+            result.append(buffer, static_cast<size_t>(read));
+        }
+        CPPUNIT_ASSERT_EQUAL(0, read);
+        CPPUNIT_ASSERT_EQUAL(Z_OK, gzclose(fp));
+        return result;
+    }
+
+private:
+    fs::path file;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelGzOutputStreamTest);
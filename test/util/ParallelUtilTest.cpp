@@ -0,0 +1,99 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <ParallelUtil.h>
+#include <config-test.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class ParallelUtilTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ParallelUtilTest);
+
+    CPPUNIT_TEST(testOrder);
+    CPPUNIT_TEST(testSingleThread);
+    CPPUNIT_TEST(testWindow);
+    CPPUNIT_TEST(testEmpty);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+
+    void tearDown() {}
+
+    void testOrder() {
+        std::vector<size_t> consumed;
+        Util::orderedParallelFor(
+                1000, 8, 16, [](size_t i) { return std::to_string(i * i); },
+                [&](size_t i, std::string result) {
+                    CPPUNIT_ASSERT_EQUAL(std::to_string(i * i), result);
+                    consumed.push_back(i);
+                });
+
+        CPPUNIT_ASSERT_EQUAL((size_t)1000, consumed.size());
+        for (size_t i = 0; i < consumed.size(); i++) {
+            CPPUNIT_ASSERT_EQUAL(i, consumed[i]);
+        }
+    }
+
+    void testSingleThread() {
+        size_t produced = 0;
+        size_t consumed = 0;
+        Util::orderedParallelFor(
+                10, 1, 1,
+                [&](size_t i) {
+                    // Everything runs on the calling thread, one item after another
+                    CPPUNIT_ASSERT_EQUAL(consumed, produced);
+                    produced++;
+                    return i;
+                },
+                [&](size_t i, size_t result) {
+                    CPPUNIT_ASSERT_EQUAL(i, result);
+                    consumed++;
+                });
+
+        CPPUNIT_ASSERT_EQUAL((size_t)10, consumed);
+    }
+
+    void testWindow() {
+        std::atomic<size_t> produced{0};
+        size_t maxAhead = 0;
+        Util::orderedParallelFor(
+                200, 4, 4,
+                [&](size_t i) {
+                    produced++;
+                    return i;
+                },
+                [&](size_t i, size_t) { maxAhead = std::max(maxAhead, produced.load() - i); });
+
+        // The item being consumed, and up to `window` items produced ahead
+        CPPUNIT_ASSERT(maxAhead <= 5);
+    }
+
+    void testEmpty() {
+        bool called = false;
+        Util::orderedParallelFor(
+                0, 4, 4,
+                [&](size_t i) {
+                    called = true;
+                    return i;
+                },
+                [&](size_t, size_t) { called = true; });
+
+        CPPUNIT_ASSERT(!called);
+    }
+};
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelUtilTest);
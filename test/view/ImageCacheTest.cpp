@@ -0,0 +1,176 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include <cairo.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "view/ImageCache.h"
+
+class ImageCacheTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ImageCacheTest);
+
+    CPPUNIT_TEST(testReadPngSize);
+    CPPUNIT_TEST(testChooseLevel);
+    CPPUNIT_TEST(testEvictFailed);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+        this->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 100, 100);
+        this->cr = cairo_create(this->surface);
+
+        ImageCache::getInstance().clear();
+    }
+
+    void tearDown() {
+        cairo_destroy(this->cr);
+        cairo_surface_destroy(this->surface);
+
+        ImageCache::getInstance().clear();
+        ImageCache::getInstance().setMaxBytes(256 * 1024 * 1024);
+    }
+
+    void testReadPngSize() {
+        int width = 0;
+        int height = 0;
+        std::string png = createPng(64, 48);
+        CPPUNIT_ASSERT(ImageCache::readPngSize(png, width, height));
+        CPPUNIT_ASSERT_EQUAL(64, width);
+        CPPUNIT_ASSERT_EQUAL(48, height);
+
+        // Cut off within the header
+        CPPUNIT_ASSERT(!ImageCache::readPngSize(png.substr(0, 20), width, height));
+        CPPUNIT_ASSERT(!ImageCache::readPngSize("", width, height));
+
+        std::string gif = "GIF89a";
+        gif.resize(png.size(), '\0');
+        CPPUNIT_ASSERT(!ImageCache::readPngSize(gif, width, height));
+
+        // A PNG signature without the IHDR chunk
+        std::string noHeader = png;
+        noHeader.replace(12, 4, "IDAT");
+        CPPUNIT_ASSERT(!ImageCache::readPngSize(noHeader, width, height));
+    }
+
+    void testChooseLevel() {
+        CPPUNIT_ASSERT_EQUAL(0, chooseLevel(1));
+        CPPUNIT_ASSERT_EQUAL(0, chooseLevel(2));
+        CPPUNIT_ASSERT_EQUAL(0, chooseLevel(0.6));
+        CPPUNIT_ASSERT_EQUAL(1, chooseLevel(0.5));
+        CPPUNIT_ASSERT_EQUAL(1, chooseLevel(0.3));
+        CPPUNIT_ASSERT_EQUAL(2, chooseLevel(0.25));
+        CPPUNIT_ASSERT_EQUAL(ImageCache::LEVEL_COUNT - 1, chooseLevel(1e-4));
+
+        // The direction which is downscaled less decides
+        cairo_identity_matrix(this->cr);
+        CPPUNIT_ASSERT_EQUAL(0, ImageCache::chooseLevel(this->cr, 1024, 1024, 256, 1024));
+
+        // The size on the target counts, not the axes
+        cairo_identity_matrix(this->cr);
+        cairo_rotate(this->cr, M_PI / 4);
+        cairo_scale(this->cr, 0.25, 0.25);
+        CPPUNIT_ASSERT_EQUAL(2, ImageCache::chooseLevel(this->cr, 1024, 1024, 1024, 1024));
+
+        // Vector targets always get the full resolution
+        cairo_surface_t* recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
+        cairo_t* vector = cairo_create(recording);
+        cairo_scale(vector, 0.25, 0.25);
+        CPPUNIT_ASSERT(ImageCache::isVectorTarget(vector));
+        CPPUNIT_ASSERT(!ImageCache::isVectorTarget(this->cr));
+        CPPUNIT_ASSERT_EQUAL(0, ImageCache::chooseLevel(vector, 1024, 1024, 1024, 1024));
+        cairo_destroy(vector);
+        cairo_surface_destroy(recording);
+    }
+
+    void testEvictFailed() {
+        ImageCache& cache = ImageCache::getInstance();
+
+        auto a = std::make_shared<const std::string>(createPng(SIZE, SIZE));
+        auto b = std::make_shared<const std::string>(createPng(SIZE, SIZE));
+
+        // The header can be read, the image data cannot be decoded
+        auto broken = std::make_shared<const std::string>(a->substr(0, 40));
+
+        // Painted at full resolution, each image uses a level of LEVEL_BYTES
+        cache.setMaxBytes(2 * LEVEL_BYTES);
+        CPPUNIT_ASSERT(cache.paint(this->cr, a, 0, 0, SIZE, SIZE, true));
+        CPPUNIT_ASSERT_EQUAL(LEVEL_BYTES, cache.getBytes());
+
+        // Failed images are accounted with the size of their data
+        CPPUNIT_ASSERT(cache.paint(this->cr, broken, 0, 0, SIZE, SIZE, true));
+        CPPUNIT_ASSERT_EQUAL(LEVEL_BYTES + broken->size(), cache.getBytes());
+
+        // a is the least recently used
+        CPPUNIT_ASSERT(cache.paint(this->cr, b, 0, 0, SIZE, SIZE, true));
+        CPPUNIT_ASSERT_EQUAL(LEVEL_BYTES + broken->size(), cache.getBytes());
+
+        // Painting the failed image again does not decode it again, but makes b the least recently used
+        CPPUNIT_ASSERT(cache.paint(this->cr, broken, 0, 0, SIZE, SIZE, true));
+        CPPUNIT_ASSERT_EQUAL(LEVEL_BYTES + broken->size(), cache.getBytes());
+        CPPUNIT_ASSERT(cache.paint(this->cr, a, 0, 0, SIZE, SIZE, true));
+        CPPUNIT_ASSERT_EQUAL(LEVEL_BYTES + broken->size(), cache.getBytes());
+
+        // The failed image is evicted like a level
+        cache.setMaxBytes(LEVEL_BYTES);
+        CPPUNIT_ASSERT_EQUAL(LEVEL_BYTES, cache.getBytes());
+
+        // Evicted failed images are tried again, the most recently used entry is kept even above the budget
+        CPPUNIT_ASSERT(cache.paint(this->cr, broken, 0, 0, SIZE, SIZE, true));
+        CPPUNIT_ASSERT_EQUAL(broken->size(), cache.getBytes());
+
+        cache.release(broken);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), cache.getBytes());
+    }
+
+private:
+    /**
+     * The level of a 1024 x 1024 image painted at its size, scaled on the target
+     */
+    int chooseLevel(double scale) {
+        cairo_identity_matrix(this->cr);
+        cairo_scale(this->cr, scale, scale);
+        return ImageCache::chooseLevel(this->cr, 1024, 1024, 1024, 1024);
+    }
+
+    static std::string createPng(int width, int height) {
+        cairo_surface_t* image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+        cairo_t* imageCr = cairo_create(image);
+        cairo_set_source_rgba(imageCr, 1, 0, 0, 0.5);
+        cairo_paint(imageCr);
+        cairo_destroy(imageCr);
+
+        std::string png;
+        cairo_surface_write_to_png_stream(
+                image,
+                [](void* closure, const unsigned char* data, unsigned int length) {
+                    static_cast<std::string*>(closure)->append(reinterpret_cast<const char*>(data), length);
+                    return CAIRO_STATUS_SUCCESS;
+                },
+                &png);
+        cairo_surface_destroy(image);
+
+        return png;
+    }
+
+private:
+    static constexpr int SIZE = 64;
+    static constexpr size_t LEVEL_BYTES = SIZE * SIZE * 4;
+
+    cairo_surface_t* surface = nullptr;
+    cairo_t* cr = nullptr;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ImageCacheTest);
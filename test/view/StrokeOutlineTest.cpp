@@ -0,0 +1,121 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <cairo.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "model/Point.h"
+#include "model/StrokePoints.h"
+#include "view/StrokeOutline.h"
+
+class StrokeOutlineTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(StrokeOutlineTest);
+
+    CPPUNIT_TEST(testConstantWidth);
+    CPPUNIT_TEST(testIncreasingWidthAtTurn);
+    CPPUNIT_TEST(testDecreasingWidthAtTurn);
+    CPPUNIT_TEST(testHairpin);
+    CPPUNIT_TEST(testShortSegment);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+        this->surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+        this->cr = cairo_create(this->surface);
+    }
+
+    void tearDown() {
+        cairo_destroy(this->cr);
+        cairo_surface_destroy(this->surface);
+    }
+
+    void testConstantWidth() { checkCoverage({Point(0, 0, 4), Point(20, 0, 4), Point(20 - COS30, SIN30, 4)}); }
+
+    void testIncreasingWidthAtTurn() {
+        checkCoverage({Point(0, 0, 2), Point(20, 0, 6), Point(20 - COS30, SIN30, 6)});
+        checkCoverage({Point(0, 0, 2), Point(20, 0, 6), Point(20 - COS30, -SIN30, 6)});
+    }
+
+    void testDecreasingWidthAtTurn() {
+        checkCoverage({Point(0, 0, 6), Point(20, 0, 2), Point(20 - COS30, SIN30, 2)});
+    }
+
+    void testHairpin() { checkCoverage({Point(0, 0, 1), Point(20, 0, 12), Point(0, 1, 1), Point(20, 3, 8)}); }
+
+    void testShortSegment() {
+        checkCoverage({Point(0, 0, 2), Point(10, 5, 10), Point(11, 5, 2), Point(20, -5, 6)});
+    }
+
+private:
+    /**
+     * Compares the filled outline with the union of the segments drawn as capsules (with round caps), on a grid
+     * around the stroke. Points close to the border of the union are skipped, the arcs are approximated.
+     */
+    void checkCoverage(const std::vector<Point>& points) {
+        StrokeOutline outline(StrokePoints(points), 1, 1);
+
+        cairo_new_path(this->cr);
+        outline.appendPath(this->cr);
+        cairo_set_fill_rule(this->cr, CAIRO_FILL_RULE_WINDING);
+
+        int inked = 0;
+        int missing = 0;
+        int extra = 0;
+        for (double x = -30; x <= 30; x += 0.25) {
+            for (double y = -30; y <= 30; y += 0.25) {
+                double distance = INFINITY;
+                for (size_t i = 0; i + 1 < points.size(); i++) {
+                    double radius = points[i].z / 2;
+                    distance = std::min(distance, segmentDistance(x, y, points[i], points[i + 1]) - radius);
+                }
+                if (std::abs(distance) < TOLERANCE) {
+                    continue;
+                }
+
+                bool filled = cairo_in_fill(this->cr, x, y);
+                inked += distance < 0;
+                missing += distance < 0 && !filled;
+                extra += distance > 0 && filled;
+            }
+        }
+
+        CPPUNIT_ASSERT(inked > 0);
+        CPPUNIT_ASSERT_EQUAL(0, missing);
+        CPPUNIT_ASSERT_EQUAL(0, extra);
+    }
+
+    static double segmentDistance(double x, double y, const Point& a, const Point& b) {
+        double dx = b.x - a.x;
+        double dy = b.y - a.y;
+        double lengthSquared = dx * dx + dy * dy;
+        double t = lengthSquared > 0 ? std::clamp(((x - a.x) * dx + (y - a.y) * dy) / lengthSquared, 0.0, 1.0) : 0;
+        return std::hypot(x - a.x - t * dx, y - a.y - t * dy);
+    }
+
+private:
+    static constexpr double COS30 = 17.320508075688775;
+    static constexpr double SIN30 = 10;
+
+    /**
+     * Distance from the border of the union which is not compared
+     */
+    static constexpr double TOLERANCE = 0.02;
+
+    cairo_surface_t* surface = nullptr;
+    cairo_t* cr = nullptr;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StrokeOutlineTest);
@@ -0,0 +1,140 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <cairo.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "model/Stroke.h"
+#include "view/StrokeOutline.h"
+#include "view/StrokeRenderCache.h"
+
+class StrokeRenderCacheTest: public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(StrokeRenderCacheTest);
+
+    CPPUNIT_TEST(testHairpinLevels);
+    CPPUNIT_TEST(testRevision);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+        // A hairpin drawn with pressure, the simplified levels have few long segments with large width changes
+        std::vector<Point> points;
+        for (int i = 0; i <= 200; i++) {
+            double t = i / 200.0;
+            double x = 0;
+            double y = 0;
+            if (t < 0.45) {
+                x = t / 0.45 * 40 - 20;
+                y = -2;
+            } else if (t < 0.55) {
+                double a = (t - 0.45) / 0.1 * M_PI;
+                x = 20 + 2 * std::sin(a);
+                y = -2 * std::cos(a);
+            } else {
+                x = 20 - (t - 0.55) / 0.45 * 40;
+                y = 2;
+            }
+            points.emplace_back(x, y, 1 + 7 * std::sin(t * M_PI));
+        }
+
+        this->stroke.setWidth(1);
+        this->stroke.setPoints(points);
+
+        this->surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+        this->cr = cairo_create(this->surface);
+    }
+
+    void tearDown() {
+        cairo_destroy(this->cr);
+        cairo_surface_destroy(this->surface);
+    }
+
+    void testHairpinLevels() {
+        std::shared_ptr<StrokeRenderCache> cache = StrokeRenderCache::get(this->stroke);
+        for (int level = 0; level < StrokeRenderCache::LEVEL_COUNT; level++) {
+            std::vector<Point> points = cache->getPoints(this->stroke, level)->toVector();
+            CPPUNIT_ASSERT(points.size() >= 2);
+
+            cairo_new_path(this->cr);
+            cache->getOutline(this->stroke, level, 1)->appendPath(this->cr);
+            cairo_set_fill_rule(this->cr, CAIRO_FILL_RULE_WINDING);
+
+            // The outline of the level has to cover the segments of the level drawn with round caps
+            int missing = 0;
+            int extra = 0;
+            for (double x = -25; x <= 30; x += 0.25) {
+                for (double y = -10; y <= 10; y += 0.25) {
+                    double distance = INFINITY;
+                    for (size_t i = 0; i + 1 < points.size(); i++) {
+                        distance = std::min(distance,
+                                            segmentDistance(x, y, points[i], points[i + 1]) - points[i].z / 2);
+                    }
+                    if (std::abs(distance) < TOLERANCE) {
+                        continue;
+                    }
+
+                    bool filled = cairo_in_fill(this->cr, x, y);
+                    missing += distance < 0 && !filled;
+                    extra += distance > 0 && filled;
+                }
+            }
+
+            CPPUNIT_ASSERT_EQUAL(0, missing);
+            CPPUNIT_ASSERT_EQUAL(0, extra);
+        }
+    }
+
+    void testRevision() {
+        std::shared_ptr<StrokeRenderCache> cache = StrokeRenderCache::get(this->stroke);
+        CPPUNIT_ASSERT(cache == StrokeRenderCache::get(this->stroke));
+
+        // A copy of the stroke shares the cache until one of them changes
+        Stroke copy = this->stroke;
+        CPPUNIT_ASSERT(cache == StrokeRenderCache::get(copy));
+
+        this->stroke.move(1, 1);
+        std::shared_ptr<StrokeRenderCache> moved = StrokeRenderCache::get(this->stroke);
+        CPPUNIT_ASSERT(cache != moved);
+        CPPUNIT_ASSERT(moved == StrokeRenderCache::get(this->stroke));
+        CPPUNIT_ASSERT(cache == StrokeRenderCache::get(copy));
+
+        this->stroke.resetRenderCache();
+        CPPUNIT_ASSERT(this->stroke.getRenderCache() == nullptr);
+    }
+
+private:
+    static double segmentDistance(double x, double y, const Point& a, const Point& b) {
+        double dx = b.x - a.x;
+        double dy = b.y - a.y;
+        double lengthSquared = dx * dx + dy * dy;
+        double t = lengthSquared > 0 ? std::clamp(((x - a.x) * dx + (y - a.y) * dy) / lengthSquared, 0.0, 1.0) : 0;
+        return std::hypot(x - a.x - t * dx, y - a.y - t * dy);
+    }
+
+private:
+    /**
+     * Distance from the border of the segments which is not compared, the arcs are approximated
+     */
+    static constexpr double TOLERANCE = 0.02;
+
+    Stroke stroke;
+
+    cairo_surface_t* surface = nullptr;
+    cairo_t* cr = nullptr;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StrokeRenderCacheTest);